@@ -0,0 +1,209 @@
+/*
+ * Copyright 2026 Great Scott Gadgets <info@greatscottgadgets.com>
+ *
+ * This file is part of HackRF.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "command_queue.h"
+
+#include <stddef.h>
+
+/* True if position a is at or after position b. */
+static bool after(const uint32_t a, const uint32_t b)
+{
+	return (int32_t) (a - b) >= 0;
+}
+
+void command_queue_init(command_queue_t* const queue)
+{
+	queue->count = 0;
+}
+
+/* Check a command's type, position and value before it is queued. */
+bool command_valid(const command_t* const command)
+{
+	if (command->when % COMMAND_ALIGNMENT) {
+		return false;
+	}
+
+	switch (command->type) {
+	case COMMAND_SET_FREQ:
+		return true;
+	case COMMAND_LNA_GAIN:
+		return (command->value <= 40) && ((command->value % 8) == 0);
+	case COMMAND_VGA_GAIN:
+		return (command->value <= 62) && ((command->value % 2) == 0);
+	case COMMAND_TXVGA_GAIN:
+		return command->value <= 47;
+	case COMMAND_AMP_ENABLE:
+		return command->value <= 1;
+	case COMMAND_OPERACAKE_PORTS:
+		return command->value <= 0xffffff;
+	case COMMAND_PAUSE:
+	case COMMAND_RESUME:
+		return command->value == 0;
+	default:
+		return false;
+	}
+}
+
+/* Mode switches are carried out by the M0 rather than the M4. */
+bool command_switches_mode(const command_t* const command)
+{
+	return (command->type == COMMAND_PAUSE) || (command->type == COMMAND_RESUME);
+}
+
+uint8_t command_queue_space(const command_queue_t* const queue)
+{
+	return COMMAND_QUEUE_SIZE - queue->count;
+}
+
+/*
+ * True if a mode switch at position when can't be armed in time, because
+ * it is less than COMMAND_ARM_GUARD after now or after another queued
+ * mode switch, which the M4 can only arm once the earlier one has passed.
+ */
+static bool command_too_close(
+	const command_queue_t* const queue,
+	const uint32_t when,
+	const uint32_t now)
+{
+	uint32_t distance;
+	uint8_t i;
+
+	if ((when - now) < COMMAND_ARM_GUARD) {
+		return true;
+	}
+	for (i = 0; i < queue->count; i++) {
+		if (command_switches_mode(&queue->commands[i])) {
+			distance = when - queue->commands[i].when;
+			if ((int32_t) distance < 0) {
+				distance = -distance;
+			}
+			if (distance < COMMAND_ARM_GUARD) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+/*
+ * Insert a command after any others for the same position. Fails if the
+ * queue is full, the position is not after now, or the command switches
+ * modes too close to now or to another mode switch.
+ */
+bool command_queue_insert(
+	command_queue_t* const queue,
+	const command_t* const command,
+	const uint32_t now)
+{
+	uint8_t i;
+
+	if ((queue->count == COMMAND_QUEUE_SIZE) || after(now, command->when)) {
+		return false;
+	}
+	if (command_switches_mode(command) &&
+	    command_too_close(queue, command->when, now)) {
+		return false;
+	}
+	for (i = queue->count; i > 0; i--) {
+		if (after(command->when, queue->commands[i - 1].when)) {
+			break;
+		}
+		queue->commands[i] = queue->commands[i - 1];
+	}
+	queue->commands[i] = *command;
+	queue->count++;
+	return true;
+}
+
+const command_t* command_queue_head(const command_queue_t* const queue)
+{
+	return (queue->count > 0) ? &queue->commands[0] : NULL;
+}
+
+/* True if the first command's position has been reached. */
+bool command_queue_due(const command_queue_t* const queue, const uint32_t now)
+{
+	return (queue->count > 0) && after(now, queue->commands[0].when);
+}
+
+void command_queue_pop(command_queue_t* const queue)
+{
+	uint8_t i;
+
+	if (queue->count == 0) {
+		return;
+	}
+	queue->count--;
+	for (i = 0; i < queue->count; i++) {
+		queue->commands[i] = queue->commands[i + 1];
+	}
+}
+
+/*
+ * Return the M0 count at which to switch modes for a command at position
+ * when. Commands are only queued if they leave time to arm them, but if
+ * the M4 is still late, for example while applying a previous command,
+ * the switch happens at the first aligned position it can still arm.
+ */
+uint32_t command_arm_position(const uint32_t when, const uint32_t now)
+{
+	uint32_t earliest = now + COMMAND_ARM_GUARD;
+
+	if (after(when, earliest)) {
+		return when;
+	}
+	return (earliest + COMMAND_ALIGNMENT - 1) & ~(uint32_t) (COMMAND_ALIGNMENT - 1);
+}
+
+/*
+ * Packed commands are the position (uint32), the type (uint8), three
+ * reserved bytes and the value (uint64), all little-endian.
+ */
+void command_pack(const command_t* const command, uint8_t* const data)
+{
+	uint8_t i;
+
+	for (i = 0; i < 4; i++) {
+		data[i] = (command->when >> (8 * i)) & 0xff;
+	}
+	data[4] = command->type;
+	data[5] = 0;
+	data[6] = 0;
+	data[7] = 0;
+	for (i = 0; i < 8; i++) {
+		data[8 + i] = (command->value >> (8 * i)) & 0xff;
+	}
+}
+
+void command_unpack(const uint8_t* const data, command_t* const command)
+{
+	uint8_t i;
+
+	command->when = 0;
+	for (i = 0; i < 4; i++) {
+		command->when |= (uint32_t) data[i] << (8 * i);
+	}
+	command->type = data[4];
+	command->value = 0;
+	for (i = 0; i < 8; i++) {
+		command->value |= (uint64_t) data[8 + i] << (8 * i);
+	}
+}
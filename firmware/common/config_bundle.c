@@ -0,0 +1,81 @@
+/*
+ * Copyright 2026 Great Scott Gadgets <info@greatscottgadgets.com>
+ *
+ * This file is part of HackRF.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "config_bundle.h"
+#include "tuning_plan.h"
+
+static bool config_bundle_has(const config_bundle_t* const config, const uint8_t tag)
+{
+	return (config->present & (1 << tag)) != 0;
+}
+
+/*
+ * Each entry is a tag, a length and a little-endian value of that many
+ * bytes. Every entry is checked before anything is applied, so that a
+ * bundle is either rejected or applied in full.
+ */
+bool config_bundle_parse(
+	const uint8_t* const data,
+	const uint16_t length,
+	config_bundle_t* const config)
+{
+	const uint64_t* const values = config->values;
+	tuning_if_plan_t plan;
+	uint16_t i = 0;
+	uint8_t tag, size, j;
+	uint64_t value;
+
+	config->present = 0;
+	while (i < length) {
+		if ((length - i) < 2) {
+			return false;
+		}
+		tag = data[i++];
+		size = data[i++];
+		if ((tag == 0) || (tag >= CONFIG_TAG_COUNT) || (size == 0) ||
+		    (size > sizeof(value)) || (size > (length - i)) ||
+		    config_bundle_has(config, tag)) {
+			return false;
+		}
+		value = 0;
+		for (j = 0; j < size; j++) {
+			value |= (uint64_t) data[i++] << (8 * j);
+		}
+		config->present |= 1 << tag;
+		config->values[tag] = value;
+	}
+
+	if ((config_bundle_has(config, CONFIG_TAG_FREQ) &&
+	     !tuning_if_plan(values[CONFIG_TAG_FREQ], &plan)) ||
+	    (config_bundle_has(config, CONFIG_TAG_BASEBAND_FILTER) &&
+	     (values[CONFIG_TAG_BASEBAND_FILTER] > UINT32_MAX)) ||
+	    (config_bundle_has(config, CONFIG_TAG_LNA_GAIN) &&
+	     ((values[CONFIG_TAG_LNA_GAIN] > 40) || (values[CONFIG_TAG_LNA_GAIN] % 8))) ||
+	    (config_bundle_has(config, CONFIG_TAG_VGA_GAIN) &&
+	     ((values[CONFIG_TAG_VGA_GAIN] > 62) || (values[CONFIG_TAG_VGA_GAIN] % 2))) ||
+	    (config_bundle_has(config, CONFIG_TAG_TXVGA_GAIN) &&
+	     (values[CONFIG_TAG_TXVGA_GAIN] > 47)) ||
+	    (config_bundle_has(config, CONFIG_TAG_AMP_ENABLE) &&
+	     (values[CONFIG_TAG_AMP_ENABLE] > 1))) {
+		return false;
+	}
+	return true;
+}
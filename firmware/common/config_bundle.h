@@ -0,0 +1,54 @@
+/*
+ * Copyright 2026 Great Scott Gadgets <info@greatscottgadgets.com>
+ *
+ * This file is part of HackRF.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __CONFIG_BUNDLE_H__
+#define __CONFIG_BUNDLE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Parsing and range checking for the apply_config request, which
+ * changes several settings at once. Applying them is left to the caller.
+ */
+
+#define CONFIG_BUNDLE_MAX_LENGTH 64
+
+#define CONFIG_TAG_FREQ            1
+#define CONFIG_TAG_BASEBAND_FILTER 2
+#define CONFIG_TAG_LNA_GAIN        3
+#define CONFIG_TAG_VGA_GAIN        4
+#define CONFIG_TAG_TXVGA_GAIN      5
+#define CONFIG_TAG_AMP_ENABLE      6
+#define CONFIG_TAG_COUNT           7
+
+typedef struct {
+	/* Bit n is set if the entry with tag n was given. */
+	uint8_t present;
+	uint64_t values[CONFIG_TAG_COUNT];
+} config_bundle_t;
+
+bool config_bundle_parse(
+	const uint8_t* const data,
+	const uint16_t length,
+	config_bundle_t* const config);
+
+#endif /*__CONFIG_BUNDLE_H__*/
@@ -172,6 +172,12 @@ si5351c_driver_t clock_gen = {
 	.i2c_address = 0x60,
 };
 
+static const ssp_select_pin_t ssp_select_max283x = {
+	.pin = SCU_XCVR_CS,
+	.ssel_conf = SCU_SSP_IO | SCU_CONF_FUNCTION1,
+	.gpio_conf = SCU_GPIO_FAST,
+};
+
 const ssp_config_t ssp_config_max283x = {
 	/* FIXME speed up once everything is working reliably */
 	/*
@@ -184,6 +190,7 @@ const ssp_config_t ssp_config_max283x = {
 	.serial_clock_rate = 21,
 	.clock_prescale_rate = 2,
 	.gpio_select = &gpio_max283x_select,
+	.select_pin = &ssp_select_max283x,
 };
 
 const ssp_config_t ssp_config_max5864 = {
@@ -207,6 +214,7 @@ spi_bus_t spi_bus_ssp1 = {
 	.stop = spi_ssp_stop,
 	.transfer = spi_ssp_transfer,
 	.transfer_gather = spi_ssp_transfer_gather,
+	.transfer_frames = spi_ssp_transfer_frames,
 };
 
 max283x_driver_t max283x = {};
@@ -249,6 +249,9 @@ typedef enum {
 	TRANSCEIVER_MODE_SS = 3,
 	TRANSCEIVER_MODE_CPLD_UPDATE = 4,
 	TRANSCEIVER_MODE_RX_SWEEP = 5,
+	TRANSCEIVER_MODE_SPIFLASH_PROGRAM = 6,
+	TRANSCEIVER_MODE_RX_HOP = 7,
+	TRANSCEIVER_MODE_TX_HOP = 8,
 } transceiver_mode_t;
 
 typedef enum {
@@ -0,0 +1,85 @@
+/*
+ * Copyright 2026 Great Scott Gadgets <info@greatscottgadgets.com>
+ *
+ * This file is part of HackRF.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "hop_schedule.h"
+
+#include "command_queue.h"
+
+static void hop_schedule_arm_boundary(
+	hop_schedule_t* const schedule,
+	const uint32_t start,
+	const uint32_t now,
+	const uint32_t dwell)
+{
+	const uint32_t end = start + dwell * 2;
+
+	schedule->boundary = command_arm_position(end, now);
+	if (schedule->boundary != end) {
+		schedule->late = true;
+	}
+	schedule->resuming = false;
+}
+
+/*
+ * Set the end of the first dwell, which starts at position 0. Call once
+ * the M0 count has been reset. The gap is in bytes, the dwell in samples.
+ */
+void hop_schedule_start(
+	hop_schedule_t* const schedule,
+	const uint32_t gap,
+	const uint32_t dwell)
+{
+	schedule->gap = gap;
+	schedule->late = false;
+	hop_schedule_arm_boundary(schedule, 0, 0, dwell);
+}
+
+/*
+ * Advance the schedule once the M0 count has reached now. dwell is the
+ * dwell in samples of the entry being resumed, which is only used once
+ * a gap has ended.
+ */
+hop_step_t hop_schedule_step(
+	hop_schedule_t* const schedule,
+	const uint32_t now,
+	const uint32_t dwell)
+{
+	uint32_t end;
+
+	if (schedule->resuming) {
+		if ((int32_t) (now - schedule->resume) < 0) {
+			return HOP_STEP_NONE;
+		}
+		hop_schedule_arm_boundary(schedule, schedule->resume, now, dwell);
+		return HOP_STEP_DWELL;
+	}
+	if ((int32_t) (now - schedule->boundary) < 0) {
+		return HOP_STEP_NONE;
+	}
+
+	end = schedule->boundary + schedule->gap;
+	schedule->resume = command_arm_position(end, now);
+	if (schedule->resume != end) {
+		schedule->late = true;
+	}
+	schedule->resuming = true;
+	return HOP_STEP_GAP;
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright 2026 Great Scott Gadgets <info@greatscottgadgets.com>
+ *
+ * This file is part of HackRF.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __HOP_SCHEDULE_H__
+#define __HOP_SCHEDULE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Stream positions of the dwells and gaps in hop mode. The M4 hands each
+ * position to the M0, which switches modes when its byte count reaches
+ * it: to the gap mode at the end of a dwell, and back to RX or TX at the
+ * end of a gap. Positions follow from the table alone unless the M4 is
+ * too late to arm one, in which case it and all later positions move.
+ */
+typedef struct {
+	/* Bytes skipped at each hop while retuning. */
+	uint32_t gap;
+	/* Position of the end of the current dwell. */
+	uint32_t boundary;
+	/* Position of the end of the current gap. */
+	uint32_t resume;
+	/* Set while the M0 is in a gap, waiting for its end. */
+	bool resuming;
+	/* Set if a position is later than the table gives. */
+	bool late;
+} hop_schedule_t;
+
+typedef enum {
+	HOP_STEP_NONE = 0,
+	/*
+	 * The M0 has reached the end of a dwell, and is to resume at
+	 * resume. The M4 now retunes to the next entry.
+	 */
+	HOP_STEP_GAP = 1,
+	/* The M0 has resumed, and is to stop again at boundary. */
+	HOP_STEP_DWELL = 2,
+} hop_step_t;
+
+void hop_schedule_start(
+	hop_schedule_t* const schedule,
+	const uint32_t gap,
+	const uint32_t dwell);
+hop_step_t hop_schedule_step(
+	hop_schedule_t* const schedule,
+	const uint32_t now,
+	const uint32_t dwell);
+
+#endif /*__HOP_SCHEDULE_H__*/
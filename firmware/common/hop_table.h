@@ -0,0 +1,79 @@
+/*
+ * Copyright 2026 Great Scott Gadgets <info@greatscottgadgets.com>
+ *
+ * This file is part of HackRF.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __HOP_TABLE_H__
+#define __HOP_TABLE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Hop table entries, and the tags the firmware inserts into the RX stream
+ * to mark where each hop took effect.
+ */
+
+#define HOP_TABLE_MAX_ENTRIES 128
+
+/* Sizes of a packed entry and tag. */
+#define HOP_ENTRY_SIZE 16
+#define HOP_TAG_SIZE   32
+
+/* Gain value that leaves the gain as it is. */
+#define HOP_GAIN_UNCHANGED 0xff
+
+/*
+ * Dwells and gaps are counted in samples of two bytes. They must be
+ * whole multiples of the M0's 32 byte transfers. The minimum, one USB
+ * transfer or 410us at 20Msps, leaves time for a retune without a tuning
+ * table entry and for the synthesizers to lock, as well as for the M4 to
+ * arm the next mode switch.
+ */
+#define HOP_SAMPLE_ALIGNMENT 16
+#define HOP_MIN_SAMPLES      8192
+
+#define HOP_TAG_FLAG_LATE (1 << 0)
+
+typedef struct {
+	uint64_t freq;
+	uint32_t dwell;
+	uint8_t lna_gain;
+	uint8_t vga_gain;
+	uint8_t txvga_gain;
+} hop_entry_t;
+
+typedef struct {
+	uint64_t freq;
+	/* Number of times the table has been completed. */
+	uint32_t cycle;
+	uint16_t index;
+	uint16_t flags;
+	/* M0 count of the first sample at the new frequency. */
+	uint32_t resume;
+} hop_tag_t;
+
+bool hop_samples_valid(const uint32_t samples);
+bool hop_entry_valid(const hop_entry_t* const entry);
+void hop_entry_pack(const hop_entry_t* const entry, uint8_t* const data);
+void hop_entry_unpack(const uint8_t* const data, hop_entry_t* const entry);
+void hop_tag_pack(const hop_tag_t* const tag, uint8_t* const data);
+bool hop_tag_unpack(const uint8_t* const data, hop_tag_t* const tag);
+
+#endif /*__HOP_TABLE_H__*/
@@ -153,14 +153,25 @@ static inline void max2837_reg_commit(max2837_driver_t* const drv, uint8_t r)
 	max2837_reg_write(drv, r, drv->regs[r]);
 }
 
+/*
+ * Dirty registers are written in one batch, in register order, with chip
+ * select raised between words to latch each one.
+ */
 void max2837_regs_commit(max2837_driver_t* const drv)
 {
+	uint16_t words[MAX2837_NUM_REGS];
+	size_t count = 0;
 	int r;
+
 	for (r = 0; r < MAX2837_NUM_REGS; r++) {
 		if ((drv->regs_dirty >> r) & 0x1) {
-			max2837_reg_commit(drv, r);
+			words[count++] = (r << 10) | (drv->regs[r] & 0x3ff);
+			MAX2837_REG_SET_CLEAN(drv, r);
 		}
 	}
+	if (count > 0) {
+		spi_bus_transfer_frames(drv->bus, words, count);
+	}
 }
 
 void max2837_set_mode(max2837_driver_t* const drv, const max2837_mode_t new_mode)
@@ -203,56 +214,30 @@ void max2837_stop(max2837_driver_t* const drv)
 
 void max2837_set_frequency(max2837_driver_t* const drv, uint32_t freq)
 {
-	uint8_t band;
-	uint8_t lna_band;
-	uint32_t div_frac;
-	uint32_t div_int;
-	uint32_t div_rem;
-	uint32_t div_cmp;
-	int i;
-
-	/* Select band. Allow tuning outside specified bands. */
-	if (freq < 2400000000U) {
-		band = MAX2837_LOGEN_BSW_2_3;
-		lna_band = MAX2837_LNAband_2_4;
-	} else if (freq < 2500000000U) {
-		band = MAX2837_LOGEN_BSW_2_4;
-		lna_band = MAX2837_LNAband_2_4;
-	} else if (freq < 2600000000U) {
-		band = MAX2837_LOGEN_BSW_2_5;
-		lna_band = MAX2837_LNAband_2_6;
-	} else {
-		band = MAX2837_LOGEN_BSW_2_6;
-		lna_band = MAX2837_LNAband_2_6;
-	}
+	max283x_synth_t synth;
 
-	/* ASSUME 40MHz PLL. Ratio = F*(4/3)/40,000,000 = F/30,000,000 */
-	div_int = freq / 30000000;
-	div_rem = freq % 30000000;
-	div_frac = 0;
-	div_cmp = 30000000;
-	for (i = 0; i < 20; i++) {
-		div_frac <<= 1;
-		div_cmp >>= 1;
-		if (div_rem > div_cmp) {
-			div_frac |= 0x1;
-			div_rem -= div_cmp;
-		}
-	}
+	max283x_synth_plan(freq, &synth);
+	max2837_set_synth(drv, &synth);
+}
 
+void max2837_set_synth(max2837_driver_t* const drv, const max283x_synth_t* const synth)
+{
 	/* Band settings */
-	set_MAX2837_LOGEN_BSW(drv, band);
-	set_MAX2837_LNAband(drv, lna_band);
+	set_MAX2837_LOGEN_BSW(drv, synth->band);
+	set_MAX2837_LNAband(
+		drv,
+		(synth->band < MAX2837_LOGEN_BSW_2_5) ? MAX2837_LNAband_2_4 :
+							 MAX2837_LNAband_2_6);
 
 	/* Write order matters here, so commit INT and FRAC_HI before
 	 * committing FRAC_LO, which is the trigger for VCO
 	 * auto-select. TODO - it's cleaner this way, but it would be
 	 * faster to explicitly commit the registers explicitly so the
 	 * dirty bits aren't scanned twice. */
-	set_MAX2837_SYN_INT(drv, div_int);
-	set_MAX2837_SYN_FRAC_HI(drv, (div_frac >> 10) & 0x3ff);
+	set_MAX2837_SYN_INT(drv, synth->n);
+	set_MAX2837_SYN_FRAC_HI(drv, (synth->frac >> 10) & 0x3ff);
 	max2837_regs_commit(drv);
-	set_MAX2837_SYN_FRAC_LO(drv, div_frac & 0x3ff);
+	set_MAX2837_SYN_FRAC_LO(drv, synth->frac & 0x3ff);
 	max2837_regs_commit(drv);
 }
 
@@ -300,7 +285,7 @@ uint32_t max2837_set_lpf_bandwidth(max2837_driver_t* const drv, const uint32_t b
 	return p->bandwidth_hz;
 }
 
-bool max2837_set_lna_gain(max2837_driver_t* const drv, const uint32_t gain_db) {
+bool max2837_stage_lna_gain(max2837_driver_t* const drv, const uint32_t gain_db) {
 	uint16_t val;
 	switch(gain_db){
 		case 40:
@@ -325,21 +310,37 @@ bool max2837_set_lna_gain(max2837_driver_t* const drv, const uint32_t gain_db) {
 			return false;
 	}
 	set_MAX2837_LNAgain(drv, val);
+	return true;
+}
+
+bool max2837_set_lna_gain(max2837_driver_t* const drv, const uint32_t gain_db)
+{
+	if (!max2837_stage_lna_gain(drv, gain_db)) {
+		return false;
+	}
 	max2837_reg_commit(drv, 1);
 	return true;
 }
 
-bool max2837_set_vga_gain(max2837_driver_t* const drv, const uint32_t gain_db) {
+bool max2837_stage_vga_gain(max2837_driver_t* const drv, const uint32_t gain_db) {
 	if( (gain_db & 0x1) || gain_db > 62) {/* 0b11111*2 */
 		return false;
 }
 		
 	set_MAX2837_VGA(drv, 31-(gain_db >> 1) );
+	return true;
+}
+
+bool max2837_set_vga_gain(max2837_driver_t* const drv, const uint32_t gain_db)
+{
+	if (!max2837_stage_vga_gain(drv, gain_db)) {
+		return false;
+	}
 	max2837_reg_commit(drv, 5);
 	return true;
 }
 
-bool max2837_set_txvga_gain(max2837_driver_t* const drv, const uint32_t gain_db) {
+bool max2837_stage_txvga_gain(max2837_driver_t* const drv, const uint32_t gain_db) {
 	uint16_t val=0;
 	if(gain_db <16){
 		val = 31-gain_db;
@@ -349,6 +350,14 @@ bool max2837_set_txvga_gain(max2837_driver_t* const drv, const uint32_t gain_db)
 	}
 	
 	set_MAX2837_TXVGA_GAIN(drv, val);
+	return true;
+}
+
+bool max2837_set_txvga_gain(max2837_driver_t* const drv, const uint32_t gain_db)
+{
+	if (!max2837_stage_txvga_gain(drv, gain_db)) {
+		return false;
+	}
 	max2837_reg_commit(drv, 29);
 	return true;
 }
@@ -29,6 +29,7 @@
 
 #include "gpio.h"
 #include "spi_bus.h"
+#include "tuning_plan.h"
 
 /* 32 registers, each containing 10 bits of data. */
 #define MAX2837_NUM_REGS            32
@@ -82,6 +83,9 @@ extern void max2837_stop(max2837_driver_t* const drv);
 /* Set frequency in Hz. Frequency setting is a multi-step function
  * where order of register writes matters. */
 extern void max2837_set_frequency(max2837_driver_t* const drv, uint32_t freq);
+extern void max2837_set_synth(
+	max2837_driver_t* const drv,
+	const max283x_synth_t* const synth);
 uint32_t max2837_set_lpf_bandwidth(
 	max2837_driver_t* const drv,
 	const uint32_t bandwidth_hz);
@@ -89,6 +93,12 @@ bool max2837_set_lna_gain(max2837_driver_t* const drv, const uint32_t gain_db);
 bool max2837_set_vga_gain(max2837_driver_t* const drv, const uint32_t gain_db);
 bool max2837_set_txvga_gain(max2837_driver_t* const drv, const uint32_t gain_db);
 
+/* Update the gain registers in memory only. They are written by the next
+ * max2837_regs_commit(). */
+bool max2837_stage_lna_gain(max2837_driver_t* const drv, const uint32_t gain_db);
+bool max2837_stage_vga_gain(max2837_driver_t* const drv, const uint32_t gain_db);
+bool max2837_stage_txvga_gain(max2837_driver_t* const drv, const uint32_t gain_db);
+
 extern void max2837_tx(max2837_driver_t* const drv);
 extern void max2837_rx(max2837_driver_t* const drv);
 
@@ -162,14 +162,25 @@ static inline void max2839_reg_commit(max2839_driver_t* const drv, uint8_t r)
 	max2839_reg_write(drv, r, drv->regs[r]);
 }
 
+/*
+ * Dirty registers are written in one batch, in register order, with chip
+ * select raised between words to latch each one.
+ */
 void max2839_regs_commit(max2839_driver_t* const drv)
 {
+	uint16_t words[MAX2839_NUM_REGS];
+	size_t count = 0;
 	int r;
+
 	for (r = 0; r < MAX2839_NUM_REGS; r++) {
 		if ((drv->regs_dirty >> r) & 0x1) {
-			max2839_reg_commit(drv, r);
+			words[count++] = (r << 10) | (drv->regs[r] & 0x3ff);
+			MAX2839_REG_SET_CLEAN(drv, r);
 		}
 	}
+	if (count > 0) {
+		spi_bus_transfer_frames(drv->bus, words, count);
+	}
 }
 
 void max2839_set_mode(max2839_driver_t* const drv, const max2839_mode_t new_mode)
@@ -214,50 +225,26 @@ void max2839_stop(max2839_driver_t* const drv)
 
 void max2839_set_frequency(max2839_driver_t* const drv, uint32_t freq)
 {
-	uint8_t band;
-	uint32_t div_frac;
-	uint32_t div_int;
-	uint32_t div_rem;
-	uint32_t div_cmp;
-	int i;
-
-	/* Select band. Allow tuning outside specified bands. */
-	if (freq < 2400000000U) {
-		band = MAX2839_LOGEN_BSW_2_3;
-	} else if (freq < 2500000000U) {
-		band = MAX2839_LOGEN_BSW_2_4;
-	} else if (freq < 2600000000U) {
-		band = MAX2839_LOGEN_BSW_2_5;
-	} else {
-		band = MAX2839_LOGEN_BSW_2_6;
-	}
+	max283x_synth_t synth;
 
-	/* ASSUME 40MHz PLL. Ratio = F*(4/3)/40,000,000 = F/30,000,000 */
-	div_int = freq / 30000000;
-	div_rem = freq % 30000000;
-	div_frac = 0;
-	div_cmp = 30000000;
-	for (i = 0; i < 20; i++) {
-		div_frac <<= 1;
-		div_cmp >>= 1;
-		if (div_rem > div_cmp) {
-			div_frac |= 0x1;
-			div_rem -= div_cmp;
-		}
-	}
+	max283x_synth_plan(freq, &synth);
+	max2839_set_synth(drv, &synth);
+}
 
+void max2839_set_synth(max2839_driver_t* const drv, const max283x_synth_t* const synth)
+{
 	/* Band settings */
-	set_MAX2839_LOGEN_BSW(drv, band);
+	set_MAX2839_LOGEN_BSW(drv, synth->band);
 
 	/* Write order matters here, so commit INT and FRAC_HI before
 	 * committing FRAC_LO, which is the trigger for VCO
 	 * auto-select. TODO - it's cleaner this way, but it would be
 	 * faster to explicitly commit the registers explicitly so the
 	 * dirty bits aren't scanned twice. */
-	set_MAX2839_SYN_INT(drv, div_int);
-	set_MAX2839_SYN_FRAC_HI(drv, (div_frac >> 10) & 0x3ff);
+	set_MAX2839_SYN_INT(drv, synth->n);
+	set_MAX2839_SYN_FRAC_HI(drv, (synth->frac >> 10) & 0x3ff);
 	max2839_regs_commit(drv);
-	set_MAX2839_SYN_FRAC_LO(drv, div_frac & 0x3ff);
+	set_MAX2839_SYN_FRAC_LO(drv, synth->frac & 0x3ff);
 	max2839_regs_commit(drv);
 }
 
@@ -305,7 +292,7 @@ uint32_t max2839_set_lpf_bandwidth(max2839_driver_t* const drv, const uint32_t b
 	return p->bandwidth_hz;
 }
 
-void max2839_configure_rx_gain(max2839_driver_t* const drv)
+static void max2839_stage_rx_gain(max2839_driver_t* const drv)
 {
 	/*
 	 * restrict requested LNA gain to valid MAX2837 settings:
@@ -383,35 +370,60 @@ void max2839_configure_rx_gain(max2839_driver_t* const drv)
 	}
 	set_MAX2839_LNA2gain(drv, val);
 	set_MAX2839_Rx2_VGAgain(drv, (63 - vga_gain));
-	max2839_regs_commit(drv);
 }
 
-bool max2839_set_lna_gain(max2839_driver_t* const drv, const uint32_t gain_db)
+bool max2839_stage_lna_gain(max2839_driver_t* const drv, const uint32_t gain_db)
 {
 	if ((gain_db & 0x7) || gain_db > 40) {
 		return false;
 	}
 	requested_lna_gain = gain_db;
-	max2839_configure_rx_gain(drv);
+	max2839_stage_rx_gain(drv);
 	return true;
 }
 
-bool max2839_set_vga_gain(max2839_driver_t* const drv, const uint32_t gain_db)
+bool max2839_set_lna_gain(max2839_driver_t* const drv, const uint32_t gain_db)
+{
+	if (!max2839_stage_lna_gain(drv, gain_db)) {
+		return false;
+	}
+	max2839_regs_commit(drv);
+	return true;
+}
+
+bool max2839_stage_vga_gain(max2839_driver_t* const drv, const uint32_t gain_db)
 {
 	if ((gain_db & 0x1) || gain_db > 62) {
 		return false;
 	}
 	requested_vga_gain = gain_db;
-	max2839_configure_rx_gain(drv);
+	max2839_stage_rx_gain(drv);
 	return true;
 }
 
-bool max2839_set_txvga_gain(max2839_driver_t* const drv, const uint32_t gain_db)
+bool max2839_set_vga_gain(max2839_driver_t* const drv, const uint32_t gain_db)
+{
+	if (!max2839_stage_vga_gain(drv, gain_db)) {
+		return false;
+	}
+	max2839_regs_commit(drv);
+	return true;
+}
+
+bool max2839_stage_txvga_gain(max2839_driver_t* const drv, const uint32_t gain_db)
 {
 	uint16_t val = 0;
 	val = 47 - gain_db;
 
 	set_MAX2839_TX_VGA_GAIN(drv, val);
+	return true;
+}
+
+bool max2839_set_txvga_gain(max2839_driver_t* const drv, const uint32_t gain_db)
+{
+	if (!max2839_stage_txvga_gain(drv, gain_db)) {
+		return false;
+	}
 	max2839_reg_commit(drv, 29);
 	return true;
 }
@@ -29,6 +29,7 @@
 
 #include "gpio.h"
 #include "spi_bus.h"
+#include "tuning_plan.h"
 
 /* 32 registers, each containing 10 bits of data. */
 #define MAX2839_NUM_REGS            32
@@ -84,6 +85,9 @@ extern void max2839_stop(max2839_driver_t* const drv);
 /* Set frequency in Hz. Frequency setting is a multi-step function
  * where order of register writes matters. */
 extern void max2839_set_frequency(max2839_driver_t* const drv, uint32_t freq);
+extern void max2839_set_synth(
+	max2839_driver_t* const drv,
+	const max283x_synth_t* const synth);
 uint32_t max2839_set_lpf_bandwidth(
 	max2839_driver_t* const drv,
 	const uint32_t bandwidth_hz);
@@ -91,6 +95,12 @@ bool max2839_set_lna_gain(max2839_driver_t* const drv, const uint32_t gain_db);
 bool max2839_set_vga_gain(max2839_driver_t* const drv, const uint32_t gain_db);
 bool max2839_set_txvga_gain(max2839_driver_t* const drv, const uint32_t gain_db);
 
+/* Update the gain registers in memory only. They are written by the next
+ * max2839_regs_commit(). */
+bool max2839_stage_lna_gain(max2839_driver_t* const drv, const uint32_t gain_db);
+bool max2839_stage_vga_gain(max2839_driver_t* const drv, const uint32_t gain_db);
+bool max2839_stage_txvga_gain(max2839_driver_t* const drv, const uint32_t gain_db);
+
 extern void max2839_tx(max2839_driver_t* const drv);
 extern void max2839_rx(max2839_driver_t* const drv);
 
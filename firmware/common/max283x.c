@@ -191,6 +191,19 @@ void max283x_set_frequency(max283x_driver_t* const drv, uint32_t freq)
 	}
 }
 
+void max283x_set_synth(max283x_driver_t* const drv, const max283x_synth_t* const synth)
+{
+	switch (drv->type) {
+	case MAX2837_VARIANT:
+		max2837_set_synth(&drv->drv.max2837, synth);
+		break;
+
+	case MAX2839_VARIANT:
+		max2839_set_synth(&drv->drv.max2839, synth);
+		break;
+	}
+}
+
 uint32_t max283x_set_lpf_bandwidth(
 	max283x_driver_t* const drv,
 	const uint32_t bandwidth_hz)
@@ -253,6 +266,51 @@ bool max283x_set_txvga_gain(max283x_driver_t* const drv, const uint32_t gain_db)
 	return false;
 }
 
+bool max283x_stage_lna_gain(max283x_driver_t* const drv, const uint32_t gain_db)
+{
+	switch (drv->type) {
+	case MAX2837_VARIANT:
+		return max2837_stage_lna_gain(&drv->drv.max2837, gain_db);
+		break;
+
+	case MAX2839_VARIANT:
+		return max2839_stage_lna_gain(&drv->drv.max2839, gain_db);
+		break;
+	}
+
+	return false;
+}
+
+bool max283x_stage_vga_gain(max283x_driver_t* const drv, const uint32_t gain_db)
+{
+	switch (drv->type) {
+	case MAX2837_VARIANT:
+		return max2837_stage_vga_gain(&drv->drv.max2837, gain_db);
+		break;
+
+	case MAX2839_VARIANT:
+		return max2839_stage_vga_gain(&drv->drv.max2839, gain_db);
+		break;
+	}
+
+	return false;
+}
+
+bool max283x_stage_txvga_gain(max283x_driver_t* const drv, const uint32_t gain_db)
+{
+	switch (drv->type) {
+	case MAX2837_VARIANT:
+		return max2837_stage_txvga_gain(&drv->drv.max2837, gain_db);
+		break;
+
+	case MAX2839_VARIANT:
+		return max2839_stage_txvga_gain(&drv->drv.max2839, gain_db);
+		break;
+	}
+
+	return false;
+}
+
 void max283x_tx(max283x_driver_t* const drv)
 {
 	switch (drv->type) {
@@ -86,6 +86,7 @@ void max283x_stop(max283x_driver_t* const drv);
 /* Set frequency in Hz. Frequency setting is a multi-step function
  * where order of register writes matters. */
 void max283x_set_frequency(max283x_driver_t* const drv, uint32_t freq);
+void max283x_set_synth(max283x_driver_t* const drv, const max283x_synth_t* const synth);
 uint32_t max283x_set_lpf_bandwidth(
 	max283x_driver_t* const drv,
 	const uint32_t bandwidth_hz);
@@ -95,6 +96,12 @@ bool max283x_set_lna_gain(max283x_driver_t* const drv, const uint32_t gain_db);
 bool max283x_set_vga_gain(max283x_driver_t* const drv, const uint32_t gain_db);
 bool max283x_set_txvga_gain(max283x_driver_t* const drv, const uint32_t gain_db);
 
+/* Set gains in memory only, so that several settings can be written by
+ * one max283x_regs_commit(). */
+bool max283x_stage_lna_gain(max283x_driver_t* const drv, const uint32_t gain_db);
+bool max283x_stage_vga_gain(max283x_driver_t* const drv, const uint32_t gain_db);
+bool max283x_stage_txvga_gain(max283x_driver_t* const drv, const uint32_t gain_db);
+
 void max283x_tx(max283x_driver_t* const drv);
 void max283x_rx(max283x_driver_t* const drv);
 
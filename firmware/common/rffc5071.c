@@ -216,64 +216,52 @@ void rffc5071_enable(rffc5071_driver_t* const drv)
 	rffc5071_regs_commit(drv);
 }
 
-#define LO_MAX       5400
-#define REF_FREQ     40
-#define FREQ_ONE_MHZ (1000 * 1000)
-
 /* configure frequency synthesizer in integer mode (lo in MHz) */
 uint64_t rffc5071_config_synth_int(rffc5071_driver_t* const drv, uint16_t lo)
 {
-	uint8_t lodiv;
-	uint16_t fvco;
-	uint8_t fbkdiv;
-	uint16_t n;
+	rffc5071_synth_t synth;
 	uint64_t tune_freq_hz;
-	uint16_t p1nmsb;
-	uint8_t p1nlsb;
-
-	/* Calculate n_lo */
-	uint8_t n_lo = 0;
-	uint16_t x = LO_MAX / lo;
-	while ((x > 1) && (n_lo < 5)) {
-		n_lo++;
-		x >>= 1;
-	}
 
-	lodiv = 1 << n_lo;
-	fvco = lodiv * lo;
-
-	/* higher divider and charge pump current required above
-	 * 3.2GHz. Programming guide says these values (fbkdiv, n,
-	 * maybe pump?) can be changed back after enable in order to
-	 * improve phase noise, since the VCO will already be stable
-	 * and will be unaffected. */
-	if (fvco > 3200) {
-		fbkdiv = 4;
-		set_RFFC5071_PLLCPL(drv, 3);
-	} else {
-		fbkdiv = 2;
-		set_RFFC5071_PLLCPL(drv, 2);
-	}
+	tune_freq_hz = rffc5071_synth_plan(lo, &synth);
+	rffc5071_config_synth(drv, &synth);
 
-	uint64_t tmp_n = ((uint64_t) fvco << 29ULL) / (fbkdiv * REF_FREQ);
-	n = tmp_n >> 29ULL;
-
-	p1nmsb = (tmp_n >> 13ULL) & 0xffff;
-	p1nlsb = (tmp_n >> 5ULL) & 0xff;
+	return tune_freq_hz;
+}
 
-	tune_freq_hz = (REF_FREQ * (tmp_n >> 5ULL) * fbkdiv * FREQ_ONE_MHZ) /
-		(lodiv * (1 << 24ULL));
+/* program precomputed synthesizer settings into path 2 */
+void rffc5071_config_synth(
+	rffc5071_driver_t* const drv,
+	const rffc5071_synth_t* const synth)
+{
+	set_RFFC5071_PLLCPL(drv, synth->pllcpl);
 
 	/* Path 2 */
-	set_RFFC5071_P2LODIV(drv, n_lo);
-	set_RFFC5071_P2N(drv, n);
-	set_RFFC5071_P2PRESC(drv, fbkdiv >> 1);
-	set_RFFC5071_P2NMSB(drv, p1nmsb);
-	set_RFFC5071_P2NLSB(drv, p1nlsb);
+	set_RFFC5071_P2LODIV(drv, synth->lodiv);
+	set_RFFC5071_P2N(drv, synth->n);
+	set_RFFC5071_P2PRESC(drv, synth->presc);
+	set_RFFC5071_P2NMSB(drv, synth->nmsb);
+	set_RFFC5071_P2NLSB(drv, synth->nlsb);
 
 	rffc5071_regs_commit(drv);
+}
 
-	return tune_freq_hz;
+/*
+ * The cached values of the path 2 synthesizer registers match the chip
+ * unless they are dirty, so a retune to the same settings can be skipped.
+ */
+bool rffc5071_synth_programmed(
+	rffc5071_driver_t* const drv,
+	const rffc5071_synth_t* const synth)
+{
+	const uint32_t synth_regs = (1UL << 0) | (1UL << 15) | (1UL << 16) | (1UL << 17);
+
+	return ((drv->regs_dirty & synth_regs) == 0) &&
+		(get_RFFC5071_PLLCPL(drv) == synth->pllcpl) &&
+		(get_RFFC5071_P2LODIV(drv) == synth->lodiv) &&
+		(get_RFFC5071_P2N(drv) == synth->n) &&
+		(get_RFFC5071_P2PRESC(drv) == synth->presc) &&
+		(get_RFFC5071_P2NMSB(drv) == synth->nmsb) &&
+		(get_RFFC5071_P2NLSB(drv) == synth->nlsb);
 }
 
 /* !!!!!!!!!!! hz is currently ignored !!!!!!!!!!! */
@@ -288,6 +276,13 @@ uint64_t rffc5071_set_frequency(rffc5071_driver_t* const drv, uint16_t mhz)
 	return tune_freq;
 }
 
+void rffc5071_set_synth(rffc5071_driver_t* const drv, const rffc5071_synth_t* const synth)
+{
+	rffc5071_disable(drv);
+	rffc5071_config_synth(drv, synth);
+	rffc5071_enable(drv);
+}
+
 void rffc5071_set_gpo(rffc5071_driver_t* const drv, uint8_t gpo)
 {
 	/* We set GPO for both paths just in case. */
@@ -27,6 +27,7 @@
 
 #include "spi_bus.h"
 #include "gpio.h"
+#include "tuning_plan.h"
 
 /* 31 registers, each containing 16 bits of data. */
 #define RFFC5071_NUM_REGS 31
@@ -57,6 +58,20 @@ extern void rffc5071_regs_commit(rffc5071_driver_t* const drv);
 
 /* Set frequency (MHz). */
 extern uint64_t rffc5071_set_frequency(rffc5071_driver_t* const drv, uint16_t mhz);
+extern uint64_t rffc5071_config_synth_int(rffc5071_driver_t* const drv, uint16_t lo);
+
+/* Set frequency from settings computed by rffc5071_synth_plan(). */
+extern void rffc5071_set_synth(
+	rffc5071_driver_t* const drv,
+	const rffc5071_synth_t* const synth);
+extern void rffc5071_config_synth(
+	rffc5071_driver_t* const drv,
+	const rffc5071_synth_t* const synth);
+
+/* True if the chip already holds these settings, per the register cache. */
+extern bool rffc5071_synth_programmed(
+	rffc5071_driver_t* const drv,
+	const rffc5071_synth_t* const synth);
 
 /* Set up rx only, tx only, or full duplex. Chip should be disabled
  * before _tx, _rx, or _rxtx are called. */
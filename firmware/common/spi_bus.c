@@ -44,3 +44,12 @@ void spi_bus_transfer_gather(
 {
 	bus->transfer_gather(bus, transfers, count);
 }
+
+/*
+ * Transfer count words, each as a separate transaction: the device is
+ * deselected between words, but the bus is not restarted for each one.
+ */
+void spi_bus_transfer_frames(spi_bus_t* const bus, void* const data, const size_t count)
+{
+	bus->transfer_frames(bus, data, count);
+}
@@ -43,6 +43,10 @@ struct spi_bus_t {
 		spi_bus_t* const bus,
 		const spi_transfer_t* const transfers,
 		const size_t count);
+	void (*transfer_frames)(
+		spi_bus_t* const bus,
+		void* const data,
+		const size_t count);
 };
 
 void spi_bus_start(spi_bus_t* const bus, const void* const config);
@@ -52,5 +56,6 @@ void spi_bus_transfer_gather(
 	spi_bus_t* const bus,
 	const spi_transfer_t* const transfers,
 	const size_t count);
+void spi_bus_transfer_frames(spi_bus_t* const bus, void* const data, const size_t count);
 
 #endif /*__SPI_BUS_H__*/
@@ -23,8 +23,11 @@
 #include "spi_ssp.h"
 
 #include <libopencm3/lpc43xx/rgu.h>
+#include <libopencm3/lpc43xx/scu.h>
 #include <libopencm3/lpc43xx/ssp.h>
 
+#define SSP_FIFO_DEPTH 8
+
 void spi_ssp_start(spi_bus_t* const bus, const void* const _config)
 {
 	const ssp_config_t* const config = _config;
@@ -111,3 +114,52 @@ void spi_ssp_transfer(spi_bus_t* const bus, void* const data, const size_t count
 	};
 	spi_ssp_transfer_gather(bus, transfers, 1);
 }
+
+/*
+ * With CPHA = 0 the SSP returns SSEL high between consecutive words, so if
+ * the chip select pin can be handed over to it, the words are queued back
+ * to back through the FIFOs. Otherwise each word is sent on its own.
+ */
+void spi_ssp_transfer_frames(spi_bus_t* const bus, void* const data, const size_t count)
+{
+	const ssp_config_t* const config = bus->config;
+	const ssp_select_pin_t* const select = config->select_pin;
+
+	const bool word_size_u16 = (SSP_CR0(bus->obj) & 0xf) > SSP_DATA_8BITS;
+	const size_t word_size = word_size_u16 ? sizeof(uint16_t) : sizeof(uint8_t);
+
+	size_t sent = 0;
+	size_t received = 0;
+	uint32_t value;
+
+	if (select == NULL) {
+		for (size_t i = 0; i < count; i++) {
+			spi_ssp_transfer(bus, (uint8_t*) data + (i * word_size), 1);
+		}
+		return;
+	}
+
+	scu_pinmux(select->pin, select->ssel_conf);
+	while (received < count) {
+		if ((sent < count) && ((sent - received) < SSP_FIFO_DEPTH) &&
+		    (SSP_SR(bus->obj) & SSP_SR_TNF)) {
+			if (word_size_u16) {
+				SSP_DR(bus->obj) = ((uint16_t*) data)[sent];
+			} else {
+				SSP_DR(bus->obj) = ((uint8_t*) data)[sent];
+			}
+			sent++;
+		}
+		if (SSP_SR(bus->obj) & SSP_SR_RNE) {
+			value = SSP_DR(bus->obj);
+			if (word_size_u16) {
+				((uint16_t*) data)[received] = value;
+			} else {
+				((uint8_t*) data)[received] = value;
+			}
+			received++;
+		}
+	}
+	spi_ssp_wait_for_not_busy(bus);
+	scu_pinmux(select->pin, select->gpio_conf);
+}
@@ -30,13 +30,25 @@
 
 #include "gpio.h"
 
+#include <libopencm3/lpc43xx/scu.h>
 #include <libopencm3/lpc43xx/ssp.h>
 
+/*
+ * A chip select pin that can be switched from GPIO to the SSP's own SSEL
+ * output, which the SSP deasserts between words by itself.
+ */
+typedef struct ssp_select_pin_t {
+	scu_grp_pin_t pin;
+	uint32_t ssel_conf;
+	uint32_t gpio_conf;
+} ssp_select_pin_t;
+
 typedef struct ssp_config_t {
 	ssp_datasize_t data_bits;
 	uint8_t serial_clock_rate;
 	uint8_t clock_prescale_rate;
 	gpio_t gpio_select;
+	const ssp_select_pin_t* select_pin;
 } ssp_config_t;
 
 void spi_ssp_start(spi_bus_t* const bus, const void* const config);
@@ -46,5 +58,6 @@ void spi_ssp_transfer_gather(
 	spi_bus_t* const bus,
 	const spi_transfer_t* const transfers,
 	const size_t count);
+void spi_ssp_transfer_frames(spi_bus_t* const bus, void* const data, const size_t count);
 
 #endif /*__SPI_SSP_H__*/
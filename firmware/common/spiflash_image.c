@@ -0,0 +1,157 @@
+/*
+ * Copyright 2026 Great Scott Gadgets <info@greatscottgadgets.com>
+ *
+ * This file is part of HackRF.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "spiflash_image.h"
+
+#include <string.h>
+
+/* Buffer size == drv->page_len */
+static uint8_t spiflash_image_page[256U];
+
+/*
+ * Start an image of length bytes at addr, which must be on a sector
+ * boundary. Returns false if the image doesn't fit the flash.
+ */
+bool spiflash_image_init(
+	spiflash_image_t* const image,
+	w25q80bv_driver_t* const drv,
+	const uint32_t addr,
+	const uint32_t length)
+{
+	if ((addr % W25Q80BV_SECTOR_LEN) || (length == 0) || (addr >= drv->num_bytes) ||
+	    (length > (drv->num_bytes - addr))) {
+		return false;
+	}
+	image->drv = drv;
+	image->start = addr;
+	image->end = addr + length;
+	image->erased_end = addr;
+	crc32_init(&image->crc);
+	return true;
+}
+
+static uint32_t page_length(
+	const spiflash_image_t* const image,
+	const uint32_t offset,
+	const uint32_t length)
+{
+	return ((length - offset) > image->drv->page_len) ? image->drv->page_len :
+							   (length - offset);
+}
+
+static bool page_blank(const uint8_t* const data, const uint32_t length)
+{
+	uint32_t i;
+
+	for (i = 0; i < length; i++) {
+		if (data[i] != 0xff) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/*
+ * Write one sector of the image, or the end of it, unless the flash
+ * already holds the same data. When the first sector of a 64 KiB block has
+ * changed and the whole block is part of the image, the block is erased at
+ * once: the rest of a changed image usually differs too, and one block
+ * erase is much faster than sixteen sector erases.
+ */
+static void write_sector(
+	spiflash_image_t* const image,
+	const uint32_t addr,
+	uint8_t* const data,
+	const uint32_t length)
+{
+	uint32_t offset, page_len;
+	bool changed = false;
+
+	if (addr >= image->erased_end) {
+		for (offset = 0; (offset < length) && !changed; offset += page_len) {
+			page_len = page_length(image, offset, length);
+			w25q80bv_read(image->drv, addr + offset, page_len, spiflash_image_page);
+			changed = (memcmp(spiflash_image_page, &data[offset], page_len) != 0);
+		}
+		if (!changed) {
+			return;
+		}
+		if (((addr % W25Q80BV_BLOCK_LEN) == 0) &&
+		    ((image->end - addr) >= W25Q80BV_BLOCK_LEN)) {
+			w25q80bv_block_erase(image->drv, addr);
+			image->erased_end = addr + W25Q80BV_BLOCK_LEN;
+		} else {
+			w25q80bv_sector_erase(image->drv, addr);
+			image->erased_end = addr + W25Q80BV_SECTOR_LEN;
+		}
+	}
+
+	for (offset = 0; offset < length; offset += page_len) {
+		page_len = page_length(image, offset, length);
+		if (!page_blank(&data[offset], page_len)) {
+			w25q80bv_program(image->drv, addr + offset, page_len, &data[offset]);
+		}
+	}
+}
+
+/* Read a written sector back into the CRC. */
+static void read_back(
+	spiflash_image_t* const image,
+	const uint32_t addr,
+	const uint32_t length)
+{
+	uint32_t offset, page_len;
+
+	for (offset = 0; offset < length; offset += page_len) {
+		page_len = page_length(image, offset, length);
+		w25q80bv_read(image->drv, addr + offset, page_len, spiflash_image_page);
+		crc32_update(&image->crc, spiflash_image_page, page_len);
+	}
+}
+
+/*
+ * Write the next length bytes of the image, which start at addr. Pieces
+ * must be written in order, and all but the last must end on a sector
+ * boundary, since a sector is only compared and erased as a whole.
+ */
+void spiflash_image_write(
+	spiflash_image_t* const image,
+	const uint32_t addr,
+	uint8_t* const data,
+	const uint32_t length)
+{
+	uint32_t offset, sector_len;
+
+	for (offset = 0; offset < length; offset += sector_len) {
+		sector_len = W25Q80BV_SECTOR_LEN - ((addr + offset) % W25Q80BV_SECTOR_LEN);
+		if (sector_len > (length - offset)) {
+			sector_len = length - offset;
+		}
+		write_sector(image, addr + offset, &data[offset], sector_len);
+		read_back(image, addr + offset, sector_len);
+	}
+}
+
+/* CRC-32 of everything written, as read back from the flash. */
+uint32_t spiflash_image_crc(const spiflash_image_t* const image)
+{
+	return crc32_digest(&image->crc);
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright 2026 Great Scott Gadgets <info@greatscottgadgets.com>
+ *
+ * This file is part of HackRF.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __SPIFLASH_IMAGE_H__
+#define __SPIFLASH_IMAGE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "crc.h"
+#include "w25q80bv.h"
+
+/*
+ * Writing an image to the SPI flash a piece at a time, erasing and
+ * programming only the sectors that differ. This only uses the w25q80bv
+ * driver interface, so it can also be exercised on a host.
+ */
+
+typedef struct {
+	w25q80bv_driver_t* drv;
+	uint32_t start;
+	uint32_t end;
+	/* Sectors at or after this address have not been erased yet. */
+	uint32_t erased_end;
+	/* CRC-32 of the flash contents written so far, read back. */
+	crc32_t crc;
+} spiflash_image_t;
+
+bool spiflash_image_init(
+	spiflash_image_t* const image,
+	w25q80bv_driver_t* const drv,
+	const uint32_t addr,
+	const uint32_t length);
+void spiflash_image_write(
+	spiflash_image_t* const image,
+	const uint32_t addr,
+	uint8_t* const data,
+	const uint32_t length);
+uint32_t spiflash_image_crc(const spiflash_image_t* const image);
+
+#endif /*__SPIFLASH_IMAGE_H__*/
@@ -0,0 +1,154 @@
+/*
+ * Copyright 2026 Great Scott Gadgets <info@greatscottgadgets.com>
+ *
+ * This file is part of HackRF.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "sweep_schedule.h"
+
+/*
+ * When the M0 is waiting, the next threshold must be placed far enough
+ * ahead of its count that it cannot pass before the M4 has written it.
+ */
+#define SWEEP_SCHEDULE_GUARD 0x200
+
+/* True if position a is at or after position b. */
+static bool after(const uint32_t a, const uint32_t b)
+{
+	return (int32_t) (a - b) >= 0;
+}
+
+static void absorb_gaps(sweep_schedule_t* const schedule)
+{
+	uint8_t head;
+
+	// Skipped space only becomes reusable once every block before it has
+	// been sent.
+	while (schedule->gap_count > 0) {
+		head = schedule->gap_head;
+		if (!after(schedule->consumed, schedule->gap_start[head])) {
+			break;
+		}
+		schedule->consumed = schedule->gap_end[head];
+		schedule->gap_head = (head + 1) % SWEEP_SCHEDULE_MAX_GAPS;
+		schedule->gap_count--;
+	}
+}
+
+void sweep_schedule_init(
+	sweep_schedule_t* const schedule,
+	const uint32_t ring_size,
+	const uint32_t block_size,
+	const uint32_t settle,
+	const uint32_t min_gap)
+{
+	schedule->ring_size = ring_size;
+	schedule->block_size = block_size;
+	schedule->settle = settle;
+	schedule->min_gap = min_gap;
+	schedule->block_start = 0;
+	schedule->consumed = 0;
+	schedule->gap_head = 0;
+	schedule->gap_count = 0;
+	schedule->missed = false;
+}
+
+uint32_t sweep_schedule_block_end(const sweep_schedule_t* const schedule)
+{
+	return schedule->block_start + schedule->block_size;
+}
+
+uint32_t sweep_schedule_ring_offset(const sweep_schedule_t* const schedule)
+{
+	return schedule->block_start & (schedule->ring_size - 1);
+}
+
+/*
+ * Returns true if the block after the current one can follow it directly,
+ * with the M0 staying in RX mode.
+ */
+bool sweep_schedule_gapless(const sweep_schedule_t* const schedule, const bool retune)
+{
+	return !retune && (schedule->min_gap == 0) && !schedule->missed;
+}
+
+/*
+ * Advance to the next block and return its start position.
+ *
+ * If the current block was followed by a retune, now is the M0 count at
+ * which the retune completed, and the settle interval is counted from
+ * there. The next block starts on a block-aligned position so that it
+ * never wraps around the end of the ring.
+ */
+uint32_t sweep_schedule_next(
+	sweep_schedule_t* const schedule,
+	const bool retuned,
+	const uint32_t now)
+{
+	const uint32_t end = sweep_schedule_block_end(schedule);
+	uint32_t start = end + schedule->min_gap;
+	uint8_t tail;
+
+	if (sweep_schedule_gapless(schedule, retuned)) {
+		schedule->block_start = end;
+		return end;
+	}
+	schedule->missed = false;
+
+	if (retuned && !after(start, now + schedule->settle)) {
+		start = now + schedule->settle;
+	}
+	if (!after(start, now + SWEEP_SCHEDULE_GUARD)) {
+		start = now + SWEEP_SCHEDULE_GUARD;
+	}
+	start = (start + schedule->block_size - 1) & ~(schedule->block_size - 1);
+
+	if (start != end) {
+		tail = (schedule->gap_head + schedule->gap_count) %
+			SWEEP_SCHEDULE_MAX_GAPS;
+		schedule->gap_start[tail] = end;
+		schedule->gap_end[tail] = start;
+		schedule->gap_count++;
+		absorb_gaps(schedule);
+	}
+
+	schedule->block_start = start;
+	return start;
+}
+
+/*
+ * Record that the M0 count had already passed the end of the current
+ * block when its threshold was written, so the M0 will not switch modes
+ * there. The block after it is then placed as if a gap were required,
+ * so that its start is armed with the usual guard.
+ */
+void sweep_schedule_missed(sweep_schedule_t* const schedule)
+{
+	schedule->missed = true;
+}
+
+/*
+ * Record that the block ending at position end has been sent, and return
+ * the new position up to which the ring may be reused.
+ */
+uint32_t sweep_schedule_sent(sweep_schedule_t* const schedule, const uint32_t end)
+{
+	schedule->consumed = end;
+	absorb_gaps(schedule);
+	return schedule->consumed;
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright 2026 Great Scott Gadgets <info@greatscottgadgets.com>
+ *
+ * This file is part of HackRF.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __SWEEP_SCHEDULE_H__
+#define __SWEEP_SCHEDULE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Sweep block scheduling, kept free of hardware dependencies so that it
+ * can also be built and exercised on a host.
+ *
+ * All positions are M0 byte counts, which wrap at 2^32. Block and ring
+ * sizes must be powers of two, with the block size no larger than half
+ * the ring.
+ */
+
+/*
+ * One entry for every block the smallest block size (2K) fits in the
+ * largest ring (64K).
+ */
+#define SWEEP_SCHEDULE_MAX_GAPS 32
+
+typedef struct {
+	uint32_t ring_size;
+	uint32_t block_size;
+	/* Bytes to skip after a retune has completed. */
+	uint32_t settle;
+	/* Minimum bytes to skip after every block. */
+	uint32_t min_gap;
+	/* Position of the block currently being captured. */
+	uint32_t block_start;
+	/* Position up to which the M0 may reuse the ring. */
+	uint32_t consumed;
+	uint32_t gap_start[SWEEP_SCHEDULE_MAX_GAPS];
+	uint32_t gap_end[SWEEP_SCHEDULE_MAX_GAPS];
+	uint8_t gap_head;
+	uint8_t gap_count;
+	/* The M0 passed the end of a gapless block before it was armed. */
+	bool missed;
+} sweep_schedule_t;
+
+void sweep_schedule_init(
+	sweep_schedule_t* const schedule,
+	const uint32_t ring_size,
+	const uint32_t block_size,
+	const uint32_t settle,
+	const uint32_t min_gap);
+uint32_t sweep_schedule_block_end(const sweep_schedule_t* const schedule);
+uint32_t sweep_schedule_ring_offset(const sweep_schedule_t* const schedule);
+bool sweep_schedule_gapless(const sweep_schedule_t* const schedule, const bool retune);
+uint32_t sweep_schedule_next(
+	sweep_schedule_t* const schedule,
+	const bool retuned,
+	const uint32_t now);
+void sweep_schedule_missed(sweep_schedule_t* const schedule);
+uint32_t sweep_schedule_sent(sweep_schedule_t* const schedule, const uint32_t end);
+
+#endif /*__SWEEP_SCHEDULE_H__*/
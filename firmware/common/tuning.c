@@ -33,26 +33,25 @@
 
 #define FREQ_ONE_MHZ (1000ULL * 1000)
 
-#define MIN_LP_FREQ_MHZ (0)
-#define MAX_LP_FREQ_MHZ (2170ULL)
-
 #define ABS_MIN_BYPASS_FREQ_MHZ (2000ULL)
-#define MIN_BYPASS_FREQ_MHZ     (MAX_LP_FREQ_MHZ)
-#define MAX_BYPASS_FREQ_MHZ     (2740ULL)
 #define ABS_MAX_BYPASS_FREQ_MHZ (3000ULL)
 
-#define MIN_HP_FREQ_MHZ  (MAX_BYPASS_FREQ_MHZ)
-#define MID1_HP_FREQ_MHZ (3600ULL)
-#define MID2_HP_FREQ_MHZ (5100ULL)
-#define MAX_HP_FREQ_MHZ  (7250ULL)
-
 #define MIN_LO_FREQ_HZ (84375000ULL)
 #define MAX_LO_FREQ_HZ (5400000000ULL)
 
-static uint32_t max2837_freq_nominal_hz = 2560000000;
-
 uint64_t freq_cache = 100000000;
 
+/* Filter last selected here, so that it is only switched when it changes. */
+static uint8_t filter_cache = 0xff;
+
+static void set_filter(const rf_path_filter_t filter)
+{
+	if (filter != filter_cache) {
+		rf_path_set_filter(&rf_path, filter);
+		filter_cache = filter;
+	}
+}
+
 /*
  * Set freq/tuning between 0MHz to 7250 MHz (less than 16bits really used)
  * hz between 0 to 999999 Hz (not checked)
@@ -61,60 +60,45 @@ uint64_t freq_cache = 100000000;
 bool set_freq(const uint64_t freq)
 {
 	bool success;
-	uint32_t mixer_freq_mhz;
-	uint32_t MAX2837_freq_hz;
+	tuning_if_plan_t plan;
 	uint64_t real_mixer_freq_hz;
 
 	const uint32_t freq_mhz = freq / FREQ_ONE_MHZ;
-	const uint32_t freq_hz = freq % FREQ_ONE_MHZ;
 
-	success = true;
+#ifndef RAD1O
+	tuning_step_t step;
+
+	/* Going through a step lets settings that haven't changed be skipped. */
+	if (tuning_step_plan(freq, &step)) {
+		return set_freq_step(&step);
+	}
+#endif
+
+	success = tuning_if_plan(freq, &plan);
 
 	max283x_mode_t prior_max283x_mode = max283x_mode(&max283x);
 	max283x_set_mode(&max283x, MAX283x_MODE_STANDBY);
-	if (freq_mhz < MAX_LP_FREQ_MHZ) {
-		rf_path_set_filter(&rf_path, RF_PATH_FILTER_LOW_PASS);
-#ifdef RAD1O
-		max2837_freq_nominal_hz = 2300 * FREQ_ONE_MHZ;
-#else
-		/* IF is graduated from 2650 MHz to 2340 MHz */
-		max2837_freq_nominal_hz = (2650 * FREQ_ONE_MHZ) - (freq / 7);
-#endif
-		mixer_freq_mhz = (max2837_freq_nominal_hz / FREQ_ONE_MHZ) + freq_mhz;
-		/* Set Freq and read real freq */
-		real_mixer_freq_hz = mixer_set_frequency(&mixer, mixer_freq_mhz);
-		max283x_set_frequency(&max283x, real_mixer_freq_hz - freq);
-		sgpio_cpld_set_mixer_invert(&sgpio_config, 1);
-	} else if ((freq_mhz >= MIN_BYPASS_FREQ_MHZ) && (freq_mhz < MAX_BYPASS_FREQ_MHZ)) {
-		rf_path_set_filter(&rf_path, RF_PATH_FILTER_BYPASS);
-		MAX2837_freq_hz = (freq_mhz * FREQ_ONE_MHZ) + freq_hz;
-		/* mixer_freq_mhz <= not used in Bypass mode */
-		max283x_set_frequency(&max283x, MAX2837_freq_hz);
-		sgpio_cpld_set_mixer_invert(&sgpio_config, 0);
-	} else if ((freq_mhz >= MIN_HP_FREQ_MHZ) && (freq_mhz <= MAX_HP_FREQ_MHZ)) {
-		if (freq_mhz < MID1_HP_FREQ_MHZ) {
-			/* IF is graduated from 2170 MHz to 2740 MHz */
-			max2837_freq_nominal_hz = (MIN_BYPASS_FREQ_MHZ * FREQ_ONE_MHZ) +
-				(((freq - (MAX_BYPASS_FREQ_MHZ * FREQ_ONE_MHZ)) * 57) /
-				 86);
-		} else if (freq_mhz < MID2_HP_FREQ_MHZ) {
-			/* IF is graduated from 2350 MHz to 2650 MHz */
-			max2837_freq_nominal_hz = (2350 * FREQ_ONE_MHZ) +
-				((freq - (MID1_HP_FREQ_MHZ * FREQ_ONE_MHZ)) / 5);
-		} else {
-			/* IF is graduated from 2500 MHz to 2738 MHz */
-			max2837_freq_nominal_hz = (2500 * FREQ_ONE_MHZ) +
-				((freq - (MID2_HP_FREQ_MHZ * FREQ_ONE_MHZ)) / 9);
+	if (success) {
+		set_filter(plan.filter);
+		switch (plan.side) {
+		case TUNING_SIDE_HIGH_LO:
+			/* Set Freq and read real freq */
+			real_mixer_freq_hz = mixer_set_frequency(&mixer, plan.mixer_mhz);
+			max283x_set_frequency(&max283x, real_mixer_freq_hz - freq);
+			sgpio_cpld_set_mixer_invert(&sgpio_config, 1);
+			break;
+		case TUNING_SIDE_LOW_LO:
+			/* Set Freq and read real freq */
+			real_mixer_freq_hz = mixer_set_frequency(&mixer, plan.mixer_mhz);
+			max283x_set_frequency(&max283x, freq - real_mixer_freq_hz);
+			sgpio_cpld_set_mixer_invert(&sgpio_config, 0);
+			break;
+		default:
+			/* Mixer not used in Bypass mode */
+			max283x_set_frequency(&max283x, freq);
+			sgpio_cpld_set_mixer_invert(&sgpio_config, 0);
+			break;
 		}
-		rf_path_set_filter(&rf_path, RF_PATH_FILTER_HIGH_PASS);
-		mixer_freq_mhz = freq_mhz - (max2837_freq_nominal_hz / FREQ_ONE_MHZ);
-		/* Set Freq and read real freq */
-		real_mixer_freq_hz = mixer_set_frequency(&mixer, mixer_freq_mhz);
-		max283x_set_frequency(&max283x, freq - real_mixer_freq_hz);
-		sgpio_cpld_set_mixer_invert(&sgpio_config, 0);
-	} else {
-		/* Error freq_mhz too high */
-		success = false;
 	}
 	max283x_set_mode(&max283x, prior_max283x_mode);
 	if (success) {
@@ -127,6 +111,45 @@ bool set_freq(const uint64_t freq)
 	return success;
 }
 
+/*
+ * Apply a tuning step computed in advance by tuning_step_plan() or
+ * tuning_sequence_plan(), which skips all of the frequency planning
+ * arithmetic done by set_freq(). The filter and mixer are only
+ * reprogrammed if they differ from the settings already in place, so
+ * steps planned to share a mixer LO only retune the MAX283x.
+ */
+bool set_freq_step(const tuning_step_t* const step)
+{
+#ifdef RAD1O
+	(void) step;
+	return false;
+#else
+	if (step->filter > RF_PATH_FILTER_HIGH_PASS) {
+		return false;
+	}
+
+	max283x_mode_t prior_max283x_mode = max283x_mode(&max283x);
+	max283x_set_mode(&max283x, MAX283x_MODE_STANDBY);
+	set_filter(step->filter);
+	if ((step->flags & TUNING_STEP_MIXER) &&
+	    !rffc5071_synth_programmed(&mixer, &step->mixer)) {
+		rffc5071_set_synth(&mixer, &step->mixer);
+	}
+	max283x_set_synth(&max283x, &step->synth);
+	sgpio_cpld_set_mixer_invert(
+		&sgpio_config,
+		(step->flags & TUNING_STEP_MIXER_INVERT) ? 1 : 0);
+	max283x_set_mode(&max283x, prior_max283x_mode);
+
+	freq_cache = step->freq;
+	hackrf_ui()->set_frequency(step->freq);
+	#ifdef HACKRF_ONE
+	operacake_set_range(step->freq / FREQ_ONE_MHZ);
+	#endif
+	return true;
+#endif
+}
+
 bool set_freq_explicit(
 	const uint64_t if_freq_hz,
 	const uint64_t lo_freq_hz,
@@ -146,7 +169,7 @@ bool set_freq_explicit(
 		return false;
 	}
 
-	rf_path_set_filter(&rf_path, path);
+	set_filter(path);
 	max283x_set_frequency(&max283x, if_freq_hz);
 	if (lo_freq_hz > if_freq_hz) {
 		sgpio_cpld_set_mixer_invert(&sgpio_config, 1);
@@ -25,11 +25,13 @@
 #define __TUNING_H__
 
 #include "rf_path.h"
+#include "tuning_plan.h"
 
 #include <stdint.h>
 #include <stdbool.h>
 
 bool set_freq(const uint64_t freq);
+bool set_freq_step(const tuning_step_t* const step);
 bool set_freq_explicit(
 	const uint64_t if_freq_hz,
 	const uint64_t lo_freq_hz,
@@ -0,0 +1,307 @@
+/*
+ * Copyright 2026 Great Scott Gadgets <info@greatscottgadgets.com>
+ *
+ * This file is part of HackRF.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "tuning_plan.h"
+
+#define FREQ_ONE_MHZ (1000ULL * 1000)
+
+#define MIN_LP_FREQ_MHZ (0)
+#define MAX_LP_FREQ_MHZ (2170ULL)
+
+#define MIN_BYPASS_FREQ_MHZ (MAX_LP_FREQ_MHZ)
+#define MAX_BYPASS_FREQ_MHZ (2740ULL)
+
+#define MIN_HP_FREQ_MHZ  (MAX_BYPASS_FREQ_MHZ)
+#define MID1_HP_FREQ_MHZ (3600ULL)
+#define MID2_HP_FREQ_MHZ (5100ULL)
+#define MAX_HP_FREQ_MHZ  (7250ULL)
+
+/* RFFC5071 */
+#define LO_MIN   85
+#define LO_MAX   5400
+#define REF_FREQ 40
+
+/*
+ * Choose the RF filter and mixer frequency for an RF frequency between
+ * 0MHz and 7250MHz. Returns false if the frequency is out of range.
+ */
+bool tuning_if_plan(const uint64_t freq, tuning_if_plan_t* const plan)
+{
+	uint32_t max2837_freq_nominal_hz;
+	const uint32_t freq_mhz = freq / FREQ_ONE_MHZ;
+
+	if (freq_mhz < MAX_LP_FREQ_MHZ) {
+		plan->filter = TUNING_FILTER_LOW_PASS;
+#ifdef RAD1O
+		max2837_freq_nominal_hz = 2300 * FREQ_ONE_MHZ;
+#else
+		/* IF is graduated from 2650 MHz to 2340 MHz */
+		max2837_freq_nominal_hz = (2650 * FREQ_ONE_MHZ) - (freq / 7);
+#endif
+		plan->mixer_mhz = (max2837_freq_nominal_hz / FREQ_ONE_MHZ) + freq_mhz;
+		plan->side = TUNING_SIDE_HIGH_LO;
+	} else if ((freq_mhz >= MIN_BYPASS_FREQ_MHZ) && (freq_mhz < MAX_BYPASS_FREQ_MHZ)) {
+		plan->filter = TUNING_FILTER_BYPASS;
+		plan->mixer_mhz = 0;
+		plan->side = TUNING_SIDE_NONE;
+	} else if ((freq_mhz >= MIN_HP_FREQ_MHZ) && (freq_mhz <= MAX_HP_FREQ_MHZ)) {
+		if (freq_mhz < MID1_HP_FREQ_MHZ) {
+			/* IF is graduated from 2170 MHz to 2740 MHz */
+			max2837_freq_nominal_hz = (MIN_BYPASS_FREQ_MHZ * FREQ_ONE_MHZ) +
+				(((freq - (MAX_BYPASS_FREQ_MHZ * FREQ_ONE_MHZ)) * 57) /
+				 86);
+		} else if (freq_mhz < MID2_HP_FREQ_MHZ) {
+			/* IF is graduated from 2350 MHz to 2650 MHz */
+			max2837_freq_nominal_hz = (2350 * FREQ_ONE_MHZ) +
+				((freq - (MID1_HP_FREQ_MHZ * FREQ_ONE_MHZ)) / 5);
+		} else {
+			/* IF is graduated from 2500 MHz to 2738 MHz */
+			max2837_freq_nominal_hz = (2500 * FREQ_ONE_MHZ) +
+				((freq - (MID2_HP_FREQ_MHZ * FREQ_ONE_MHZ)) / 9);
+		}
+		plan->filter = TUNING_FILTER_HIGH_PASS;
+		plan->mixer_mhz = freq_mhz - (max2837_freq_nominal_hz / FREQ_ONE_MHZ);
+		plan->side = TUNING_SIDE_LOW_LO;
+	} else {
+		/* Error freq_mhz too high */
+		return false;
+	}
+	return true;
+}
+
+/*
+ * Compute the RFFC5071 integer-N synthesizer settings for an LO
+ * frequency in MHz, returning the frequency actually produced in Hz.
+ */
+uint64_t rffc5071_synth_plan(const uint16_t lo_mhz, rffc5071_synth_t* const synth)
+{
+	uint8_t lodiv;
+	uint16_t fvco;
+	uint8_t fbkdiv;
+
+	/* Calculate n_lo */
+	uint8_t n_lo = 0;
+	uint16_t x = LO_MAX / lo_mhz;
+	while ((x > 1) && (n_lo < 5)) {
+		n_lo++;
+		x >>= 1;
+	}
+
+	lodiv = 1 << n_lo;
+	fvco = lodiv * lo_mhz;
+
+	/* higher divider and charge pump current required above
+	 * 3.2GHz. Programming guide says these values (fbkdiv, n,
+	 * maybe pump?) can be changed back after enable in order to
+	 * improve phase noise, since the VCO will already be stable
+	 * and will be unaffected. */
+	if (fvco > 3200) {
+		fbkdiv = 4;
+		synth->pllcpl = 3;
+	} else {
+		fbkdiv = 2;
+		synth->pllcpl = 2;
+	}
+
+	uint64_t tmp_n = ((uint64_t) fvco << 29ULL) / (fbkdiv * REF_FREQ);
+
+	synth->lodiv = n_lo;
+	synth->n = tmp_n >> 29ULL;
+	synth->presc = fbkdiv >> 1;
+	synth->nmsb = (tmp_n >> 13ULL) & 0xffff;
+	synth->nlsb = (tmp_n >> 5ULL) & 0xff;
+
+	return (REF_FREQ * (tmp_n >> 5ULL) * fbkdiv * FREQ_ONE_MHZ) /
+		(lodiv * (1 << 24ULL));
+}
+
+/* Compute the MAX2837/MAX2839 synthesizer settings for a frequency in Hz. */
+void max283x_synth_plan(const uint32_t freq, max283x_synth_t* const synth)
+{
+	uint32_t div_frac;
+	uint32_t div_rem;
+	uint32_t div_cmp;
+	int i;
+
+	/* Select band. Allow tuning outside specified bands. */
+	if (freq < 2400000000U) {
+		synth->band = 0;
+	} else if (freq < 2500000000U) {
+		synth->band = 1;
+	} else if (freq < 2600000000U) {
+		synth->band = 2;
+	} else {
+		synth->band = 3;
+	}
+
+	/* ASSUME 40MHz PLL. Ratio = F*(4/3)/40,000,000 = F/30,000,000 */
+	synth->n = freq / 30000000;
+	div_rem = freq % 30000000;
+	div_frac = 0;
+	div_cmp = 30000000;
+	for (i = 0; i < 20; i++) {
+		div_frac <<= 1;
+		div_cmp >>= 1;
+		if (div_rem > div_cmp) {
+			div_frac |= 0x1;
+			div_rem -= div_cmp;
+		}
+	}
+	synth->frac = div_frac;
+}
+
+/*
+ * Compute everything set_freq() would program for an RF frequency, on
+ * boards with an RFFC5071 mixer.
+ */
+bool tuning_step_plan(const uint64_t freq, tuning_step_t* const step)
+{
+	tuning_if_plan_t plan;
+	uint64_t real_mixer_freq_hz;
+	uint32_t if_freq_hz;
+
+	if (!tuning_if_plan(freq, &plan)) {
+		return false;
+	}
+
+	step->freq = freq;
+	step->filter = plan.filter;
+	step->flags = 0;
+
+	switch (plan.side) {
+	case TUNING_SIDE_HIGH_LO:
+		real_mixer_freq_hz = rffc5071_synth_plan(plan.mixer_mhz, &step->mixer);
+		if_freq_hz = real_mixer_freq_hz - freq;
+		step->flags = TUNING_STEP_MIXER | TUNING_STEP_MIXER_INVERT;
+		break;
+	case TUNING_SIDE_LOW_LO:
+		real_mixer_freq_hz = rffc5071_synth_plan(plan.mixer_mhz, &step->mixer);
+		if_freq_hz = freq - real_mixer_freq_hz;
+		step->flags = TUNING_STEP_MIXER;
+		break;
+	default:
+		if_freq_hz = freq;
+		break;
+	}
+
+	max283x_synth_plan(if_freq_hz, &step->synth);
+	return true;
+}
+
+/* Range of IF frequencies tuning_if_plan() uses with each filter. */
+static void if_range(const uint8_t filter, uint64_t* const min_hz, uint64_t* const max_hz)
+{
+	if (filter == TUNING_FILTER_LOW_PASS) {
+		*min_hz = 2340 * FREQ_ONE_MHZ;
+		*max_hz = 2650 * FREQ_ONE_MHZ;
+	} else {
+		*min_hz = MIN_BYPASS_FREQ_MHZ * FREQ_ONE_MHZ;
+		*max_hz = MAX_BYPASS_FREQ_MHZ * FREQ_ONE_MHZ;
+	}
+}
+
+/*
+ * Plan steps in place for a sequence of RF frequencies, given by the freq
+ * field of each step, that will be tuned to in order. Each run of
+ * consecutive frequencies that can share one mixer LO, with every IF
+ * staying within the range tuning_if_plan() uses for their filter, is
+ * given the same LO, placed in the middle of the range the run allows.
+ * The firmware then only needs to reprogram the mixer between runs.
+ * Frequencies that can't share an LO are planned as by tuning_step_plan().
+ * Every step tunes to the same RF frequency either way, only the split
+ * between LO and IF differs.
+ *
+ * Returns false if any frequency is out of range.
+ */
+bool tuning_sequence_plan(tuning_step_t* const steps, const int count)
+{
+	tuning_if_plan_t first, plan;
+	rffc5071_synth_t mixer;
+	uint64_t if_min, if_max, lo_min, lo_max, run_min, run_max;
+	uint64_t real_mixer_freq_hz;
+	uint32_t if_freq_hz;
+	uint32_t lo_min_mhz, lo_max_mhz;
+	uint16_t lo_mhz;
+	int i, end;
+
+	for (i = 0; i < count; i = end) {
+		if (!tuning_if_plan(steps[i].freq, &first)) {
+			return false;
+		}
+		if_range(first.filter, &if_min, &if_max);
+
+		// Extend the run while the LO ranges of its steps still overlap.
+		lo_mhz = 0;
+		run_min = 0;
+		run_max = UINT64_MAX;
+		for (end = i; end < count; end++) {
+			if (!tuning_if_plan(steps[end].freq, &plan)) {
+				return false;
+			}
+			if ((first.side == TUNING_SIDE_NONE) ||
+			    (plan.side != first.side) || (plan.filter != first.filter)) {
+				break;
+			}
+			if (plan.side == TUNING_SIDE_HIGH_LO) {
+				lo_min = steps[end].freq + if_min;
+				lo_max = steps[end].freq + if_max;
+			} else {
+				lo_min = steps[end].freq - if_max;
+				lo_max = steps[end].freq - if_min;
+			}
+			lo_min = (lo_min > run_min) ? lo_min : run_min;
+			lo_max = (lo_max < run_max) ? lo_max : run_max;
+			lo_min_mhz = (lo_min + FREQ_ONE_MHZ - 1) / FREQ_ONE_MHZ;
+			lo_max_mhz = lo_max / FREQ_ONE_MHZ;
+			if (lo_min_mhz < LO_MIN) {
+				lo_min_mhz = LO_MIN;
+			}
+			if (lo_min_mhz > lo_max_mhz) {
+				break;
+			}
+			run_min = lo_min;
+			run_max = lo_max;
+			lo_mhz = (lo_min_mhz + lo_max_mhz) / 2;
+		}
+
+		if ((end - i) < 2) {
+			end = i + 1;
+			tuning_step_plan(steps[i].freq, &steps[i]);
+			continue;
+		}
+
+		real_mixer_freq_hz = rffc5071_synth_plan(lo_mhz, &mixer);
+		for (; i < end; i++) {
+			steps[i].mixer = mixer;
+			steps[i].filter = first.filter;
+			if (first.side == TUNING_SIDE_HIGH_LO) {
+				if_freq_hz = real_mixer_freq_hz - steps[i].freq;
+				steps[i].flags =
+					TUNING_STEP_MIXER | TUNING_STEP_MIXER_INVERT;
+			} else {
+				if_freq_hz = steps[i].freq - real_mixer_freq_hz;
+				steps[i].flags = TUNING_STEP_MIXER;
+			}
+			max283x_synth_plan(if_freq_hz, &steps[i].synth);
+		}
+	}
+	return true;
+}
@@ -0,0 +1,88 @@
+/*
+ * Copyright 2026 Great Scott Gadgets <info@greatscottgadgets.com>
+ *
+ * This file is part of HackRF.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __TUNING_PLAN_H__
+#define __TUNING_PLAN_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Frequency planning for set_freq() and the tuning table. Nothing here
+ * touches hardware: the results are applied by the drivers, either
+ * straight away or when a tuning table entry is used.
+ */
+
+/* Values match rf_path_filter_t. */
+#define TUNING_FILTER_BYPASS    0
+#define TUNING_FILTER_LOW_PASS  1
+#define TUNING_FILTER_HIGH_PASS 2
+
+typedef enum {
+	/* No mixer, the MAX283x tunes to the RF frequency directly. */
+	TUNING_SIDE_NONE = 0,
+	/* Mixer LO above RF, IF = LO - RF. Spectrum is inverted. */
+	TUNING_SIDE_HIGH_LO = 1,
+	/* Mixer LO below RF, IF = RF - LO. */
+	TUNING_SIDE_LOW_LO = 2,
+} tuning_side_t;
+
+typedef struct {
+	uint8_t filter;
+	tuning_side_t side;
+	uint16_t mixer_mhz;
+} tuning_if_plan_t;
+
+/* RFFC5071 path 2 synthesizer fields. */
+typedef struct {
+	uint8_t lodiv;
+	uint8_t presc;
+	uint8_t pllcpl;
+	uint8_t nlsb;
+	uint16_t n;
+	uint16_t nmsb;
+} rffc5071_synth_t;
+
+/* MAX2837/MAX2839 synthesizer fields. */
+typedef struct {
+	uint32_t frac;
+	uint8_t n;
+	uint8_t band;
+} max283x_synth_t;
+
+#define TUNING_STEP_MIXER        (1 << 0)
+#define TUNING_STEP_MIXER_INVERT (1 << 1)
+
+typedef struct {
+	uint64_t freq;
+	rffc5071_synth_t mixer;
+	max283x_synth_t synth;
+	uint8_t filter;
+	uint8_t flags;
+} tuning_step_t;
+
+bool tuning_if_plan(const uint64_t freq, tuning_if_plan_t* const plan);
+uint64_t rffc5071_synth_plan(const uint16_t lo_mhz, rffc5071_synth_t* const synth);
+void max283x_synth_plan(const uint32_t freq, max283x_synth_t* const synth);
+bool tuning_step_plan(const uint64_t freq, tuning_step_t* const step);
+bool tuning_sequence_plan(tuning_step_t* const steps, const int count);
+
+#endif /*__TUNING_PLAN_H__*/
@@ -38,6 +38,8 @@
 #define W25Q80BV_FAST_READ    0x0b
 #define W25Q80BV_WRITE_ENABLE 0x06
 #define W25Q80BV_CHIP_ERASE   0xC7
+#define W25Q80BV_SECTOR_ERASE 0x20
+#define W25Q80BV_BLOCK_ERASE  0xD8
 #define W25Q80BV_WRITE_STATUS 0x01
 #define W25Q80BV_READ_STATUS1 0x05
 #define W25Q80BV_READ_STATUS2 0x35
@@ -138,6 +140,34 @@ void w25q80bv_chip_erase(w25q80bv_driver_t* const drv)
 	spi_bus_transfer(drv->bus, data, ARRAY_SIZE(data));
 }
 
+static void w25q80bv_erase(
+	w25q80bv_driver_t* const drv,
+	const uint8_t command,
+	const uint32_t addr)
+{
+	w25q80bv_wait_while_busy(drv);
+	w25q80bv_write_enable(drv);
+
+	uint8_t data[] = {
+		command,
+		(addr & 0xFF0000) >> 16,
+		(addr & 0xFF00) >> 8,
+		addr & 0xFF};
+	spi_bus_transfer(drv->bus, data, ARRAY_SIZE(data));
+}
+
+/* erase the 4 KiB sector containing addr */
+void w25q80bv_sector_erase(w25q80bv_driver_t* const drv, const uint32_t addr)
+{
+	w25q80bv_erase(drv, W25Q80BV_SECTOR_ERASE, addr);
+}
+
+/* erase the 64 KiB block containing addr */
+void w25q80bv_block_erase(w25q80bv_driver_t* const drv, const uint32_t addr)
+{
+	w25q80bv_erase(drv, W25Q80BV_BLOCK_ERASE, addr);
+}
+
 /* write up a 256 byte page or partial page */
 static void w25q80bv_page_program(
 	w25q80bv_driver_t* const drv,
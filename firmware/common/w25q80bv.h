@@ -29,6 +29,9 @@
 
 #define W25Q80BV_DEVICE_ID_RES 0x13 /* Expected device_id for W25Q80BV */
 #define W25Q16DV_DEVICE_ID_RES 0x14 /* Expected device_id for W25Q16DV */
+
+#define W25Q80BV_SECTOR_LEN 0x1000  /* Smallest erasable unit */
+#define W25Q80BV_BLOCK_LEN  0x10000 /* Largest erasable unit short of the chip */
 #include "spi_bus.h"
 #include "gpio.h"
 
@@ -54,6 +57,8 @@ struct w25q80bv_driver_t {
 void w25q80bv_setup(w25q80bv_driver_t* const drv);
 void w25q80bv_get_full_status(w25q80bv_driver_t* const drv, uint8_t* data);
 void w25q80bv_chip_erase(w25q80bv_driver_t* const drv);
+void w25q80bv_sector_erase(w25q80bv_driver_t* const drv, const uint32_t addr);
+void w25q80bv_block_erase(w25q80bv_driver_t* const drv, const uint32_t addr);
 void w25q80bv_program(
 	w25q80bv_driver_t* const drv,
 	uint32_t addr,
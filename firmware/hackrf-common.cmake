@@ -78,11 +78,22 @@ else()
 	set(MCU_PARTNO LPC4330)
 endif()
 
+# Size of the sample ring shared by the M0 and USB, in bytes. 65536 uses all
+# of AHB SRAM for the ring, and moves the M0 image to local SRAM, which
+# leaves less room for M4 code.
+if(NOT DEFINED USB_BULK_BUFFER_SIZE)
+	set(USB_BULK_BUFFER_SIZE 32768)
+endif()
+
+if(NOT (USB_BULK_BUFFER_SIZE EQUAL 32768 OR USB_BULK_BUFFER_SIZE EQUAL 65536))
+	message(FATAL_ERROR "USB_BULK_BUFFER_SIZE must be 32768 or 65536")
+endif()
+
 if(NOT DEFINED SRC_M0)
 	set(SRC_M0 "${PATH_HACKRF_FIRMWARE_COMMON}/m0_sleep.c")
 endif()
 
-SET(HACKRF_OPTS "-D${BOARD} -DLPC43XX -D${MCU_PARTNO} -DTX_ENABLE -D'VERSION_STRING=\"${VERSION}\"'")
+SET(HACKRF_OPTS "-D${BOARD} -DLPC43XX -D${MCU_PARTNO} -DTX_ENABLE -DUSB_BULK_BUFFER_SIZE=${USB_BULK_BUFFER_SIZE} -D'VERSION_STRING=\"${VERSION}\"'")
 
 SET(LDSCRIPT_M4 "-T${PATH_HACKRF_FIRMWARE_COMMON}/${MCU_PARTNO}_M4_memory.ld -Tlibopencm3_lpc43xx_rom_to_ram.ld -T${PATH_HACKRF_FIRMWARE_COMMON}/LPC43xx_M4_M0_image_from_text.ld")
 
@@ -91,14 +102,15 @@ SET(LDSCRIPT_M4_RAM "-T${PATH_HACKRF_FIRMWARE_COMMON}/${MCU_PARTNO}_M4_memory.ld
 SET(LDSCRIPT_M0 "-T${PATH_HACKRF_FIRMWARE_COMMON}/LPC43xx_M0_memory.ld -Tlibopencm3_lpc43xx_m0.ld")
 
 SET(CFLAGS_COMMON "-Os -g3 -Wall -Wextra ${HACKRF_OPTS} -fno-common -MD")
-SET(LDFLAGS_COMMON "-nostartfiles -Wl,--gc-sections")
+SET(LDFLAGS_COMMON "-nostartfiles -Wl,--gc-sections -Wl,--defsym=USB_BULK_BUFFER_SIZE=${USB_BULK_BUFFER_SIZE}")
 
 if(V STREQUAL "1")
 	SET(LDFLAGS_COMMON "${LDFLAGS_COMMON} -Wl,--print-gc-sections")
 endif()
 
 SET(CPUFLAGS_M0 "-mthumb -mcpu=cortex-m0 -mfloat-abi=soft")
-SET(CFLAGS_M0 "-std=gnu99 ${CFLAGS_COMMON} ${CPUFLAGS_M0} -DLPC43XX_M0")
+SET(ASFLAGS_M0 "-Wa,--defsym,USB_BULK_BUFFER_SIZE=${USB_BULK_BUFFER_SIZE}")
+SET(CFLAGS_M0 "-std=gnu99 ${CFLAGS_COMMON} ${CPUFLAGS_M0} ${ASFLAGS_M0} -DLPC43XX_M0")
 SET(CXXFLAGS_M0 "-std=gnu++0x ${CFLAGS_COMMON} ${CPUFLAGS_M0} -DLPC43XX_M0")
 SET(LDFLAGS_M0 "${LDFLAGS_COMMON} ${CPUFLAGS_M0} ${LDSCRIPT_M0} -Xlinker -Map=m0.map")
 
@@ -175,6 +187,7 @@ macro(DeclareTargets)
 		${PATH_HACKRF_FIRMWARE_COMMON}/max2837_target.c
 		${PATH_HACKRF_FIRMWARE_COMMON}/max2839.c
 		${PATH_HACKRF_FIRMWARE_COMMON}/max2839_target.c
+		${PATH_HACKRF_FIRMWARE_COMMON}/tuning_plan.c
 		${PATH_HACKRF_FIRMWARE_COMMON}/max5864.c
 		${PATH_HACKRF_FIRMWARE_COMMON}/max5864_target.c
 		${PATH_HACKRF_FIRMWARE_COMMON}/mixer.c
@@ -48,6 +48,9 @@
 #include "usb_api_operacake.h"
 #include "operacake.h"
 #include "usb_api_sweep.h"
+#include "usb_api_tuning.h"
+#include "usb_api_schedule.h"
+#include "usb_api_hop.h"
 #include "usb_api_transceiver.h"
 #include "usb_api_ui.h"
 #include "usb_bulk_buffer.h"
@@ -126,6 +129,16 @@ static usb_request_handler_fn vendor_request_handler[] = {
 	usb_vendor_request_read_supported_platform,
 	usb_vendor_request_set_leds,
 	usb_vendor_request_user_config_set_bias_t_opts,
+	usb_vendor_request_set_sweep_timing,
+	usb_vendor_request_set_tuning_table,
+	usb_vendor_request_init_sweep_list,
+	usb_vendor_request_set_sweep_spectrum,
+	usb_vendor_request_spiflash_program,
+	usb_vendor_request_spiflash_program_status,
+	usb_vendor_request_apply_config,
+	usb_vendor_request_schedule_commands,
+	usb_vendor_request_set_hop_table,
+	usb_vendor_request_get_m0_telemetry,
 };
 
 static const uint32_t vendor_request_handler_count =
@@ -321,9 +334,18 @@ int main(void)
 		case TRANSCEIVER_MODE_RX_SWEEP:
 			sweep_mode(request.seq);
 			break;
+		case TRANSCEIVER_MODE_RX_HOP:
+			rx_hop_mode(request.seq);
+			break;
+		case TRANSCEIVER_MODE_TX_HOP:
+			tx_hop_mode(request.seq);
+			break;
 		case TRANSCEIVER_MODE_CPLD_UPDATE:
 			cpld_update();
 			break;
+		case TRANSCEIVER_MODE_SPIFLASH_PROGRAM:
+			spiflash_program_mode(request.seq);
+			break;
 		default:
 			break;
 		}
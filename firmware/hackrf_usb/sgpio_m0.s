@@ -41,7 +41,7 @@ To implement the different functions of HackRF, the M0 operates in one of
 five modes, configured by the M4:
 
 IDLE:           Do nothing.
-WAIT:           Do nothing, but increment byte counter for timing purposes.
+WAIT:           Write zeroes to SGPIO, and increment byte counter for timing purposes.
 RX:             Read data from SGPIO and write it to the buffer.
 TX_START:       Write zeroes to SGPIO until there is data in the buffer.
 TX_RUN:         Read data from the buffer and write it to SGPIO.
@@ -50,6 +50,10 @@ In all modes except IDLE, the M0 advances a byte counter, which increases by
 32 each time that many bytes are exchanged with the buffer (or skipped over,
 in WAIT mode).
 
+WAIT mode writes zeroes so that nothing is transmitted while TX is paused, for
+example during a retune. In RX the zeroes are harmless, because the slices
+shift in a full 32 bits of new data before each exchange.
+
 As the M4 core produces or consumes these bytes, it advances its own counter.
 The difference between the two counter values therefore indicates the number
 of bytes available.
@@ -64,6 +68,11 @@ SGPIO. When in a shortfall, the byte counter does not advance.
 The M0 maintains statistics on the the number of shortfalls, and the length of
 the longest shortfall.
 
+For more detailed telemetry, the M0 also keeps the smallest buffer margin seen
+outside of a shortfall, and logs the byte count at which each shortfall started
+together with its length. The log holds the most recent 32 shortfalls, and the
+M4 reads it to build a histogram of shortfall lengths.
+
 The M0 can be configured to abort TX or RX and return to IDLE mode, if the
 length of a shortfall exceeds a configured limit.
 
@@ -100,10 +109,10 @@ shadow registers.
 
 There are four key code paths, with the following worst-case timings:
 
-RX, normal:     152 cycles
-RX, overrun:    76 cycles
-TX, normal:     140 cycles
-TX, underrun:   145 cycles
+RX, normal:     157 cycles
+RX, overrun:    90 cycles
+TX, normal:     145 cycles
+TX, underrun:   159 cycles
 
 Design
 ======
@@ -205,13 +214,18 @@ The rest of this file is organised as follows:
 .equ INT_CLEAR,                            0x30
 .equ INT_STATUS,                           0x2C
 
-// Buffer that we're funneling data to/from.
+// Buffer that we're funneling data to/from, and base address of the state
+// structure. USB_BULK_BUFFER_SIZE is defined by the build, and these must
+// match the layout in LPC43xx_M4_memory.ld.
+.equ TARGET_BUFFER_SIZE,                   USB_BULK_BUFFER_SIZE
+.equ TARGET_BUFFER_MASK,                   (TARGET_BUFFER_SIZE - 1)
+.if TARGET_BUFFER_SIZE > 0x8000
+.equ TARGET_DATA_BUFFER,                   0x20000000
+.equ STATE_BASE,                           0x10087000
+.else
 .equ TARGET_DATA_BUFFER,                   0x20008000
-.equ TARGET_BUFFER_SIZE,                   0x8000
-.equ TARGET_BUFFER_MASK,                   0x7fff
-
-// Base address of the state structure.
 .equ STATE_BASE,                           0x20007000
+.endif
 
 // Offsets into the state structure.
 .equ REQUESTED_MODE,                       0x00
@@ -228,6 +242,16 @@ The rest of this file is organised as follows:
 // Private variables stored after state.
 .equ PREV_LONGEST_SHORTFALL,               0x28
 
+// Offsets into the telemetry structure, which follows the state.
+.equ MIN_MARGIN,                           0x40
+.equ SHORTFALL_LOG_OFFSET,                 0x44
+
+// Offsets of the fields of the first shortfall log entry. The log is 256
+// bytes, so that the offset of the latest entry can wrap with a single uxtb.
+.equ SHORTFALL_LOG_START,                  0x48
+.equ SHORTFALL_LOG_LENGTH,                 0x4C
+.equ SHORTFALL_LOG_ENTRY_SIZE,             8
+
 // Operating modes.
 .equ MODE_IDLE,                            0
 .equ MODE_WAIT,                            1
@@ -261,6 +285,7 @@ buf_base          .req r12
 buf_mask          .req r11
 shortfall_length  .req r10
 hi_zero           .req r9
+min_margin        .req r8
 sgpio_data        .req r7
 sgpio_int         .req r6
 count             .req r5
@@ -315,6 +340,17 @@ buf_ptr           .req r4
 	add buf_ptr, buf_base                           // buf_ptr += buf_base                  // 1
 .endm
 
+.macro update_min_margin name
+	// Keep the smallest buffer margin seen, which is in r0.
+	buf_margin .req r0
+
+	cmp buf_margin, min_margin                      // if buf_margin >= min_margin:         // 1
+	bge \name\()_margin_checked                     //      goto margin_checked             // 1 thru, 3 taken
+	mov min_margin, buf_margin                      // min_margin = buf_margin              // 1
+	str buf_margin, [state, #MIN_MARGIN]            // state.min_margin = buf_margin        // 2
+\name\()_margin_checked:
+.endm
+
 .macro update_counts
 	// Update counts after successful SGPIO operation.
 
@@ -368,7 +404,18 @@ buf_ptr           .req r4
 	cmp length, #0                                  // if length > 0:                       // 1
 	bgt \name\()_extend_shortfall                   //      goto extend_shortfall           // 1 thru, 3 taken
 
-	// If so, increase the shortfall count.
+	// If so, log the byte count at which the shortfall started, in the next
+	// entry. This is done before the count is increased, so that the M4 can
+	// read the start of every shortfall it has counted.
+	entry .req r2
+	ldr entry, [state, #SHORTFALL_LOG_OFFSET]       // entry = shortfall_log_offset         // 2
+	add entry, #SHORTFALL_LOG_ENTRY_SIZE            // entry += SHORTFALL_LOG_ENTRY_SIZE    // 1
+	uxtb entry, entry                               // entry &= 0xFF                        // 1
+	str entry, [state, #SHORTFALL_LOG_OFFSET]       // shortfall_log_offset = entry         // 2
+	add entry, state                                // entry += state                       // 1
+	str count, [entry, #SHORTFALL_LOG_START]        // entry.start = count                  // 2
+
+	// Increase the shortfall count.
 	ldr num, [state, #NUM_SHORTFALLS]               // num = state.num_shortfalls           // 2
 	add num, #1                                     // num += 1                             // 1
 	str num, [state, #NUM_SHORTFALLS]               // state.num_shortfalls = num           // 2
@@ -383,6 +430,11 @@ buf_ptr           .req r4
 	add length, #32                                 // length += 32                         // 1
 	mov shortfall_length, length                    // shortfall_length = length            // 1
 
+	// Log the length so far.
+	ldr entry, [state, #SHORTFALL_LOG_OFFSET]       // entry = shortfall_log_offset         // 2
+	add entry, state                                // entry += state                       // 1
+	str length, [entry, #SHORTFALL_LOG_LENGTH]      // entry.length = length                // 2
+
 	// Is this now the longest shortfall?
 	ldr longest, [state, #LONGEST_SHORTFALL]        // longest = state.longest_shortfall    // 2
 	cmp length, longest                             // if length <= longest:                // 1
@@ -434,7 +486,7 @@ idle                    tx_loop, wait_loop
 tx_zeros                tx_loop
 checked_rollback        idle
 tx_loop                 tx_zeros, checked_rollback, rx_loop, wait_loop
-wait_loop               rx_loop, tx_loop
+wait_loop               checked_rollback, rx_loop, tx_loop
 rx_loop                 rx_shortfall, checked_rollback, tx_loop, wait_loop
 rx_shortfall            rx_loop
 
@@ -477,6 +529,8 @@ main:
 	str zero, [state, #THRESHOLD]                   // state.threshold = zero               // 2
 	str zero, [state, #NEXT_MODE]                   // state.next_mode = zero               // 2
 	str zero, [state, #ERROR]                       // state.error = zero                   // 2
+	str zero, [state, #MIN_MARGIN]                  // state.min_margin = zero              // 2
+	str zero, [state, #SHORTFALL_LOG_OFFSET]        // shortfall_log_offset = zero          // 2
 
 idle:
 	// Wait for a mode to be requested, then set up the new mode and acknowledge the request.
@@ -514,6 +568,14 @@ idle:
 	mov shortfall_length, zero                      // shortfall_length = zero              // 1
 	mov count, zero                                 // count = zero                         // 1
 
+	// Reset telemetry. The first shortfall will be logged in the first entry.
+	reset .req r1
+	mov reset, buf_size_minus_32                    // reset = buf_size_minus_32            // 1
+	mov min_margin, reset                           // min_margin = reset                   // 1
+	str reset, [state, #MIN_MARGIN]                 // state.min_margin = reset             // 2
+	mov reset, #(256 - SHORTFALL_LOG_ENTRY_SIZE)    // reset = 256 - entry size             // 1
+	str reset, [state, #SHORTFALL_LOG_OFFSET]       // shortfall_log_offset = reset         // 2
+
 ack_request:
 	// Clear SGPIO interrupt flag, which the M4 set to get our attention.
 	str flag, [sgpio_int, #INT_CLEAR]               // SGPIO_CLR_STATUS_1 = flag            // 8
@@ -552,7 +614,7 @@ tx_zeros:
 	beq tx_loop                                     //      goto tx_loop                    // 1 thru, 3 taken
 
 	// Run common shortfall handling and jump back to TX loop start.
-	handle_shortfall tx                             // handle_shortfall()                   // 24
+	handle_shortfall tx                             // handle_shortfall()                   // 38
 
 checked_rollback:
 	// Checked rollback handler. This code is run when the M0 is in a TX or RX mode, and is
@@ -599,6 +661,9 @@ tx_loop:
 	sub buf_margin, #32                             // buf_margin -= 32                     // 1
 	bmi tx_zeros                                    // if buf_margin < 0: goto tx_zeros     // 1 thru, 3 taken
 
+	// Track the smallest margin.
+	update_min_margin tx                            // update_min_margin()                  // 5
+
 	// Update buffer pointer.
 	update_buf_ptr                                  // update_buf_ptr()                     // 3
 
@@ -631,8 +696,21 @@ wait_loop:
 	await_sgpio wait                                // await_sgpio()                        // 34
 
 	// Check if there is a mode change request.
-	// If so, return to idle.
-	on_request idle                                                                         // 4
+	// If so, return to idle. There is never an ongoing shortfall in WAIT
+	// mode, so this goes via checked_rollback only because idle is out of
+	// range of a conditional branch.
+	on_request checked_rollback                                                             // 4
+
+	// Write zeros to SGPIO, so that stale data is not transmitted.
+	mov zero, #0                                    // zero = 0                             // 1
+	str zero, [sgpio_data, #SLICE0]                 // SGPIO_REG_SS[SLICE0] = zero          // 8
+	str zero, [sgpio_data, #SLICE1]                 // SGPIO_REG_SS[SLICE1] = zero          // 8
+	str zero, [sgpio_data, #SLICE2]                 // SGPIO_REG_SS[SLICE2] = zero          // 8
+	str zero, [sgpio_data, #SLICE3]                 // SGPIO_REG_SS[SLICE3] = zero          // 8
+	str zero, [sgpio_data, #SLICE4]                 // SGPIO_REG_SS[SLICE4] = zero          // 8
+	str zero, [sgpio_data, #SLICE5]                 // SGPIO_REG_SS[SLICE5] = zero          // 8
+	str zero, [sgpio_data, #SLICE6]                 // SGPIO_REG_SS[SLICE6] = zero          // 8
+	str zero, [sgpio_data, #SLICE7]                 // SGPIO_REG_SS[SLICE7] = zero          // 8
 
 	// Update counts.
 	update_counts                                   // update_counts()                      // 4
@@ -668,6 +746,9 @@ rx_loop:
 	sub buf_margin, count                           // buf_margin -= count                  // 1
 	bmi rx_shortfall                                // if buf_margin < 0: goto rx_shortfall // 1 thru, 3 taken
 
+	// Track the smallest margin.
+	update_min_margin rx                            // update_min_margin()                  // 5
+
 	// Update buffer pointer.
 	update_buf_ptr                                  // update_buf_ptr()                     // 3
 
@@ -692,7 +773,7 @@ rx_loop:
 rx_shortfall:
 
 	// Run common shortfall handling and jump back to RX loop.
-	handle_shortfall rx                             // handle_shortfall()                   // 24
+	handle_shortfall rx                             // handle_shortfall()                   // 38
 
 // The linker will put a literal pool here, so add a label for clearer objdump output:
 constants:
@@ -0,0 +1,237 @@
+/*
+ * Copyright 2026 Great Scott Gadgets <info@greatscottgadgets.com>
+ *
+ * This file is part of HackRF.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "usb_api_hop.h"
+
+#include "usb_queue.h"
+#include <stddef.h>
+#include "hackrf_ui.h"
+#include "hop_schedule.h"
+#include "hop_table.h"
+#include "max283x.h"
+#include "usb_api_m0_state.h"
+#include "usb_api_transceiver.h"
+#include "usb_api_tuning.h"
+#include "usb_bulk_buffer.h"
+
+#include <libopencm3/lpc43xx/m4/nvic.h>
+
+/*
+ * Entries are kept packed, as uploaded by the host, and only unpacked
+ * when used.
+ */
+static uint8_t hop_table[HOP_TABLE_MAX_ENTRIES * HOP_ENTRY_SIZE];
+static uint16_t hop_entries = 0;
+static uint16_t hop_pending = 0;
+/* Bytes skipped at each hop while retuning. */
+static uint32_t hop_gap = HOP_MIN_SAMPLES * 2;
+
+/*
+ * The M0 runs through each gap in WAIT mode, which writes zeros to the
+ * SGPIO, so nothing is transmitted while the M4 retunes in TX.
+ */
+#define HOP_GAP_MODE M0_MODE_WAIT
+
+static struct {
+	bool rx;
+	uint32_t resume_mode;
+	uint16_t index;
+	uint32_t cycle;
+	hop_entry_t entry;
+	hop_schedule_t schedule;
+} hop;
+
+static bool hopping(void)
+{
+	return (transceiver_request.mode == TRANSCEIVER_MODE_RX_HOP) ||
+		(transceiver_request.mode == TRANSCEIVER_MODE_TX_HOP);
+}
+
+/*
+ * The setup value gives the index of the first entry written, and the
+ * setup index the gap in samples. As with the tuning table, the table
+ * then ends after the last entry written. The table can't be changed
+ * while hopping.
+ */
+usb_request_status_t usb_vendor_request_set_hop_table(
+	usb_endpoint_t* const endpoint,
+	const usb_transfer_stage_t stage)
+{
+	hop_entry_t entry;
+	uint16_t first, count, i;
+
+	if (stage == USB_TRANSFER_STAGE_SETUP) {
+		first = endpoint->setup.value;
+		count = endpoint->setup.length / HOP_ENTRY_SIZE;
+		if (hopping() || (endpoint->setup.length % HOP_ENTRY_SIZE) ||
+		    (first > hop_entries) || ((first + count) > HOP_TABLE_MAX_ENTRIES) ||
+		    !hop_samples_valid(endpoint->setup.index)) {
+			return USB_REQUEST_STATUS_STALL;
+		}
+		hop_gap = endpoint->setup.index * 2;
+		hop_entries = 0;
+		hop_pending = first + count;
+		if (count == 0) {
+			hop_entries = first;
+			usb_transfer_schedule_ack(endpoint->in);
+		} else {
+			usb_transfer_schedule_block(
+				endpoint->out,
+				&hop_table[first * HOP_ENTRY_SIZE],
+				endpoint->setup.length,
+				NULL,
+				NULL);
+		}
+	} else if (stage == USB_TRANSFER_STAGE_DATA) {
+		for (i = endpoint->setup.value; i < hop_pending; i++) {
+			hop_entry_unpack(&hop_table[i * HOP_ENTRY_SIZE], &entry);
+			if (!hop_entry_valid(&entry)) {
+				return USB_REQUEST_STATUS_STALL;
+			}
+		}
+		hop_entries = hop_pending;
+		usb_transfer_schedule_ack(endpoint->in);
+	}
+	return USB_REQUEST_STATUS_OK;
+}
+
+static void hop_apply(const uint16_t index)
+{
+	hop_entry_t* const entry = &hop.entry;
+
+	hop_entry_unpack(&hop_table[index * HOP_ENTRY_SIZE], entry);
+
+	// Don't let a control request change settings at the same time.
+	nvic_disable_irq(NVIC_USB0_IRQ);
+	tuning_table_set_freq(entry->freq);
+	if (entry->lna_gain != HOP_GAIN_UNCHANGED) {
+		max283x_set_lna_gain(&max283x, entry->lna_gain);
+		hackrf_ui()->set_bb_lna_gain(entry->lna_gain);
+	}
+	if (entry->vga_gain != HOP_GAIN_UNCHANGED) {
+		max283x_set_vga_gain(&max283x, entry->vga_gain);
+		hackrf_ui()->set_bb_vga_gain(entry->vga_gain);
+	}
+	if (entry->txvga_gain != HOP_GAIN_UNCHANGED) {
+		max283x_set_txvga_gain(&max283x, entry->txvga_gain);
+		hackrf_ui()->set_bb_tx_vga_gain(entry->txvga_gain);
+	}
+	nvic_enable_irq(NVIC_USB0_IRQ);
+}
+
+/*
+ * Tune to the first entry. Call after transceiver_startup(), which resets
+ * the M0 count, and before streaming starts.
+ */
+void hop_start(const transceiver_mode_t mode)
+{
+	hop.rx = (mode == TRANSCEIVER_MODE_RX_HOP);
+	hop.resume_mode = hop.rx ? M0_MODE_RX : M0_MODE_TX_RUN;
+	hop.index = 0;
+	hop.cycle = 0;
+	if (hop_entries == 0) {
+		return;
+	}
+	hop_apply(0);
+	hop_schedule_start(&hop.schedule, hop_gap, hop.entry.dwell);
+	m0_state.next_mode = HOP_GAP_MODE;
+	m0_state.threshold = hop.schedule.boundary;
+}
+
+/*
+ * Called repeatedly while streaming in a hop mode. Hop mode uses timed M0
+ * operations much as sweep mode does:
+ *
+ * 1. The M0 switches to WAIT at the end of each dwell, so the last sample
+ *    at the old frequency is always the same one. WAIT writes zeros, so
+ *    in TX the carrier is muted for the whole gap.
+ *
+ * 2. The M4 sees the M0 count pass the end of the dwell, and has the M0
+ *    resume RX or TX at the end of a fixed gap. It then retunes and sets
+ *    the gains during the gap.
+ *
+ * 3. In RX, the M4 writes a tag at the start of the gap, which the M0
+ *    doesn't write to, giving the new frequency and the resume position.
+ *
+ * 4. Once the M0 has resumed, the M4 sets the end of the next dwell.
+ *
+ * Positions therefore follow from the table alone, so TX samples are
+ * sent at the intended frequency. If the M4 is too late to arm the end of
+ * a dwell or gap, for example while a slow control request runs, it is
+ * moved to the first position the M4 can still arm, later positions move
+ * with it, and the tag for the hop is flagged as late.
+ */
+void hop_run(void)
+{
+	hop_schedule_t* const schedule = &hop.schedule;
+	hop_tag_t tag;
+
+	if (hop_entries == 0) {
+		return;
+	}
+
+	switch (hop_schedule_step(schedule, m0_state.m0_count, hop.entry.dwell)) {
+	case HOP_STEP_NONE:
+		return;
+	case HOP_STEP_DWELL:
+		m0_state.next_mode = HOP_GAP_MODE;
+		m0_state.threshold = schedule->boundary;
+		return;
+	case HOP_STEP_GAP:
+		m0_state.next_mode = hop.resume_mode;
+		m0_state.threshold = schedule->resume;
+		break;
+	}
+
+	hop.index++;
+	if (hop.index == hop_entries) {
+		hop.index = 0;
+		hop.cycle++;
+	}
+	hop_apply(hop.index);
+
+	if (hop.rx) {
+		tag.freq = hop.entry.freq;
+		tag.cycle = hop.cycle;
+		tag.index = hop.index;
+		tag.flags = 0;
+		if (schedule->late ||
+		    ((int32_t) (m0_state.m0_count - schedule->resume) > 0)) {
+			tag.flags |= HOP_TAG_FLAG_LATE;
+		}
+		tag.resume = schedule->resume;
+		hop_tag_pack(
+			&tag,
+			&usb_bulk_buffer[schedule->boundary & USB_BULK_BUFFER_MASK]);
+	}
+	schedule->late = false;
+}
+
+/*
+ * True if the tag at the end of the current dwell lies before end but
+ * hasn't been written yet. The bulk transfer holding it must wait until
+ * it has, or the host would receive the gap without its tag.
+ */
+bool hop_tag_pending(const uint32_t end)
+{
+	return hop.rx && (hop_entries > 0) && !hop.schedule.resuming &&
+		((int32_t) (end - hop.schedule.boundary) > 0);
+}
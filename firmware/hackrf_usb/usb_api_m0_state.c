@@ -23,9 +23,62 @@
 
 #include <libopencm3/lpc43xx/sgpio.h>
 #include <stddef.h>
+#include <string.h>
 #include <usb_request.h>
 #include <usb_queue.h>
 
+/*
+ * The M0 only logs shortfalls, and the histogram is built here from
+ * completed log entries before the M0 overwrites them.
+ */
+static struct {
+	uint32_t binned;
+	uint32_t missed;
+	uint32_t histogram[M0_SHORTFALL_HISTOGRAM_BINS];
+} telemetry;
+
+static void m0_telemetry_reset(void)
+{
+	memset(&telemetry, 0, sizeof(telemetry));
+}
+
+static uint8_t shortfall_bin(uint32_t length)
+{
+	uint8_t bin = 0;
+
+	while ((length >= 64) && (bin < (M0_SHORTFALL_HISTOGRAM_BINS - 1))) {
+		length >>= 1;
+		bin++;
+	}
+	return bin;
+}
+
+/*
+ * Bin shortfalls that the M0 has finished logging. While the M0 is running,
+ * the latest shortfall may still be growing, so it is left until another
+ * one starts or the M0 stops. Only called from the main loop, so that the
+ * USB ISR never sees the histogram half updated by itself.
+ */
+void m0_telemetry_update(const bool stopped)
+{
+	uint32_t logged = m0_state.num_shortfalls;
+	uint32_t index, length;
+
+	if (!stopped && (logged > 0)) {
+		logged--;
+	}
+	if ((logged - telemetry.binned) > M0_SHORTFALL_LOG_SIZE) {
+		telemetry.missed += logged - telemetry.binned - M0_SHORTFALL_LOG_SIZE;
+		telemetry.binned = logged - M0_SHORTFALL_LOG_SIZE;
+	}
+	while (telemetry.binned < logged) {
+		index = telemetry.binned % M0_SHORTFALL_LOG_SIZE;
+		length = m0_shortfall_log.entries[index].length;
+		telemetry.histogram[shortfall_bin(length)]++;
+		telemetry.binned++;
+	}
+}
+
 void m0_set_mode(enum m0_mode mode)
 {
 	// Set requested mode and flag bit.
@@ -39,6 +92,14 @@ void m0_set_mode(enum m0_mode mode)
 
 	// Wait for M0 to acknowledge by clearing the flag.
 	while (m0_state.requested_mode & M0_REQUEST_FLAG) {}
+
+	// The M0 resets its statistics when it leaves IDLE mode, and any
+	// ongoing shortfall has ended once it returns.
+	if (mode == M0_MODE_IDLE) {
+		m0_telemetry_update(true);
+	} else {
+		m0_telemetry_reset();
+	}
 }
 
 usb_request_status_t usb_vendor_request_get_m0_state(
@@ -58,3 +119,42 @@ usb_request_status_t usb_vendor_request_get_m0_state(
 		return USB_REQUEST_STATUS_OK;
 	}
 }
+
+usb_request_status_t usb_vendor_request_get_m0_telemetry(
+	usb_endpoint_t* const endpoint,
+	const usb_transfer_stage_t stage)
+{
+	static struct m0_telemetry report;
+	uint32_t first, index, i;
+
+	// This runs in the USB ISR, so it only takes a snapshot of the
+	// histogram. The main loop keeps it up to date while streaming, and
+	// m0_set_mode() completes it when the M0 stops.
+	if (stage == USB_TRANSFER_STAGE_SETUP) {
+		report.min_margin = m0_shortfall_log.min_margin;
+		report.num_shortfalls = m0_state.num_shortfalls;
+		report.histogram_missed = telemetry.missed;
+		memcpy(report.histogram, telemetry.histogram, sizeof(report.histogram));
+
+		// Copy the most recent entries, oldest first.
+		report.num_recent = report.num_shortfalls;
+		if (report.num_recent > M0_SHORTFALL_LOG_SIZE) {
+			report.num_recent = M0_SHORTFALL_LOG_SIZE;
+		}
+		first = report.num_shortfalls - report.num_recent;
+		for (i = 0; i < report.num_recent; i++) {
+			index = (first + i) % M0_SHORTFALL_LOG_SIZE;
+			report.recent[i].start = m0_shortfall_log.entries[index].start;
+			report.recent[i].length = m0_shortfall_log.entries[index].length;
+		}
+
+		usb_transfer_schedule_block(
+			endpoint->in,
+			&report,
+			sizeof(report),
+			NULL,
+			NULL);
+		usb_transfer_schedule_ack(endpoint->out);
+	}
+	return USB_REQUEST_STATUS_OK;
+}
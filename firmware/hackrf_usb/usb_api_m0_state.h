@@ -22,6 +22,7 @@
 #ifndef __M0_STATE_H__
 #define __M0_STATE_H__
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <usb_request.h>
 
@@ -40,6 +41,34 @@ struct m0_state {
 	uint32_t error;
 };
 
+/* Must match the log size in sgpio_m0.s. */
+#define M0_SHORTFALL_LOG_SIZE 32
+
+/* Shortfall lengths are binned by powers of two, starting from 32 bytes. */
+#define M0_SHORTFALL_HISTOGRAM_BINS 16
+
+struct m0_shortfall {
+	uint32_t start;
+	uint32_t length;
+};
+
+/* Written by the M0, at a fixed offset after m0_state. */
+struct m0_shortfall_log {
+	uint32_t min_margin;
+	uint32_t offset;
+	struct m0_shortfall entries[M0_SHORTFALL_LOG_SIZE];
+};
+
+/* Reported to the host by usb_vendor_request_get_m0_telemetry(). */
+struct m0_telemetry {
+	uint32_t min_margin;
+	uint32_t num_shortfalls;
+	uint32_t histogram_missed;
+	uint32_t histogram[M0_SHORTFALL_HISTOGRAM_BINS];
+	uint32_t num_recent;
+	struct m0_shortfall recent[M0_SHORTFALL_LOG_SIZE];
+};
+
 enum m0_mode {
 	M0_MODE_IDLE = 0,
 	M0_MODE_WAIT = 1,
@@ -54,16 +83,22 @@ enum m0_error {
 	M0_ERROR_TX_TIMEOUT = 2,
 };
 
-/* Address of m0_state is set in ldscripts. If you change the name of this
- * variable, it won't be where it needs to be in the processor's address space,
- * unless you also adjust the ldscripts.
+/* Addresses of m0_state and m0_shortfall_log are set in ldscripts. If you
+ * change the name of these variables, they won't be where they need to be in
+ * the processor's address space, unless you also adjust the ldscripts.
  */
 extern volatile struct m0_state m0_state;
+extern volatile struct m0_shortfall_log m0_shortfall_log;
 
 void m0_set_mode(enum m0_mode mode);
+void m0_telemetry_update(const bool stopped);
 
 usb_request_status_t usb_vendor_request_get_m0_state(
 	usb_endpoint_t* const endpoint,
 	const usb_transfer_stage_t stage);
 
+usb_request_status_t usb_vendor_request_get_m0_telemetry(
+	usb_endpoint_t* const endpoint,
+	const usb_transfer_stage_t stage);
+
 #endif /*__M0_STATE_H__*/
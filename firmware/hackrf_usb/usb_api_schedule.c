@@ -0,0 +1,193 @@
+/*
+ * Copyright 2026 Great Scott Gadgets <info@greatscottgadgets.com>
+ *
+ * This file is part of HackRF.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "usb_api_schedule.h"
+
+#include "usb_queue.h"
+#include <stddef.h>
+#include "command_queue.h"
+#include "hackrf_ui.h"
+#include "max283x.h"
+#include "operacake.h"
+#include "rf_path.h"
+#include "usb_api_m0_state.h"
+#include "usb_api_tuning.h"
+
+#include <libopencm3/lpc43xx/m4/nvic.h>
+
+#define SCHEDULE_FLAG_CLEAR (1 << 0)
+
+static command_queue_t queue;
+/* New commands are inserted here first, so that none is queued unless all are. */
+static command_queue_t pending;
+static uint8_t schedule_data[COMMAND_QUEUE_SIZE * COMMAND_SIZE];
+/* Set once the first command's mode switch has been handed to the M0. */
+static bool armed = false;
+static uint32_t armed_position;
+
+/* Must be called from an atomic context. */
+static void disarm(void)
+{
+	if (armed) {
+		// If the M0 has already switched, this leaves it in the new mode
+		// and the command is simply armed again.
+		m0_state.next_mode = m0_state.active_mode;
+		armed = false;
+	}
+}
+
+/* Must be called from an atomic context (normally USB ISR) */
+void scheduled_commands_clear(void)
+{
+	disarm();
+	command_queue_init(&queue);
+}
+
+/*
+ * The setup value holds flags, and the data holds packed commands. Every
+ * command is checked before any is queued. Positions must be after the
+ * current M0 count, which restarts at zero when streaming starts, and
+ * pause or resume must leave COMMAND_ARM_GUARD bytes to arm them.
+ */
+usb_request_status_t usb_vendor_request_schedule_commands(
+	usb_endpoint_t* const endpoint,
+	const usb_transfer_stage_t stage)
+{
+	command_t command;
+	uint32_t now;
+	uint16_t count, i;
+
+	if (stage == USB_TRANSFER_STAGE_SETUP) {
+		if ((endpoint->setup.length % COMMAND_SIZE) ||
+		    (endpoint->setup.length > sizeof(schedule_data))) {
+			return USB_REQUEST_STATUS_STALL;
+		}
+		if (endpoint->setup.length == 0) {
+			if (endpoint->setup.value & SCHEDULE_FLAG_CLEAR) {
+				scheduled_commands_clear();
+			}
+			usb_transfer_schedule_ack(endpoint->in);
+		} else {
+			usb_transfer_schedule_block(
+				endpoint->out,
+				schedule_data,
+				endpoint->setup.length,
+				NULL,
+				NULL);
+		}
+	} else if (stage == USB_TRANSFER_STAGE_DATA) {
+		count = endpoint->setup.length / COMMAND_SIZE;
+		now = (m0_state.active_mode == M0_MODE_IDLE) ? 0 : m0_state.m0_count;
+		if (endpoint->setup.value & SCHEDULE_FLAG_CLEAR) {
+			scheduled_commands_clear();
+		}
+		pending = queue;
+		for (i = 0; i < count; i++) {
+			command_unpack(&schedule_data[i * COMMAND_SIZE], &command);
+			if (!command_valid(&command) ||
+			    !command_queue_insert(&pending, &command, now)) {
+				return USB_REQUEST_STATUS_STALL;
+			}
+		}
+		// A new first command may have to be armed instead.
+		disarm();
+		queue = pending;
+		usb_transfer_schedule_ack(endpoint->in);
+	}
+	return USB_REQUEST_STATUS_OK;
+}
+
+static void command_apply(const command_t* const command)
+{
+	switch (command->type) {
+	case COMMAND_SET_FREQ:
+		tuning_table_set_freq(command->value);
+		break;
+	case COMMAND_LNA_GAIN:
+		max283x_set_lna_gain(&max283x, command->value);
+		hackrf_ui()->set_bb_lna_gain(command->value);
+		break;
+	case COMMAND_VGA_GAIN:
+		max283x_set_vga_gain(&max283x, command->value);
+		hackrf_ui()->set_bb_vga_gain(command->value);
+		break;
+	case COMMAND_TXVGA_GAIN:
+		max283x_set_txvga_gain(&max283x, command->value);
+		hackrf_ui()->set_bb_tx_vga_gain(command->value);
+		break;
+	case COMMAND_AMP_ENABLE:
+		rf_path_set_lna(&rf_path, command->value);
+		break;
+	case COMMAND_OPERACAKE_PORTS:
+		operacake_set_ports(
+			command->value & 0xff,
+			(command->value >> 8) & 0xff,
+			(command->value >> 16) & 0xff);
+		break;
+	default:
+		break;
+	}
+}
+
+/*
+ * Called repeatedly while streaming in RX or TX mode. Settings are applied
+ * by the M4 as soon as their position has been reached. Pausing and
+ * resuming are handed to the M0, which switches modes at exactly the
+ * given position, so the first command is armed as soon as it is reached
+ * in the queue.
+ */
+void scheduled_commands_run(const transceiver_mode_t mode)
+{
+	const command_t* command;
+	uint32_t now;
+
+	if (command_queue_head(&queue) == NULL) {
+		return;
+	}
+
+	nvic_disable_irq(NVIC_USB0_IRQ);
+	command = command_queue_head(&queue);
+	now = m0_state.m0_count;
+	if (command == NULL) {
+		// Cleared since the check above.
+	} else if (!command_switches_mode(command)) {
+		if (command_queue_due(&queue, now)) {
+			command_apply(command);
+			command_queue_pop(&queue);
+		}
+	} else if (!armed) {
+		armed_position = command_arm_position(command->when, now);
+		if (command->type == COMMAND_PAUSE) {
+			// WAIT writes zeros, so a paused TX stream is silent.
+			m0_state.next_mode = M0_MODE_WAIT;
+		} else if (mode == TRANSCEIVER_MODE_TX) {
+			m0_state.next_mode = M0_MODE_TX_RUN;
+		} else {
+			m0_state.next_mode = M0_MODE_RX;
+		}
+		m0_state.threshold = armed_position;
+		armed = true;
+	} else if ((int32_t) (now - armed_position) >= 0) {
+		armed = false;
+		command_queue_pop(&queue);
+	}
+	nvic_enable_irq(NVIC_USB0_IRQ);
+}
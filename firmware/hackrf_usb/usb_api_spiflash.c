@@ -23,17 +23,48 @@
 
 #include "usb_api_spiflash.h"
 
+#include "usb_api_transceiver.h"
+#include "usb_bulk_buffer.h"
+#include "usb_endpoint.h"
 #include "usb_queue.h"
 
 #include <stddef.h>
+#include <string.h>
 
 #include <hackrf_core.h>
+#include <spiflash_image.h>
 
 #include <w25q80bv.h>
 
 /* Buffer size == spi_flash.page_len */
 uint8_t spiflash_buffer[256U];
 
+/*
+ * Image data for spiflash_program_mode() is received into two alternate
+ * chunks of the bulk buffer, so that one can be written to flash
+ * while the other is being filled.
+ */
+#define SPIFLASH_CHUNK_SIZE USB_TRANSFER_SIZE
+
+#define SPIFLASH_PROGRAM_IDLE   0
+#define SPIFLASH_PROGRAM_BUSY   1
+#define SPIFLASH_PROGRAM_DONE   2
+#define SPIFLASH_PROGRAM_FAILED 3
+
+typedef struct {
+	uint32_t processed;
+	uint32_t crc;
+	uint8_t state;
+	uint8_t reserved[3];
+} spiflash_program_status_t;
+
+static uint32_t spiflash_program_length;
+static spiflash_image_t spiflash_program_image;
+static volatile spiflash_program_status_t spiflash_program_status;
+
+static volatile uint32_t spiflash_chunk_length;
+static volatile bool spiflash_chunk_ready;
+
 usb_request_status_t usb_vendor_request_erase_spiflash(
 	usb_endpoint_t* const endpoint,
 	const usb_transfer_stage_t stage)
@@ -159,3 +190,148 @@ usb_request_status_t usb_vendor_request_spiflash_clear_status(
 	}
 	return USB_REQUEST_STATUS_OK;
 }
+
+/*
+ * Start writing an image to the flash. The setup value and index give the
+ * start address, which must be on a sector boundary, and the data stage
+ * the image length. The image is then sent on the bulk OUT endpoint and
+ * written by spiflash_program_mode().
+ */
+usb_request_status_t usb_vendor_request_spiflash_program(
+	usb_endpoint_t* const endpoint,
+	const usb_transfer_stage_t stage)
+{
+	uint32_t addr;
+
+	if (stage == USB_TRANSFER_STAGE_SETUP) {
+		if (endpoint->setup.length != sizeof(spiflash_program_length)) {
+			return USB_REQUEST_STATUS_STALL;
+		}
+		usb_transfer_schedule_block(
+			endpoint->out,
+			&spiflash_program_length,
+			sizeof(spiflash_program_length),
+			NULL,
+			NULL);
+	} else if (stage == USB_TRANSFER_STAGE_DATA) {
+		addr = (endpoint->setup.value << 16) | endpoint->setup.index;
+		// The flash size is only known once the driver is set up.
+		spi_bus_start(spi_flash.bus, &ssp_config_w25q80bv);
+		w25q80bv_setup(&spi_flash);
+		if (!spiflash_image_init(
+			    &spiflash_program_image,
+			    &spi_flash,
+			    addr,
+			    spiflash_program_length)) {
+			// Don't leave the status of a previous image behind.
+			spiflash_program_status.processed = 0;
+			spiflash_program_status.crc = 0;
+			spiflash_program_status.state = SPIFLASH_PROGRAM_FAILED;
+			return USB_REQUEST_STATUS_STALL;
+		}
+		spiflash_program_status.processed = 0;
+		spiflash_program_status.crc = 0;
+		spiflash_program_status.state = SPIFLASH_PROGRAM_BUSY;
+		request_transceiver_mode(TRANSCEIVER_MODE_SPIFLASH_PROGRAM);
+		usb_transfer_schedule_ack(endpoint->in);
+	}
+	return USB_REQUEST_STATUS_OK;
+}
+
+usb_request_status_t usb_vendor_request_spiflash_program_status(
+	usb_endpoint_t* const endpoint,
+	const usb_transfer_stage_t stage)
+{
+	if (stage == USB_TRANSFER_STAGE_SETUP) {
+		memcpy(endpoint->buffer,
+		       (void*) &spiflash_program_status,
+		       sizeof(spiflash_program_status));
+		usb_transfer_schedule_block(
+			endpoint->in,
+			endpoint->buffer,
+			sizeof(spiflash_program_status),
+			NULL,
+			NULL);
+		usb_transfer_schedule_ack(endpoint->out);
+	}
+	return USB_REQUEST_STATUS_OK;
+}
+
+static void spiflash_chunk_received(void* user_data, unsigned int length)
+{
+	(void) user_data;
+	spiflash_chunk_length = length;
+	spiflash_chunk_ready = true;
+}
+
+static void spiflash_receive_chunk(uint8_t* const buffer, const uint32_t length)
+{
+	spiflash_chunk_ready = false;
+	usb_transfer_schedule_block(
+		&usb_endpoint_bulk_out,
+		buffer,
+		length,
+		spiflash_chunk_received,
+		NULL);
+}
+
+/*
+ * Receive an image on the bulk OUT endpoint and write it to the flash,
+ * erasing and programming only the sectors that differ. Each sector is
+ * read back once it has been written, and the CRC-32 of the region is
+ * reported through the status request, so that the host does not need
+ * to read the image back to verify it.
+ */
+void spiflash_program_mode(uint32_t seq)
+{
+	spiflash_image_t* const image = &spiflash_program_image;
+	const uint32_t end = image->end;
+	uint32_t addr = image->start;
+	uint32_t requested, length, received;
+	uint8_t* chunk;
+	unsigned int buffer = 0;
+
+	spi_bus_start(spi_flash.bus, &ssp_config_w25q80bv);
+	w25q80bv_setup(&spi_flash);
+
+	length = (end - addr > SPIFLASH_CHUNK_SIZE) ? SPIFLASH_CHUNK_SIZE : end - addr;
+	spiflash_receive_chunk(&usb_bulk_buffer[0], length);
+	requested = addr + length;
+
+	while (addr < end) {
+		while (!spiflash_chunk_ready) {
+			if (transceiver_request.seq != seq) {
+				spiflash_program_status.state = SPIFLASH_PROGRAM_FAILED;
+				return;
+			}
+		}
+		received = spiflash_chunk_length;
+		if (received != length) {
+			spiflash_program_status.state = SPIFLASH_PROGRAM_FAILED;
+			break;
+		}
+		chunk = &usb_bulk_buffer[buffer * SPIFLASH_CHUNK_SIZE];
+
+		// Receive the next chunk while this one is written.
+		buffer ^= 1;
+		if (requested < end) {
+			length = (end - requested > SPIFLASH_CHUNK_SIZE) ?
+				SPIFLASH_CHUNK_SIZE :
+				end - requested;
+			spiflash_receive_chunk(
+				&usb_bulk_buffer[buffer * SPIFLASH_CHUNK_SIZE],
+				length);
+			requested += length;
+		}
+
+		spiflash_image_write(image, addr, chunk, received);
+		addr += received;
+		spiflash_program_status.processed = addr - image->start;
+	}
+
+	if (addr == end) {
+		spiflash_program_status.crc = spiflash_image_crc(image);
+		spiflash_program_status.state = SPIFLASH_PROGRAM_DONE;
+	}
+	while (transceiver_request.seq == seq) {}
+}
@@ -26,6 +26,7 @@
 
 #include <usb_type.h>
 #include <usb_request.h>
+#include <stdint.h>
 
 usb_request_status_t usb_vendor_request_erase_spiflash(
 	usb_endpoint_t* const endpoint,
@@ -42,5 +43,13 @@ usb_request_status_t usb_vendor_request_spiflash_status(
 usb_request_status_t usb_vendor_request_spiflash_clear_status(
 	usb_endpoint_t* const endpoint,
 	const usb_transfer_stage_t stage);
+usb_request_status_t usb_vendor_request_spiflash_program(
+	usb_endpoint_t* const endpoint,
+	const usb_transfer_stage_t stage);
+usb_request_status_t usb_vendor_request_spiflash_program_status(
+	usb_endpoint_t* const endpoint,
+	const usb_transfer_stage_t stage);
+
+void spiflash_program_mode(uint32_t seq);
 
 #endif /* end of include guard: __USB_API_SPIFLASH_H__ */
@@ -28,25 +28,91 @@
 #include "usb_bulk_buffer.h"
 #include "usb_api_m0_state.h"
 #include "tuning.h"
+#include "tuning_plan.h"
 #include "usb_endpoint.h"
 #include "streaming.h"
+#include "sweep_schedule.h"
+#include "usb_api_tuning.h"
+#include "spectrum.h"
 
 #include <libopencm3/lpc43xx/m4/nvic.h>
 
-#define MIN(x, y)         ((x) < (y) ? (x) : (y))
-#define MAX(x, y)         ((x) > (y) ? (x) : (y))
-#define FREQ_GRANULARITY  1000000
-#define MAX_RANGES        10
-#define THROWAWAY_BUFFERS 2
+#define MIN(x, y)          ((x) < (y) ? (x) : (y))
+#define MAX(x, y)          ((x) > (y) ? (x) : (y))
+#define FREQ_GRANULARITY   1000000
+#define MAX_RANGES         10
+#define MAX_LIST_ENTRIES   512
+#define LIST_HEADER_SIZE   8
+#define LIST_ENTRY_SIZE    12
+#define LIST_CHUNK_ENTRIES 64
+#define MIN_BLOCK_SIZE     USB_MIN_TRANSFER_SIZE
+#define DEFAULT_BLOCK_SIZE 0x4000
+/*
+ * Unless the host configures sweep timing, skip two blocks' worth of
+ * samples after every block, as earlier firmware did.
+ */
+#define DEFAULT_MIN_GAP 0x8000
+
+/*
+ * Each block starts with a header of 0x7f 0x7f, the frequency (uint64),
+ * the sweep sequence number (uint32), the index of the tuning within the
+ * sweep (uint16), the index of the block at that tuning (uint16), flags
+ * (uint16) and the m0_count at the start of the block (uint32), 24 bytes
+ * in all. The sequence number counts completed sweeps.
+ */
+#define BLOCK_FLAG_SHORTFALL     (1 << 0)
+#define BLOCK_FLAG_RETUNE_FAILED (1 << 1)
 
 static uint64_t sweep_freq;
+static uint32_t sweep_seq;
+static uint16_t sweep_step;
 static uint16_t frequencies[MAX_RANGES * 2];
 static unsigned char data[9 + MAX_RANGES * 2 * sizeof(frequencies[0])];
 static uint16_t num_ranges = 0;
-static uint32_t dwell_blocks = 0;
+static uint32_t dwell_bytes = 0;
+/* Frequency list used instead of ranges when list_entries is nonzero. */
+static uint64_t list_freq[MAX_LIST_ENTRIES];
+static uint32_t list_dwell[MAX_LIST_ENTRIES];
+static uint16_t list_entries = 0;
+static uint16_t list_received = 0;
+static unsigned char list_data[LIST_HEADER_SIZE + LIST_CHUNK_ENTRIES * LIST_ENTRY_SIZE];
 static uint32_t step_width = 0;
 static uint32_t offset = 0;
 static enum sweep_style style = LINEAR;
+static uint32_t block_size = DEFAULT_BLOCK_SIZE;
+static uint32_t settle = 0;
+static uint32_t min_gap = DEFAULT_MIN_GAP;
+static sweep_schedule_t schedule;
+/* Averaged spectra are sent instead of samples when spectrum_size is nonzero. */
+static uint16_t spectrum_size = 0;
+static spectrum_t spectrum;
+static uint8_t spectrum_record[SPECTRUM_RECORD_SIZE(SPECTRUM_MAX_SIZE)];
+static volatile bool spectrum_record_busy = false;
+/* Number of shortfalls already placed before the current block's end. */
+static uint32_t shortfalls_placed;
+
+/* Timing and spectrum mode must be configured again after each init. */
+static void reset_options(void)
+{
+	block_size = DEFAULT_BLOCK_SIZE;
+	settle = 0;
+	min_gap = DEFAULT_MIN_GAP;
+	spectrum_size = 0;
+}
+
+static uint32_t read_le32(const unsigned char* const p)
+{
+	return ((uint32_t) (p[3]) << 24) | ((uint32_t) (p[2]) << 16) |
+		((uint32_t) (p[1]) << 8) | p[0];
+}
+
+static void write_le32(unsigned char* const p, const uint32_t value)
+{
+	p[0] = value & 0xff;
+	p[1] = (value >> 8) & 0xff;
+	p[2] = (value >> 16) & 0xff;
+	p[3] = (value >> 24) & 0xff;
+}
 
 /* Do this before starting sweep mode with request_transceiver_mode(). */
 usb_request_status_t usb_vendor_request_init_sweep(
@@ -57,10 +123,12 @@ usb_request_status_t usb_vendor_request_init_sweep(
 	int i;
 	if (stage == USB_TRANSFER_STAGE_SETUP) {
 		num_bytes = (endpoint->setup.index << 16) | endpoint->setup.value;
-		dwell_blocks = num_bytes / 0x4000;
-		if (1 > dwell_blocks) {
+		if (MIN_BLOCK_SIZE > num_bytes) {
 			return USB_REQUEST_STATUS_STALL;
 		}
+		dwell_bytes = num_bytes;
+		list_entries = 0;
+		reset_options();
 		num_ranges = (endpoint->setup.length - 9) / (2 * sizeof(frequencies[0]));
 		if ((1 > num_ranges) || (MAX_RANGES < num_ranges)) {
 			return USB_REQUEST_STATUS_STALL;
@@ -72,13 +140,11 @@ usb_request_status_t usb_vendor_request_init_sweep(
 			NULL,
 			NULL);
 	} else if (stage == USB_TRANSFER_STAGE_DATA) {
-		step_width = ((uint32_t) (data[3]) << 24) | ((uint32_t) (data[2]) << 16) |
-			((uint32_t) (data[1]) << 8) | data[0];
+		step_width = read_le32(&data[0]);
 		if (1 > step_width) {
 			return USB_REQUEST_STATUS_STALL;
 		}
-		offset = ((uint32_t) (data[7]) << 24) | ((uint32_t) (data[6]) << 16) |
-			((uint32_t) (data[5]) << 8) | data[4];
+		offset = read_le32(&data[4]);
 		style = data[8];
 		if (INTERLEAVED < style) {
 			return USB_REQUEST_STATUS_STALL;
@@ -88,20 +154,259 @@ usb_request_status_t usb_vendor_request_init_sweep(
 				((uint16_t) (data[10 + i * 2]) << 8) + data[9 + i * 2];
 		}
 		sweep_freq = (uint64_t) frequencies[0] * FREQ_GRANULARITY;
-		set_freq(sweep_freq + offset);
+		if (!set_freq(sweep_freq + offset)) {
+			return USB_REQUEST_STATUS_STALL;
+		}
+		usb_transfer_schedule_ack(endpoint->in);
+	}
+	return USB_REQUEST_STATUS_OK;
+}
+
+/*
+ * Alternative to usb_vendor_request_init_sweep() that sweeps through an
+ * explicit list of frequencies in Hz, each with its own dwell. Each
+ * request carries a header (uint32 offset, uint16 index of the first
+ * entry, uint16 total number of entries) followed by up to
+ * LIST_CHUNK_ENTRIES entries (uint64 frequency, uint32 dwell bytes).
+ * Chunks must be sent in order, and the list is used once the last one
+ * has arrived. Each frequency, with the offset added, must be one that
+ * can be tuned to. Unlike usb_vendor_request_init_sweep(), this keeps the
+ * block size, settle time and spectrum mode already set.
+ */
+usb_request_status_t usb_vendor_request_init_sweep_list(
+	usb_endpoint_t* const endpoint,
+	const usb_transfer_stage_t stage)
+{
+	uint16_t first, total, count, i;
+	const unsigned char* entry;
+	tuning_if_plan_t plan;
+	uint32_t list_offset;
+
+	if (stage == USB_TRANSFER_STAGE_SETUP) {
+		if ((LIST_HEADER_SIZE + LIST_ENTRY_SIZE > endpoint->setup.length) ||
+		    (sizeof(list_data) < endpoint->setup.length) ||
+		    ((endpoint->setup.length - LIST_HEADER_SIZE) % LIST_ENTRY_SIZE)) {
+			return USB_REQUEST_STATUS_STALL;
+		}
+		usb_transfer_schedule_block(
+			endpoint->out,
+			&list_data,
+			endpoint->setup.length,
+			NULL,
+			NULL);
+	} else if (stage == USB_TRANSFER_STAGE_DATA) {
+		first = ((uint16_t) (list_data[5]) << 8) | list_data[4];
+		total = ((uint16_t) (list_data[7]) << 8) | list_data[6];
+		count = (endpoint->setup.length - LIST_HEADER_SIZE) / LIST_ENTRY_SIZE;
+		list_offset = read_le32(list_data);
+		if (0 == first) {
+			list_entries = 0;
+			list_received = 0;
+		}
+		if ((first != list_received) || (MAX_LIST_ENTRIES < total) ||
+		    ((first + count) > total)) {
+			return USB_REQUEST_STATUS_STALL;
+		}
+		for (i = 0; i < count; i++) {
+			entry = &list_data[LIST_HEADER_SIZE + i * LIST_ENTRY_SIZE];
+			list_freq[first + i] = ((uint64_t) read_le32(&entry[4]) << 32) |
+				read_le32(entry);
+			list_dwell[first + i] = read_le32(&entry[8]);
+			if ((MIN_BLOCK_SIZE > list_dwell[first + i]) ||
+			    !tuning_if_plan(list_freq[first + i] + list_offset, &plan)) {
+				return USB_REQUEST_STATUS_STALL;
+			}
+		}
+		list_received = first + count;
+		if (list_received == total) {
+			offset = list_offset;
+			sweep_freq = list_freq[0];
+			if (!set_freq(sweep_freq + offset)) {
+				return USB_REQUEST_STATUS_STALL;
+			}
+			list_entries = total;
+		}
 		usb_transfer_schedule_ack(endpoint->in);
 	}
 	return USB_REQUEST_STATUS_OK;
 }
 
+/* Do this after usb_vendor_request_init_sweep() to use a shorter settle time. */
+usb_request_status_t usb_vendor_request_set_sweep_timing(
+	usb_endpoint_t* const endpoint,
+	const usb_transfer_stage_t stage)
+{
+	uint32_t size;
+	if (stage == USB_TRANSFER_STAGE_SETUP) {
+		size = endpoint->setup.index;
+		if ((MIN_BLOCK_SIZE > size) || (DEFAULT_BLOCK_SIZE < size) ||
+		    (size & (size - 1))) {
+			return USB_REQUEST_STATUS_STALL;
+		}
+		block_size = size;
+		// Settle time is given in samples, two bytes each.
+		settle = endpoint->setup.value * 2;
+		min_gap = 0;
+		usb_transfer_schedule_ack(endpoint->in);
+	}
+	return USB_REQUEST_STATUS_OK;
+}
+
+/*
+ * Do this after usb_vendor_request_init_sweep() to have the firmware
+ * average the power spectrum of the samples at each frequency and send
+ * one record per frequency instead of the samples. The setup value gives
+ * the FFT size, or zero to send samples.
+ */
+usb_request_status_t usb_vendor_request_set_sweep_spectrum(
+	usb_endpoint_t* const endpoint,
+	const usb_transfer_stage_t stage)
+{
+	if (stage == USB_TRANSFER_STAGE_SETUP) {
+		if ((endpoint->setup.value != 0) &&
+		    !spectrum_init(&spectrum, endpoint->setup.value)) {
+			return USB_REQUEST_STATUS_STALL;
+		}
+		spectrum_size = endpoint->setup.value;
+		usb_transfer_schedule_ack(endpoint->in);
+	}
+	return USB_REQUEST_STATUS_OK;
+}
+
+/*
+ * Return true if every dwell, from usb_vendor_request_init_sweep() or the
+ * list, covers at least one block. Sweep mode may only be entered then, as
+ * a shorter dwell would otherwise have to be rounded up to a whole block.
+ */
+bool sweep_ready(void)
+{
+	uint16_t i;
+
+	if (list_entries == 0) {
+		return dwell_bytes >= block_size;
+	}
+	for (i = 0; i < list_entries; i++) {
+		if (list_dwell[i] < block_size) {
+			return false;
+		}
+	}
+	return true;
+}
+
 void sweep_bulk_transfer_complete(void* user_data, unsigned int bytes_transferred)
+{
+	(void) bytes_transferred;
+
+	// Once a block has been sent, the M0 may reuse its space in the
+	// buffer, along with any skipped space that follows it.
+	m0_state.m4_count = sweep_schedule_sent(&schedule, (uint32_t) user_data);
+}
+
+static void spectrum_transfer_complete(void* user_data, unsigned int bytes_transferred)
 {
 	(void) user_data;
 	(void) bytes_transferred;
 
-	// For each buffer transferred, we need to bump the count by three buffers
-	// worth of data, to allow for the discarded buffers.
-	m0_state.m4_count += 3 * 0x4000;
+	spectrum_record_busy = false;
+}
+
+/*
+ * Return true if the M0 logged a shortfall starting within the block that
+ * ends at end, and move past every shortfall that started before end. The
+ * log gives the M0 count at which each shortfall started, so shortfalls
+ * are placed correctly even when the M4 checks after the next block has
+ * begun. A shortfall starting at end lost samples after the block, so it
+ * belongs to the next one. If more shortfalls happened than the log holds
+ * since the last check, the block is flagged, as the lost entries can't be
+ * placed.
+ */
+static bool block_shortfall(const uint32_t end)
+{
+	const uint32_t start = end - block_size;
+	const uint32_t counted = m0_state.num_shortfalls;
+	uint32_t index, position;
+	bool found = false;
+
+	if ((counted - shortfalls_placed) > M0_SHORTFALL_LOG_SIZE) {
+		shortfalls_placed = counted - M0_SHORTFALL_LOG_SIZE;
+		found = true;
+	}
+	while (shortfalls_placed != counted) {
+		index = shortfalls_placed % M0_SHORTFALL_LOG_SIZE;
+		position = m0_shortfall_log.entries[index].start;
+		if ((int32_t) (position - end) >= 0) {
+			break;
+		}
+		if ((int32_t) (position - start) >= 0) {
+			found = true;
+		}
+		shortfalls_placed++;
+	}
+	return found;
+}
+
+/* Add the sweep metadata to the start of a block and schedule its transfer. */
+static void send_block(
+	uint8_t* const buffer,
+	const uint32_t end,
+	const uint16_t block,
+	const uint16_t flags)
+{
+	// Write metadata to buffer.
+	*buffer = 0x7f;
+	*(buffer + 1) = 0x7f;
+	*(buffer + 2) = sweep_freq & 0xff;
+	*(buffer + 3) = (sweep_freq >> 8) & 0xff;
+	*(buffer + 4) = (sweep_freq >> 16) & 0xff;
+	*(buffer + 5) = (sweep_freq >> 24) & 0xff;
+	*(buffer + 6) = (sweep_freq >> 32) & 0xff;
+	*(buffer + 7) = (sweep_freq >> 40) & 0xff;
+	*(buffer + 8) = (sweep_freq >> 48) & 0xff;
+	*(buffer + 9) = (sweep_freq >> 56) & 0xff;
+	write_le32(buffer + 10, sweep_seq);
+	*(buffer + 14) = sweep_step & 0xff;
+	*(buffer + 15) = sweep_step >> 8;
+	*(buffer + 16) = block & 0xff;
+	*(buffer + 17) = block >> 8;
+	*(buffer + 18) = flags & 0xff;
+	*(buffer + 19) = flags >> 8;
+	write_le32(buffer + 20, end - block_size);
+
+	// Set up IN transfer of buffer.
+	usb_transfer_schedule_block(
+		&usb_endpoint_bulk_in,
+		buffer,
+		block_size,
+		sweep_bulk_transfer_complete,
+		(void*) end);
+}
+
+/*
+ * Schedule the transfer of the spectrum averaged at this frequency.
+ * Returns false if the transceiver mode changed while waiting for the
+ * previous record to be sent.
+ */
+static bool send_spectrum(const uint32_t seq)
+{
+	while (spectrum_record_busy) {
+		if (transceiver_request.seq != seq) {
+			return false;
+		}
+	}
+	spectrum_write_record(&spectrum, sweep_freq, spectrum_record);
+	spectrum_record_busy = true;
+	usb_transfer_schedule_block(
+		&usb_endpoint_bulk_in,
+		spectrum_record,
+		SPECTRUM_RECORD_SIZE(spectrum_size),
+		spectrum_transfer_complete,
+		NULL);
+	return true;
+}
+
+static uint32_t block_mode(const bool retune)
+{
+	return sweep_schedule_gapless(&schedule, retune) ? M0_MODE_RX : M0_MODE_WAIT;
 }
 
 void sweep_mode(uint32_t seq)
@@ -109,92 +414,158 @@ void sweep_mode(uint32_t seq)
 	// Sweep mode is implemented using timed M0 operations, as follows:
 	//
 	// 0. M4 initially puts the M0 into RX mode, with an m0_count threshold
-	//    of 16K and a next mode of WAIT.
+	//    of one block. The next mode is WAIT if a retune or minimum gap
+	//    follows the block, or RX if the next block can follow directly.
 	//
-	// 1. M4 spins until the M0 switches to WAIT mode.
+	// 1. M4 spins until the M0 count reaches the end of the block.
 	//
-	// 2. M0 captures one 16K block of samples, and switches to WAIT mode.
+	// 2. If the M0 stayed in RX, M4 immediately sets the threshold and
+	//    next mode for the following block. If that block is to end in
+	//    WAIT but the M0 count has already reached its end, the M0 may
+	//    not switch, so the block after it is resumed as in step 5.
 	//
-	// 3. M4 sees the mode change, advances the m0_count target by 32K, and
-	//    sets next mode to RX.
+	// 3. M4 adds the sweep metadata at the start of the block and
+	//    schedules a bulk transfer for the block. In spectrum mode, M4
+	//    instead adds the power spectrum of the block to the average,
+	//    releases the block, and after the last block at this frequency
+	//    schedules a bulk transfer of the averaged spectrum. Averaging
+	//    keeps up with about 2.8Msps at 256 points (about 90us a frame).
+	//    Above that, the M0 falls short while M4 averages, and blocks
+	//    with a shortfall are skipped, so at 20Msps only about one sample
+	//    in seven is averaged. The record counts the skipped blocks.
 	//
-	// 4. M4 adds the sweep metadata at the start of the block and
-	//    schedules a bulk transfer for the block.
+	// 4. If this was the last block at this frequency, M4 retunes - this
+	//    takes about 760us worst-case.
 	//
-	// 5. M4 retunes - this takes about 760us worst-case, so should be
-	//    complete before the M0 goes back to RX.
+	// 5. If the M0 is in WAIT, M4 places the next block on the first
+	//    block-aligned position at least the settle time after the retune
+	//    completed, sets that as the threshold with a next mode of RX, and
+	//    spins until the M0 resumes RX. It then sets the threshold and next
+	//    mode for the end of that block.
 	//
-	// 6. M4 spins until the M0 mode changes to RX, then advances the
-	//    m0_count limit by 16K and sets the next mode to WAIT.
+	// 6. Process repeats from step 1.
 	//
-	// 7. Process repeats from step 1.
+	// The M0 counts through skipped samples in WAIT mode, so the position
+	// of each block in the buffer follows from its start count. The M4
+	// only credits the M0 with skipped space once all the blocks before it
+	// have been sent, so a slow transfer causes a shortfall rather than an
+	// overwritten block.
 
 	unsigned int blocks_queued = 0;
-	unsigned int phase = 0;
+	uint32_t dwell_blocks;
 	bool odd = true;
+	bool retune;
+	bool gapless;
+	bool wrapped;
 	uint16_t range = 0;
+	uint16_t entry = 0;
+	uint16_t flags;
+	bool retune_failed = false;
+	uint32_t end, start;
 
 	uint8_t* buffer;
 
+	sweep_schedule_init(&schedule, USB_BULK_BUFFER_SIZE, block_size, settle, min_gap);
+	if (spectrum_size > 0) {
+		spectrum_reset(&spectrum);
+		spectrum_record_busy = false;
+	}
+	if (list_entries > 0) {
+		dwell_bytes = list_dwell[0];
+	}
+	dwell_blocks = dwell_bytes / block_size;
+	sweep_seq = 0;
+	sweep_step = 0;
+
 	transceiver_startup(TRANSCEIVER_MODE_RX_SWEEP);
+	shortfalls_placed = m0_state.num_shortfalls;
 
-	// Set M0 to RX first buffer, then wait.
-	m0_state.threshold = 0x4000;
-	m0_state.next_mode = M0_MODE_WAIT;
+	// Set M0 to RX first block.
+	m0_state.threshold = sweep_schedule_block_end(&schedule);
+	m0_state.next_mode = block_mode(1 == dwell_blocks);
 
 	baseband_streaming_enable(&sgpio_config);
 
 	while (transceiver_request.seq == seq) {
-		// Wait for M0 to finish receiving a buffer.
-		while (m0_state.active_mode != M0_MODE_WAIT) {
+		buffer = &usb_bulk_buffer[sweep_schedule_ring_offset(&schedule)];
+		end = sweep_schedule_block_end(&schedule);
+
+		// Wait for M0 to finish receiving the block.
+		while ((int32_t) (m0_state.m0_count - end) < 0) {
 			if (transceiver_request.seq != seq) {
 				goto end;
 			}
 		}
 
-		// Set M0 to switch back to RX after two more buffers.
-		m0_state.threshold += 0x8000;
-		m0_state.next_mode = M0_MODE_RX;
+		retune = (++blocks_queued == dwell_blocks);
 
-		// Write metadata to buffer.
-		buffer = &usb_bulk_buffer[phase * 0x4000];
-		*buffer = 0x7f;
-		*(buffer + 1) = 0x7f;
-		*(buffer + 2) = sweep_freq & 0xff;
-		*(buffer + 3) = (sweep_freq >> 8) & 0xff;
-		*(buffer + 4) = (sweep_freq >> 16) & 0xff;
-		*(buffer + 5) = (sweep_freq >> 24) & 0xff;
-		*(buffer + 6) = (sweep_freq >> 32) & 0xff;
-		*(buffer + 7) = (sweep_freq >> 40) & 0xff;
-		*(buffer + 8) = (sweep_freq >> 48) & 0xff;
-		*(buffer + 9) = (sweep_freq >> 56) & 0xff;
-
-		// Set up IN transfer of buffer.
-		usb_transfer_schedule_block(
-			&usb_endpoint_bulk_in,
-			buffer,
-			0x4000,
-			sweep_bulk_transfer_complete,
-			NULL);
+		flags = 0;
+		if (block_shortfall(end)) {
+			flags |= BLOCK_FLAG_SHORTFALL;
+		}
+		if (retune_failed) {
+			flags |= BLOCK_FLAG_RETUNE_FAILED;
+		}
+		gapless = sweep_schedule_gapless(&schedule, retune);
+		if (gapless) {
+			// M0 is already receiving the next block.
+			nvic_disable_irq(NVIC_USB0_IRQ);
+			sweep_schedule_next(&schedule, false, end);
+			nvic_enable_irq(NVIC_USB0_IRQ);
+			m0_state.threshold = sweep_schedule_block_end(&schedule);
+			m0_state.next_mode =
+				block_mode(blocks_queued + 1 == dwell_blocks);
+			// If the M0 count had already reached the threshold, the M0
+			// may not stop at the end of the block, so resume through
+			// WAIT as if a gap were required.
+			if ((m0_state.next_mode == M0_MODE_WAIT) &&
+			    ((int32_t) (m0_state.m0_count - m0_state.threshold) >= 0)) {
+				sweep_schedule_missed(&schedule);
+			}
+		}
 
-		// Use other buffer next time.
-		phase = (phase + 1) % 2;
+		if (spectrum_size > 0) {
+			// The block can be reused as soon as it has been averaged.
+			// Flagged blocks are left out, and counted in the record.
+			if (flags != 0) {
+				spectrum_skip_block(&spectrum);
+			} else {
+				spectrum_add_block(&spectrum, (int8_t*) buffer, block_size);
+			}
+			nvic_disable_irq(NVIC_USB0_IRQ);
+			m0_state.m4_count = sweep_schedule_sent(&schedule, end);
+			nvic_enable_irq(NVIC_USB0_IRQ);
+			if (retune && !send_spectrum(seq)) {
+				goto end;
+			}
+		} else {
+			send_block(buffer, end, blocks_queued - 1, flags);
+		}
 
-		if (++blocks_queued == dwell_blocks) {
+		if (retune) {
 			// Calculate next sweep frequency.
-			if (INTERLEAVED == style) {
+			wrapped = false;
+			if (list_entries > 0) {
+				entry = (entry + 1) % list_entries;
+				wrapped = (0 == entry);
+				sweep_freq = list_freq[entry];
+				dwell_blocks = list_dwell[entry] / block_size;
+			} else if (INTERLEAVED == style) {
 				if (!odd &&
 				    ((sweep_freq + step_width) >=
 				     ((uint64_t) frequencies[1 + range * 2] *
 				      FREQ_GRANULARITY))) {
 					range = (range + 1) % num_ranges;
+					wrapped = (0 == range);
 					sweep_freq = (uint64_t) frequencies[range * 2] *
 						FREQ_GRANULARITY;
 				} else {
+					// Odd and even steps add up to exactly one
+					// step width, whatever the sample rate.
 					if (odd) {
 						sweep_freq += step_width / 4;
 					} else {
-						sweep_freq += 3 * step_width / 4;
+						sweep_freq += step_width - step_width / 4;
 					}
 				}
 				odd = !odd;
@@ -203,29 +574,49 @@ void sweep_mode(uint32_t seq)
 				    ((uint64_t) frequencies[1 + range * 2] *
 				     FREQ_GRANULARITY)) {
 					range = (range + 1) % num_ranges;
+					wrapped = (0 == range);
 					sweep_freq = (uint64_t) frequencies[range * 2] *
 						FREQ_GRANULARITY;
 				} else {
 					sweep_freq += step_width;
 				}
 			}
-			// Retune to new frequency.
+			if (wrapped) {
+				sweep_seq++;
+				sweep_step = 0;
+			} else {
+				sweep_step++;
+			}
+			// Retune to new frequency. Blocks are flagged until the
+			// next retune if this fails.
 			nvic_disable_irq(NVIC_USB0_IRQ);
-			set_freq(sweep_freq + offset);
+			retune_failed = !tuning_table_set_freq(sweep_freq + offset);
 			nvic_enable_irq(NVIC_USB0_IRQ);
 			blocks_queued = 0;
 		}
 
+		if (gapless) {
+			continue;
+		}
+
+		// Set M0 to switch back to RX at the start of the next block.
+		nvic_disable_irq(NVIC_USB0_IRQ);
+		start = sweep_schedule_next(&schedule, retune, m0_state.m0_count);
+		m0_state.m4_count = schedule.consumed;
+		nvic_enable_irq(NVIC_USB0_IRQ);
+		m0_state.next_mode = M0_MODE_RX;
+		m0_state.threshold = start;
+
 		// Wait for M0 to resume RX.
-		while (m0_state.active_mode != M0_MODE_RX) {
+		while ((int32_t) (m0_state.m0_count - start) < 0) {
 			if (transceiver_request.seq != seq) {
 				goto end;
 			}
 		}
 
-		// Set M0 to switch back to WAIT after filling next buffer.
-		m0_state.threshold += 0x4000;
-		m0_state.next_mode = M0_MODE_WAIT;
+		// Set M0 to switch at the end of the next block.
+		m0_state.threshold = sweep_schedule_block_end(&schedule);
+		m0_state.next_mode = block_mode(blocks_queued + 1 == dwell_blocks);
 	}
 end:
 	transceiver_shutdown();
@@ -36,6 +36,19 @@ usb_request_status_t usb_vendor_request_init_sweep(
 	usb_endpoint_t* const endpoint,
 	const usb_transfer_stage_t stage);
 
+usb_request_status_t usb_vendor_request_init_sweep_list(
+	usb_endpoint_t* const endpoint,
+	const usb_transfer_stage_t stage);
+
+usb_request_status_t usb_vendor_request_set_sweep_timing(
+	usb_endpoint_t* const endpoint,
+	const usb_transfer_stage_t stage);
+
+usb_request_status_t usb_vendor_request_set_sweep_spectrum(
+	usb_endpoint_t* const endpoint,
+	const usb_transfer_stage_t stage);
+
+bool sweep_ready(void);
 void sweep_mode(uint32_t seq);
 
 #endif /* __USB_API_SWEEP_H__ */
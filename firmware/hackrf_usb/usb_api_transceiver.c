@@ -46,8 +46,10 @@
 
 #include "usb_endpoint.h"
 #include "usb_api_sweep.h"
-
-#define USB_TRANSFER_SIZE 0x4000
+#include "usb_api_tuning.h"
+#include "usb_api_schedule.h"
+#include "usb_api_hop.h"
+#include "config_bundle.h"
 
 typedef struct {
 	uint32_t freq_mhz;
@@ -277,6 +279,75 @@ usb_request_status_t usb_vendor_request_set_freq_explicit(
 	}
 }
 
+static uint8_t config_bundle[CONFIG_BUNDLE_MAX_LENGTH];
+
+/*
+ * The filter goes first, as it is the only setting the drivers can still
+ * reject. The frequency and gains have already been checked. The gains
+ * are only staged, and written together by one batched commit once the
+ * frequency has been set.
+ */
+static bool config_bundle_apply(const config_bundle_t* const config)
+{
+	const uint64_t* const values = config->values;
+
+	if ((config->present & (1 << CONFIG_TAG_BASEBAND_FILTER)) &&
+	    !baseband_filter_bandwidth_set(values[CONFIG_TAG_BASEBAND_FILTER])) {
+		return false;
+	}
+	if ((config->present & (1 << CONFIG_TAG_FREQ)) &&
+	    !tuning_table_set_freq(values[CONFIG_TAG_FREQ])) {
+		return false;
+	}
+	if (config->present & (1 << CONFIG_TAG_LNA_GAIN)) {
+		max283x_stage_lna_gain(&max283x, values[CONFIG_TAG_LNA_GAIN]);
+		hackrf_ui()->set_bb_lna_gain(values[CONFIG_TAG_LNA_GAIN]);
+	}
+	if (config->present & (1 << CONFIG_TAG_VGA_GAIN)) {
+		max283x_stage_vga_gain(&max283x, values[CONFIG_TAG_VGA_GAIN]);
+		hackrf_ui()->set_bb_vga_gain(values[CONFIG_TAG_VGA_GAIN]);
+	}
+	if (config->present & (1 << CONFIG_TAG_TXVGA_GAIN)) {
+		max283x_stage_txvga_gain(&max283x, values[CONFIG_TAG_TXVGA_GAIN]);
+		hackrf_ui()->set_bb_tx_vga_gain(values[CONFIG_TAG_TXVGA_GAIN]);
+	}
+	max283x_regs_commit(&max283x);
+	if (config->present & (1 << CONFIG_TAG_AMP_ENABLE)) {
+		rf_path_set_lna(&rf_path, values[CONFIG_TAG_AMP_ENABLE]);
+	}
+	return true;
+}
+
+usb_request_status_t usb_vendor_request_apply_config(
+	usb_endpoint_t* const endpoint,
+	const usb_transfer_stage_t stage)
+{
+	config_bundle_t config;
+
+	if (stage == USB_TRANSFER_STAGE_SETUP) {
+		if ((endpoint->setup.length == 0) ||
+		    (endpoint->setup.length > CONFIG_BUNDLE_MAX_LENGTH)) {
+			return USB_REQUEST_STATUS_STALL;
+		}
+		usb_transfer_schedule_block(
+			endpoint->out,
+			config_bundle,
+			endpoint->setup.length,
+			NULL,
+			NULL);
+	} else if (stage == USB_TRANSFER_STAGE_DATA) {
+		if (!config_bundle_parse(
+			    config_bundle,
+			    endpoint->setup.length,
+			    &config) ||
+		    !config_bundle_apply(&config)) {
+			return USB_REQUEST_STATUS_STALL;
+		}
+		usb_transfer_schedule_ack(endpoint->in);
+	}
+	return USB_REQUEST_STATUS_OK;
+}
+
 static volatile hw_sync_mode_t _hw_sync_mode = HW_SYNC_MODE_OFF;
 static volatile uint32_t _tx_underrun_limit;
 static volatile uint32_t _rx_overrun_limit;
@@ -297,6 +368,12 @@ void request_transceiver_mode(transceiver_mode_t mode)
 	usb_endpoint_flush(&usb_endpoint_bulk_in);
 	usb_endpoint_flush(&usb_endpoint_bulk_out);
 
+	// Scheduled positions only apply to the stream they were given for.
+	// Commands may be scheduled before streaming starts.
+	if (transceiver_request.mode != TRANSCEIVER_MODE_OFF) {
+		scheduled_commands_clear();
+	}
+
 	transceiver_request.mode = mode;
 	transceiver_request.seq++;
 }
@@ -322,6 +399,7 @@ void transceiver_startup(const transceiver_mode_t mode)
 	switch (mode) {
 	case TRANSCEIVER_MODE_RX_SWEEP:
 	case TRANSCEIVER_MODE_RX:
+	case TRANSCEIVER_MODE_RX_HOP:
 		led_off(LED3);
 		led_on(LED2);
 		rf_path_set_direction(&rf_path, RF_PATH_DIRECTION_RX);
@@ -329,6 +407,7 @@ void transceiver_startup(const transceiver_mode_t mode)
 		m0_state.shortfall_limit = _rx_overrun_limit;
 		break;
 	case TRANSCEIVER_MODE_TX:
+	case TRANSCEIVER_MODE_TX_HOP:
 		led_off(LED2);
 		led_on(LED3);
 		rf_path_set_direction(&rf_path, RF_PATH_DIRECTION_TX);
@@ -349,11 +428,19 @@ usb_request_status_t usb_vendor_request_set_transceiver_mode(
 {
 	if (stage == USB_TRANSFER_STAGE_SETUP) {
 		switch (endpoint->setup.value) {
+		case TRANSCEIVER_MODE_RX_SWEEP:
+			if (!sweep_ready()) {
+				return USB_REQUEST_STATUS_STALL;
+			}
+			request_transceiver_mode(endpoint->setup.value);
+			usb_transfer_schedule_ack(endpoint->in);
+			return USB_REQUEST_STATUS_OK;
 		case TRANSCEIVER_MODE_OFF:
 		case TRANSCEIVER_MODE_RX:
 		case TRANSCEIVER_MODE_TX:
-		case TRANSCEIVER_MODE_RX_SWEEP:
 		case TRANSCEIVER_MODE_CPLD_UPDATE:
+		case TRANSCEIVER_MODE_RX_HOP:
+		case TRANSCEIVER_MODE_TX_HOP:
 			request_transceiver_mode(endpoint->setup.value);
 			usb_transfer_schedule_ack(endpoint->in);
 			return USB_REQUEST_STATUS_OK;
@@ -408,16 +495,27 @@ void transceiver_bulk_transfer_complete(void* user_data, unsigned int bytes_tran
 	m0_state.m4_count += bytes_transferred;
 }
 
-void rx_mode(uint32_t seq)
+static void rx_stream(const uint32_t seq, const transceiver_mode_t mode)
 {
 	uint32_t usb_count = 0;
 
-	transceiver_startup(TRANSCEIVER_MODE_RX);
+	transceiver_startup(mode);
+	if (mode == TRANSCEIVER_MODE_RX_HOP) {
+		hop_start(mode);
+	}
 
 	baseband_streaming_enable(&sgpio_config);
 
 	while (transceiver_request.seq == seq) {
-		if ((m0_state.m0_count - usb_count) >= USB_TRANSFER_SIZE) {
+		if (mode == TRANSCEIVER_MODE_RX_HOP) {
+			hop_run();
+		} else {
+			scheduled_commands_run(TRANSCEIVER_MODE_RX);
+		}
+		m0_telemetry_update(m0_state.active_mode == M0_MODE_IDLE);
+		if (((m0_state.m0_count - usb_count) >= USB_TRANSFER_SIZE) &&
+		    !((mode == TRANSCEIVER_MODE_RX_HOP) &&
+		      hop_tag_pending(usb_count + USB_TRANSFER_SIZE))) {
 			usb_transfer_schedule_block(
 				&usb_endpoint_bulk_in,
 				&usb_bulk_buffer[usb_count & USB_BULK_BUFFER_MASK],
@@ -431,12 +529,15 @@ void rx_mode(uint32_t seq)
 	transceiver_shutdown();
 }
 
-void tx_mode(uint32_t seq)
+static void tx_stream(const uint32_t seq, const transceiver_mode_t mode)
 {
 	unsigned int usb_count = 0;
 	bool started = false;
 
-	transceiver_startup(TRANSCEIVER_MODE_TX);
+	transceiver_startup(mode);
+	if (mode == TRANSCEIVER_MODE_TX_HOP) {
+		hop_start(mode);
+	}
 
 	// Set up OUT transfer of buffer 0.
 	usb_transfer_schedule_block(
@@ -448,12 +549,19 @@ void tx_mode(uint32_t seq)
 	usb_count += USB_TRANSFER_SIZE;
 
 	while (transceiver_request.seq == seq) {
+		if (mode == TRANSCEIVER_MODE_TX_HOP) {
+			hop_run();
+		} else {
+			scheduled_commands_run(TRANSCEIVER_MODE_TX);
+		}
+		m0_telemetry_update(m0_state.active_mode == M0_MODE_IDLE);
 		if (!started && (m0_state.m4_count == USB_BULK_BUFFER_SIZE)) {
 			// Buffer is now full, start streaming.
 			baseband_streaming_enable(&sgpio_config);
 			started = true;
 		}
-		if ((usb_count - m0_state.m0_count) <= USB_TRANSFER_SIZE) {
+		if ((usb_count - m0_state.m0_count) <=
+		    (USB_BULK_BUFFER_SIZE - USB_TRANSFER_SIZE)) {
 			usb_transfer_schedule_block(
 				&usb_endpoint_bulk_out,
 				&usb_bulk_buffer[usb_count & USB_BULK_BUFFER_MASK],
@@ -467,6 +575,26 @@ void tx_mode(uint32_t seq)
 	transceiver_shutdown();
 }
 
+void rx_mode(uint32_t seq)
+{
+	rx_stream(seq, TRANSCEIVER_MODE_RX);
+}
+
+void tx_mode(uint32_t seq)
+{
+	tx_stream(seq, TRANSCEIVER_MODE_TX);
+}
+
+void rx_hop_mode(uint32_t seq)
+{
+	rx_stream(seq, TRANSCEIVER_MODE_RX_HOP);
+}
+
+void tx_hop_mode(uint32_t seq)
+{
+	tx_stream(seq, TRANSCEIVER_MODE_TX_HOP);
+}
+
 void off_mode(uint32_t seq)
 {
 	hackrf_ui()->set_transceiver_mode(TRANSCEIVER_MODE_OFF);
@@ -66,6 +66,9 @@ usb_request_status_t usb_vendor_request_set_antenna_enable(
 usb_request_status_t usb_vendor_request_set_freq_explicit(
 	usb_endpoint_t* const endpoint,
 	const usb_transfer_stage_t stage);
+usb_request_status_t usb_vendor_request_apply_config(
+	usb_endpoint_t* const endpoint,
+	const usb_transfer_stage_t stage);
 usb_request_status_t usb_vendor_request_set_hw_sync_mode(
 	usb_endpoint_t* const endpoint,
 	const usb_transfer_stage_t stage);
@@ -82,6 +85,8 @@ void transceiver_shutdown(void);
 void start_streaming_on_hw_sync();
 void rx_mode(uint32_t seq);
 void tx_mode(uint32_t seq);
+void rx_hop_mode(uint32_t seq);
+void tx_hop_mode(uint32_t seq);
 void off_mode(uint32_t seq);
 
 #endif /*__USB_API_TRANSCEIVER_H__*/
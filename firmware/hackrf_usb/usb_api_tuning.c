@@ -0,0 +1,140 @@
+/*
+ * Copyright 2026 Great Scott Gadgets <info@greatscottgadgets.com>
+ *
+ * This file is part of HackRF.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "usb_api_tuning.h"
+
+#include "usb_queue.h"
+#include <stddef.h>
+#include "tuning.h"
+#include "tuning_plan.h"
+
+#define TUNING_TABLE_MAX_STEPS 128
+#define TUNING_TABLE_MAX_CHUNK 32
+
+/* Each uploaded entry is a frequency in Hz (uint64, little-endian). */
+#define TUNING_FREQ_SIZE 8
+
+static tuning_step_t tuning_table[TUNING_TABLE_MAX_STEPS];
+static uint8_t tuning_table_data[TUNING_TABLE_MAX_CHUNK * TUNING_FREQ_SIZE];
+static uint16_t tuning_table_steps = 0;
+static uint16_t tuning_table_uploaded = 0;
+static uint16_t tuning_table_next = 0;
+
+/*
+ * The host uploads the frequencies in the order they will be tuned to,
+ * and the firmware plans the settings for each. The setup value gives the
+ * index of the first entry written and the setup index the length of the
+ * whole table, and at most TUNING_TABLE_MAX_CHUNK entries are written per
+ * request. Each frequency is checked as it arrives, and the table is
+ * planned once, when its last entry has been written, as a run sharing
+ * one mixer LO may span several uploads. A table length of zero clears the
+ * table.
+ */
+usb_request_status_t usb_vendor_request_set_tuning_table(
+	usb_endpoint_t* const endpoint,
+	const usb_transfer_stage_t stage)
+{
+	const uint8_t* data;
+	tuning_if_plan_t plan;
+	uint64_t freq;
+	uint16_t first, count, total, i;
+	uint8_t j;
+
+	first = endpoint->setup.value;
+	total = endpoint->setup.index;
+	count = endpoint->setup.length / TUNING_FREQ_SIZE;
+	if (stage == USB_TRANSFER_STAGE_SETUP) {
+		if ((endpoint->setup.length % TUNING_FREQ_SIZE) ||
+		    (count > TUNING_TABLE_MAX_CHUNK) || (total > TUNING_TABLE_MAX_STEPS) ||
+		    (first > tuning_table_uploaded) || ((first + count) > total) ||
+		    ((count == 0) && (total != 0))) {
+			return USB_REQUEST_STATUS_STALL;
+		}
+		// Don't use entries while they are being overwritten.
+		tuning_table_steps = 0;
+		tuning_table_uploaded = first;
+		if (count == 0) {
+			usb_transfer_schedule_ack(endpoint->in);
+		} else {
+			usb_transfer_schedule_block(
+				endpoint->out,
+				tuning_table_data,
+				endpoint->setup.length,
+				NULL,
+				NULL);
+		}
+	} else if (stage == USB_TRANSFER_STAGE_DATA) {
+		for (i = 0; i < count; i++) {
+			data = &tuning_table_data[i * TUNING_FREQ_SIZE];
+			freq = 0;
+			for (j = 0; j < TUNING_FREQ_SIZE; j++) {
+				freq |= (uint64_t) data[j] << (8 * j);
+			}
+			if (!tuning_if_plan(freq, &plan)) {
+				return USB_REQUEST_STATUS_STALL;
+			}
+			tuning_table[first + i].freq = freq;
+		}
+		tuning_table_uploaded = first + count;
+		if (tuning_table_uploaded == total) {
+			if (!tuning_sequence_plan(tuning_table, total)) {
+				return USB_REQUEST_STATUS_STALL;
+			}
+			tuning_table_next = 0;
+			tuning_table_steps = total;
+		}
+		usb_transfer_schedule_ack(endpoint->in);
+	}
+	return USB_REQUEST_STATUS_OK;
+}
+
+static bool tuning_table_apply(const uint16_t index, const uint64_t freq)
+{
+	if ((tuning_table[index].freq != freq) ||
+	    !set_freq_step(&tuning_table[index])) {
+		return false;
+	}
+	tuning_table_next = (index + 1) % tuning_table_steps;
+	return true;
+}
+
+/*
+ * Tune using the precomputed entry for this frequency if the table has
+ * one, or with set_freq() otherwise. Tables are normally uploaded in the
+ * order they will be used, so the entry after the last one applied is
+ * tried first.
+ */
+bool tuning_table_set_freq(const uint64_t freq)
+{
+	uint16_t i;
+
+	if (tuning_table_steps > 0) {
+		if (tuning_table_apply(tuning_table_next, freq)) {
+			return true;
+		}
+		for (i = 0; i < tuning_table_steps; i++) {
+			if (tuning_table_apply(i, freq)) {
+				return true;
+			}
+		}
+	}
+	return set_freq(freq);
+}
@@ -27,8 +27,28 @@
 #include <stdbool.h>
 #include <stdint.h>
 
-#define USB_BULK_BUFFER_SIZE 0x8000
-#define USB_BULK_BUFFER_MASK 0x7FFF
+/* The buffer size is normally set by the build, see hackrf-common.cmake. */
+#ifndef USB_BULK_BUFFER_SIZE
+	#define USB_BULK_BUFFER_SIZE 0x8000
+#endif
+#define USB_BULK_BUFFER_MASK (USB_BULK_BUFFER_SIZE - 1)
+
+/* Size of each streaming transfer. A dTD can't describe more than 16K of a
+ * buffer that isn't page aligned, so this is also the largest transfer size.
+ */
+#define USB_TRANSFER_SIZE 0x4000
+
+/* Enough transfers to have the whole buffer queued at once. */
+#define USB_BULK_TRANSFERS (USB_BULK_BUFFER_SIZE / USB_TRANSFER_SIZE)
+
+/* Smallest transfer from the buffer while streaming, a sweep block. */
+#define USB_MIN_TRANSFER_SIZE 0x800
+
+/* Sweeps send each block as a transfer of its own, so the IN endpoint
+ * needs enough transfers to queue the whole buffer in the smallest
+ * blocks, and one more for a spectrum record.
+ */
+#define USB_BULK_IN_TRANSFERS ((USB_BULK_BUFFER_SIZE / USB_MIN_TRANSFER_SIZE) + 1)
 
 /* Address of usb_bulk_buffer is set in ldscripts. If you change the name of this
  * variable, it won't be where it needs to be in the processor's address space,
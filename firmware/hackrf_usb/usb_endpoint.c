@@ -26,6 +26,7 @@
 #include <usb_request.h>
 
 #include "usb_device.h"
+#include "usb_bulk_buffer.h"
 
 usb_endpoint_t usb_endpoint_control_out = {
 	.address = 0x00,
@@ -58,7 +59,7 @@ usb_endpoint_t usb_endpoint_bulk_in = {
 	.out = 0,
 	.setup_complete = 0,
 	.transfer_complete = usb_queue_transfer_complete};
-static USB_DEFINE_QUEUE(usb_endpoint_bulk_in, 1);
+static USB_DEFINE_QUEUE(usb_endpoint_bulk_in, USB_BULK_IN_TRANSFERS);
 
 usb_endpoint_t usb_endpoint_bulk_out = {
 	.address = 0x02,
@@ -67,4 +68,4 @@ usb_endpoint_t usb_endpoint_bulk_out = {
 	.out = &usb_endpoint_bulk_out,
 	.setup_complete = 0,
 	.transfer_complete = usb_queue_transfer_complete};
-static USB_DEFINE_QUEUE(usb_endpoint_bulk_out, 1);
+static USB_DEFINE_QUEUE(usb_endpoint_bulk_out, USB_BULK_TRANSFERS);
@@ -36,6 +36,7 @@ typedef int bool;
 #endif
 
 #define REGISTER_INVALID 32767
+#define TRACE_CAPACITY   65536
 
 int parse_int(char* s, uint32_t* const value)
 {
@@ -457,6 +458,214 @@ static void print_state(hackrf_m0_state* state)
 	printf("Error: %u (%s)\n", state->error, error_name(state->error));
 }
 
+static void print_telemetry(hackrf_m0_telemetry* telemetry)
+{
+	uint32_t i;
+
+	printf("Minimum buffer margin: %u bytes\n", telemetry->min_margin);
+	printf("Shortfall lengths:\n");
+	for (i = 0; i < HACKRF_M0_SHORTFALL_HISTOGRAM_BINS; i++) {
+		if (telemetry->histogram[i] == 0) {
+			continue;
+		}
+		if (i == HACKRF_M0_SHORTFALL_HISTOGRAM_BINS - 1) {
+			printf("  >= %u bytes: %u\n", 32U << i, telemetry->histogram[i]);
+		} else {
+			printf("  %u-%u bytes: %u\n",
+			       32U << i,
+			       (64U << i) - 1,
+			       telemetry->histogram[i]);
+		}
+	}
+	if (telemetry->histogram_missed > 0) {
+		printf("  not binned: %u\n", telemetry->histogram_missed);
+	}
+	printf("Recent shortfalls (M0 count: length):\n");
+	for (i = 0; i < telemetry->num_recent; i++) {
+		printf("  %u: %u bytes\n",
+		       telemetry->recent[i].start,
+		       telemetry->recent[i].length);
+	}
+}
+
+static int compare_latency(const void* a, const void* b)
+{
+	const hackrf_trace_event* x = (const hackrf_trace_event*) a;
+	const hackrf_trace_event* y = (const hackrf_trace_event*) b;
+	const uint64_t x_ns = x->complete_ns - x->submit_ns;
+	const uint64_t y_ns = y->complete_ns - y->submit_ns;
+
+	if (x->request != y->request) {
+		return x->request - y->request;
+	}
+	return (x_ns > y_ns) - (x_ns < y_ns);
+}
+
+/* Latency in microseconds of the event at percentile p of a sorted run. */
+static double percentile(const hackrf_trace_event* events, const int count, const int p)
+{
+	const hackrf_trace_event* event = &events[(count - 1) * p / 100];
+
+	return (event->complete_ns - event->submit_ns) / 1e3;
+}
+
+static void print_latencies(hackrf_trace_event* events, const int count)
+{
+	int start, end;
+
+	qsort(events, count, sizeof(*events), compare_latency);
+	printf("%-28s %7s %9s %9s %9s %9s\n",
+	       "request",
+	       "count",
+	       "p50 us",
+	       "p90 us",
+	       "p99 us",
+	       "max us");
+	for (start = 0; start < count; start = end) {
+		end = start;
+		while ((end < count) && (events[end].request == events[start].request)) {
+			end++;
+		}
+		printf("%-28s %7d %9.1f %9.1f %9.1f %9.1f\n",
+		       hackrf_vendor_request_name(events[start].request),
+		       end - start,
+		       percentile(&events[start], end - start, 50),
+		       percentile(&events[start], end - start, 90),
+		       percentile(&events[start], end - start, 99),
+		       percentile(&events[start], end - start, 100));
+	}
+}
+
+/*
+ * Issue read-only requests back to back for the given number of seconds,
+ * printing the latency of each request type once per second. Intervals
+ * are timed from the trace itself. Only these synthetic probes are timed,
+ * not the requests of any other program using the device.
+ */
+static int measure_latency(hackrf_device* device, const uint32_t seconds)
+{
+	hackrf_trace_event* events;
+	hackrf_m0_state state;
+	uint8_t board_id;
+	uint32_t position = 0;
+	uint32_t elapsed = 0;
+	uint64_t interval_start = 0;
+	int count = 0;
+	int result;
+
+	events = (hackrf_trace_event*) malloc(TRACE_CAPACITY * sizeof(*events));
+	if (events == NULL) {
+		return HACKRF_ERROR_NO_MEM;
+	}
+
+	while (elapsed < seconds) {
+		result = hackrf_board_id_read(device, &board_id);
+		if (result == HACKRF_SUCCESS) {
+			result = hackrf_get_m0_state(device, &state);
+		}
+		if ((result != HACKRF_SUCCESS) &&
+		    (result != HACKRF_ERROR_USB_API_VERSION)) {
+			free(events);
+			return result;
+		}
+
+		result = hackrf_trace_read(
+			device,
+			&position,
+			&events[count],
+			TRACE_CAPACITY - count);
+		if ((count == 0) && (result > 0) && (interval_start == 0)) {
+			interval_start = events[0].submit_ns;
+		}
+		count += result;
+		if ((count == TRACE_CAPACITY) ||
+		    ((count > 0) &&
+		     (events[count - 1].complete_ns - interval_start >= 1000000000))) {
+			interval_start = events[count - 1].complete_ns;
+			elapsed++;
+			printf("\nRequest latency, second %u:\n", elapsed);
+			print_latencies(events, count);
+			count = 0;
+		}
+	}
+
+	free(events);
+	return HACKRF_SUCCESS;
+}
+
+static uint64_t get_le(const uint8_t* data, const int size)
+{
+	uint64_t value = 0;
+	int i;
+
+	for (i = size - 1; i >= 0; i--) {
+		value = (value << 8) | data[i];
+	}
+	return value;
+}
+
+/*
+ * Print the latency of each request type in a trace saved in
+ * HACKRF_TRACE_FORMAT_BINARY, for example by a program that called
+ * hackrf_trace_dump(), or by --trace with a .bin file.
+ */
+static int print_trace_file_latency(const char* path)
+{
+	hackrf_trace_event* events;
+	uint8_t record[32];
+	uint32_t count, i;
+	FILE* file;
+
+	file = fopen(path, "rb");
+	if (file == NULL) {
+		fprintf(stderr, "Failed to open %s\n", path);
+		return HACKRF_ERROR_OTHER;
+	}
+	if ((fread(record, 16, 1, file) != 1) || memcmp(record, "HACKRFTR", 8) ||
+	    (get_le(&record[8], 4) != 1)) {
+		fprintf(stderr, "%s is not a binary request trace\n", path);
+		fclose(file);
+		return HACKRF_ERROR_OTHER;
+	}
+	count = get_le(&record[12], 4);
+	if (count == 0) {
+		printf("%s holds no requests\n", path);
+		fclose(file);
+		return HACKRF_SUCCESS;
+	}
+
+	events = NULL;
+	if (count <= (SIZE_MAX / sizeof(*events))) {
+		events = (hackrf_trace_event*) malloc(count * sizeof(*events));
+	}
+	if (events == NULL) {
+		fclose(file);
+		return HACKRF_ERROR_NO_MEM;
+	}
+	for (i = 0; i < count; i++) {
+		if (fread(record, sizeof(record), 1, file) != 1) {
+			fprintf(stderr, "%s is truncated\n", path);
+			free(events);
+			fclose(file);
+			return HACKRF_ERROR_OTHER;
+		}
+		events[i].submit_ns = get_le(&record[0], 8);
+		events[i].complete_ns = get_le(&record[8], 8);
+		events[i].result = (int32_t) get_le(&record[16], 4);
+		events[i].value = get_le(&record[20], 2);
+		events[i].index = get_le(&record[22], 2);
+		events[i].length = get_le(&record[24], 2);
+		events[i].request = record[26];
+		events[i].flags = record[27];
+	}
+	fclose(file);
+
+	printf("Request latency, %s:\n", path);
+	print_latencies(events, count);
+	free(events);
+	return HACKRF_SUCCESS;
+}
+
 static void usage()
 {
 	printf("\nUsage:\n");
@@ -469,17 +678,22 @@ static void usage()
 	printf("\t-m, --max2837: target MAX2837\n");
 	printf("\t-s, --si5351c: target SI5351C\n");
 	printf("\t-f, --rffc5072: target RFFC5072\n");
-	printf("\t-S, --state: display M0 state\n");
+	printf("\t-S, --state: display M0 state and buffer statistics\n");
 	printf("\t-T, --tx-underrun-limit <n>: set TX underrun limit in bytes (0 for no limit)\n");
 	printf("\t-R, --rx-overrun-limit <n>: set RX overrun limit in bytes (0 for no limit)\n");
 	printf("\t-u, --ui <1/0>: enable/disable UI\n");
 	printf("\t-l, --leds <state>: configure LED state (0 for all off, 1 for default)\n");
+	printf("\t-L, --latency <n>: time synthetic read-only requests for <n> seconds\n");
+	printf("\t-i, --latency-file <file>: print latency from a binary trace dump\n");
+	printf("\t-t, --trace <file>: save requests to <file> as Chrome trace JSON (binary if .bin)\n");
 	printf("\nExamples:\n");
 	printf("\thackrf_debug --si5351c -n 0 -r     # reads from si5351c register 0\n");
 	printf("\thackrf_debug --si5351c -c          # displays si5351c multisynth configuration\n");
 	printf("\thackrf_debug --rffc5072 -r         # reads all rffc5072 registers\n");
 	printf("\thackrf_debug --max2837 -n 10 -w 22 # writes max2837 register 10 with 22 decimal\n");
 	printf("\thackrf_debug --state               # displays M0 state\n");
+	printf("\thackrf_debug --latency 10          # prints request latency for 10 seconds\n");
+	printf("\thackrf_debug --latency-file a.bin  # prints latency from an application's trace\n");
 }
 
 static struct option long_options[] = {
@@ -497,6 +711,9 @@ static struct option long_options[] = {
 	{"rx-overrun-limit", required_argument, 0, 'R'},
 	{"ui", required_argument, 0, 'u'},
 	{"leds", required_argument, 0, 'l'},
+	{"latency", required_argument, 0, 'L'},
+	{"latency-file", required_argument, 0, 'i'},
+	{"trace", required_argument, 0, 't'},
 	{0, 0, 0, 0},
 };
 
@@ -521,6 +738,12 @@ int main(int argc, char** argv)
 	uint32_t rx_limit;
 	bool set_tx_limit = false;
 	bool set_rx_limit = false;
+	bool latency = false;
+	uint32_t latency_seconds;
+	const char* latency_path = NULL;
+	const char* trace_path = NULL;
+	enum hackrf_trace_format trace_format = HACKRF_TRACE_FORMAT_CHROME_JSON;
+	size_t length;
 
 	int result = hackrf_init();
 	if (result) {
@@ -533,7 +756,7 @@ int main(int argc, char** argv)
 	while ((opt = getopt_long(
 			argc,
 			argv,
-			"n:rw:d:cmsfST:R:h?u:l:",
+			"n:rw:d:cmsfST:R:h?u:l:L:i:t:",
 			long_options,
 			&option_index)) != EOF) {
 		switch (opt) {
@@ -605,6 +828,23 @@ int main(int argc, char** argv)
 			result = parse_int(optarg, &led_state);
 			break;
 
+		case 'L':
+			latency = true;
+			result = parse_int(optarg, &latency_seconds);
+			break;
+
+		case 'i':
+			latency_path = optarg;
+			break;
+
+		case 't':
+			trace_path = optarg;
+			length = strlen(trace_path);
+			if ((length > 4) && !strcmp(&trace_path[length - 4], ".bin")) {
+				trace_format = HACKRF_TRACE_FORMAT_BINARY;
+			}
+			break;
+
 		case 'h':
 		case '?':
 			usage();
@@ -642,15 +882,30 @@ int main(int argc, char** argv)
 		return EXIT_FAILURE;
 	}
 
+	// A saved trace needs no device.
+	if (latency_path != NULL) {
+		if (write || read || dump_config || dump_state || set_tx_limit ||
+		    set_rx_limit || set_ui || set_leds || latency ||
+		    (trace_path != NULL)) {
+			fprintf(stderr,
+				"The latency file option can't be combined with others.\n");
+			usage();
+			return EXIT_FAILURE;
+		}
+		result = print_trace_file_latency(latency_path);
+		hackrf_exit();
+		return (result == HACKRF_SUCCESS) ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
 	if (!(write || read || dump_config || dump_state || set_tx_limit ||
-	      set_rx_limit || set_ui || set_leds)) {
+	      set_rx_limit || set_ui || set_leds || latency)) {
 		fprintf(stderr, "Specify read, write, or config option.\n");
 		usage();
 		return EXIT_FAILURE;
 	}
 
 	if (part == PART_NONE && !set_ui && !dump_state && !set_tx_limit &&
-	    !set_rx_limit && !set_leds) {
+	    !set_rx_limit && !set_leds && !latency) {
 		fprintf(stderr, "Specify a part to read, write, or print config from.\n");
 		usage();
 		return EXIT_FAILURE;
@@ -664,6 +919,16 @@ int main(int argc, char** argv)
 		return EXIT_FAILURE;
 	}
 
+	if (latency || (trace_path != NULL)) {
+		result = hackrf_trace_enable(device, TRACE_CAPACITY);
+		if (result != HACKRF_SUCCESS) {
+			printf("hackrf_trace_enable() failed: %s (%d)\n",
+			       hackrf_error_name(result),
+			       result);
+			return EXIT_FAILURE;
+		}
+	}
+
 	if (write) {
 		result = write_register(device, part, register_number, register_value);
 	}
@@ -710,6 +975,17 @@ int main(int argc, char** argv)
 			return EXIT_FAILURE;
 		}
 		print_state(&state);
+
+		hackrf_m0_telemetry telemetry;
+		result = hackrf_get_m0_telemetry(device, &telemetry);
+		if (result == HACKRF_SUCCESS) {
+			print_telemetry(&telemetry);
+		} else if (result != HACKRF_ERROR_USB_API_VERSION) {
+			printf("hackrf_get_m0_telemetry() failed: %s (%d)\n",
+			       hackrf_error_name(result),
+			       result);
+			return EXIT_FAILURE;
+		}
 	}
 
 	if (set_ui) {
@@ -726,6 +1002,26 @@ int main(int argc, char** argv)
 		result = hackrf_set_leds(device, led_state);
 	}
 
+	if (latency) {
+		result = measure_latency(device, latency_seconds);
+		if (result != HACKRF_SUCCESS) {
+			printf("latency measurement failed: %s (%d)\n",
+			       hackrf_error_name(result),
+			       result);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (trace_path != NULL) {
+		result = hackrf_trace_dump(device, trace_path, trace_format);
+		if (result != HACKRF_SUCCESS) {
+			printf("hackrf_trace_dump() failed: %s (%d)\n",
+			       hackrf_error_name(result),
+			       result);
+			return EXIT_FAILURE;
+		}
+	}
+
 	result = hackrf_close(device);
 	if (result) {
 		printf("hackrf_close() failed: %s (%d)\n",
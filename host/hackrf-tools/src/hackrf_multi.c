@@ -0,0 +1,828 @@
+/*
+ * Copyright 2026 Great Scott Gadgets <info@greatscottgadgets.com>
+ *
+ * This file is part of HackRF.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <hackrf.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <signal.h>
+
+#ifndef bool
+typedef int bool;
+	#define true 1
+	#define false 0
+#endif
+
+#ifdef _WIN32
+	#include <windows.h>
+	/* Avoid redefinition of timespec from time.h */
+	#define HAVE_STRUCT_TIMESPEC 1
+
+	#ifdef _MSC_VER
+		#define strtoull _strtoui64
+		#define snprintf _snprintf
+
+int gettimeofday(struct timeval* tv, void* ignored)
+{
+	FILETIME ft;
+	unsigned __int64 tmp = 0;
+	if (NULL != tv) {
+		GetSystemTimeAsFileTime(&ft);
+		tmp |= ft.dwHighDateTime;
+		tmp <<= 32;
+		tmp |= ft.dwLowDateTime;
+		tmp /= 10;
+		tmp -= 11644473600000000Ui64;
+		tv->tv_sec = (long) (tmp / 1000000UL);
+		tv->tv_usec = (long) (tmp % 1000000UL);
+	}
+	return 0;
+}
+
+	#endif
+#endif
+
+#if defined(__GNUC__)
+	#include <unistd.h>
+	#include <sys/time.h>
+#endif
+
+#include <pthread.h>
+
+#define FREQ_ONE_MHZ (1000000ll)
+
+#define DEFAULT_FREQ_HZ        (900000000ll) /* 900MHz */
+#define DEFAULT_SAMPLE_RATE_HZ (10000000)    /* 10MHz */
+
+/* Per-device buffer between the USB transfer thread and the file writer. */
+#define RING_SIZE (16 * 1024 * 1024)
+
+/* Spans dropped from a full ring that are still to be zero-filled. */
+#define MAX_GAPS 256
+
+typedef struct {
+	uint64_t start; /* position of the first dropped byte */
+	uint64_t length;
+} gap_t;
+
+typedef struct {
+	/* Serial number, or the device's index if its serial number is unknown. */
+	char name[40];
+	hackrf_device* device;
+	FILE* file;
+	uint8_t* ring;
+	pthread_t writer;
+	bool writer_started;
+	pthread_mutex_t lock; /* guards everything below */
+	pthread_cond_t cv;    /* signalled when data is added or done is set */
+	uint32_t head;        /* ring offset of the oldest unwritten byte */
+	uint32_t used;        /* bytes in the ring */
+	uint64_t received;    /* bytes received, including any dropped */
+	uint64_t written;     /* bytes written to the file */
+	uint64_t dropped;     /* bytes dropped because the ring was full */
+	uint64_t lost;        /* dropped bytes that couldn't be zero-filled */
+	gap_t gaps[MAX_GAPS]; /* dropped spans, oldest first */
+	uint32_t gap_head;
+	uint32_t gap_count;
+	bool done;            /* no more data will be added */
+	bool failed;          /* the file could not be written */
+} capture_t;
+
+static volatile bool do_exit = false;
+
+/* Bytes to capture from each device, or 0 for no limit. */
+static uint64_t bytes_to_xfer = 0;
+
+static const uint8_t zeros[64 * 1024];
+
+static pthread_mutex_t main_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t main_cv = PTHREAD_COND_INITIALIZER;
+static int writers_finished = 0;
+
+int parse_u64(char* s, uint64_t* const value)
+{
+	uint_fast8_t base = 10;
+	char* s_end;
+	uint64_t u64_value;
+
+	if (strlen(s) > 2) {
+		if (s[0] == '0') {
+			if ((s[1] == 'x') || (s[1] == 'X')) {
+				base = 16;
+				s += 2;
+			} else if ((s[1] == 'b') || (s[1] == 'B')) {
+				base = 2;
+				s += 2;
+			}
+		}
+	}
+
+	s_end = s;
+	u64_value = strtoull(s, &s_end, base);
+	if ((s != s_end) && (*s_end == 0)) {
+		*value = u64_value;
+		return HACKRF_SUCCESS;
+	} else {
+		return HACKRF_ERROR_INVALID_PARAM;
+	}
+}
+
+int parse_u32(char* s, uint32_t* const value)
+{
+	uint64_t u64_value;
+
+	if ((parse_u64(s, &u64_value) != HACKRF_SUCCESS) || (u64_value > UINT32_MAX)) {
+		return HACKRF_ERROR_INVALID_PARAM;
+	}
+	*value = (uint32_t) u64_value;
+	return HACKRF_SUCCESS;
+}
+
+/*
+ * Note a span dropped from a full ring, so that the writer can fill it
+ * with zeros and later samples stay at their position in the file.
+ * Must be called with the capture's lock held.
+ */
+static void add_gap(capture_t* capture, const uint64_t length)
+{
+	gap_t* last;
+
+	capture->dropped += length;
+	if (capture->gap_count > 0) {
+		last = &capture->gaps
+				[(capture->gap_head + capture->gap_count - 1) % MAX_GAPS];
+		if (last->start + last->length == capture->received) {
+			last->length += length;
+			return;
+		}
+	}
+	if (capture->gap_count == MAX_GAPS) {
+		capture->lost += length;
+		return;
+	}
+	last = &capture->gaps[(capture->gap_head + capture->gap_count) % MAX_GAPS];
+	last->start = capture->received;
+	last->length = length;
+	capture->gap_count++;
+}
+
+/*
+ * Called on each device's USB transfer thread. The copy into the ring is
+ * done without the lock held: only this thread adds data, so the space
+ * found free stays free until it is published.
+ */
+static int rx_callback(hackrf_transfer* transfer)
+{
+	capture_t* capture = (capture_t*) transfer->rx_ctx;
+	uint64_t length = transfer->valid_length;
+	uint32_t tail, first;
+	bool space;
+
+	pthread_mutex_lock(&capture->lock);
+	if (capture->done) {
+		pthread_mutex_unlock(&capture->lock);
+		return 0;
+	}
+	if ((bytes_to_xfer > 0) && (capture->received + length > bytes_to_xfer)) {
+		length = bytes_to_xfer - capture->received;
+	}
+	space = (RING_SIZE - capture->used) >= length;
+	tail = (capture->head + capture->used) % RING_SIZE;
+	pthread_mutex_unlock(&capture->lock);
+
+	if (space) {
+		first = RING_SIZE - tail;
+		if (first > length) {
+			first = length;
+		}
+		memcpy(capture->ring + tail, transfer->buffer, first);
+		memcpy(capture->ring, transfer->buffer + first, length - first);
+	}
+
+	pthread_mutex_lock(&capture->lock);
+	if (space) {
+		capture->used += length;
+	} else {
+		add_gap(capture, length);
+	}
+	capture->received += length;
+	if ((bytes_to_xfer > 0) && (capture->received == bytes_to_xfer)) {
+		capture->done = true;
+	}
+	pthread_cond_signal(&capture->cv);
+	pthread_mutex_unlock(&capture->lock);
+
+	/*
+	 * Keep streaming after the sample limit is reached, discarding the
+	 * data, so that the device doesn't overrun before it is stopped.
+	 */
+	return 0;
+}
+
+static bool write_zeros(FILE* file, uint64_t length)
+{
+	size_t chunk;
+
+	while (length > 0) {
+		chunk = (length > sizeof(zeros)) ? sizeof(zeros) : (size_t) length;
+		if (fwrite(zeros, 1, chunk, file) != chunk) {
+			return false;
+		}
+		length -= chunk;
+	}
+	return true;
+}
+
+/*
+ * Data in the ring is written up to the next dropped span, which is then
+ * filled with zeros, so that the Nth sample of every file still belongs
+ * to the same instant.
+ */
+static void* writer_thread(void* arg)
+{
+	capture_t* capture = (capture_t*) arg;
+	gap_t* gap;
+	uint64_t gap_start, gap_length;
+	uint32_t length;
+	bool ok;
+
+	pthread_mutex_lock(&capture->lock);
+	while (true) {
+		while ((capture->used == 0) && (capture->gap_count == 0) &&
+		       !capture->done) {
+			pthread_cond_wait(&capture->cv, &capture->lock);
+		}
+
+		gap = (capture->gap_count > 0) ? &capture->gaps[capture->gap_head] :
+						 NULL;
+		if ((gap != NULL) && (gap->start == capture->written)) {
+			gap_start = gap->start;
+			gap_length = gap->length;
+			capture->gap_head = (capture->gap_head + 1) % MAX_GAPS;
+			capture->gap_count--;
+			pthread_mutex_unlock(&capture->lock);
+			fprintf(stderr,
+				"%s: %" PRIu64 " samples dropped at sample %" PRIu64
+				", filled with zeros\n",
+				capture->name,
+				gap_length / 2,
+				gap_start / 2);
+			ok = write_zeros(capture->file, gap_length);
+			pthread_mutex_lock(&capture->lock);
+			if (!ok) {
+				capture->failed = true;
+				capture->done = true;
+				do_exit = true;
+				break;
+			}
+			capture->written += gap_length;
+			continue;
+		}
+		if (capture->used == 0) {
+			break;
+		}
+
+		length = capture->used;
+		if (capture->head + length > RING_SIZE) {
+			length = RING_SIZE - capture->head;
+		}
+		if ((gap != NULL) && (gap->start - capture->written < length)) {
+			length = gap->start - capture->written;
+		}
+		pthread_mutex_unlock(&capture->lock);
+		if (fwrite(capture->ring + capture->head, 1, length, capture->file) !=
+		    length) {
+			pthread_mutex_lock(&capture->lock);
+			capture->failed = true;
+			capture->done = true;
+			do_exit = true;
+			break;
+		}
+		pthread_mutex_lock(&capture->lock);
+
+		capture->head = (capture->head + length) % RING_SIZE;
+		capture->used -= length;
+		capture->written += length;
+	}
+	pthread_mutex_unlock(&capture->lock);
+
+	pthread_mutex_lock(&main_lock);
+	writers_finished++;
+	pthread_cond_signal(&main_cv);
+	pthread_mutex_unlock(&main_lock);
+	return NULL;
+}
+
+static void stop_capture(capture_t* capture)
+{
+	pthread_mutex_lock(&capture->lock);
+	capture->done = true;
+	pthread_cond_signal(&capture->cv);
+	pthread_mutex_unlock(&capture->lock);
+}
+
+/*
+ * With a shared clock and trigger, the Nth sample of every file was taken
+ * at the same instant, so the spread of received counts shows how far
+ * apart the streams are on the host.
+ */
+static void print_status(capture_t* captures, const int count)
+{
+	uint64_t min_received = UINT64_MAX;
+	uint64_t max_received = 0;
+	uint64_t dropped = 0;
+	int i;
+
+	for (i = 0; i < count; i++) {
+		pthread_mutex_lock(&captures[i].lock);
+		if (captures[i].received < min_received) {
+			min_received = captures[i].received;
+		}
+		if (captures[i].received > max_received) {
+			max_received = captures[i].received;
+		}
+		dropped += captures[i].dropped;
+		pthread_mutex_unlock(&captures[i].lock);
+	}
+
+	if (max_received == 0) {
+		fprintf(stderr, "Waiting for trigger...\n");
+	} else {
+		fprintf(stderr,
+			"%.1f Msamples per device, spread %" PRIu64
+			" samples, %" PRIu64 " samples dropped\n",
+			(min_received / 2) / 1e6,
+			(max_received - min_received) / 2,
+			dropped / 2);
+	}
+}
+
+static void usage()
+{
+	printf("Usage:\n");
+	printf("\t-h # this help\n");
+	printf("\t-r <prefix> # Receive from each device into <prefix>-<serial number>.cs8\n");
+	printf("\t            # or <prefix>-<index>.cs8 if its serial number is unknown.\n");
+	printf("\t[-d serial_number] # Serial number of a HackRF to use, may be repeated.\n");
+	printf("\t                   # The first is the primary. Default is all connected HackRFs.\n");
+	printf("\t[-f freq_hz] # Frequency in Hz (default %lldMHz).\n",
+	       DEFAULT_FREQ_HZ / FREQ_ONE_MHZ);
+	printf("\t[-s sample_rate_hz] # Sample rate in Hz (default %lldMHz).\n",
+	       DEFAULT_SAMPLE_RATE_HZ / FREQ_ONE_MHZ);
+	printf("\t[-a amp_enable] # RX RF amplifier 1=Enable, 0=Disable.\n");
+	printf("\t[-l gain_db] # RX LNA (IF) gain, 0-40dB, 8dB steps\n");
+	printf("\t[-g gain_db] # RX VGA (baseband) gain, 0-62dB, 2dB steps\n");
+	printf("\t[-n num_samples] # Number of samples to capture per device (default is unlimited).\n");
+	printf("\t[-H] # Trigger all devices from an external source, not from the primary.\n");
+	printf("\nThe primary drives CLKOUT, which should be connected to every other device's\n");
+	printf("CLKIN, and its trigger output should be connected to their trigger inputs.\n");
+}
+
+#ifdef _WIN32
+BOOL WINAPI sighandler(int signum)
+{
+	if (CTRL_C_EVENT == signum) {
+		fprintf(stderr, "Caught signal %d\n", signum);
+		do_exit = true;
+		return TRUE;
+	}
+	return FALSE;
+}
+#else
+void sigint_callback_handler(int signum)
+{
+	fprintf(stderr, "Caught signal %d\n", signum);
+	do_exit = true;
+}
+#endif
+
+static int configure_device(
+	capture_t* capture,
+	const bool primary,
+	const bool external_trigger,
+	const uint64_t freq_hz,
+	const uint32_t sample_rate_hz,
+	const uint32_t amp_enable,
+	const uint32_t lna_gain,
+	const uint32_t vga_gain)
+{
+	hackrf_device* device = capture->device;
+	uint8_t clkin;
+	int result;
+
+	result = hackrf_set_sample_rate(device, sample_rate_hz);
+	if (result == HACKRF_SUCCESS) {
+		result = hackrf_set_freq(device, freq_hz);
+	}
+	if (result == HACKRF_SUCCESS) {
+		result = hackrf_set_amp_enable(device, (uint8_t) amp_enable);
+	}
+	if (result == HACKRF_SUCCESS) {
+		result = hackrf_set_lna_gain(device, lna_gain);
+	}
+	if (result == HACKRF_SUCCESS) {
+		result = hackrf_set_vga_gain(device, vga_gain);
+	}
+	if (result == HACKRF_SUCCESS) {
+		result = hackrf_set_hw_sync_mode(device, (!primary || external_trigger));
+	}
+	if (result != HACKRF_SUCCESS) {
+		return result;
+	}
+
+	if (primary) {
+		return hackrf_set_clkout_enable(device, 1);
+	}
+
+	result = hackrf_get_clkin_status(device, &clkin);
+	if ((result == HACKRF_SUCCESS) && !clkin) {
+		fprintf(stderr,
+			"warning: no clock on CLKIN of %s, its samples will drift\n",
+			capture->name);
+	}
+	return (result == HACKRF_ERROR_USB_API_VERSION) ? HACKRF_SUCCESS : result;
+}
+
+int main(int argc, char** argv)
+{
+	int opt;
+	int result = HACKRF_SUCCESS;
+	int exit_code = EXIT_SUCCESS;
+	const char* prefix = NULL;
+	const char** serial_numbers = NULL;
+	hackrf_device_list_t* list = NULL;
+	capture_t* captures = NULL;
+	hackrf_m0_state* states = NULL;
+	bool* state_valid = NULL;
+	int count = 0;
+	int started = 0;
+	int i;
+	char path[FILENAME_MAX];
+	char shortfalls[16];
+	uint64_t freq_hz = DEFAULT_FREQ_HZ;
+	uint32_t sample_rate_hz = DEFAULT_SAMPLE_RATE_HZ;
+	uint32_t amp_enable = 0;
+	uint32_t lna_gain = 8;
+	uint32_t vga_gain = 20;
+	uint64_t samples_to_xfer = 0;
+	bool external_trigger = false;
+	bool aligned;
+	int misaligned = 0;
+	uint64_t dropped = 0;
+	struct timeval now;
+	struct timespec deadline;
+
+	serial_numbers = (const char**) calloc(argc, sizeof(*serial_numbers));
+	if (serial_numbers == NULL) {
+		return EXIT_FAILURE;
+	}
+
+	while ((opt = getopt(argc, argv, "r:d:f:s:a:l:g:n:Hh?")) != EOF) {
+		switch (opt) {
+		case 'r':
+			prefix = optarg;
+			break;
+
+		case 'd':
+			serial_numbers[count++] = optarg;
+			break;
+
+		case 'f':
+			result = parse_u64(optarg, &freq_hz);
+			break;
+
+		case 's':
+			result = parse_u32(optarg, &sample_rate_hz);
+			break;
+
+		case 'a':
+			result = parse_u32(optarg, &amp_enable);
+			break;
+
+		case 'l':
+			result = parse_u32(optarg, &lna_gain);
+			break;
+
+		case 'g':
+			result = parse_u32(optarg, &vga_gain);
+			break;
+
+		case 'n':
+			result = parse_u64(optarg, &samples_to_xfer);
+			bytes_to_xfer = samples_to_xfer * 2;
+			break;
+
+		case 'H':
+			external_trigger = true;
+			break;
+
+		case 'h':
+		case '?':
+			usage();
+			return EXIT_SUCCESS;
+
+		default:
+			fprintf(stderr, "unknown argument '-%c %s'\n", opt, optarg);
+			usage();
+			return EXIT_FAILURE;
+		}
+
+		if (result != HACKRF_SUCCESS) {
+			fprintf(stderr,
+				"argument error: '-%c %s' %s (%d)\n",
+				opt,
+				optarg,
+				hackrf_error_name(result),
+				result);
+			usage();
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (prefix == NULL) {
+		fprintf(stderr, "Specify an output file prefix with -r.\n");
+		usage();
+		return EXIT_FAILURE;
+	}
+
+	result = hackrf_init();
+	if (result != HACKRF_SUCCESS) {
+		fprintf(stderr,
+			"hackrf_init() failed: %s (%d)\n",
+			hackrf_error_name(result),
+			result);
+		free(serial_numbers);
+		return EXIT_FAILURE;
+	}
+
+	// From here on, errors go through the cleanup at the end.
+	exit_code = EXIT_FAILURE;
+
+	if (count == 0) {
+		list = hackrf_device_list();
+		if ((list == NULL) || (list->devicecount < 1)) {
+			fprintf(stderr, "No HackRF boards found.\n");
+			goto cleanup;
+		}
+		count = list->devicecount;
+	} else {
+		/*
+		 * Let the registry find each serial number, rather than
+		 * opening every board once per -d. Without hotplug support,
+		 * hackrf_open_by_serial() still scans the bus.
+		 */
+		hackrf_enable_device_registry();
+	}
+
+	captures = (capture_t*) calloc(count, sizeof(*captures));
+	states = (hackrf_m0_state*) calloc(count, sizeof(*states));
+	state_valid = (bool*) calloc(count, sizeof(*state_valid));
+	if ((captures == NULL) || (states == NULL) || (state_valid == NULL)) {
+		fprintf(stderr, "Failed to allocate capture state.\n");
+		goto cleanup;
+	}
+
+	for (i = 0; i < count; i++) {
+		capture_t* capture = &captures[i];
+
+		if (list != NULL) {
+			if (list->serial_numbers[i] != NULL) {
+				snprintf(capture->name,
+					 sizeof(capture->name),
+					 "%s",
+					 list->serial_numbers[i]);
+			} else {
+				snprintf(capture->name, sizeof(capture->name), "%d", i);
+			}
+			result = hackrf_device_list_open(list, i, &capture->device);
+		} else {
+			snprintf(capture->name,
+				 sizeof(capture->name),
+				 "%s",
+				 serial_numbers[i]);
+			result = hackrf_open_by_serial(
+				serial_numbers[i],
+				&capture->device);
+		}
+		if (result != HACKRF_SUCCESS) {
+			fprintf(stderr,
+				"failed to open device %d: %s (%d)\n",
+				i,
+				hackrf_error_name(result),
+				result);
+			goto cleanup;
+		}
+
+		pthread_mutex_init(&capture->lock, NULL);
+		pthread_cond_init(&capture->cv, NULL);
+		capture->ring = (uint8_t*) malloc(RING_SIZE);
+		if (capture->ring == NULL) {
+			fprintf(stderr, "Failed to allocate buffer for device %d.\n", i);
+			goto cleanup;
+		}
+
+		snprintf(path, sizeof(path), "%s-%s.cs8", prefix, capture->name);
+		capture->file = fopen(path, "wb");
+		if (capture->file == NULL) {
+			fprintf(stderr, "Failed to open file: %s\n", path);
+			goto cleanup;
+		}
+
+		result = configure_device(
+			capture,
+			i == 0,
+			external_trigger,
+			freq_hz,
+			sample_rate_hz,
+			amp_enable,
+			lna_gain,
+			vga_gain);
+		if (result != HACKRF_SUCCESS) {
+			fprintf(stderr,
+				"failed to configure %s: %s (%d)\n",
+				capture->name,
+				hackrf_error_name(result),
+				result);
+			goto cleanup;
+		}
+		fprintf(stderr, "%s -> %s\n", capture->name, path);
+	}
+	exit_code = EXIT_SUCCESS;
+
+#ifdef _WIN32
+	SetConsoleCtrlHandler((PHANDLER_ROUTINE) sighandler, TRUE);
+#else
+	signal(SIGINT, &sigint_callback_handler);
+	signal(SIGTERM, &sigint_callback_handler);
+#endif
+
+	for (i = 0; i < count; i++) {
+		result = pthread_create(
+			&captures[i].writer,
+			NULL,
+			writer_thread,
+			&captures[i]);
+		if (result != 0) {
+			fprintf(stderr,
+				"Failed to start writer thread for device %d.\n",
+				i);
+			do_exit = true;
+			break;
+		}
+		captures[i].writer_started = true;
+	}
+
+	/*
+	 * The other devices are started first and wait for the trigger, which
+	 * the primary sends as it starts streaming.
+	 */
+	for (i = count - 1; (i >= 0) && !do_exit; i--) {
+		result = hackrf_start_rx(captures[i].device, rx_callback, &captures[i]);
+		if (result != HACKRF_SUCCESS) {
+			fprintf(stderr,
+				"hackrf_start_rx() failed for %s: %s (%d)\n",
+				captures[i].name,
+				hackrf_error_name(result),
+				result);
+			exit_code = EXIT_FAILURE;
+			do_exit = true;
+			break;
+		}
+		started++;
+	}
+
+	if (!do_exit) {
+		fprintf(stderr, "Stop with Ctrl-C\n");
+	}
+
+	pthread_mutex_lock(&main_lock);
+	while (!do_exit && (writers_finished < count)) {
+		gettimeofday(&now, NULL);
+		deadline.tv_sec = now.tv_sec + 1;
+		deadline.tv_nsec = now.tv_usec * 1000;
+		result = pthread_cond_timedwait(&main_cv, &main_lock, &deadline);
+		if (result == ETIMEDOUT) {
+			pthread_mutex_unlock(&main_lock);
+			print_status(captures, count);
+			pthread_mutex_lock(&main_lock);
+		}
+	}
+	pthread_mutex_unlock(&main_lock);
+
+	fprintf(stderr, "\nExiting...\n");
+
+	// Read shortfall counts before stopping, which can itself cause overruns.
+	for (i = count - started; i < count; i++) {
+		state_valid[i] = (hackrf_get_m0_state(captures[i].device, &states[i]) ==
+				  HACKRF_SUCCESS);
+	}
+	for (i = count - started; i < count; i++) {
+		result = hackrf_stop_rx(captures[i].device);
+		if (result != HACKRF_SUCCESS) {
+			fprintf(stderr,
+				"hackrf_stop_rx() failed for %s: %s (%d)\n",
+				captures[i].name,
+				hackrf_error_name(result),
+				result);
+		}
+	}
+	for (i = 0; i < count; i++) {
+		if (captures[i].writer_started) {
+			stop_capture(&captures[i]);
+			pthread_join(captures[i].writer, NULL);
+		}
+	}
+
+	fprintf(stderr,
+		"%-32s %12s %12s %10s %10s %s\n",
+		"serial number",
+		"samples",
+		"offset",
+		"dropped",
+		"shortfalls",
+		"aligned");
+	for (i = 0; i < count; i++) {
+		capture_t* capture = &captures[i];
+
+		// Spans dropped on the host are zero-filled, but samples lost
+		// on the device leave no trace in the stream.
+		aligned = (capture->lost == 0) && state_valid[i] &&
+			(states[i].num_shortfalls == 0);
+		if (!aligned) {
+			misaligned++;
+		}
+		if (capture->failed) {
+			exit_code = EXIT_FAILURE;
+		}
+		dropped += capture->dropped;
+		if (state_valid[i]) {
+			snprintf(shortfalls,
+				 sizeof(shortfalls),
+				 "%u",
+				 states[i].num_shortfalls);
+		} else {
+			snprintf(shortfalls, sizeof(shortfalls), "unknown");
+		}
+		fprintf(stderr,
+			"%-32s %12" PRIu64 " %+12" PRId64 " %10" PRIu64 " %10s %s\n",
+			capture->name,
+			capture->written / 2,
+			(int64_t) (capture->written - captures[0].written) / 2,
+			capture->dropped / 2,
+			shortfalls,
+			capture->failed ? "write failed" : (aligned ? "yes" : "no"));
+	}
+	if ((misaligned == 0) && (dropped > 0)) {
+		fprintf(stderr,
+			"All %d captures are sample aligned, "
+			"with dropped samples filled with zeros.\n",
+			count);
+	} else if (misaligned == 0) {
+		fprintf(stderr, "All %d captures are sample aligned.\n", count);
+	} else {
+		fprintf(stderr,
+			"%d of %d captures lost samples and are not aligned with the others.\n",
+			misaligned,
+			count);
+	}
+
+cleanup:
+	for (i = 0; (captures != NULL) && (i < count); i++) {
+		if (captures[i].file != NULL) {
+			fclose(captures[i].file);
+		}
+		hackrf_close(captures[i].device);
+		free(captures[i].ring);
+	}
+	if (list != NULL) {
+		hackrf_device_list_free(list);
+	}
+	hackrf_exit();
+	free(state_valid);
+	free(states);
+	free(captures);
+	free(serial_numbers);
+	return exit_code;
+}
@@ -187,6 +187,45 @@ int parse_u32(char* s, uint32_t* const value)
 	}
 }
 
+/*
+ * Write the image with hackrf_spiflash_program(), which only rewrites the
+ * sectors that have changed, and check the checksum it returns.
+ */
+static int program_image(
+	hackrf_device* device,
+	const uint32_t address,
+	const uint8_t* data,
+	const uint32_t length)
+{
+	const uint32_t expected = hackrf_compute_crc32(data, length);
+	uint32_t crc;
+	int result;
+
+	result = hackrf_spiflash_program(device, address, data, length, &crc);
+	if (result == HACKRF_ERROR_USB_API_VERSION) {
+		return result;
+	}
+	if (result != HACKRF_SUCCESS) {
+		fprintf(stderr,
+			"hackrf_spiflash_program() failed: %s (%d)\n",
+			hackrf_error_name(result),
+			result);
+		return result;
+	}
+	if (crc != expected) {
+		fprintf(stderr,
+			"Verification failed: flash CRC-32 0x%08x, expected 0x%08x.\n",
+			crc,
+			expected);
+		return HACKRF_ERROR_OTHER;
+	}
+	printf("Wrote %d bytes at 0x%06x, verified CRC-32 0x%08x.\n",
+	       length,
+	       address,
+	       crc);
+	return HACKRF_SUCCESS;
+}
+
 static void usage()
 {
 	printf("Usage:\n");
@@ -221,6 +260,7 @@ int main(int argc, char** argv)
 	FILE* infile = NULL;
 	bool read = false;
 	bool write = false;
+	bool programmed = false;
 	bool ignore_compat_check = false;
 	bool verbose = false;
 	bool reset = false;
@@ -435,6 +475,9 @@ int main(int argc, char** argv)
 			pdata += xfer_len;
 			tmp_length -= xfer_len;
 		}
+		if (verbose) {
+			printf("CRC-32: 0x%08x\n", hackrf_compute_crc32(data, length));
+		}
 		bytes_written = fwrite(data, 1, length, infile);
 		if (bytes_written != length) {
 			fprintf(stderr,
@@ -456,6 +499,9 @@ int main(int argc, char** argv)
 			infile = NULL;
 			return EXIT_FAILURE;
 		}
+		if (verbose) {
+			printf("CRC-32: 0x%08x\n", hackrf_compute_crc32(data, length));
+		}
 		if (!ignore_compat_check) {
 			printf("Checking target device compatibility\n");
 			result = compatibility_check(data, length, device);
@@ -466,6 +512,20 @@ int main(int argc, char** argv)
 				return EXIT_FAILURE;
 			}
 		}
+		// Older firmware only supports the erase and write below.
+		if ((address % 4096) == 0) {
+			result = program_image(device, address, data, length);
+			if (result == HACKRF_SUCCESS) {
+				programmed = true;
+			} else if (result != HACKRF_ERROR_USB_API_VERSION) {
+				fclose(infile);
+				infile = NULL;
+				return EXIT_FAILURE;
+			}
+		}
+	}
+
+	if (write && !programmed) {
 		printf("Erasing SPI flash.\n");
 		result = hackrf_spiflash_erase(device);
 		if (result != HACKRF_SUCCESS) {
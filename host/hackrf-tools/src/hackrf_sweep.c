@@ -84,6 +84,10 @@ int gettimeofday(struct timeval* tv, void* ignored)
 	#include <sys/time.h>
 #endif
 
+#ifndef _WIN32
+	#include <sys/mman.h>
+#endif
+
 #include <signal.h>
 #include <math.h>
 
@@ -96,12 +100,12 @@ int gettimeofday(struct timeval* tv, void* ignored)
 
 #define DEFAULT_SAMPLE_RATE_HZ            (20000000) /* 20MHz default sample rate */
 #define DEFAULT_BASEBAND_FILTER_BANDWIDTH (15000000) /* 15MHz default */
-
-#define TUNE_STEP (DEFAULT_SAMPLE_RATE_HZ / FREQ_ONE_MHZ)
-#define OFFSET    7500000
+#define MIN_SAMPLE_RATE_HZ                (2000000)
+#define MAX_SAMPLE_RATE_HZ                (20000000)
 
 #define BLOCKS_PER_TRANSFER 16
 #define THROWAWAY_BLOCKS    2
+#define DROPPED_BLOCK_FLAGS (SWEEP_BLOCK_FLAG_SHORTFALL | SWEEP_BLOCK_FLAG_RETUNE_FAILED)
 
 #if defined _WIN32
 	#define m_sleep(a) Sleep((a))
@@ -112,7 +116,53 @@ int gettimeofday(struct timeval* tv, void* ignored)
 uint32_t num_sweeps = 0;
 int num_ranges = 0;
 uint16_t frequencies[MAX_SWEEP_RANGES * 2];
-int step_count;
+uint32_t range_steps[MAX_SWEEP_RANGES];
+uint32_t block_size = BYTES_PER_BLOCK;
+bool settle_set = false;
+uint32_t settle_samples = 0;
+uint32_t sample_rate_hz = DEFAULT_SAMPLE_RATE_HZ;
+uint32_t baseband_filter_bw_hz = 0;
+
+/*
+ * Each tuning keeps two slices of its spectrum, the ones lying between
+ * one half and one and a half slice widths either side of the center,
+ * away from the DC spike. Tunings alternate between slice_hz and three
+ * times slice_hz apart, so that two tunings cover one step of four
+ * slices. At 20 Msps with the 15MHz filter, a slice is a quarter of the
+ * sample rate.
+ */
+uint32_t slices_per_rate = 4;
+uint32_t slice_hz;
+uint32_t step_hz;
+uint32_t offset_hz;
+int slice_bins;
+int lower_bin;
+int upper_bin;
+
+/*
+ * With device_spectrum, the HackRF averages the power spectrum at each
+ * tuning itself and sends one record of fftSize bins per tuning, in
+ * place of the samples. It can't keep up at high sample rates, so the
+ * FFTs averaged and blocks skipped are totalled to report how much of
+ * the time was used.
+ */
+bool device_spectrum = false;
+uint64_t device_frames = 0;
+uint64_t device_skipped = 0;
+
+/*
+ * Block headers carry the sweep sequence number and the index of the
+ * tuning within the sweep, so that lost blocks can be spotted. Sweeps
+ * missing any block, or with blocks the HackRF flagged as not contiguous,
+ * are counted as incomplete. Older firmware sends 10-byte headers holding
+ * only the frequency.
+ */
+uint32_t header_size = SWEEP_BLOCK_HEADER_SIZE;
+uint32_t sweep_tunings = 0;
+uint32_t last_seq = 0;
+uint16_t last_step = 0;
+bool sweep_incomplete = false;
+uint64_t incomplete_sweeps = 0;
 
 static float TimevalDiff(const struct timeval* a, const struct timeval* b)
 {
@@ -206,6 +256,116 @@ float* window;
 
 struct timeval usb_transfer_time;
 
+/*
+ * Trace reduction: instead of emitting every sweep, per-bin accumulators
+ * keyed by absolute bin index across all ranges are updated and only the
+ * reduced trace is emitted every reduce_sweeps sweeps or reduce_interval
+ * seconds.
+ */
+typedef enum {
+	REDUCE_NONE = 0,
+	REDUCE_MAX = 1,
+	REDUCE_MIN = 2,
+	REDUCE_MEAN = 3,
+	REDUCE_EMA = 4,
+	REDUCE_PERCENTILE = 5,
+} reduce_mode;
+
+/*
+ * P-square streaming quantile estimator (Jain & Chlamtac, 1985). Five
+ * markers per bin give a fixed-memory percentile estimate without storing
+ * the observations.
+ */
+struct p2_estimator {
+	float q[5];    /* marker heights */
+	int32_t n[5];  /* marker positions, zero-based */
+};
+
+reduce_mode reduction = REDUCE_NONE;
+float ema_alpha = 0.1f;
+float percentile = 0.5f;
+uint32_t reduce_sweeps = 0;
+float reduce_interval = 0;
+uint32_t reduce_sweep_count = 0;
+struct timeval reduce_start;
+uint32_t total_bins = 0;
+uint32_t range_bin_offset[MAX_SWEEP_RANGES];
+float* acc = NULL;
+uint32_t* acc_count = NULL;
+struct p2_estimator* acc_p2 = NULL;
+float* reduced_row = NULL;
+
+/*
+ * Full-sweep output: every step's quarter-band bins are placed into one
+ * contiguous array of total_bins covering all ranges, which is emitted as
+ * a single row per sweep.
+ */
+typedef enum {
+	SPECTRUM_NONE = 0,
+	SPECTRUM_FLOAT = 1,
+	SPECTRUM_PGM = 2,
+} spectrum_format;
+
+#define PGM_STRIP_ROWS 64
+#define SHM_RING_ROWS  256
+#define SHM_MAGIC      0x53465248 /* "HRFS" */
+
+/*
+ * Layout of the shared memory ring. The header is followed by num_rows
+ * rows of num_bins floats. Row (row_count - 1) % num_rows is the newest
+ * complete row; row_count is only advanced once that row has been written.
+ *
+ * The writer doesn't wait for readers, so a slow reader's row may be
+ * overwritten while it is copied. row_sequence[r] is zero while row r is
+ * being written and otherwise holds the number (counting from one) of the
+ * row it contains. A reader checks that it is unchanged after its copy.
+ */
+struct sweep_shm_header {
+	uint32_t magic;
+	uint32_t num_bins;
+	uint32_t num_rows;
+	uint32_t num_ranges;
+	double bin_width;
+	uint64_t range_hz[MAX_SWEEP_RANGES * 2];
+	volatile uint64_t row_count;
+	volatile uint64_t row_sequence[SHM_RING_ROWS];
+};
+
+spectrum_format spectrum_output = SPECTRUM_NONE;
+float* spectrum = NULL;
+float pgm_db_min = -100.0f;
+float pgm_db_max = 0.0f;
+uint8_t* pgm_strip = NULL;
+uint32_t pgm_strip_rows = PGM_STRIP_ROWS;
+uint32_t pgm_rows = 0;
+const char* shm_name = NULL;
+struct sweep_shm_header* shm_header = NULL;
+float* shm_rows = NULL;
+size_t shm_size = 0;
+
+/*
+ * Detector: the noise floor of each bin is a rolling minimum, kept as the
+ * minimum over the current and the previous window of floor_window sweeps.
+ * Runs of adjacent bins more than detect_threshold dB above their floor
+ * are reported as a single detection.
+ */
+bool detect = false;
+float detect_threshold = 0;
+uint32_t floor_window = 16;
+uint32_t floor_sweeps = 0;
+float* floor_cur = NULL;
+float* floor_prev = NULL;
+
+/*
+ * Capture files hold the sweep plan followed by the raw transfers exactly
+ * as received, so that they can be fed back through rx_callback().
+ */
+#define CAPTURE_MAGIC   "HRFSWEEP"
+#define CAPTURE_VERSION 4
+
+FILE* capture_file = NULL;
+FILE* replay_file = NULL;
+
 float logPower(fftwf_complex in, float scale)
 {
 	float re = in[0] * scale;
@@ -214,16 +374,481 @@ float logPower(fftwf_complex in, float scale)
 	return (float) (log2(magsq) * 10.0f / log2(10.0f));
 }
 
+/*
+ * Map the low edge of a quarter-band segment to its absolute bin index in
+ * the whole multi-range sweep, or -1 if it lies outside every range.
+ */
+static int32_t sweep_bin_index(uint64_t frequency)
+{
+	uint64_t range_low, range_high;
+	int r;
+
+	for (r = 0; r < num_ranges; r++) {
+		range_low = FREQ_ONE_MHZ * frequencies[2 * r];
+		range_high = range_low + (uint64_t) range_steps[r] * step_hz;
+		if ((frequency >= range_low) && (frequency < range_high)) {
+			return (int32_t) (range_bin_offset[r] +
+					  ((frequency - range_low) / slice_hz) *
+						  slice_bins);
+		}
+	}
+	return -1;
+}
+
+static void p2_update(struct p2_estimator* e, uint32_t count, float x, float p)
+{
+	const float dn[5] = {0.0f, p / 2, p, (1.0f + p) / 2, 1.0f};
+	float d, qp;
+	int i, k, s;
+
+	/* The first five observations are kept sorted as the initial markers. */
+	if (count < 5) {
+		for (i = count; (i > 0) && (e->q[i - 1] > x); i--) {
+			e->q[i] = e->q[i - 1];
+		}
+		e->q[i] = x;
+		if (count == 4) {
+			for (i = 0; i < 5; i++) {
+				e->n[i] = i;
+			}
+		}
+		return;
+	}
+
+	if (x < e->q[0]) {
+		e->q[0] = x;
+		k = 0;
+	} else if (x >= e->q[4]) {
+		e->q[4] = x;
+		k = 3;
+	} else {
+		for (k = 0; (k < 3) && (x >= e->q[k + 1]); k++) {}
+	}
+	for (i = k + 1; i < 5; i++) {
+		e->n[i]++;
+	}
+
+	for (i = 1; i < 4; i++) {
+		d = dn[i] * count - e->n[i];
+		if (((d >= 1.0f) && ((e->n[i + 1] - e->n[i]) > 1)) ||
+		    ((d <= -1.0f) && ((e->n[i - 1] - e->n[i]) < -1))) {
+			s = (d >= 0) ? 1 : -1;
+			qp = e->q[i] +
+				(float) s / (e->n[i + 1] - e->n[i - 1]) *
+					((e->n[i] - e->n[i - 1] + s) *
+						 (e->q[i + 1] - e->q[i]) /
+						 (e->n[i + 1] - e->n[i]) +
+					 (e->n[i + 1] - e->n[i] - s) *
+						 (e->q[i] - e->q[i - 1]) /
+						 (e->n[i] - e->n[i - 1]));
+			if ((e->q[i - 1] < qp) && (qp < e->q[i + 1])) {
+				e->q[i] = qp;
+			} else {
+				e->q[i] += s * (e->q[i + s] - e->q[i]) /
+					(e->n[i + s] - e->n[i]);
+			}
+			e->n[i] += s;
+		}
+	}
+}
+
+static float p2_estimate(const struct p2_estimator* e, uint32_t count, float p)
+{
+	if (count < 5) {
+		return e->q[(int) (p * (count - 1) + 0.5f)];
+	}
+	return e->q[2];
+}
+
+static void reduce_accumulate(uint32_t idx, const float* bins, int num_bins)
+{
+	float* a = &acc[idx];
+	uint32_t* c = &acc_count[idx];
+	int i;
+
+	switch (reduction) {
+	case REDUCE_MAX:
+		for (i = 0; i < num_bins; i++) {
+			a[i] = (c[i] == 0 || bins[i] > a[i]) ? bins[i] : a[i];
+		}
+		break;
+	case REDUCE_MIN:
+		for (i = 0; i < num_bins; i++) {
+			a[i] = (c[i] == 0 || bins[i] < a[i]) ? bins[i] : a[i];
+		}
+		break;
+	case REDUCE_MEAN:
+		for (i = 0; i < num_bins; i++) {
+			a[i] = (c[i] == 0) ? bins[i] : a[i] + bins[i];
+		}
+		break;
+	case REDUCE_EMA:
+		for (i = 0; i < num_bins; i++) {
+			a[i] = (c[i] == 0) ? bins[i] :
+					     a[i] + ema_alpha * (bins[i] - a[i]);
+		}
+		break;
+	case REDUCE_PERCENTILE:
+		for (i = 0; i < num_bins; i++) {
+			p2_update(&acc_p2[idx + i], c[i], bins[i], percentile);
+		}
+		break;
+	default:
+		return;
+	}
+	for (i = 0; i < num_bins; i++) {
+		c[i]++;
+	}
+}
+
+static void reduce_reset(void)
+{
+	/* The EMA carries over from one reduction interval to the next. */
+	if (reduction != REDUCE_EMA) {
+		memset(acc_count, 0, sizeof(uint32_t) * total_bins);
+	}
+	reduce_sweep_count = 0;
+	gettimeofday(&reduce_start, NULL);
+}
+
+static void write_row(
+	const char* time_str,
+	long int time_usec,
+	uint64_t hz_low,
+	uint64_t hz_high,
+	const float* bins)
+{
+	uint32_t record_length;
+	int i;
+
+	if (binary_output) {
+		record_length = 2 * sizeof(hz_low) + slice_bins * sizeof(float);
+		fwrite(&record_length, sizeof(record_length), 1, outfile);
+		fwrite(&hz_low, sizeof(hz_low), 1, outfile);
+		fwrite(&hz_high, sizeof(hz_high), 1, outfile);
+		fwrite(bins, sizeof(float), slice_bins, outfile);
+	} else {
+		fprintf(outfile,
+			"%s.%06ld, %" PRIu64 ", %" PRIu64 ", %.2f, %u",
+			time_str,
+			time_usec,
+			hz_low,
+			hz_high,
+			fft_bin_width,
+			fftSize);
+		for (i = 0; slice_bins > i; i++) {
+			fprintf(outfile, ", %.2f", bins[i]);
+		}
+		fprintf(outfile, "\n");
+	}
+}
+
+static void write_pgm_strip(void)
+{
+	if (pgm_rows == 0) {
+		return;
+	}
+	fprintf(outfile, "P5\n%u %u\n255\n", total_bins, pgm_rows);
+	fwrite(pgm_strip, 1, (size_t) total_bins * pgm_rows, outfile);
+	fflush(outfile);
+	pgm_rows = 0;
+}
+
+static void emit_spectrum_row(void)
+{
+	float scale = 255.0f / (pgm_db_max - pgm_db_min);
+	uint8_t* row;
+	float v;
+	uint32_t i;
+
+	if (spectrum_output == SPECTRUM_FLOAT) {
+		fwrite(spectrum, sizeof(float), total_bins, outfile);
+	} else if (spectrum_output == SPECTRUM_PGM) {
+		row = &pgm_strip[(size_t) pgm_rows * total_bins];
+		for (i = 0; i < total_bins; i++) {
+			/* Missing bins are NaN and fail both comparisons. */
+			v = (spectrum[i] - pgm_db_min) * scale;
+			row[i] = (v > 0.0f) ? ((v < 255.0f) ? (uint8_t) v : 255) : 0;
+		}
+		if (++pgm_rows == pgm_strip_rows) {
+			write_pgm_strip();
+		}
+	}
+
+#ifndef _WIN32
+	if (shm_header != NULL) {
+		i = shm_header->row_count % SHM_RING_ROWS;
+		shm_header->row_sequence[i] = 0;
+		__sync_synchronize();
+		memcpy(&shm_rows[(size_t) i * total_bins],
+		       spectrum,
+		       sizeof(float) * total_bins);
+		__sync_synchronize();
+		shm_header->row_sequence[i] = shm_header->row_count + 1;
+		shm_header->row_count++;
+	}
+#endif
+
+	for (i = 0; i < total_bins; i++) {
+		spectrum[i] = NAN;
+	}
+}
+
+static void detect_signals(void)
+{
+	time_t time_stamp_seconds = usb_transfer_time.tv_sec;
+	char time_str[50];
+	float peak, noise_floor;
+	float* swap;
+	uint32_t i, start = 0, end;
+	bool active;
+	int r;
+
+	strftime(
+		time_str,
+		50,
+		"%Y-%m-%d, %H:%M:%S",
+		localtime(&time_stamp_seconds));
+
+	for (r = 0; r < num_ranges; r++) {
+		end = (r + 1 < num_ranges) ? range_bin_offset[r + 1] : total_bins;
+		active = false;
+		peak = 0;
+		for (i = range_bin_offset[r]; i <= end; i++) {
+			noise_floor = (floor_cur[i] < floor_prev[i]) ? floor_cur[i] :
+									 floor_prev[i];
+			if ((i < end) && (spectrum[i] > noise_floor + detect_threshold)) {
+				if (!active) {
+					active = true;
+					start = i;
+					peak = spectrum[i];
+				} else if (spectrum[i] > peak) {
+					peak = spectrum[i];
+				}
+			} else if (active) {
+				active = false;
+				fprintf(outfile,
+					"%s.%06ld, %" PRIu64 ", %" PRIu64 ", %.2f\n",
+					time_str,
+					(long int) usb_transfer_time.tv_usec,
+					(uint64_t) (FREQ_ONE_MHZ * frequencies[2 * r] +
+						    (start - range_bin_offset[r]) *
+							    fft_bin_width),
+					(uint64_t) (FREQ_ONE_MHZ * frequencies[2 * r] +
+						    (i - range_bin_offset[r]) *
+							    fft_bin_width),
+					peak);
+			}
+		}
+	}
+
+	for (i = 0; i < total_bins; i++) {
+		floor_cur[i] = (spectrum[i] < floor_cur[i]) ? spectrum[i] : floor_cur[i];
+	}
+	if (++floor_sweeps == floor_window) {
+		swap = floor_prev;
+		floor_prev = floor_cur;
+		floor_cur = swap;
+		for (i = 0; i < total_bins; i++) {
+			floor_cur[i] = INFINITY;
+		}
+		floor_sweeps = 0;
+	}
+}
+
+static int write_capture_header(FILE* file)
+{
+	uint32_t version = CAPTURE_VERSION;
+	uint32_t ranges = num_ranges;
+
+	if ((fwrite(CAPTURE_MAGIC, 8, 1, file) != 1) ||
+	    (fwrite(&version, sizeof(version), 1, file) != 1) ||
+	    (fwrite(&block_size, sizeof(block_size), 1, file) != 1) ||
+	    (fwrite(&sample_rate_hz, sizeof(sample_rate_hz), 1, file) != 1) ||
+	    (fwrite(&baseband_filter_bw_hz, sizeof(baseband_filter_bw_hz), 1, file) !=
+	     1) ||
+	    (fwrite(&header_size, sizeof(header_size), 1, file) != 1) ||
+	    (fwrite(&ranges, sizeof(ranges), 1, file) != 1) ||
+	    (fwrite(frequencies, sizeof(frequencies[0]), 2 * ranges, file) !=
+	     2 * ranges)) {
+		return -1;
+	}
+	return 0;
+}
+
+static int read_capture_header(FILE* file)
+{
+	char magic[8];
+	uint32_t version, ranges;
+
+	if ((fread(magic, 8, 1, file) != 1) ||
+	    (memcmp(magic, CAPTURE_MAGIC, 8) != 0) ||
+	    (fread(&version, sizeof(version), 1, file) != 1) ||
+	    (version < 1) || (version > CAPTURE_VERSION)) {
+		return -1;
+	}
+	/* Version 1 files predate configurable block sizes. */
+	if ((version > 1) &&
+	    ((fread(&block_size, sizeof(block_size), 1, file) != 1) ||
+	     (block_size < MIN_BYTES_PER_BLOCK) || (block_size > BYTES_PER_BLOCK) ||
+	     (block_size & (block_size - 1)))) {
+		return -1;
+	}
+	/* Earlier versions were always recorded at the default sample rate. */
+	sample_rate_hz = DEFAULT_SAMPLE_RATE_HZ;
+	baseband_filter_bw_hz = DEFAULT_BASEBAND_FILTER_BANDWIDTH;
+	if ((version > 2) &&
+	    ((fread(&sample_rate_hz, sizeof(sample_rate_hz), 1, file) != 1) ||
+	     (fread(&baseband_filter_bw_hz, sizeof(baseband_filter_bw_hz), 1, file) !=
+	      1) ||
+	     (sample_rate_hz < MIN_SAMPLE_RATE_HZ) ||
+	     (sample_rate_hz > MAX_SAMPLE_RATE_HZ) || (baseband_filter_bw_hz == 0))) {
+		return -1;
+	}
+	/* Earlier versions were recorded with 10-byte block headers. */
+	header_size = 10;
+	if ((version > 3) &&
+	    ((fread(&header_size, sizeof(header_size), 1, file) != 1) ||
+	     ((header_size != 10) && (header_size != SWEEP_BLOCK_HEADER_SIZE)))) {
+		return -1;
+	}
+	if ((fread(&ranges, sizeof(ranges), 1, file) != 1) || (ranges < 1) ||
+	    (ranges > MAX_SWEEP_RANGES) ||
+	    (fread(frequencies, sizeof(frequencies[0]), 2 * ranges, file) !=
+	     2 * ranges)) {
+		return -1;
+	}
+	num_ranges = ranges;
+	return 0;
+}
+
+#ifndef _WIN32
+static int open_shm_ring(const char* name)
+{
+	int fd, i;
+
+	shm_size = sizeof(struct sweep_shm_header) +
+		sizeof(float) * (size_t) total_bins * SHM_RING_ROWS;
+	fd = shm_open(name, O_CREAT | O_RDWR, 0644);
+	if (fd < 0) {
+		return -1;
+	}
+	if (ftruncate(fd, shm_size) != 0) {
+		close(fd);
+		return -1;
+	}
+	shm_header = (struct sweep_shm_header*)
+		mmap(NULL, shm_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (shm_header == MAP_FAILED) {
+		shm_header = NULL;
+		return -1;
+	}
+
+	shm_rows = (float*) (shm_header + 1);
+	shm_header->row_count = 0;
+	memset((void*) shm_header->row_sequence, 0, sizeof(shm_header->row_sequence));
+	shm_header->num_bins = total_bins;
+	shm_header->num_rows = SHM_RING_ROWS;
+	shm_header->num_ranges = num_ranges;
+	shm_header->bin_width = fft_bin_width;
+	for (i = 0; i < num_ranges; i++) {
+		shm_header->range_hz[2 * i] = FREQ_ONE_MHZ * frequencies[2 * i];
+		shm_header->range_hz[2 * i + 1] =
+			shm_header->range_hz[2 * i] + (uint64_t) range_steps[i] * step_hz;
+	}
+	__sync_synchronize();
+	shm_header->magic = SHM_MAGIC;
+	return 0;
+}
+#endif
+
+static void emit_reduced_trace(void)
+{
+	struct timeval now;
+	time_t time_stamp_seconds;
+	char time_str[50];
+	uint64_t hz_low;
+	uint32_t idx, seg, num_segs;
+	int i, r;
+
+	gettimeofday(&now, NULL);
+	time_stamp_seconds = now.tv_sec;
+	strftime(time_str, 50, "%Y-%m-%d, %H:%M:%S", localtime(&time_stamp_seconds));
+
+	for (r = 0; r < num_ranges; r++) {
+		num_segs = 4 * range_steps[r];
+		for (seg = 0; seg < num_segs; seg++) {
+			idx = range_bin_offset[r] + seg * slice_bins;
+			if (acc_count[idx] == 0) {
+				continue;
+			}
+			for (i = 0; i < slice_bins; i++) {
+				switch (reduction) {
+				case REDUCE_MEAN:
+					reduced_row[i] =
+						acc[idx + i] / acc_count[idx + i];
+					break;
+				case REDUCE_PERCENTILE:
+					reduced_row[i] = p2_estimate(
+						&acc_p2[idx + i],
+						acc_count[idx + i],
+						percentile);
+					break;
+				default:
+					reduced_row[i] = acc[idx + i];
+					break;
+				}
+			}
+			hz_low = FREQ_ONE_MHZ * frequencies[2 * r] +
+				(uint64_t) seg * slice_hz;
+			write_row(
+				time_str,
+				(long int) now.tv_usec,
+				hz_low,
+				hz_low + slice_hz,
+				reduced_row);
+		}
+	}
+	fflush(outfile);
+	reduce_reset();
+}
+
+/*
+ * Convert the mean powers in a record averaged on the device to dB, on
+ * the same scale as logPower() gives for the host's FFT. The device
+ * reports squared Q15 magnitudes.
+ */
+static void record_power(const uint8_t* record)
+{
+	const uint8_t* bin;
+	uint32_t power;
+	int i;
+
+	device_frames += record[10] | (record[11] << 8);
+	device_skipped += record[14] | (record[15] << 8);
+	for (i = 0; i < fftSize; i++) {
+		bin = &record[SWEEP_SPECTRUM_HEADER_SIZE + 4 * i];
+		power = ((uint32_t) bin[3] << 24) | ((uint32_t) bin[2] << 16) |
+			((uint32_t) bin[1] << 8) | bin[0];
+		pwr[i] = (float) (10.0 * log10(power / 1073741824.0));
+	}
+}
+
 int rx_callback(hackrf_transfer* transfer)
 {
 	int8_t* buf;
 	uint8_t* ubuf;
 	uint64_t frequency; /* in Hz */
-	uint64_t band_edge;
-	uint32_t record_length;
 	int i, j, ifft_bins;
+	uint32_t record_size, seq;
+	uint16_t step, flags;
+	bool new_sweep, lost_before, lost;
+	float* ifft_out;
+	float ifft_scale;
 	struct tm* fft_time;
 	char time_str[50];
+	struct timeval time_now;
 
 	if (NULL == outfile) {
 		return -1;
@@ -233,6 +858,10 @@ int rx_callback(hackrf_transfer* transfer)
 		return 0;
 	}
 
+	if (capture_file != NULL) {
+		fwrite(transfer->buffer, 1, transfer->valid_length, capture_file);
+	}
+
 	// happens only once with timestamp_normalized == true
 	if ((usb_transfer_time.tv_sec == 0 && usb_transfer_time.tv_usec == 0) ||
 	    timestamp_normalized == false) {
@@ -242,8 +871,9 @@ int rx_callback(hackrf_transfer* transfer)
 
 	byte_count += transfer->valid_length;
 	buf = (int8_t*) transfer->buffer;
-	ifft_bins = fftSize * step_count;
-	for (j = 0; j < BLOCKS_PER_TRANSFER; j++) {
+	ifft_bins = 4 * slice_bins * range_steps[0];
+	record_size = device_spectrum ? SWEEP_SPECTRUM_RECORD_SIZE(fftSize) : block_size;
+	for (j = 0; j < transfer->valid_length / (int) record_size; j++) {
 		ubuf = (uint8_t*) buf;
 		if (ubuf[0] == 0x7F && ubuf[1] == 0x7F) {
 			frequency = ((uint64_t) (ubuf[9]) << 56) |
@@ -254,27 +884,73 @@ int rx_callback(hackrf_transfer* transfer)
 				((uint64_t) (ubuf[4]) << 16) |
 				((uint64_t) (ubuf[3]) << 8) | ubuf[2];
 		} else {
-			buf += BYTES_PER_BLOCK;
+			buf += record_size;
 			continue;
 		}
-		if (frequency == (uint64_t) (FREQ_ONE_MHZ * frequencies[0])) {
+		lost_before = false;
+		lost = false;
+		flags = 0;
+		if (!device_spectrum && (header_size == SWEEP_BLOCK_HEADER_SIZE)) {
+			seq = ((uint32_t) (ubuf[13]) << 24) |
+				((uint32_t) (ubuf[12]) << 16) |
+				((uint32_t) (ubuf[11]) << 8) | ubuf[10];
+			step = ((uint16_t) (ubuf[15]) << 8) | ubuf[14];
+			flags = ((uint16_t) (ubuf[19]) << 8) | ubuf[18];
+			if (sweep_started) {
+				/*
+				 * Each sweep takes one block at each tuning, so
+				 * every block should follow on from the last.
+				 */
+				new_sweep = (seq != last_seq);
+				if (new_sweep) {
+					lost_before = (seq != last_seq + 1) ||
+						(last_step + 1u != sweep_tunings);
+					lost = (step != 0);
+				} else {
+					lost = (step != last_step + 1u);
+				}
+			} else {
+				new_sweep = (step == 0);
+			}
+			last_seq = seq;
+			last_step = step;
+		} else {
+			new_sweep =
+				(frequency == (uint64_t) (FREQ_ONE_MHZ * frequencies[0]));
+		}
+		if (lost_before) {
+			sweep_incomplete = true;
+		}
+		if (new_sweep) {
 			if (sweep_started) {
 				if (ifft_output) {
 					fftwf_execute(ifftwPlan);
-					for (i = 0; i < ifft_bins; i++) {
-						ifftwOut[i][0] *= 1.0f / ifft_bins;
-						ifftwOut[i][1] *= 1.0f / ifft_bins;
-						fwrite(&ifftwOut[i][0],
-						       sizeof(float),
-						       1,
-						       outfile);
-						fwrite(&ifftwOut[i][1],
-						       sizeof(float),
-						       1,
-						       outfile);
+					/*
+					 * fftwf_complex is an interleaved I/Q pair, so
+					 * the output can be scaled as one flat array and
+					 * written with a single call.
+					 */
+					ifft_out = (float*) ifftwOut;
+					ifft_scale = 1.0f / ifft_bins;
+					for (i = 0; i < 2 * ifft_bins; i++) {
+						ifft_out[i] *= ifft_scale;
 					}
+					fwrite(ifftwOut,
+					       sizeof(fftwf_complex),
+					       ifft_bins,
+					       outfile);
+				}
+				if (detect) {
+					detect_signals();
+				}
+				if (spectrum != NULL) {
+					emit_spectrum_row();
 				}
 				sweep_count++;
+				if (sweep_incomplete) {
+					incomplete_sweeps++;
+					sweep_incomplete = false;
+				}
 
 				if (timestamp_normalized == true) {
 					// set the timestamp of the next sweep
@@ -286,6 +962,19 @@ int rx_callback(hackrf_transfer* transfer)
 				} else if (finite_mode && sweep_count == num_sweeps) {
 					do_exit = true;
 				}
+
+				if (reduction != REDUCE_NONE) {
+					reduce_sweep_count++;
+					gettimeofday(&time_now, NULL);
+					if (do_exit ||
+					    (reduce_sweeps &&
+					     (reduce_sweep_count >= reduce_sweeps)) ||
+					    (reduce_interval &&
+					     (TimevalDiff(&time_now, &reduce_start) >=
+					      reduce_interval))) {
+						emit_reduced_trace();
+					}
+				}
 			}
 			sweep_started = true;
 		}
@@ -293,98 +982,173 @@ int rx_callback(hackrf_transfer* transfer)
 			return 0;
 		}
 		if (!sweep_started) {
-			buf += BYTES_PER_BLOCK;
+			buf += record_size;
+			continue;
+		}
+		/*
+		 * Drop blocks with missing samples or at the wrong frequency, but
+		 * still count the sweep.
+		 */
+		if (lost || (flags & DROPPED_BLOCK_FLAGS)) {
+			sweep_incomplete = true;
+		}
+		if (flags & DROPPED_BLOCK_FLAGS) {
+			buf += record_size;
 			continue;
 		}
 		if ((FREQ_MAX_MHZ * FREQ_ONE_MHZ) < frequency) {
-			buf += BYTES_PER_BLOCK;
+			buf += record_size;
 			continue;
 		}
-		/* copy to fftwIn as floats */
-		buf += BYTES_PER_BLOCK - (fftSize * 2);
-		for (i = 0; i < fftSize; i++) {
-			fftwIn[i][0] = buf[i * 2] * window[i] * 1.0f / 128.0f;
-			fftwIn[i][1] = buf[i * 2 + 1] * window[i] * 1.0f / 128.0f;
-		}
-		buf += fftSize * 2;
-		fftwf_execute(fftwPlan);
-		for (i = 0; i < fftSize; i++) {
-			pwr[i] = logPower(fftwOut[i], 1.0f / fftSize);
-		}
-		if (binary_output) {
-			record_length =
-				2 * sizeof(band_edge) + (fftSize / 4) * sizeof(float);
-
-			fwrite(&record_length, sizeof(record_length), 1, outfile);
-			band_edge = frequency;
-			fwrite(&band_edge, sizeof(band_edge), 1, outfile);
-			band_edge = frequency + DEFAULT_SAMPLE_RATE_HZ / 4;
-			fwrite(&band_edge, sizeof(band_edge), 1, outfile);
-			fwrite(&pwr[1 + (fftSize * 5) / 8],
-			       sizeof(float),
-			       fftSize / 4,
-			       outfile);
-
-			fwrite(&record_length, sizeof(record_length), 1, outfile);
-			band_edge = frequency + DEFAULT_SAMPLE_RATE_HZ / 2;
-			fwrite(&band_edge, sizeof(band_edge), 1, outfile);
-			band_edge = frequency + (DEFAULT_SAMPLE_RATE_HZ * 3) / 4;
-			fwrite(&band_edge, sizeof(band_edge), 1, outfile);
-			fwrite(&pwr[1 + fftSize / 8], sizeof(float), fftSize / 4, outfile);
+		if (device_spectrum) {
+			record_power(ubuf);
+			buf += record_size;
+		} else {
+			/* copy to fftwIn as floats */
+			buf += block_size - (fftSize * 2);
+			for (i = 0; i < fftSize; i++) {
+				fftwIn[i][0] = buf[i * 2] * window[i] * 1.0f / 128.0f;
+				fftwIn[i][1] = buf[i * 2 + 1] * window[i] * 1.0f / 128.0f;
+			}
+			buf += fftSize * 2;
+			fftwf_execute(fftwPlan);
+			for (i = 0; i < fftSize; i++) {
+				pwr[i] = logPower(fftwOut[i], 1.0f / fftSize);
+			}
+		}
+		if (spectrum != NULL) {
+			int32_t idx = sweep_bin_index(frequency);
+			if (idx >= 0) {
+				memcpy(&spectrum[idx],
+				       &pwr[lower_bin],
+				       sizeof(float) * slice_bins);
+			}
+			idx = sweep_bin_index(frequency + 2 * slice_hz);
+			if (idx >= 0) {
+				memcpy(&spectrum[idx],
+				       &pwr[upper_bin],
+				       sizeof(float) * slice_bins);
+			}
+		}
+		if (reduction != REDUCE_NONE) {
+			int32_t idx = sweep_bin_index(frequency);
+			if (idx >= 0) {
+				reduce_accumulate(idx, &pwr[lower_bin], slice_bins);
+			}
+			idx = sweep_bin_index(frequency + 2 * slice_hz);
+			if (idx >= 0) {
+				reduce_accumulate(idx, &pwr[upper_bin], slice_bins);
+			}
 		} else if (ifft_output) {
 			ifft_idx = (uint32_t) round(
 				(frequency - (uint64_t) (FREQ_ONE_MHZ * frequencies[0])) /
 				fft_bin_width);
 			ifft_idx = (ifft_idx + ifft_bins / 2) % ifft_bins;
-			for (i = 0; (fftSize / 4) > i; i++) {
-				ifftwIn[ifft_idx + i][0] =
-					fftwOut[i + 1 + (fftSize * 5) / 8][0];
-				ifftwIn[ifft_idx + i][1] =
-					fftwOut[i + 1 + (fftSize * 5) / 8][1];
+			for (i = 0; slice_bins > i; i++) {
+				ifftwIn[ifft_idx + i][0] = fftwOut[i + lower_bin][0];
+				ifftwIn[ifft_idx + i][1] = fftwOut[i + lower_bin][1];
 			}
-			ifft_idx += fftSize / 2;
+			ifft_idx += 2 * slice_bins;
 			ifft_idx %= ifft_bins;
-			for (i = 0; (fftSize / 4) > i; i++) {
-				ifftwIn[ifft_idx + i][0] =
-					fftwOut[i + 1 + (fftSize / 8)][0];
-				ifftwIn[ifft_idx + i][1] =
-					fftwOut[i + 1 + (fftSize / 8)][1];
+			for (i = 0; slice_bins > i; i++) {
+				ifftwIn[ifft_idx + i][0] = fftwOut[i + upper_bin][0];
+				ifftwIn[ifft_idx + i][1] = fftwOut[i + upper_bin][1];
 			}
-		} else {
+		} else if ((spectrum_output == SPECTRUM_NONE) && !detect) {
 			time_t time_stamp_seconds = usb_transfer_time.tv_sec;
 			fft_time = localtime(&time_stamp_seconds);
 			strftime(time_str, 50, "%Y-%m-%d, %H:%M:%S", fft_time);
-			fprintf(outfile,
-				"%s.%06ld, %" PRIu64 ", %" PRIu64 ", %.2f, %u",
+			write_row(
 				time_str,
 				(long int) usb_transfer_time.tv_usec,
-				(uint64_t) (frequency),
-				(uint64_t) (frequency + DEFAULT_SAMPLE_RATE_HZ / 4),
-				fft_bin_width,
-				fftSize);
-			for (i = 0; (fftSize / 4) > i; i++) {
-				fprintf(outfile,
-					", %.2f",
-					pwr[i + 1 + (fftSize * 5) / 8]);
-			}
-			fprintf(outfile, "\n");
-			fprintf(outfile,
-				"%s.%06ld, %" PRIu64 ", %" PRIu64 ", %.2f, %u",
+				frequency,
+				frequency + slice_hz,
+				&pwr[lower_bin]);
+			write_row(
 				time_str,
 				(long int) usb_transfer_time.tv_usec,
-				(uint64_t) (frequency + (DEFAULT_SAMPLE_RATE_HZ / 2)),
-				(uint64_t) (frequency + ((DEFAULT_SAMPLE_RATE_HZ * 3) / 4)),
-				fft_bin_width,
-				fftSize);
-			for (i = 0; (fftSize / 4) > i; i++) {
-				fprintf(outfile, ", %.2f", pwr[i + 1 + (fftSize / 8)]);
-			}
-			fprintf(outfile, "\n");
+				frequency + 2 * slice_hz,
+				frequency + 3 * slice_hz,
+				&pwr[upper_bin]);
 		}
 	}
 	return 0;
 }
 
+/*
+ * Feed a capture file through rx_callback() as fast as possible.
+ */
+static int replay_sweeps(FILE* file)
+{
+	const size_t transfer_size = BLOCKS_PER_TRANSFER * BYTES_PER_BLOCK;
+	hackrf_transfer transfer;
+	struct timeval replay_start, replay_end;
+	uint64_t blocks = 0;
+	float replay_time;
+	size_t length;
+
+	memset(&transfer, 0, sizeof(transfer));
+	transfer.buffer = (uint8_t*) malloc(transfer_size);
+	if (NULL == transfer.buffer) {
+		return -1;
+	}
+	transfer.buffer_length = transfer_size;
+
+	gettimeofday(&replay_start, NULL);
+	while (!do_exit) {
+		length = fread(transfer.buffer, 1, transfer_size, file);
+		if (length < block_size) {
+			break;
+		}
+		/* Blocks past the end of a short read have no header and are skipped. */
+		memset(&transfer.buffer[length], 0, transfer_size - length);
+		transfer.valid_length = length;
+		blocks += length / block_size;
+		if (rx_callback(&transfer) != 0) {
+			break;
+		}
+	}
+	gettimeofday(&replay_end, NULL);
+	free(transfer.buffer);
+
+	replay_time = TimevalDiff(&replay_end, &replay_start);
+	if (replay_time > 0) {
+		fprintf(stderr,
+			"Replayed %" PRIu64 " blocks, %" PRIu64
+			" sweeps in %.5f seconds (%.1f blocks/second, %.2f sweeps/second)\n",
+			blocks,
+			sweep_count,
+			replay_time,
+			blocks / replay_time,
+			sweep_count / replay_time);
+	}
+	return 0;
+}
+
+/*
+ * Choose the slice width for the sample rate and baseband filter. The
+ * outer edges of the slices kept from each tuning, one and a half slice
+ * widths from the center, must lie within the filter passband, and no
+ * further out than 3/8 of the sample rate so that they stay clear of the
+ * filter roll-off and aliasing.
+ */
+static void plan_slices(void)
+{
+	slices_per_rate = 4;
+	while ((uint64_t) slices_per_rate * baseband_filter_bw_hz <
+	       (uint64_t) 3 * sample_rate_hz) {
+		slices_per_rate++;
+	}
+	/* Device FFT sizes are powers of 4, which only divide into powers of 2. */
+	if (device_spectrum) {
+		slices_per_rate = 1 << (int) ceil(log2(slices_per_rate));
+	}
+	/* Keep the offset of one and a half slices a whole number of Hz. */
+	slice_hz = (sample_rate_hz / slices_per_rate) & ~1;
+	step_hz = 4 * slice_hz;
+	offset_hz = 3 * slice_hz / 2;
+}
+
 static void usage()
 {
 	fprintf(stderr,
@@ -396,7 +1160,7 @@ static void usage()
 		"\t[-p antenna_enable] # Antenna port power, 1=Enable, 0=Disable\n"
 		"\t[-l gain_db] # RX LNA (IF) gain, 0-40dB, 8dB steps\n"
 		"\t[-g gain_db] # RX VGA (baseband) gain, 0-62dB, 2dB steps\n"
-		"\t[-w bin_width] # FFT bin width (frequency resolution) in Hz, 2445-5000000\n"
+		"\t[-w bin_width] # FFT bin width (frequency resolution) in Hz, 2445-5000000 at 20 Msps\n"
 		"\t[-W wisdom_file] # Use FFTW wisdom file (will be created if necessary)\n"
 		"\t[-P estimate|measure|patient|exhaustive] # FFTW plan type, default is 'measure'\n"
 		"\t[-1] # one shot mode\n"
@@ -404,14 +1168,70 @@ static void usage()
 		"\t[-B] # binary output\n"
 		"\t[-I] # binary inverse FFT output\n"
 		"\t[-n] # keep the same timestamp within a sweep\n"
+		"\t[-s settle_samples] # samples to discard after each retune, 0-65535\n"
+		"\t[-e sample_rate_hz] # sample rate in Hz, 2-20MHz, default 20MHz\n"
+		"\t[-b baseband_filter_bw_hz] # baseband filter bandwidth in Hz, default 3/4 of the sample rate\n"
+		"\t[-D] # average spectra on the HackRF, FFT size rounded up to 16, 64 or 256\n"
+		"\t[-C capture_file] # also record the raw sweep transfers to a file\n"
+		"\t[-R capture_file] # replay a capture file instead of using a HackRF\n"
+		"\t[-M max|min|mean|ema|pNN] # emit a reduced trace (NN = percentile, 1-99)\n"
+		"\t[-E ema_alpha] # EMA smoothing factor, 0-1, default 0.1\n"
+		"\t[-S num_sweeps] # emit reduced trace every num_sweeps sweeps\n"
+		"\t[-T seconds] # emit reduced trace every number of seconds\n"
+		"\t[-F float|pgm] # one full-sweep row per sweep, float32 or 8-bit PGM strips\n"
+		"\t[-q db_min:db_max] # PGM quantization range in dB, default -100:0\n"
+		"\t[-t threshold_db] # only report detections this far above the noise floor\n"
+		"\t[-k num_sweeps] # noise floor rolling minimum window, default 16\n"
+#ifndef _WIN32
+		"\t[-m shm_name] # publish recent full-sweep rows in a POSIX shared memory ring\n"
+#endif
 		"\t-r filename # output file\n"
 		"\n"
 		"Output fields:\n"
-		"\tdate, time, hz_low, hz_high, hz_bin_width, num_samples, dB, dB, . . .\n");
+		"\tdate, time, hz_low, hz_high, hz_bin_width, num_samples, dB, dB, . . .\n"
+		"\n"
+		"Detection output fields (-t):\n"
+		"\tdate, time, hz_low, hz_high, peak_dB\n");
 }
 
 static hackrf_device* device = NULL;
 
+/*
+ * Upload the frequencies the firmware will tune to, in the order it
+ * visits them, so that it can retune from precomputed settings. This
+ * follows the interleaved stepping in the firmware sweep loop. Sweeps
+ * with too many tunings are left to tune as before.
+ */
+static int upload_tuning_table(void)
+{
+	const uint64_t step = step_hz;
+	uint64_t table[MAX_TUNING_TABLE_ENTRIES];
+	uint64_t freq;
+	int count = 0;
+	int range;
+	bool odd = true;
+
+	for (range = 0; range < num_ranges; range++) {
+		freq = FREQ_ONE_MHZ * frequencies[2 * range];
+		while (true) {
+			if (MAX_TUNING_TABLE_ENTRIES <= count) {
+				return HACKRF_SUCCESS;
+			}
+			table[count++] = freq + offset_hz;
+			if (!odd &&
+			    ((freq + step) >=
+			     FREQ_ONE_MHZ * frequencies[2 * range + 1])) {
+				odd = !odd;
+				break;
+			}
+			freq += odd ? step / 4 : 3 * step / 4;
+			odd = !odd;
+		}
+	}
+
+	return hackrf_set_tuning_table(device, table, count);
+}
+
 #ifdef _MSC_VER
 BOOL WINAPI sighandler(int signum)
 {
@@ -473,11 +1293,23 @@ int main(int argc, char** argv)
 	unsigned int lna_gain = 16, vga_gain = 20;
 	uint32_t freq_min = 0;
 	uint32_t freq_max = 6000;
-	uint32_t requested_fft_bin_width;
+	uint32_t requested_fft_bin_width = 0;
 	const char* fftwWisdomPath = NULL;
 	int fftw_plan_type = FFTW_MEASURE;
-
-	while ((opt = getopt(argc, argv, "a:f:p:l:g:d:N:w:W:P:n1BIr:h?")) != EOF) {
+	uint32_t reduce_seconds = 0;
+	uint32_t requested_percentile;
+	char* endptr;
+	const char* capture_path = NULL;
+	const char* replay_path = NULL;
+	uint32_t max_fft_size;
+	uint16_t usb_api_version;
+	uint64_t range_low_hz, range_high_hz;
+	int ifft_size;
+
+	while ((opt = getopt(
+			argc,
+			argv,
+			"a:f:p:l:g:d:N:w:W:P:n1BIs:e:b:DM:E:S:T:F:q:t:k:m:C:R:r:h?")) != EOF) {
 		result = HACKRF_SUCCESS;
 		switch (opt) {
 		case 'd':
@@ -536,7 +1368,10 @@ int main(int argc, char** argv)
 
 		case 'w':
 			result = parse_u32(optarg, &requested_fft_bin_width);
-			fftSize = DEFAULT_SAMPLE_RATE_HZ / requested_fft_bin_width;
+			if ((result == HACKRF_SUCCESS) &&
+			    (requested_fft_bin_width == 0)) {
+				result = HACKRF_ERROR_INVALID_PARAM;
+			}
 			break;
 
 		case 'W':
@@ -574,6 +1409,122 @@ int main(int argc, char** argv)
 			ifft_output = true;
 			break;
 
+		case 'M':
+			if (strcmp("max", optarg) == 0) {
+				reduction = REDUCE_MAX;
+			} else if (strcmp("min", optarg) == 0) {
+				reduction = REDUCE_MIN;
+			} else if (strcmp("mean", optarg) == 0) {
+				reduction = REDUCE_MEAN;
+			} else if (strcmp("ema", optarg) == 0) {
+				reduction = REDUCE_EMA;
+			} else if (optarg[0] == 'p') {
+				reduction = REDUCE_PERCENTILE;
+				result = parse_u32(optarg + 1, &requested_percentile);
+				if ((result == HACKRF_SUCCESS) &&
+				    ((requested_percentile < 1) ||
+				     (requested_percentile > 99))) {
+					result = HACKRF_ERROR_INVALID_PARAM;
+				}
+				percentile = requested_percentile / 100.0f;
+			} else {
+				fprintf(stderr, "Unknown reduction '%s'\n", optarg);
+				return EXIT_FAILURE;
+			}
+			break;
+
+		case 'E':
+			ema_alpha = strtof(optarg, &endptr);
+			if ((endptr == optarg) || (*endptr != 0) || (ema_alpha <= 0) ||
+			    (ema_alpha > 1)) {
+				result = HACKRF_ERROR_INVALID_PARAM;
+			}
+			break;
+
+		case 'S':
+			result = parse_u32(optarg, &reduce_sweeps);
+			break;
+
+		case 'T':
+			result = parse_u32(optarg, &reduce_seconds);
+			reduce_interval = (float) reduce_seconds;
+			break;
+
+		case 'F':
+			if (strcmp("float", optarg) == 0) {
+				spectrum_output = SPECTRUM_FLOAT;
+			} else if (strcmp("pgm", optarg) == 0) {
+				spectrum_output = SPECTRUM_PGM;
+			} else {
+				fprintf(stderr,
+					"Unknown full-sweep format '%s'\n",
+					optarg);
+				return EXIT_FAILURE;
+			}
+			break;
+
+		case 'q':
+			if ((sscanf(optarg, "%f:%f", &pgm_db_min, &pgm_db_max) != 2) ||
+			    (pgm_db_min >= pgm_db_max)) {
+				result = HACKRF_ERROR_INVALID_PARAM;
+			}
+			break;
+
+		case 't':
+			detect = true;
+			detect_threshold = strtof(optarg, &endptr);
+			if ((endptr == optarg) || (*endptr != 0) ||
+			    (detect_threshold <= 0)) {
+				result = HACKRF_ERROR_INVALID_PARAM;
+			}
+			break;
+
+		case 'k':
+			result = parse_u32(optarg, &floor_window);
+			if ((result == HACKRF_SUCCESS) && (floor_window < 1)) {
+				result = HACKRF_ERROR_INVALID_PARAM;
+			}
+			break;
+
+		case 'm':
+			shm_name = optarg;
+			break;
+
+		case 's':
+			result = parse_u32(optarg, &settle_samples);
+			if ((result == HACKRF_SUCCESS) && (settle_samples > 0xffff)) {
+				result = HACKRF_ERROR_INVALID_PARAM;
+			}
+			settle_set = true;
+			break;
+
+		case 'e':
+			result = parse_u32(optarg, &sample_rate_hz);
+			if ((result == HACKRF_SUCCESS) &&
+			    ((sample_rate_hz < MIN_SAMPLE_RATE_HZ) ||
+			     (sample_rate_hz > MAX_SAMPLE_RATE_HZ))) {
+				result = HACKRF_ERROR_INVALID_PARAM;
+			}
+			break;
+
+		case 'b':
+			result = parse_u32(optarg, &baseband_filter_bw_hz);
+			baseband_filter_bw_hz =
+				hackrf_compute_baseband_filter_bw(baseband_filter_bw_hz);
+			break;
+
+		case 'D':
+			device_spectrum = true;
+			break;
+
+		case 'C':
+			capture_path = optarg;
+			break;
+
+		case 'R':
+			replay_path = optarg;
+			break;
+
 		case 'r':
 			path = optarg;
 			break;
@@ -634,58 +1585,161 @@ int main(int argc, char** argv)
 		}
 	}
 
+	if (NULL != replay_path) {
+		replay_file = fopen(replay_path, "rb");
+		if (NULL == replay_file) {
+			fprintf(stderr, "Failed to open file: %s\n", replay_path);
+			return EXIT_FAILURE;
+		}
+		if (read_capture_header(replay_file) != 0) {
+			fprintf(stderr, "%s is not a sweep capture file\n", replay_path);
+			return EXIT_FAILURE;
+		}
+	}
+
 	if (0 == num_ranges) {
 		frequencies[0] = (uint16_t) freq_min;
 		frequencies[1] = (uint16_t) freq_max;
 		num_ranges++;
 	}
 
+	if (0 == baseband_filter_bw_hz) {
+		baseband_filter_bw_hz =
+			hackrf_compute_baseband_filter_bw((sample_rate_hz / 4) * 3);
+	}
+	plan_slices();
+
+	if (0 != requested_fft_bin_width) {
+		fftSize = sample_rate_hz / requested_fft_bin_width;
+	}
+
 	if (binary_output && ifft_output) {
 		fprintf(stderr,
 			"argument error: binary output (-B) and IFFT output (-I) are mutually exclusive.\n");
 		return EXIT_FAILURE;
 	}
 
+	if (ifft_output && (reduction != REDUCE_NONE)) {
+		fprintf(stderr,
+			"argument error: IFFT output (-I) and trace reduction (-M) are mutually exclusive.\n");
+		return EXIT_FAILURE;
+	}
+
+	if ((spectrum_output != SPECTRUM_NONE) &&
+	    (binary_output || ifft_output || (reduction != REDUCE_NONE))) {
+		fprintf(stderr,
+			"argument error: full-sweep output (-F) can't be combined with -B, -I or -M.\n");
+		return EXIT_FAILURE;
+	}
+
+	if (detect &&
+	    (binary_output || ifft_output || (reduction != REDUCE_NONE) ||
+	     (spectrum_output != SPECTRUM_NONE))) {
+		fprintf(stderr,
+			"argument error: detection (-t) can't be combined with -B, -I, -M or -F.\n");
+		return EXIT_FAILURE;
+	}
+
+	if ((reduction != REDUCE_NONE) && (reduce_sweeps == 0) &&
+	    (reduce_interval == 0)) {
+		reduce_sweeps = 10;
+	}
+
 	if (ifft_output && (1 < num_ranges)) {
 		fprintf(stderr,
 			"argument error: only one frequency range is supported in IFFT output (-I) mode.\n");
 		return EXIT_FAILURE;
 	}
 
+	if (device_spectrum &&
+	    (ifft_output || (NULL != capture_path) || (NULL != replay_path))) {
+		fprintf(stderr,
+			"argument error: device spectra (-D) can't be combined with -I, -C or -R.\n");
+		return EXIT_FAILURE;
+	}
+
 	/*
-	 * The FFT bin width must be no more than a quarter of the sample rate
-	 * for interleaved mode. With our fixed sample rate of 20 Msps, that
-	 * results in a maximum bin width of 5000000 Hz.
+	 * The FFT bin width must be no more than the width of a slice for
+	 * interleaved mode. At 20 Msps, that results in a maximum bin width of
+	 * 5000000 Hz.
 	 */
-	if (4 > fftSize) {
+	if ((int) slices_per_rate > fftSize) {
 		fprintf(stderr,
-			"argument error: FFT bin width (-w) must be no more than 5000000\n");
+			"argument error: FFT bin width (-w) must be no more than %u\n",
+			sample_rate_hz / slices_per_rate);
 		return EXIT_FAILURE;
 	}
 
 	/*
 	 * The maximum number of FFT bins we support is equal to the number of
-	 * samples in a block. Each block consists of 16384 bytes minus 10
-	 * bytes for the frequency header, leaving room for 8187 two-byte
-	 * samples. As we pad fftSize up to the next odd multiple of four, this
-	 * makes our maximum supported fftSize 8180.  With our fixed sample
-	 * rate of 20 Msps, that results in a minimum bin width of 2445 Hz.
+	 * samples in a block. Each block consists of 16384 bytes minus 24
+	 * bytes for the header, leaving room for 8180 two-byte samples. As we
+	 * pad fftSize up to the next odd multiple of the number of slices, this
+	 * makes our maximum supported fftSize 8180 at 20 Msps, a minimum bin
+	 * width of 2445 Hz.
 	 */
-	if (8180 < fftSize) {
+	max_fft_size = (BYTES_PER_BLOCK - SWEEP_BLOCK_HEADER_SIZE) / 2 / slices_per_rate;
+	max_fft_size = slices_per_rate * ((max_fft_size - 1) | 1);
+	if (device_spectrum) {
+		max_fft_size = MAX_SWEEP_SPECTRUM_SIZE;
+	}
+	if (max_fft_size < (uint32_t) fftSize) {
 		fprintf(stderr,
-			"argument error: FFT bin width (-w) must be no less than 2445\n");
+			"argument error: FFT bin width (-w) must be no less than %u\n",
+			(sample_rate_hz + max_fft_size - 1) / max_fft_size);
 		return EXIT_FAILURE;
 	}
 
 	/* In interleaved mode, the FFT bin selection works best if the total
-	 * number of FFT bins is equal to an odd multiple of four.
-	 * (e.g. 4, 12, 20, 28, 36, . . .)
+	 * number of FFT bins is equal to an odd multiple of the number of
+	 * slices, so that each slice is an odd number of bins and its edges
+	 * fall halfway between bins. (e.g. 4, 12, 20, 28, 36, . . . at 20 Msps)
 	 */
-	while ((fftSize + 4) % 8) {
-		fftSize++;
+	if (device_spectrum) {
+		/*
+		 * The device's FFT size is a power of 4, giving each slice an even
+		 * number of bins, at least two so that DC falls between the slices
+		 * kept. Tuning half a bin higher puts the slice edges halfway
+		 * between bins again.
+		 */
+		i = MIN_SWEEP_SPECTRUM_SIZE;
+		while ((i < fftSize) || (i < 2 * (int) slices_per_rate)) {
+			i *= 4;
+		}
+		fftSize = i;
+		slice_bins = fftSize / slices_per_rate;
+		lower_bin = fftSize - 3 * slice_bins / 2;
+		upper_bin = slice_bins / 2;
+		offset_hz += sample_rate_hz / fftSize / 2;
+	} else {
+		while ((fftSize % slices_per_rate) ||
+		       !((fftSize / slices_per_rate) % 2)) {
+			fftSize++;
+		}
+		slice_bins = fftSize / slices_per_rate;
+		lower_bin = 1 + (2 * fftSize - 3 * slice_bins) / 2;
+		upper_bin = 1 + slice_bins / 2;
+	}
+
+	/*
+	 * With a configured settle time, use the smallest block that holds
+	 * the frequency header and one FFT worth of samples. A replayed
+	 * capture keeps the block size it was recorded with.
+	 */
+	if (settle_set && (NULL == replay_file)) {
+		block_size = MIN_BYTES_PER_BLOCK;
+		while (block_size < (uint32_t) (SWEEP_BLOCK_HEADER_SIZE + fftSize * 2)) {
+			block_size *= 2;
+		}
 	}
 
-	fft_bin_width = (double) DEFAULT_SAMPLE_RATE_HZ / fftSize;
+	if (block_size < (uint32_t) (SWEEP_BLOCK_HEADER_SIZE + fftSize * 2)) {
+		fprintf(stderr,
+			"argument error: FFT bin width (-w) too small for the capture's block size\n");
+		return EXIT_FAILURE;
+	}
+
+	fft_bin_width = (double) sample_rate_hz / fftSize;
 	fftwIn = (fftwf_complex*) fftwf_malloc(sizeof(fftwf_complex) * fftSize);
 	fftwOut = (fftwf_complex*) fftwf_malloc(sizeof(fftwf_complex) * fftSize);
 	fftwPlan =
@@ -705,29 +1759,36 @@ int main(int argc, char** argv)
 	memset(&usb_transfer_time, 0, sizeof(usb_transfer_time));
 
 #ifdef _MSC_VER
-	if (binary_output) {
+	if (binary_output || (spectrum_output != SPECTRUM_NONE)) {
 		_setmode(_fileno(stdout), _O_BINARY);
 	}
 #endif
 
-	result = hackrf_init();
-	if (result != HACKRF_SUCCESS) {
-		fprintf(stderr,
-			"hackrf_init() failed: %s (%d)\n",
-			hackrf_error_name(result),
-			result);
-		usage();
-		return EXIT_FAILURE;
-	}
+	if (NULL == replay_file) {
+		result = hackrf_init();
+		if (result != HACKRF_SUCCESS) {
+			fprintf(stderr,
+				"hackrf_init() failed: %s (%d)\n",
+				hackrf_error_name(result),
+				result);
+			usage();
+			return EXIT_FAILURE;
+		}
 
-	result = hackrf_open_by_serial(serial_number, &device);
-	if (result != HACKRF_SUCCESS) {
-		fprintf(stderr,
-			"hackrf_open() failed: %s (%d)\n",
-			hackrf_error_name(result),
-			result);
-		usage();
-		return EXIT_FAILURE;
+		result = hackrf_open_by_serial(serial_number, &device);
+		if (result != HACKRF_SUCCESS) {
+			fprintf(stderr,
+				"hackrf_open() failed: %s (%d)\n",
+				hackrf_error_name(result),
+				result);
+			usage();
+			return EXIT_FAILURE;
+		}
+
+		result = hackrf_usb_api_version_read(device, &usb_api_version);
+		if ((result == HACKRF_SUCCESS) && (usb_api_version < 0x0109)) {
+			header_size = 10;
+		}
 	}
 
 	if ((NULL == path) || (strcmp(path, "-") == 0)) {
@@ -758,36 +1819,38 @@ int main(int argc, char** argv)
 	signal(SIGTERM, &sigint_callback_handler);
 	signal(SIGABRT, &sigint_callback_handler);
 #endif
-	fprintf(stderr,
-		"call hackrf_sample_rate_set(%.03f MHz)\n",
-		((float) DEFAULT_SAMPLE_RATE_HZ / (float) FREQ_ONE_MHZ));
-	result = hackrf_set_sample_rate_manual(device, DEFAULT_SAMPLE_RATE_HZ, 1);
-	if (result != HACKRF_SUCCESS) {
+	if (NULL == replay_file) {
 		fprintf(stderr,
-			"hackrf_sample_rate_set() failed: %s (%d)\n",
-			hackrf_error_name(result),
-			result);
-		usage();
-		return EXIT_FAILURE;
-	}
+			"call hackrf_sample_rate_set(%.03f MHz)\n",
+			((float) sample_rate_hz / (float) FREQ_ONE_MHZ));
+		result = hackrf_set_sample_rate_manual(device, sample_rate_hz, 1);
+		if (result != HACKRF_SUCCESS) {
+			fprintf(stderr,
+				"hackrf_sample_rate_set() failed: %s (%d)\n",
+				hackrf_error_name(result),
+				result);
+			usage();
+			return EXIT_FAILURE;
+		}
 
-	fprintf(stderr,
-		"call hackrf_baseband_filter_bandwidth_set(%.03f MHz)\n",
-		((float) DEFAULT_BASEBAND_FILTER_BANDWIDTH / (float) FREQ_ONE_MHZ));
-	result = hackrf_set_baseband_filter_bandwidth(
-		device,
-		DEFAULT_BASEBAND_FILTER_BANDWIDTH);
-	if (result != HACKRF_SUCCESS) {
 		fprintf(stderr,
-			"hackrf_baseband_filter_bandwidth_set() failed: %s (%d)\n",
-			hackrf_error_name(result),
-			result);
-		usage();
-		return EXIT_FAILURE;
-	}
+			"call hackrf_baseband_filter_bandwidth_set(%.03f MHz)\n",
+			((float) baseband_filter_bw_hz / (float) FREQ_ONE_MHZ));
+		result = hackrf_set_baseband_filter_bandwidth(
+			device,
+			baseband_filter_bw_hz);
+		if (result != HACKRF_SUCCESS) {
+			fprintf(stderr,
+				"hackrf_baseband_filter_bandwidth_set() failed: %s (%d)\n",
+				hackrf_error_name(result),
+				result);
+			usage();
+			return EXIT_FAILURE;
+		}
 
-	result = hackrf_set_vga_gain(device, vga_gain);
-	result |= hackrf_set_lna_gain(device, lna_gain);
+		result = hackrf_set_vga_gain(device, vga_gain);
+		result |= hackrf_set_lna_gain(device, lna_gain);
+	}
 
 	/*
 	 * For each range, plan a whole number of tuning steps of a certain
@@ -795,23 +1858,102 @@ int main(int argc, char** argv)
 	 * whole number of steps, minimum 1.
 	 */
 	for (i = 0; i < num_ranges; i++) {
-		step_count =
-			1 + (frequencies[2 * i + 1] - frequencies[2 * i] - 1) / TUNE_STEP;
-		frequencies[2 * i + 1] =
-			(uint16_t) (frequencies[2 * i] + step_count * TUNE_STEP);
+		range_low_hz = FREQ_ONE_MHZ * frequencies[2 * i];
+		range_high_hz = FREQ_ONE_MHZ * frequencies[2 * i + 1];
+		range_steps[i] = 1 + (range_high_hz - range_low_hz - 1) / step_hz;
+		range_high_hz = range_low_hz + (uint64_t) range_steps[i] * step_hz;
+		/*
+		 * The firmware takes the high end in whole MHz. Rounding down
+		 * still leaves it within the last step, as a step is wider than
+		 * 1MHz.
+		 */
+		frequencies[2 * i + 1] = (uint16_t) (range_high_hz / FREQ_ONE_MHZ);
 		fprintf(stderr,
-			"Sweeping from %u MHz to %u MHz\n",
+			"Sweeping from %u MHz to %.10g MHz\n",
 			frequencies[2 * i],
-			frequencies[2 * i + 1]);
+			(double) range_high_hz / FREQ_ONE_MHZ);
 	}
 
+	/*
+	 * Each tuning step contributes four slices of slice_bins bins, from
+	 * two tunings.
+	 */
+	for (i = 0; i < num_ranges; i++) {
+		range_bin_offset[i] = total_bins;
+		total_bins += range_steps[i] * 4 * slice_bins;
+		sweep_tunings += 2 * range_steps[i];
+	}
+
+	if (reduction != REDUCE_NONE) {
+		acc = (float*) calloc(total_bins, sizeof(float));
+		acc_count = (uint32_t*) calloc(total_bins, sizeof(uint32_t));
+		reduced_row = (float*) calloc(slice_bins, sizeof(float));
+		if (reduction == REDUCE_PERCENTILE) {
+			acc_p2 = (struct p2_estimator*) calloc(
+				total_bins,
+				sizeof(struct p2_estimator));
+		}
+		if ((NULL == acc) || (NULL == acc_count) || (NULL == reduced_row) ||
+		    ((reduction == REDUCE_PERCENTILE) && (NULL == acc_p2))) {
+			fprintf(stderr, "Failed to allocate trace reduction buffers\n");
+			return EXIT_FAILURE;
+		}
+		reduce_reset();
+	}
+
+	if ((spectrum_output != SPECTRUM_NONE) || (shm_name != NULL) || detect) {
+		spectrum = (float*) malloc(sizeof(float) * total_bins);
+		if (spectrum_output == SPECTRUM_PGM) {
+			if (finite_mode && (num_sweeps < pgm_strip_rows)) {
+				pgm_strip_rows = num_sweeps;
+			}
+			pgm_strip =
+				(uint8_t*) malloc((size_t) total_bins * pgm_strip_rows);
+		}
+		if ((NULL == spectrum) ||
+		    ((spectrum_output == SPECTRUM_PGM) && (NULL == pgm_strip))) {
+			fprintf(stderr, "Failed to allocate full-sweep buffers\n");
+			return EXIT_FAILURE;
+		}
+		for (i = 0; i < (int) total_bins; i++) {
+			spectrum[i] = NAN;
+		}
+		fprintf(stderr, "Full-sweep rows of %u bins\n", total_bins);
+	}
+
+	if (detect) {
+		floor_cur = (float*) malloc(sizeof(float) * total_bins);
+		floor_prev = (float*) malloc(sizeof(float) * total_bins);
+		if ((NULL == floor_cur) || (NULL == floor_prev)) {
+			fprintf(stderr, "Failed to allocate noise floor buffers\n");
+			return EXIT_FAILURE;
+		}
+		for (i = 0; i < (int) total_bins; i++) {
+			floor_cur[i] = INFINITY;
+			floor_prev[i] = INFINITY;
+		}
+	}
+
+#ifndef _WIN32
+	if (shm_name != NULL) {
+		if (open_shm_ring(shm_name) != 0) {
+			fprintf(stderr,
+				"Failed to create shared memory ring %s: %s\n",
+				shm_name,
+				strerror(errno));
+			return EXIT_FAILURE;
+		}
+	}
+#endif
+
 	if (ifft_output) {
+		ifft_size = 4 * slice_bins * range_steps[0];
 		ifftwIn = (fftwf_complex*) fftwf_malloc(
-			sizeof(fftwf_complex) * fftSize * step_count);
+			sizeof(fftwf_complex) * ifft_size);
 		ifftwOut = (fftwf_complex*) fftwf_malloc(
-			sizeof(fftwf_complex) * fftSize * step_count);
+			sizeof(fftwf_complex) * ifft_size);
 		ifftwPlan = fftwf_plan_dft_1d(
-			fftSize * step_count,
+			ifft_size,
 			ifftwIn,
 			ifftwOut,
 			FFTW_BACKWARD,
@@ -823,92 +1965,152 @@ int main(int argc, char** argv)
 		fftwf_execute(ifftwPlan);
 	}
 
-	result = hackrf_init_sweep(
-		device,
-		frequencies,
-		num_ranges,
-		BYTES_PER_BLOCK,
-		TUNE_STEP * FREQ_ONE_MHZ,
-		OFFSET,
-		INTERLEAVED);
-	if (result != HACKRF_SUCCESS) {
-		fprintf(stderr,
-			"hackrf_init_sweep() failed: %s (%d)\n",
-			hackrf_error_name(result),
-			result);
-		return EXIT_FAILURE;
-	}
-
-	result |= hackrf_start_rx_sweep(device, rx_callback, NULL);
-	if (result != HACKRF_SUCCESS) {
-		fprintf(stderr,
-			"hackrf_start_rx_sweep() failed: %s (%d)\n",
-			hackrf_error_name(result),
-			result);
-		usage();
-		return EXIT_FAILURE;
+	if (NULL != capture_path) {
+		capture_file = fopen(capture_path, "wb");
+		if ((NULL == capture_file) ||
+		    (write_capture_header(capture_file) != 0)) {
+			fprintf(stderr, "Failed to open file: %s\n", capture_path);
+			return EXIT_FAILURE;
+		}
 	}
 
-	if (amp) {
-		fprintf(stderr, "call hackrf_set_amp_enable(%u)\n", amp_enable);
-		result = hackrf_set_amp_enable(device, (uint8_t) amp_enable);
+	if (NULL != replay_file) {
+		gettimeofday(&t_start, NULL);
+		if (replay_sweeps(replay_file) != 0) {
+			fprintf(stderr, "Failed to replay %s\n", replay_path);
+			exit_code = EXIT_FAILURE;
+		}
+	} else {
+		result = hackrf_init_sweep(
+			device,
+			frequencies,
+			num_ranges,
+			block_size,
+			step_hz,
+			offset_hz,
+			INTERLEAVED);
 		if (result != HACKRF_SUCCESS) {
 			fprintf(stderr,
-				"hackrf_set_amp_enable() failed: %s (%d)\n",
+				"hackrf_init_sweep() failed: %s (%d)\n",
 				hackrf_error_name(result),
 				result);
-			usage();
 			return EXIT_FAILURE;
 		}
-	}
 
-	if (antenna) {
-		fprintf(stderr, "call hackrf_set_antenna_enable(%u)\n", antenna_enable);
-		result = hackrf_set_antenna_enable(device, (uint8_t) antenna_enable);
+		if (settle_set) {
+			result = hackrf_set_sweep_timing(
+				device,
+				block_size,
+				settle_samples);
+			if (result != HACKRF_SUCCESS) {
+				fprintf(stderr,
+					"hackrf_set_sweep_timing() failed: %s (%d)\n",
+					hackrf_error_name(result),
+					result);
+				return EXIT_FAILURE;
+			}
+		}
+
+		if (device_spectrum) {
+			result = hackrf_set_sweep_spectrum(device, fftSize);
+			if (result != HACKRF_SUCCESS) {
+				fprintf(stderr,
+					"hackrf_set_sweep_spectrum() failed: %s (%d)\n",
+					hackrf_error_name(result),
+					result);
+				return EXIT_FAILURE;
+			}
+		}
+
+		result = upload_tuning_table();
+		if ((result != HACKRF_SUCCESS) &&
+		    (result != HACKRF_ERROR_USB_API_VERSION)) {
+			fprintf(stderr,
+				"hackrf_set_tuning_table() failed: %s (%d)\n",
+				hackrf_error_name(result),
+				result);
+			return EXIT_FAILURE;
+		}
+
+		result = hackrf_start_rx_sweep(device, rx_callback, NULL);
 		if (result != HACKRF_SUCCESS) {
 			fprintf(stderr,
-				"hackrf_set_antenna_enable() failed: %s (%d)\n",
+				"hackrf_start_rx_sweep() failed: %s (%d)\n",
 				hackrf_error_name(result),
 				result);
 			usage();
 			return EXIT_FAILURE;
 		}
-	}
 
-	gettimeofday(&t_start, NULL);
-	time_prev = t_start;
-
-	fprintf(stderr, "Stop with Ctrl-C\n");
-	while ((hackrf_is_streaming(device) == HACKRF_TRUE) && (do_exit == false)) {
-		float time_difference;
-		m_sleep(50);
+		if (amp) {
+			fprintf(stderr, "call hackrf_set_amp_enable(%u)\n", amp_enable);
+			result = hackrf_set_amp_enable(device, (uint8_t) amp_enable);
+			if (result != HACKRF_SUCCESS) {
+				fprintf(stderr,
+					"hackrf_set_amp_enable() failed: %s (%d)\n",
+					hackrf_error_name(result),
+					result);
+				usage();
+				return EXIT_FAILURE;
+			}
+		}
 
-		gettimeofday(&time_now, NULL);
-		if (TimevalDiff(&time_now, &time_prev) >= 1.0f) {
-			time_difference = TimevalDiff(&time_now, &t_start);
-			sweep_rate = (float) sweep_count / time_difference;
+		if (antenna) {
 			fprintf(stderr,
-				"%" PRIu64
-				" total sweeps completed, %.2f sweeps/second\n",
-				sweep_count,
-				sweep_rate);
+				"call hackrf_set_antenna_enable(%u)\n",
+				antenna_enable);
+			result = hackrf_set_antenna_enable(
+				device,
+				(uint8_t) antenna_enable);
+			if (result != HACKRF_SUCCESS) {
+				fprintf(stderr,
+					"hackrf_set_antenna_enable() failed: %s (%d)\n",
+					hackrf_error_name(result),
+					result);
+				usage();
+				return EXIT_FAILURE;
+			}
+		}
 
-			if (byte_count == 0) {
-				exit_code = EXIT_FAILURE;
+		gettimeofday(&t_start, NULL);
+		time_prev = t_start;
+
+		fprintf(stderr, "Stop with Ctrl-C\n");
+		while ((hackrf_is_streaming(device) == HACKRF_TRUE) &&
+		       (do_exit == false)) {
+			float time_difference;
+			m_sleep(50);
+
+			gettimeofday(&time_now, NULL);
+			if (TimevalDiff(&time_now, &time_prev) >= 1.0f) {
+				time_difference = TimevalDiff(&time_now, &t_start);
+				sweep_rate = (float) sweep_count / time_difference;
 				fprintf(stderr,
-					"\nCouldn't transfer any data for one second.\n");
-				break;
+					"%" PRIu64
+					" total sweeps completed, %.2f sweeps/second\n",
+					sweep_count,
+					sweep_rate);
+
+				if (byte_count == 0) {
+					exit_code = EXIT_FAILURE;
+					fprintf(stderr,
+						"\nCouldn't transfer any data for one second.\n");
+					break;
+				}
+				byte_count = 0;
+				time_prev = time_now;
 			}
-			byte_count = 0;
-			time_prev = time_now;
 		}
 	}
 
+	if (spectrum_output == SPECTRUM_PGM) {
+		write_pgm_strip();
+	}
 	fflush(outfile);
-	result = hackrf_is_streaming(device);
-	if (do_exit) {
+	if (do_exit || (NULL == device)) {
 		fprintf(stderr, "\nExiting...\n");
 	} else {
+		result = hackrf_is_streaming(device);
 		fprintf(stderr,
 			"\nExiting... hackrf_is_streaming() result: %s (%d)\n",
 			hackrf_error_name(result),
@@ -925,6 +2127,18 @@ int main(int argc, char** argv)
 		sweep_count,
 		time_diff,
 		sweep_rate);
+	if (incomplete_sweeps > 0) {
+		fprintf(stderr,
+			"Incomplete sweeps: %" PRIu64 " (blocks lost or not contiguous)\n",
+			incomplete_sweeps);
+	}
+	if (device_spectrum && (NULL == replay_file) && (time_diff > 0)) {
+		fprintf(stderr,
+			"Device spectrum: averaged %.1f%% of the time, %" PRIu64
+			" blocks skipped\n",
+			100.0 * device_frames * fftSize / (time_diff * sample_rate_hz),
+			device_skipped);
+	}
 
 	if (device != NULL) {
 		result = hackrf_close(device);
@@ -947,12 +2161,32 @@ int main(int argc, char** argv)
 		outfile = NULL;
 		fprintf(stderr, "fclose() done\n");
 	}
+	if (NULL != capture_file) {
+		fclose(capture_file);
+	}
+	if (NULL != replay_file) {
+		fclose(replay_file);
+	}
 	fftwf_free(fftwIn);
 	fftwf_free(fftwOut);
 	fftwf_free(pwr);
 	fftwf_free(window);
 	fftwf_free(ifftwIn);
 	fftwf_free(ifftwOut);
+	free(acc);
+	free(acc_count);
+	free(acc_p2);
+	free(reduced_row);
+	free(spectrum);
+	free(pgm_strip);
+	free(floor_cur);
+	free(floor_prev);
+#ifndef _WIN32
+	if (shm_header != NULL) {
+		munmap(shm_header, shm_size);
+		shm_unlink(shm_name);
+	}
+#endif
 	export_wisdom(fftwWisdomPath);
 	fprintf(stderr, "exit\n");
 	return exit_code;
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2026 Great Scott Gadgets <info@greatscottgadgets.com>
+ *
+ * This file is part of HackRF.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __COMMAND_QUEUE_H__
+#define __COMMAND_QUEUE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Commands scheduled by the host to run when the M0 byte count reaches a
+ * given position. The queue itself runs only in the firmware, and the host
+ * tests exercise it; libhackrf only packs commands.
+ *
+ * Positions are M0 byte counts, which start at zero when streaming starts
+ * and wrap at 2^32. The M0 count advances 32 bytes at a time, so positions
+ * must be multiples of 32.
+ */
+
+#define COMMAND_QUEUE_SIZE 32
+#define COMMAND_ALIGNMENT  32
+
+/*
+ * A mode switch is carried out by the M0 when its count matches the
+ * threshold exactly, so the threshold must be placed far enough ahead of
+ * the count that it cannot pass before the M4 has written it.
+ */
+#define COMMAND_ARM_GUARD 0x200
+
+/* Size of a packed command. */
+#define COMMAND_SIZE 16
+
+typedef enum {
+	COMMAND_SET_FREQ = 1,
+	COMMAND_LNA_GAIN = 2,
+	COMMAND_VGA_GAIN = 3,
+	COMMAND_TXVGA_GAIN = 4,
+	COMMAND_AMP_ENABLE = 5,
+	/* Value is the address, port A << 8 and port B << 16. */
+	COMMAND_OPERACAKE_PORTS = 6,
+	/* Stop receiving or transmitting samples, but keep counting. */
+	COMMAND_PAUSE = 7,
+	COMMAND_RESUME = 8,
+	COMMAND_TYPE_COUNT = 9,
+} command_type_t;
+
+typedef struct {
+	uint32_t when;
+	uint8_t type;
+	uint64_t value;
+} command_t;
+
+/* Commands are kept in order of position, then of insertion. */
+typedef struct {
+	command_t commands[COMMAND_QUEUE_SIZE];
+	uint8_t count;
+} command_queue_t;
+
+void command_queue_init(command_queue_t* const queue);
+bool command_valid(const command_t* const command);
+bool command_switches_mode(const command_t* const command);
+uint8_t command_queue_space(const command_queue_t* const queue);
+bool command_queue_insert(
+	command_queue_t* const queue,
+	const command_t* const command,
+	const uint32_t now);
+const command_t* command_queue_head(const command_queue_t* const queue);
+bool command_queue_due(const command_queue_t* const queue, const uint32_t now);
+void command_queue_pop(command_queue_t* const queue);
+uint32_t command_arm_position(const uint32_t when, const uint32_t now);
+void command_pack(const command_t* const command, uint8_t* const data);
+void command_unpack(const uint8_t* const data, command_t* const command);
+
+#endif /*__COMMAND_QUEUE_H__*/
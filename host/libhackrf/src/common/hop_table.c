@@ -0,0 +1,117 @@
+/*
+ * Copyright 2026 Great Scott Gadgets <info@greatscottgadgets.com>
+ *
+ * This file is part of HackRF.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "hop_table.h"
+
+static void write_le(uint8_t* const data, const uint64_t value, const uint8_t size)
+{
+	uint8_t i;
+
+	for (i = 0; i < size; i++) {
+		data[i] = (value >> (8 * i)) & 0xff;
+	}
+}
+
+static uint64_t read_le(const uint8_t* const data, const uint8_t size)
+{
+	uint64_t value = 0;
+	uint8_t i;
+
+	for (i = 0; i < size; i++) {
+		value |= (uint64_t) data[i] << (8 * i);
+	}
+	return value;
+}
+
+bool hop_samples_valid(const uint32_t samples)
+{
+	return (samples >= HOP_MIN_SAMPLES) && ((samples % HOP_SAMPLE_ALIGNMENT) == 0) &&
+		(samples <= (UINT32_MAX / 4));
+}
+
+bool hop_entry_valid(const hop_entry_t* const entry)
+{
+	return hop_samples_valid(entry->dwell) &&
+		((entry->lna_gain == HOP_GAIN_UNCHANGED) ||
+		 ((entry->lna_gain <= 40) && ((entry->lna_gain % 8) == 0))) &&
+		((entry->vga_gain == HOP_GAIN_UNCHANGED) ||
+		 ((entry->vga_gain <= 62) && ((entry->vga_gain % 2) == 0))) &&
+		((entry->txvga_gain == HOP_GAIN_UNCHANGED) || (entry->txvga_gain <= 47));
+}
+
+/*
+ * Packed entries are the frequency in Hz (uint64), the dwell in samples
+ * (uint32), the LNA, VGA and TX VGA gains (uint8 each) and a reserved
+ * byte, all little-endian.
+ */
+void hop_entry_pack(const hop_entry_t* const entry, uint8_t* const data)
+{
+	write_le(&data[0], entry->freq, 8);
+	write_le(&data[8], entry->dwell, 4);
+	data[12] = entry->lna_gain;
+	data[13] = entry->vga_gain;
+	data[14] = entry->txvga_gain;
+	data[15] = 0;
+}
+
+void hop_entry_unpack(const uint8_t* const data, hop_entry_t* const entry)
+{
+	entry->freq = read_le(&data[0], 8);
+	entry->dwell = read_le(&data[8], 4);
+	entry->lna_gain = data[12];
+	entry->vga_gain = data[13];
+	entry->txvga_gain = data[14];
+}
+
+/*
+ * Tags start with 0x7f 0x7f, followed by the frequency (uint64), the
+ * cycle (uint32), the index (uint16), the flags (uint16) and the resume
+ * position (uint32), and are padded with zeroes.
+ */
+void hop_tag_pack(const hop_tag_t* const tag, uint8_t* const data)
+{
+	uint8_t i;
+
+	data[0] = 0x7f;
+	data[1] = 0x7f;
+	write_le(&data[2], tag->freq, 8);
+	write_le(&data[10], tag->cycle, 4);
+	write_le(&data[14], tag->index, 2);
+	write_le(&data[16], tag->flags, 2);
+	write_le(&data[18], tag->resume, 4);
+	for (i = 22; i < HOP_TAG_SIZE; i++) {
+		data[i] = 0;
+	}
+}
+
+/* Returns false if the data doesn't start with a tag header. */
+bool hop_tag_unpack(const uint8_t* const data, hop_tag_t* const tag)
+{
+	if ((data[0] != 0x7f) || (data[1] != 0x7f)) {
+		return false;
+	}
+	tag->freq = read_le(&data[2], 8);
+	tag->cycle = read_le(&data[10], 4);
+	tag->index = read_le(&data[14], 2);
+	tag->flags = read_le(&data[16], 2);
+	tag->resume = read_le(&data[18], 4);
+	return true;
+}
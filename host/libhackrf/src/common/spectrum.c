@@ -0,0 +1,429 @@
+/*
+ * Copyright 2026 Great Scott Gadgets <info@greatscottgadgets.com>
+ *
+ * This file is part of HackRF.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "spectrum.h"
+
+#include <string.h>
+
+/* Number of points in one turn of the sine table. */
+#define TABLE_POINTS SPECTRUM_MAX_SIZE
+
+/* First quarter of sin(2 * pi * i / TABLE_POINTS) in Q15. */
+static const int16_t sin_table[TABLE_POINTS / 4 + 1] = {
+	0,     804,   1608,  2410,  3212,  4011,  4808,  5602,  6393,  7179,  7962,
+	8739,  9512,  10278, 11039, 11793, 12539, 13279, 14010, 14732, 15446, 16151,
+	16846, 17530, 18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594, 23170,
+	23731, 24279, 24811, 25329, 25832, 26319, 26790, 27245, 27683, 28105, 28510,
+	28898, 29268, 29621, 29956, 30273, 30571, 30852, 31113, 31356, 31580, 31785,
+	31971, 32137, 32285, 32412, 32521, 32609, 32678, 32728, 32757, 32767,
+};
+
+static int16_t sin_q15(uint32_t i)
+{
+	i %= TABLE_POINTS;
+	if (i <= TABLE_POINTS / 4) {
+		return sin_table[i];
+	} else if (i <= TABLE_POINTS / 2) {
+		return sin_table[TABLE_POINTS / 2 - i];
+	} else if (i <= 3 * TABLE_POINTS / 4) {
+		return -sin_table[i - TABLE_POINTS / 2];
+	}
+	return -sin_table[TABLE_POINTS - i];
+}
+
+static int16_t cos_q15(const uint32_t i)
+{
+	return sin_q15(i + TABLE_POINTS / 4);
+}
+
+/*
+ * Operations on pairs of Q15 values packed into 32 bits. On the M4 each
+ * is a single DSP instruction. Elsewhere, the same results are computed
+ * in C, so that libhackrf's output matches the firmware's bit for bit.
+ *
+ *   halving_add(a, b)      SHADD16  (a + b) / 2 on each half
+ *   halving_sub(a, b)      SHSUB16  (a - b) / 2 on each half
+ *   halving_add_sub(a, b)  SHSAX    ((a.re + b.im) / 2, (a.im - b.re) / 2)
+ *   halving_sub_add(a, b)  SHASX    ((a.re - b.im) / 2, (a.im + b.re) / 2)
+ *   dual_mul_add(a, b)     SMUAD    a.re * b.re + a.im * b.im
+ *   dual_mul_sub_x(a, b)   SMUSDX   a.re * b.im - a.im * b.re
+ *
+ * Halving never overflows. The products are kept to 32 bits, so
+ * dual_mul_add() of two full-scale values only fits as unsigned.
+ */
+#if defined(__ARM_FEATURE_DSP)
+
+	#define DSP_INLINE static inline __attribute__((always_inline))
+
+DSP_INLINE uint32_t halving_add(const uint32_t a, const uint32_t b)
+{
+	uint32_t result;
+
+	__asm__("shadd16 %0, %1, %2" : "=r"(result) : "r"(a), "r"(b));
+	return result;
+}
+
+DSP_INLINE uint32_t halving_sub(const uint32_t a, const uint32_t b)
+{
+	uint32_t result;
+
+	__asm__("shsub16 %0, %1, %2" : "=r"(result) : "r"(a), "r"(b));
+	return result;
+}
+
+DSP_INLINE uint32_t halving_add_sub(const uint32_t a, const uint32_t b)
+{
+	uint32_t result;
+
+	__asm__("shsax %0, %1, %2" : "=r"(result) : "r"(a), "r"(b));
+	return result;
+}
+
+DSP_INLINE uint32_t halving_sub_add(const uint32_t a, const uint32_t b)
+{
+	uint32_t result;
+
+	__asm__("shasx %0, %1, %2" : "=r"(result) : "r"(a), "r"(b));
+	return result;
+}
+
+DSP_INLINE uint32_t dual_mul_add(const uint32_t a, const uint32_t b)
+{
+	uint32_t result;
+
+	__asm__("smuad %0, %1, %2" : "=r"(result) : "r"(a), "r"(b));
+	return result;
+}
+
+DSP_INLINE uint32_t dual_mul_sub_x(const uint32_t a, const uint32_t b)
+{
+	uint32_t result;
+
+	__asm__("smusdx %0, %1, %2" : "=r"(result) : "r"(a), "r"(b));
+	return result;
+}
+
+/* Pack (re >> 15, im >> 15), each saturated to 16 bits. */
+DSP_INLINE uint32_t pack_q30(const uint32_t re, const uint32_t im)
+{
+	uint32_t re16, im16, result;
+
+	__asm__("ssat %0, #16, %1, asr #15" : "=r"(re16) : "r"(re));
+	__asm__("ssat %0, #16, %1, asr #15" : "=r"(im16) : "r"(im));
+	__asm__("pkhbt %0, %1, %2, lsl #16" : "=r"(result) : "r"(re16), "r"(im16));
+	return result;
+}
+
+#else
+
+static int32_t lo(const uint32_t x)
+{
+	return (int32_t) ((x & 0xffff) ^ 0x8000) - 0x8000;
+}
+
+static int32_t hi(const uint32_t x)
+{
+	return (int32_t) ((x >> 16) ^ 0x8000) - 0x8000;
+}
+
+static uint32_t pack(const int32_t re, const int32_t im)
+{
+	return ((uint32_t) re & 0xffff) | ((uint32_t) im << 16);
+}
+
+static uint32_t halving_add(const uint32_t a, const uint32_t b)
+{
+	return pack((lo(a) + lo(b)) >> 1, (hi(a) + hi(b)) >> 1);
+}
+
+static uint32_t halving_sub(const uint32_t a, const uint32_t b)
+{
+	return pack((lo(a) - lo(b)) >> 1, (hi(a) - hi(b)) >> 1);
+}
+
+static uint32_t halving_add_sub(const uint32_t a, const uint32_t b)
+{
+	return pack((lo(a) + hi(b)) >> 1, (hi(a) - lo(b)) >> 1);
+}
+
+static uint32_t halving_sub_add(const uint32_t a, const uint32_t b)
+{
+	return pack((lo(a) - hi(b)) >> 1, (hi(a) + lo(b)) >> 1);
+}
+
+static uint32_t dual_mul_add(const uint32_t a, const uint32_t b)
+{
+	return (uint32_t) (lo(a) * lo(b)) + (uint32_t) (hi(a) * hi(b));
+}
+
+static uint32_t dual_mul_sub_x(const uint32_t a, const uint32_t b)
+{
+	return (uint32_t) (lo(a) * hi(b)) - (uint32_t) (hi(a) * lo(b));
+}
+
+static int32_t saturate(const int32_t x)
+{
+	if (x > INT16_MAX) {
+		return INT16_MAX;
+	} else if (x < INT16_MIN) {
+		return INT16_MIN;
+	}
+	return x;
+}
+
+static uint32_t pack_q30(const uint32_t re, const uint32_t im)
+{
+	return pack(saturate((int32_t) re >> 15), saturate((int32_t) im >> 15));
+}
+
+#endif
+
+/*
+ * Multiply x by the twiddle factor w = cos + j * sin, giving
+ * x * exp(-j * angle). Neither product sum can overflow, as no table value
+ * is -32768.
+ */
+static uint32_t rotate(const uint32_t x, const uint32_t w)
+{
+	return pack_q30(dual_mul_add(x, w), dual_mul_sub_x(w, x));
+}
+
+static bool valid_size(const uint16_t size)
+{
+	uint16_t n;
+
+	for (n = SPECTRUM_MIN_SIZE; n <= SPECTRUM_MAX_SIZE; n *= 4) {
+		if (n == size) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/*
+ * Fill in the periodic Hann window, the twiddle factors and the base-4
+ * digit reversal of each bin index, so that none of them are worked out
+ * per frame.
+ */
+bool spectrum_init(spectrum_t* const spectrum, const uint16_t size)
+{
+	const uint32_t stride = TABLE_POINTS / size;
+	uint32_t i, j, n, rev;
+
+	if (!valid_size(size)) {
+		return false;
+	}
+	spectrum->size = size;
+
+	for (i = 0; i < size; i++) {
+		spectrum->window[i] = (INT16_MAX - cos_q15(i * stride)) >> 1;
+		rev = 0;
+		for (n = size, j = i; n > 1; n >>= 2, j >>= 2) {
+			rev = (rev << 2) | (j & 3);
+		}
+		spectrum->reverse[i] = rev;
+	}
+	for (i = 0; i < SPECTRUM_TWIDDLES; i++) {
+		spectrum->twiddle[i] = ((uint32_t) cos_q15(i) & 0xffff) |
+			((uint32_t) sin_q15(i) << 16);
+	}
+
+	spectrum_reset(spectrum);
+	return true;
+}
+
+void spectrum_reset(spectrum_t* const spectrum)
+{
+	memset(spectrum->power, 0, sizeof(spectrum->power));
+	spectrum->frames = 0;
+	spectrum->skipped = 0;
+}
+
+/*
+ * Radix-4 decimation in frequency, leaving the output in base-4 digit
+ * reversed order. Each butterfly halves twice on the way through, so each
+ * stage scales by 1/4, the result is scaled by 1/size, and only the
+ * twiddle multiplication can saturate. The first butterfly of each group
+ * has no twiddles, which covers the whole of the last stage.
+ */
+static void fft_stages(const spectrum_t* const spectrum, uint32_t* const data)
+{
+	const uint32_t size = spectrum->size;
+	const uint32_t* const twiddle = spectrum->twiddle;
+	uint32_t span, quarter, stride, i, j;
+	uint32_t a, b, c, d, w1, w2, w3;
+	uint32_t* x;
+
+	for (span = size; span > 1; span >>= 2) {
+		quarter = span >> 2;
+		stride = TABLE_POINTS / span;
+		for (i = 0; i < size; i += span) {
+			x = &data[i];
+			a = halving_add(x[0], x[2 * quarter]);
+			b = halving_sub(x[0], x[2 * quarter]);
+			c = halving_add(x[quarter], x[3 * quarter]);
+			d = halving_sub(x[quarter], x[3 * quarter]);
+			x[0] = halving_add(a, c);
+			x[quarter] = halving_add_sub(b, d);
+			x[2 * quarter] = halving_sub(a, c);
+			x[3 * quarter] = halving_sub_add(b, d);
+		}
+		for (j = 1; j < quarter; j++) {
+			w1 = twiddle[j * stride];
+			w2 = twiddle[2 * j * stride];
+			w3 = twiddle[3 * j * stride];
+			for (i = j; i < size; i += span) {
+				x = &data[i];
+				a = halving_add(x[0], x[2 * quarter]);
+				b = halving_sub(x[0], x[2 * quarter]);
+				c = halving_add(x[quarter], x[3 * quarter]);
+				d = halving_sub(x[quarter], x[3 * quarter]);
+				x[0] = halving_add(a, c);
+				x[quarter] = rotate(halving_add_sub(b, d), w1);
+				x[2 * quarter] = rotate(halving_sub(a, c), w2);
+				x[3 * quarter] = rotate(halving_sub_add(b, d), w3);
+			}
+		}
+	}
+}
+
+/*
+ * In-place forward FFT of the spectrum's size of packed Q15 complex
+ * values, in natural order. The result is scaled by 1/size and cannot
+ * overflow.
+ */
+void spectrum_fft(const spectrum_t* const spectrum, uint32_t* const data)
+{
+	uint32_t i, rev, tmp;
+
+	fft_stages(spectrum, data);
+	for (i = 0; i < spectrum->size; i++) {
+		rev = spectrum->reverse[i];
+		if (rev > i) {
+			tmp = data[i];
+			data[i] = data[rev];
+			data[rev] = tmp;
+		}
+	}
+}
+
+/*
+ * Add the power spectrum of one frame of size interleaved 8-bit I/Q
+ * samples, with a periodic Hann window applied. The FFT output is left in
+ * digit reversed order, and each bin's power is added to its place in
+ * natural order instead.
+ *
+ * Counting instructions, a 256-point frame should take about 18,000 M4
+ * cycles, or under 90us at 204MHz: about 3,000 to window the samples,
+ * 2,100 for the 85 butterflies without twiddles, 8,700 for the 171 with
+ * them at about 51 cycles each, and 4,000 to add up the power. These are
+ * estimates, not measurements.
+ */
+void spectrum_add_frame(spectrum_t* const spectrum, const int8_t* const samples)
+{
+	const uint16_t size = spectrum->size;
+	uint32_t* const work = spectrum->work;
+	uint32_t i, x;
+	int32_t window;
+
+	for (i = 0; i < size; i++) {
+		window = spectrum->window[i];
+		work[i] = (((uint32_t) ((samples[2 * i] * window) >> 7)) & 0xffff) |
+			((uint32_t) ((samples[2 * i + 1] * window) >> 7) << 16);
+	}
+
+	fft_stages(spectrum, work);
+
+	for (i = 0; i < size; i++) {
+		x = work[i];
+		spectrum->power[spectrum->reverse[i]] += dual_mul_add(x, x);
+	}
+	spectrum->frames++;
+}
+
+/*
+ * Add every whole frame in length bytes of samples, returning the number
+ * of frames added.
+ */
+uint32_t spectrum_add_block(
+	spectrum_t* const spectrum,
+	const int8_t* const samples,
+	const uint32_t length)
+{
+	const uint32_t frame_bytes = 2 * spectrum->size;
+	uint32_t offset;
+
+	for (offset = 0; offset + frame_bytes <= length; offset += frame_bytes) {
+		spectrum_add_frame(spectrum, &samples[offset]);
+	}
+	return length / frame_bytes;
+}
+
+/* Count a block left out of the average, as its samples can't be used. */
+void spectrum_skip_block(spectrum_t* const spectrum)
+{
+	spectrum->skipped++;
+}
+
+/*
+ * Write a record of the mean power in each bin since the last reset, then
+ * reset. The record must have room for SPECTRUM_RECORD_SIZE(size) bytes.
+ */
+void spectrum_write_record(
+	spectrum_t* const spectrum,
+	const uint64_t freq,
+	uint8_t* const record)
+{
+	const uint16_t size = spectrum->size;
+	const uint16_t frames = (spectrum->frames > UINT16_MAX) ? UINT16_MAX :
+								  spectrum->frames;
+	const uint16_t skipped = (spectrum->skipped > UINT16_MAX) ? UINT16_MAX :
+								     spectrum->skipped;
+	uint8_t* bin;
+	uint32_t mean;
+	int i;
+
+	memset(record, 0, SPECTRUM_RECORD_SIZE(size));
+	record[0] = 0x7f;
+	record[1] = 0x7f;
+	for (i = 0; i < 8; i++) {
+		record[2 + i] = (freq >> (8 * i)) & 0xff;
+	}
+	record[10] = frames & 0xff;
+	record[11] = frames >> 8;
+	record[12] = size & 0xff;
+	record[13] = size >> 8;
+	record[14] = skipped & 0xff;
+	record[15] = skipped >> 8;
+
+	for (i = 0; i < size; i++) {
+		mean = 0;
+		if (spectrum->frames > 0) {
+			mean = spectrum->power[i] / spectrum->frames;
+		}
+		bin = &record[SPECTRUM_HEADER_SIZE + 4 * i];
+		bin[0] = mean & 0xff;
+		bin[1] = (mean >> 8) & 0xff;
+		bin[2] = (mean >> 16) & 0xff;
+		bin[3] = (mean >> 24) & 0xff;
+	}
+	spectrum_reset(spectrum);
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2026 Great Scott Gadgets <info@greatscottgadgets.com>
+ *
+ * This file is part of HackRF.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __SPECTRUM_H__
+#define __SPECTRUM_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Fixed-point power spectrum averaging used by the firmware in spectrum
+ * sweep mode. libhackrf builds the same code as a reference for the
+ * firmware's output.
+ */
+
+/* FFT sizes must be a power of 4 between these limits. */
+#define SPECTRUM_MIN_SIZE 16
+#define SPECTRUM_MAX_SIZE 256
+
+/*
+ * Each record starts with a header of 0x7f 0x7f, the frequency (uint64),
+ * the number of frames averaged (uint16, saturating), the FFT size
+ * (uint16) and the number of blocks skipped (uint16, saturating),
+ * followed by the mean power of each bin (uint32) in FFT order, starting
+ * with DC. Records are padded to a power of two of at least one
+ * USB packet, so that they never straddle the host's transfers.
+ */
+#define SPECTRUM_HEADER_SIZE 16
+#define SPECTRUM_RECORD_SIZE(size) ((8 * (size) > 512) ? (8 * (size)) : 512)
+
+/* Twiddle factors used by an FFT of the largest size. */
+#define SPECTRUM_TWIDDLES (3 * SPECTRUM_MAX_SIZE / 4)
+
+/*
+ * Complex values are packed into 32 bits, with the Q15 real part in the
+ * low half and the imaginary part in the high half, so that the M4 can
+ * work on both halves at once.
+ */
+typedef struct {
+	uint16_t size;
+	uint32_t frames;
+	uint32_t skipped;
+	uint32_t work[SPECTRUM_MAX_SIZE];
+	uint64_t power[SPECTRUM_MAX_SIZE];
+	/* Tables filled in by spectrum_init(). */
+	int16_t window[SPECTRUM_MAX_SIZE];
+	uint32_t twiddle[SPECTRUM_TWIDDLES];
+	uint8_t reverse[SPECTRUM_MAX_SIZE];
+} spectrum_t;
+
+bool spectrum_init(spectrum_t* const spectrum, const uint16_t size);
+void spectrum_reset(spectrum_t* const spectrum);
+void spectrum_fft(const spectrum_t* const spectrum, uint32_t* const data);
+void spectrum_add_frame(spectrum_t* const spectrum, const int8_t* const samples);
+uint32_t spectrum_add_block(
+	spectrum_t* const spectrum,
+	const int8_t* const samples,
+	const uint32_t length);
+void spectrum_skip_block(spectrum_t* const spectrum);
+void spectrum_write_record(
+	spectrum_t* const spectrum,
+	const uint64_t freq,
+	uint8_t* const record);
+
+#endif /*__SPECTRUM_H__*/
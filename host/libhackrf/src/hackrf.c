@@ -22,12 +22,18 @@ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSI
 */
 
 #include "hackrf.h"
+#include "spectrum.h"
+#include "crc.h"
+#include "command_queue.h"
+#include "hop_table.h"
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #ifndef _WIN32
 	#include <unistd.h>
 	#include <signal.h>
+	#include <time.h>
 #endif
 #include <libusb.h>
 
@@ -35,6 +41,7 @@ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSI
 	/* Avoid redefinition of timespec from time.h (included by libusb.h) */
 	#define HAVE_STRUCT_TIMESPEC 1
 	#define strdup               _strdup
+	#include <windows.h>
 #endif
 #include <pthread.h>
 
@@ -56,6 +63,14 @@ typedef int bool;
 	#define FROM_LE32(x) x
 #endif
 
+#ifdef _MSC_VER
+	#define trace_fetch_add(p, n) InterlockedExchangeAdd((volatile LONG*) (p), (n))
+	#define trace_barrier()       MemoryBarrier()
+#else
+	#define trace_fetch_add(p, n) __sync_fetch_and_add((p), (n))
+	#define trace_barrier()       __sync_synchronize()
+#endif
+
 // TODO: Factor this into a shared #include so that firmware can use
 // the same values.
 typedef enum {
@@ -105,6 +120,16 @@ typedef enum {
 	HACKRF_VENDOR_REQUEST_SUPPORTED_PLATFORM_READ = 46,
 	HACKRF_VENDOR_REQUEST_SET_LEDS = 47,
 	HACKRF_VENDOR_REQUEST_SET_USER_BIAS_T_OPTS = 48,
+	HACKRF_VENDOR_REQUEST_SET_SWEEP_TIMING = 49,
+	HACKRF_VENDOR_REQUEST_SET_TUNING_TABLE = 50,
+	HACKRF_VENDOR_REQUEST_INIT_SWEEP_LIST = 51,
+	HACKRF_VENDOR_REQUEST_SET_SWEEP_SPECTRUM = 52,
+	HACKRF_VENDOR_REQUEST_SPIFLASH_PROGRAM = 53,
+	HACKRF_VENDOR_REQUEST_SPIFLASH_PROGRAM_STATUS = 54,
+	HACKRF_VENDOR_REQUEST_APPLY_CONFIG = 55,
+	HACKRF_VENDOR_REQUEST_SCHEDULE_COMMANDS = 56,
+	HACKRF_VENDOR_REQUEST_SET_HOP_TABLE = 57,
+	HACKRF_VENDOR_REQUEST_GET_M0_TELEMETRY = 58,
 } hackrf_vendor_request;
 
 #define USB_CONFIG_STANDARD 0x1
@@ -119,6 +144,8 @@ typedef enum {
 	HACKRF_TRANSCEIVER_MODE_SS = 3,
 	TRANSCEIVER_MODE_CPLD_UPDATE = 4,
 	TRANSCEIVER_MODE_RX_SWEEP = 5,
+	TRANSCEIVER_MODE_RX_HOP = 7,
+	TRANSCEIVER_MODE_TX_HOP = 8,
 } hackrf_transceiver_mode;
 
 typedef enum {
@@ -129,7 +156,15 @@ typedef enum {
 #define TRANSFER_COUNT        4
 #define TRANSFER_BUFFER_SIZE  262144
 #define DEVICE_BUFFER_SIZE    32768
+/* Default timeout for asynchronous control transfers. */
+#define CONTROL_ASYNC_DEFAULT_TIMEOUT_MS 1000
 #define USB_MAX_SERIAL_LENGTH 32
+#define TRACE_MAX_CAPACITY    (1 << 24)
+
+typedef struct {
+	volatile uint32_t seq; /* sequence number + 1 once recorded, 0 while written */
+	hackrf_trace_event event;
+} trace_slot_t;
 
 struct hackrf_device {
 	libusb_device_handle* usb_device;
@@ -152,6 +187,13 @@ struct hackrf_device {
 	hackrf_flush_cb_fn flush_callback;
 	hackrf_tx_block_complete_cb_fn tx_completion_callback;
 	void* flush_ctx;
+	hackrf_device_info info; /* read once at open */
+	int active_control_transfers;    /* guarded by transfer_lock */
+	unsigned int control_timeout_ms; /* timeout for async control transfers */
+	trace_slot_t* trace_slots;       /* allocated by the first hackrf_trace_enable */
+	uint32_t trace_mask;             /* number of trace slots - 1 */
+	volatile uint32_t trace_head;    /* sequence number of the next event */
+	volatile bool trace_enabled;
 };
 
 typedef struct {
@@ -177,10 +219,8 @@ static const max2837_ft_t max2837_ft[] = {
 	{28000000},
 	{0}};
 
-#define USB_API_REQUIRED(device, version)                  \
-	uint16_t usb_version = 0;                          \
-	hackrf_usb_api_version_read(device, &usb_version); \
-	if (usb_version < version)                         \
+#define USB_API_REQUIRED(device, version)          \
+	if (device->info.usb_api_version < version) \
 		return HACKRF_ERROR_USB_API_VERSION;
 
 static const uint16_t hackrf_usb_vid = 0x1d50;
@@ -190,6 +230,8 @@ static const uint16_t rad1o_usb_pid = 0xcc15;
 static uint16_t open_devices = 0;
 
 static int create_transfer_thread(hackrf_device* device);
+static void registry_stop(void);
+bool hackrf_operacake_valid_address(uint8_t address);
 
 static libusb_context* g_libusb_context = NULL;
 int last_libusb_error = LIBUSB_SUCCESS;
@@ -513,6 +555,7 @@ int ADDCALL hackrf_exit(void)
 {
 	if (open_devices == 0) {
 		if (g_libusb_context != NULL) {
+			registry_stop();
 			libusb_exit(g_libusb_context);
 			g_libusb_context = NULL;
 		}
@@ -539,13 +582,457 @@ const char* ADDCALL hackrf_library_release()
 	return LIBRARY_RELEASE;
 }
 
+static bool hackrf_usb_product(const uint16_t product_id)
+{
+	return (product_id == hackrf_one_usb_pid) ||
+		(product_id == hackrf_jawbreaker_usb_pid) ||
+		(product_id == rad1o_usb_pid);
+}
+
+/*
+ * Devices present on the bus, kept up to date by libusb hotplug events,
+ * so that listing and opening devices by serial number doesn't need to
+ * open every HackRF to read its serial number. The registry runs a thread
+ * of its own, so it is only started on request, by
+ * hackrf_enable_device_registry() or hackrf_set_hotplug_callback(). The
+ * entries are a plain list, which is searched linearly: there are rarely
+ * more than a handful of devices on one host.
+ *
+ * Hotplug callbacks may not perform I/O, so they only queue events. The
+ * serial numbers are read when the events are processed, either by the
+ * thread that started the registry or by the registry thread, which also
+ * handles libusb events while no device is open. A serial number can't be
+ * read until the OS has given access to a new device, so if the first
+ * read fails, lookups scan the bus instead and fill the entry in.
+ */
+typedef struct registry_entry {
+	struct registry_entry* next;
+	libusb_device* usb_device;
+	enum hackrf_usb_board_id board_id;
+	char serial_number[USB_MAX_SERIAL_LENGTH + 1]; /* empty until read */
+} registry_entry_t;
+
+typedef struct registry_event {
+	struct registry_event* next;
+	libusb_hotplug_event event;
+	libusb_device* usb_device;
+} registry_event_t;
+
+static struct {
+	bool active;
+	volatile bool do_exit;
+	pthread_t thread;
+	libusb_hotplug_callback_handle handle;
+	registry_entry_t* entries;
+	registry_event_t* events;
+	registry_event_t** events_tail;
+	hackrf_hotplug_cb_fn callback;
+	void* callback_ctx;
+} registry = {
+	.events_tail = &registry.events,
+};
+
+/* Guards the registry contents. */
+static pthread_mutex_t registry_lock = PTHREAD_MUTEX_INITIALIZER;
+/* Serializes starting and stopping the registry. */
+static pthread_mutex_t registry_start_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void read_serial_number(
+	libusb_device* usb_device,
+	const uint8_t serial_descriptor_index,
+	char* serial_number)
+{
+	libusb_device_handle* usb_handle;
+	int length;
+
+	serial_number[0] = 0;
+	if ((serial_descriptor_index == 0) ||
+	    (libusb_open(usb_device, &usb_handle) != 0)) {
+		return;
+	}
+	length = libusb_get_string_descriptor_ascii(
+		usb_handle,
+		serial_descriptor_index,
+		(unsigned char*) serial_number,
+		USB_MAX_SERIAL_LENGTH + 1);
+	if (length < 0) {
+		length = 0;
+	} else if (length > USB_MAX_SERIAL_LENGTH) {
+		length = USB_MAX_SERIAL_LENGTH;
+	}
+	serial_number[length] = 0;
+	libusb_close(usb_handle);
+}
+
+static int LIBUSB_CALL registry_hotplug_callback(
+	libusb_context* context,
+	libusb_device* usb_device,
+	libusb_hotplug_event event,
+	void* user_data)
+{
+	struct libusb_device_descriptor device_descriptor;
+	registry_event_t* entry;
+
+	(void) context;
+	(void) user_data;
+
+	if ((libusb_get_device_descriptor(usb_device, &device_descriptor) != 0) ||
+	    !hackrf_usb_product(device_descriptor.idProduct)) {
+		return 0;
+	}
+
+	entry = (registry_event_t*) malloc(sizeof(*entry));
+	if (entry == NULL) {
+		return 0;
+	}
+	entry->next = NULL;
+	entry->event = event;
+	entry->usb_device = libusb_ref_device(usb_device);
+
+	pthread_mutex_lock(&registry_lock);
+	*registry.events_tail = entry;
+	registry.events_tail = &entry->next;
+	pthread_mutex_unlock(&registry_lock);
+
+	return 0;
+}
+
+static void registry_notify(
+	const enum hackrf_hotplug_event event,
+	const registry_entry_t* const entry)
+{
+	hackrf_hotplug_cb_fn callback;
+	void* ctx;
+
+	pthread_mutex_lock(&registry_lock);
+	callback = registry.callback;
+	ctx = registry.callback_ctx;
+	pthread_mutex_unlock(&registry_lock);
+
+	if (callback != NULL) {
+		callback(
+			event,
+			entry->serial_number[0] ? entry->serial_number : NULL,
+			entry->board_id,
+			ctx);
+	}
+}
+
+static void registry_add(libusb_device* usb_device)
+{
+	struct libusb_device_descriptor device_descriptor;
+	registry_entry_t* entry;
+
+	entry = (registry_entry_t*) calloc(1, sizeof(*entry));
+	if ((entry == NULL) ||
+	    (libusb_get_device_descriptor(usb_device, &device_descriptor) != 0)) {
+		free(entry);
+		return;
+	}
+	entry->usb_device = libusb_ref_device(usb_device);
+	entry->board_id = device_descriptor.idProduct;
+	read_serial_number(
+		usb_device,
+		device_descriptor.iSerialNumber,
+		entry->serial_number);
+
+	pthread_mutex_lock(&registry_lock);
+	entry->next = registry.entries;
+	registry.entries = entry;
+	pthread_mutex_unlock(&registry_lock);
+
+	registry_notify(HACKRF_HOTPLUG_ARRIVED, entry);
+}
+
+static void registry_remove(libusb_device* usb_device)
+{
+	registry_entry_t** link;
+	registry_entry_t* entry = NULL;
+
+	pthread_mutex_lock(&registry_lock);
+	for (link = &registry.entries; *link != NULL; link = &(*link)->next) {
+		if ((*link)->usb_device == usb_device) {
+			entry = *link;
+			*link = entry->next;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&registry_lock);
+
+	if (entry != NULL) {
+		registry_notify(HACKRF_HOTPLUG_LEFT, entry);
+		libusb_unref_device(entry->usb_device);
+		free(entry);
+	}
+}
+
+static void registry_process_events(void)
+{
+	registry_event_t* event;
+
+	while (true) {
+		pthread_mutex_lock(&registry_lock);
+		event = registry.events;
+		if (event != NULL) {
+			registry.events = event->next;
+			if (registry.events == NULL) {
+				registry.events_tail = &registry.events;
+			}
+		}
+		pthread_mutex_unlock(&registry_lock);
+
+		if (event == NULL) {
+			break;
+		}
+		if (event->event == LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED) {
+			registry_add(event->usb_device);
+		} else {
+			registry_remove(event->usb_device);
+		}
+		libusb_unref_device(event->usb_device);
+		free(event);
+	}
+}
+
+static void* registry_threadproc(void* arg)
+{
+	struct timeval timeout = {0, 250000};
+
+	(void) arg;
+
+#ifndef _WIN32
+	sigset_t signal_mask;
+	sigfillset(&signal_mask);
+	if (pthread_sigmask(SIG_BLOCK, &signal_mask, NULL) != 0) {
+		return NULL;
+	}
+#endif
+
+	while (registry.do_exit == false) {
+		libusb_handle_events_timeout(g_libusb_context, &timeout);
+		registry_process_events();
+	}
+
+	return NULL;
+}
+
+/*
+ * Start the registry if libusb supports hotplug events. Devices already
+ * present are added before this returns.
+ */
+static int registry_start(void)
+{
+	int result = HACKRF_SUCCESS;
+
+	pthread_mutex_lock(&registry_start_lock);
+	if (registry.active) {
+		pthread_mutex_unlock(&registry_start_lock);
+		return HACKRF_SUCCESS;
+	}
+
+	if ((g_libusb_context == NULL) ||
+	    !libusb_has_capability(LIBUSB_CAP_HAS_HOTPLUG)) {
+		last_libusb_error = LIBUSB_ERROR_NOT_SUPPORTED;
+		pthread_mutex_unlock(&registry_start_lock);
+		return HACKRF_ERROR_LIBUSB;
+	}
+
+	result = libusb_hotplug_register_callback(
+		g_libusb_context,
+		LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED | LIBUSB_HOTPLUG_EVENT_DEVICE_LEFT,
+		LIBUSB_HOTPLUG_ENUMERATE,
+		hackrf_usb_vid,
+		LIBUSB_HOTPLUG_MATCH_ANY,
+		LIBUSB_HOTPLUG_MATCH_ANY,
+		registry_hotplug_callback,
+		NULL,
+		&registry.handle);
+	if (result != LIBUSB_SUCCESS) {
+		last_libusb_error = result;
+		pthread_mutex_unlock(&registry_start_lock);
+		return HACKRF_ERROR_LIBUSB;
+	}
+	registry_process_events();
+
+	registry.do_exit = false;
+	if (pthread_create(&registry.thread, NULL, registry_threadproc, NULL) != 0) {
+		libusb_hotplug_deregister_callback(g_libusb_context, registry.handle);
+		pthread_mutex_unlock(&registry_start_lock);
+		registry_stop();
+		return HACKRF_ERROR_THREAD;
+	}
+	registry.active = true;
+
+	pthread_mutex_unlock(&registry_start_lock);
+	return HACKRF_SUCCESS;
+}
+
+static void registry_stop(void)
+{
+	registry_entry_t* entry;
+	registry_event_t* event;
+
+	pthread_mutex_lock(&registry_start_lock);
+	if (registry.active) {
+		libusb_hotplug_deregister_callback(g_libusb_context, registry.handle);
+		registry.do_exit = true;
+		libusb_interrupt_event_handler(g_libusb_context);
+		pthread_join(registry.thread, NULL);
+		registry.active = false;
+	}
+
+	// Discard queued events and forget all devices, without notification.
+	registry.callback = NULL;
+	while (registry.events != NULL) {
+		event = registry.events;
+		registry.events = event->next;
+		libusb_unref_device(event->usb_device);
+		free(event);
+	}
+	registry.events_tail = &registry.events;
+	while (registry.entries != NULL) {
+		entry = registry.entries;
+		registry.entries = entry->next;
+		libusb_unref_device(entry->usb_device);
+		free(entry);
+	}
+	pthread_mutex_unlock(&registry_start_lock);
+}
+
+static bool registry_running(void)
+{
+	bool active;
+
+	pthread_mutex_lock(&registry_start_lock);
+	active = registry.active;
+	pthread_mutex_unlock(&registry_start_lock);
+
+	return active;
+}
+
+/*
+ * Look up the serial number of a device in the registry. Returns false if
+ * the device isn't known to the registry or its serial number hasn't been
+ * read yet.
+ */
+static bool registry_serial_number(libusb_device* usb_device, char* serial_number)
+{
+	registry_entry_t* entry;
+	bool found = false;
+
+	pthread_mutex_lock(&registry_lock);
+	for (entry = registry.entries; entry != NULL; entry = entry->next) {
+		if ((entry->usb_device == usb_device) && entry->serial_number[0]) {
+			strcpy(serial_number, entry->serial_number);
+			found = true;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&registry_lock);
+
+	return found;
+}
+
+/* Record a serial number that the registry couldn't read itself. */
+static void registry_set_serial_number(
+	libusb_device* usb_device,
+	const char* const serial_number)
+{
+	registry_entry_t* entry;
+
+	pthread_mutex_lock(&registry_lock);
+	for (entry = registry.entries; entry != NULL; entry = entry->next) {
+		if ((entry->usb_device == usb_device) && !entry->serial_number[0]) {
+			strncpy(entry->serial_number,
+				serial_number,
+				USB_MAX_SERIAL_LENGTH);
+			entry->serial_number[USB_MAX_SERIAL_LENGTH] = 0;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&registry_lock);
+}
+
+/*
+ * Find a device by serial number suffix, as hackrf_open_by_serial() does.
+ * The returned device is referenced and must be unreferenced by the
+ * caller.
+ */
+static libusb_device* registry_find(const char* const desired_serial_number)
+{
+	const size_t match_len = strlen(desired_serial_number);
+	registry_entry_t* entry;
+	libusb_device* usb_device = NULL;
+	size_t length;
+
+	pthread_mutex_lock(&registry_lock);
+	for (entry = registry.entries; entry != NULL; entry = entry->next) {
+		length = strlen(entry->serial_number);
+		if ((length >= match_len) &&
+		    (strcmp(entry->serial_number + length - match_len,
+			    desired_serial_number) == 0)) {
+			usb_device = libusb_ref_device(entry->usb_device);
+			break;
+		}
+	}
+	pthread_mutex_unlock(&registry_lock);
+
+	return usb_device;
+}
+
+int ADDCALL hackrf_enable_device_registry(void)
+{
+	return registry_start();
+}
+
+int ADDCALL hackrf_set_hotplug_callback(hackrf_hotplug_cb_fn callback, void* ctx)
+{
+	registry_entry_t* entry;
+	registry_entry_t* present = NULL;
+	registry_entry_t* copy;
+	int result;
+
+	result = registry_start();
+	if (result != HACKRF_SUCCESS) {
+		return result;
+	}
+
+	// Take a snapshot of the devices already present to report them.
+	pthread_mutex_lock(&registry_lock);
+	registry.callback = callback;
+	registry.callback_ctx = ctx;
+	for (entry = registry.entries; entry != NULL; entry = entry->next) {
+		copy = (registry_entry_t*) malloc(sizeof(*copy));
+		if (copy != NULL) {
+			*copy = *entry;
+			copy->next = present;
+			present = copy;
+		}
+	}
+	pthread_mutex_unlock(&registry_lock);
+
+	while (present != NULL) {
+		entry = present;
+		present = entry->next;
+		if (callback != NULL) {
+			callback(
+				HACKRF_HOTPLUG_ARRIVED,
+				entry->serial_number[0] ? entry->serial_number : NULL,
+				entry->board_id,
+				ctx);
+		}
+		free(entry);
+	}
+
+	return HACKRF_SUCCESS;
+}
+
 hackrf_device_list_t* ADDCALL hackrf_device_list()
 {
 	int i;
-	libusb_device_handle* usb_device = NULL;
-	uint8_t serial_descriptor_index;
 	char serial_number[64];
-	uint8_t idx, serial_number_length;
+	uint8_t idx;
+	bool use_registry;
 
 	hackrf_device_list_t* list = calloc(1, sizeof(*list));
 	if (list == NULL)
@@ -566,41 +1053,37 @@ hackrf_device_list_t* ADDCALL hackrf_device_list()
 		return NULL;
 	}
 
+	use_registry = registry_running();
+
 	for (i = 0; i < list->usb_devicecount; i++) {
 		struct libusb_device_descriptor device_descriptor;
 		libusb_get_device_descriptor(list->usb_devices[i], &device_descriptor);
 
 		if (device_descriptor.idVendor == hackrf_usb_vid) {
-			if ((device_descriptor.idProduct == hackrf_one_usb_pid) ||
-			    (device_descriptor.idProduct == hackrf_jawbreaker_usb_pid) ||
-			    (device_descriptor.idProduct == rad1o_usb_pid)) {
+			if (hackrf_usb_product(device_descriptor.idProduct)) {
 				idx = list->devicecount++;
 				list->usb_board_ids[idx] = device_descriptor.idProduct;
 				list->usb_device_index[idx] = i;
 
-				serial_descriptor_index = device_descriptor.iSerialNumber;
-				if (serial_descriptor_index > 0) {
-					if (libusb_open(
-						    list->usb_devices[i],
-						    &usb_device) != 0) {
-						usb_device = NULL;
-						continue;
-					}
-					serial_number_length =
-						libusb_get_string_descriptor_ascii(
-							usb_device,
-							serial_descriptor_index,
-							(unsigned char*) serial_number,
-							sizeof(serial_number));
-					if (serial_number_length >= USB_MAX_SERIAL_LENGTH)
-						serial_number_length =
-							USB_MAX_SERIAL_LENGTH;
-
-					serial_number[serial_number_length] = 0;
+				if (use_registry &&
+				    registry_serial_number(
+					    list->usb_devices[i],
+					    serial_number)) {
 					list->serial_numbers[idx] = strdup(serial_number);
+					continue;
+				}
 
-					libusb_close(usb_device);
-					usb_device = NULL;
+				read_serial_number(
+					list->usb_devices[i],
+					device_descriptor.iSerialNumber,
+					serial_number);
+				if (serial_number[0]) {
+					list->serial_numbers[idx] = strdup(serial_number);
+					if (use_registry) {
+						registry_set_serial_number(
+							list->usb_devices[i],
+							serial_number);
+					}
 				}
 			}
 		}
@@ -699,6 +1182,35 @@ libusb_device_handle* hackrf_open_usb(const char* const desired_serial_number)
 	return usb_device;
 }
 
+/*
+ * Read the information that doesn't change while the device is open. Only
+ * the USB API version is required: older firmware may not report the rest.
+ */
+static int read_device_info(hackrf_device* device)
+{
+	int result;
+	libusb_device* dev;
+	struct libusb_device_descriptor desc;
+	hackrf_device_info* const info = &device->info;
+
+	dev = libusb_get_device(device->usb_device);
+	result = libusb_get_device_descriptor(dev, &desc);
+	if (result < 0) {
+		last_libusb_error = result;
+		return HACKRF_ERROR_LIBUSB;
+	}
+	info->usb_api_version = desc.bcdDevice;
+
+	info->board_id = BOARD_ID_UNDETECTED;
+	hackrf_board_id_read(device, &info->board_id);
+	info->board_rev = BOARD_REV_UNDETECTED;
+	hackrf_board_rev_read(device, &info->board_rev);
+	info->supported_platform = 0;
+	hackrf_supported_platform_read(device, &info->supported_platform);
+
+	return HACKRF_SUCCESS;
+}
+
 static int hackrf_open_setup(libusb_device_handle* usb_device, hackrf_device** device)
 {
 	int result;
@@ -740,6 +1252,18 @@ static int hackrf_open_setup(libusb_device_handle* usb_device, hackrf_device** d
 	lib_device->flush_callback = NULL;
 	lib_device->flush_ctx = NULL;
 	lib_device->tx_completion_callback = NULL;
+	lib_device->active_control_transfers = 0;
+	lib_device->control_timeout_ms = CONTROL_ASYNC_DEFAULT_TIMEOUT_MS;
+	lib_device->trace_slots = NULL;
+	lib_device->trace_enabled = false;
+
+	result = read_device_info(lib_device);
+	if (result != HACKRF_SUCCESS) {
+		free(lib_device);
+		libusb_release_interface(usb_device, 0);
+		libusb_close(usb_device);
+		return result;
+	}
 
 	result = pthread_mutex_init(&lib_device->transfer_lock, NULL);
 	if (result != 0) {
@@ -818,6 +1342,8 @@ int ADDCALL hackrf_open_by_serial(
 	hackrf_device** device)
 {
 	libusb_device_handle* usb_device;
+	libusb_device* found;
+	int result;
 
 	if (desired_serial_number == NULL) {
 		return hackrf_open(device);
@@ -827,7 +1353,26 @@ int ADDCALL hackrf_open_by_serial(
 		return HACKRF_ERROR_INVALID_PARAM;
 	}
 
-	usb_device = hackrf_open_usb(desired_serial_number);
+	usb_device = NULL;
+	if (registry_running()) {
+		found = registry_find(desired_serial_number);
+		if (found != NULL) {
+			result = libusb_open(found, &usb_device);
+			libusb_unref_device(found);
+			if (result != 0) {
+				last_libusb_error = result;
+				return HACKRF_ERROR_LIBUSB;
+			}
+		}
+	}
+
+	/*
+	 * Scan the bus if the registry isn't running, hasn't seen the device
+	 * yet or couldn't read its serial number.
+	 */
+	if (usb_device == NULL) {
+		usb_device = hackrf_open_usb(desired_serial_number);
+	}
 
 	if (usb_device == NULL) {
 		return HACKRF_ERROR_NOT_FOUND;
@@ -860,13 +1405,116 @@ int ADDCALL hackrf_device_list_open(
 	return hackrf_open_setup(usb_device, device);
 }
 
-int ADDCALL hackrf_set_transceiver_mode(
+static uint64_t trace_time_ns(void)
+{
+#ifdef _WIN32
+	LARGE_INTEGER count, frequency;
+
+	QueryPerformanceCounter(&count);
+	QueryPerformanceFrequency(&frequency);
+	return (uint64_t) ((double) count.QuadPart * 1e9 / (double) frequency.QuadPart);
+#else
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t) now.tv_sec * 1000000000 + now.tv_nsec;
+#endif
+}
+
+/*
+ * Writers claim a slot by sequence number, so requests completing on
+ * different threads never wait for each other. The slot's seq is cleared
+ * while the event is written, which lets hackrf_trace_read() tell a
+ * partly written event from a complete one.
+ */
+static void trace_record(
 	hackrf_device* device,
-	hackrf_transceiver_mode value)
+	const uint8_t request_type,
+	const uint8_t request,
+	const uint16_t value,
+	const uint16_t index,
+	const uint16_t length,
+	const int result,
+	const bool async,
+	const uint64_t submit_ns)
+{
+	const uint32_t seq = trace_fetch_add(&device->trace_head, 1);
+	trace_slot_t* slot = &device->trace_slots[seq & device->trace_mask];
+
+	slot->seq = 0;
+	trace_barrier();
+	slot->event.submit_ns = submit_ns;
+	slot->event.complete_ns = trace_time_ns();
+	slot->event.result = result;
+	slot->event.value = value;
+	slot->event.index = index;
+	slot->event.length = length;
+	slot->event.request = request;
+	slot->event.flags = (async ? HACKRF_TRACE_FLAG_ASYNC : 0) |
+		((request_type & LIBUSB_ENDPOINT_IN) ? HACKRF_TRACE_FLAG_IN : 0);
+	trace_barrier();
+	slot->seq = seq + 1;
+}
+
+/*
+ * Send a vendor request and wait for it to complete, as
+ * libusb_control_transfer() does, recording it if tracing is enabled.
+ */
+static int control_transfer(
+	hackrf_device* device,
+	const uint8_t request_type,
+	const uint8_t request,
+	const uint16_t value,
+	const uint16_t index,
+	unsigned char* data,
+	const uint16_t length,
+	const unsigned int timeout)
 {
+	uint64_t submit_ns;
 	int result;
+
+	if (!device->trace_enabled) {
+		return libusb_control_transfer(
+			device->usb_device,
+			request_type,
+			request,
+			value,
+			index,
+			data,
+			length,
+			timeout);
+	}
+
+	submit_ns = trace_time_ns();
 	result = libusb_control_transfer(
 		device->usb_device,
+		request_type,
+		request,
+		value,
+		index,
+		data,
+		length,
+		timeout);
+	trace_record(
+		device,
+		request_type,
+		request,
+		value,
+		index,
+		length,
+		result,
+		false,
+		submit_ns);
+	return result;
+}
+
+int ADDCALL hackrf_set_transceiver_mode(
+	hackrf_device* device,
+	hackrf_transceiver_mode value)
+{
+	int result;
+	result = control_transfer(
+		device,
 		LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR |
 			LIBUSB_RECIPIENT_DEVICE,
 		HACKRF_VENDOR_REQUEST_SET_TRANSCEIVER_MODE,
@@ -895,8 +1543,8 @@ int ADDCALL hackrf_max2837_read(
 		return HACKRF_ERROR_INVALID_PARAM;
 	}
 
-	result = libusb_control_transfer(
-		device->usb_device,
+	result = control_transfer(
+		device,
 		LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
 		HACKRF_VENDOR_REQUEST_MAX2837_READ,
 		0,
@@ -927,8 +1575,8 @@ int ADDCALL hackrf_max2837_write(
 		return HACKRF_ERROR_INVALID_PARAM;
 	}
 
-	result = libusb_control_transfer(
-		device->usb_device,
+	result = control_transfer(
+		device,
 		LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR |
 			LIBUSB_RECIPIENT_DEVICE,
 		HACKRF_VENDOR_REQUEST_MAX2837_WRITE,
@@ -959,8 +1607,8 @@ int ADDCALL hackrf_si5351c_read(
 	}
 
 	temp_value = 0;
-	result = libusb_control_transfer(
-		device->usb_device,
+	result = control_transfer(
+		device,
 		LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
 		HACKRF_VENDOR_REQUEST_SI5351C_READ,
 		0,
@@ -992,8 +1640,8 @@ int ADDCALL hackrf_si5351c_write(
 		return HACKRF_ERROR_INVALID_PARAM;
 	}
 
-	result = libusb_control_transfer(
-		device->usb_device,
+	result = control_transfer(
+		device,
 		LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR |
 			LIBUSB_RECIPIENT_DEVICE,
 		HACKRF_VENDOR_REQUEST_SI5351C_WRITE,
@@ -1016,8 +1664,8 @@ int ADDCALL hackrf_set_baseband_filter_bandwidth(
 	const uint32_t bandwidth_hz)
 {
 	int result;
-	result = libusb_control_transfer(
-		device->usb_device,
+	result = control_transfer(
+		device,
 		LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR |
 			LIBUSB_RECIPIENT_DEVICE,
 		HACKRF_VENDOR_REQUEST_BASEBAND_FILTER_BANDWIDTH_SET,
@@ -1046,8 +1694,8 @@ int ADDCALL hackrf_rffc5071_read(
 		return HACKRF_ERROR_INVALID_PARAM;
 	}
 
-	result = libusb_control_transfer(
-		device->usb_device,
+	result = control_transfer(
+		device,
 		LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
 		HACKRF_VENDOR_REQUEST_RFFC5071_READ,
 		0,
@@ -1075,8 +1723,8 @@ int ADDCALL hackrf_rffc5071_write(
 		return HACKRF_ERROR_INVALID_PARAM;
 	}
 
-	result = libusb_control_transfer(
-		device->usb_device,
+	result = control_transfer(
+		device,
 		LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR |
 			LIBUSB_RECIPIENT_DEVICE,
 		HACKRF_VENDOR_REQUEST_RFFC5071_WRITE,
@@ -1099,8 +1747,8 @@ int ADDCALL hackrf_get_m0_state(hackrf_device* device, hackrf_m0_state* state)
 	USB_API_REQUIRED(device, 0x0106)
 	int result;
 
-	result = libusb_control_transfer(
-		device->usb_device,
+	result = control_transfer(
+		device,
 		LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
 		HACKRF_VENDOR_REQUEST_GET_M0_STATE,
 		0,
@@ -1128,13 +1776,256 @@ int ADDCALL hackrf_get_m0_state(hackrf_device* device, hackrf_m0_state* state)
 	}
 }
 
+int ADDCALL hackrf_get_m0_telemetry(
+	hackrf_device* device,
+	hackrf_m0_telemetry* telemetry)
+{
+	USB_API_REQUIRED(device, 0x0109)
+	int result;
+	int i;
+
+	result = control_transfer(
+		device,
+		LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
+		HACKRF_VENDOR_REQUEST_GET_M0_TELEMETRY,
+		0,
+		0,
+		(unsigned char*) telemetry,
+		sizeof(hackrf_m0_telemetry),
+		0);
+
+	if (result < (int) sizeof(hackrf_m0_telemetry)) {
+		last_libusb_error = result;
+		return HACKRF_ERROR_LIBUSB;
+	}
+
+	telemetry->min_margin = FROM_LE32(telemetry->min_margin);
+	telemetry->num_shortfalls = FROM_LE32(telemetry->num_shortfalls);
+	telemetry->histogram_missed = FROM_LE32(telemetry->histogram_missed);
+	for (i = 0; i < HACKRF_M0_SHORTFALL_HISTOGRAM_BINS; i++) {
+		telemetry->histogram[i] = FROM_LE32(telemetry->histogram[i]);
+	}
+	telemetry->num_recent = FROM_LE32(telemetry->num_recent);
+	for (i = 0; i < HACKRF_M0_SHORTFALL_LOG_SIZE; i++) {
+		telemetry->recent[i].start = FROM_LE32(telemetry->recent[i].start);
+		telemetry->recent[i].length = FROM_LE32(telemetry->recent[i].length);
+	}
+	return HACKRF_SUCCESS;
+}
+
+int ADDCALL hackrf_trace_enable(hackrf_device* device, uint32_t capacity)
+{
+	uint32_t size = 1;
+
+	if (device->trace_slots == NULL) {
+		if ((capacity == 0) || (capacity > TRACE_MAX_CAPACITY)) {
+			return HACKRF_ERROR_INVALID_PARAM;
+		}
+		while (size < capacity) {
+			size <<= 1;
+		}
+		device->trace_slots = (trace_slot_t*) calloc(size, sizeof(trace_slot_t));
+		if (device->trace_slots == NULL) {
+			return HACKRF_ERROR_NO_MEM;
+		}
+		device->trace_mask = size - 1;
+		device->trace_head = 0;
+	}
+	trace_barrier();
+	device->trace_enabled = true;
+	return HACKRF_SUCCESS;
+}
+
+int ADDCALL hackrf_trace_disable(hackrf_device* device)
+{
+	device->trace_enabled = false;
+	return HACKRF_SUCCESS;
+}
+
+int ADDCALL hackrf_trace_read(
+	hackrf_device* device,
+	uint32_t* position,
+	hackrf_trace_event* events,
+	int count)
+{
+	const trace_slot_t* slot;
+	uint32_t head, seq;
+	int copied = 0;
+
+	if ((position == NULL) || (events == NULL) || (count < 0)) {
+		return HACKRF_ERROR_INVALID_PARAM;
+	}
+	if (device->trace_slots == NULL) {
+		return 0;
+	}
+
+	head = device->trace_head;
+	if ((head - *position) > (device->trace_mask + 1)) {
+		*position = head - (device->trace_mask + 1);
+	}
+	while ((copied < count) && (*position != head)) {
+		slot = &device->trace_slots[*position & device->trace_mask];
+		seq = slot->seq;
+		// Stop at an event that has been claimed but not yet recorded.
+		if ((seq == 0) || ((int32_t) (seq - (*position + 1)) < 0)) {
+			break;
+		}
+		trace_barrier();
+		events[copied] = slot->event;
+		trace_barrier();
+		// Skip the event if a writer has lapped the reader.
+		if ((seq == *position + 1) && (slot->seq == seq)) {
+			copied++;
+		}
+		(*position)++;
+	}
+	return copied;
+}
+
+static void put_le(uint8_t* data, uint64_t value, const int size)
+{
+	int i;
+
+	for (i = 0; i < size; i++) {
+		data[i] = value & 0xff;
+		value >>= 8;
+	}
+}
+
+static bool trace_write_binary(
+	FILE* file,
+	const hackrf_trace_event* events,
+	const int count)
+{
+	uint8_t record[32];
+	int i;
+
+	memset(record, 0, sizeof(record));
+	memcpy(record, "HACKRFTR", 8);
+	put_le(&record[8], 1, 4);
+	put_le(&record[12], count, 4);
+	if (fwrite(record, 16, 1, file) != 1) {
+		return false;
+	}
+
+	for (i = 0; i < count; i++) {
+		put_le(&record[0], events[i].submit_ns, 8);
+		put_le(&record[8], events[i].complete_ns, 8);
+		put_le(&record[16], (uint32_t) events[i].result, 4);
+		put_le(&record[20], events[i].value, 2);
+		put_le(&record[22], events[i].index, 2);
+		put_le(&record[24], events[i].length, 2);
+		record[26] = events[i].request;
+		record[27] = events[i].flags;
+		memset(&record[28], 0, 4);
+		if (fwrite(record, sizeof(record), 1, file) != 1) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/*
+ * Synchronous and asynchronous requests go on separate rows, as their
+ * durations may overlap.
+ */
+static bool trace_write_chrome_json(
+	FILE* file,
+	const hackrf_trace_event* events,
+	const int count)
+{
+	const hackrf_trace_event* event;
+	uint64_t origin = 0;
+	bool async;
+	int i;
+
+	for (i = 0; i < count; i++) {
+		if ((i == 0) || (events[i].submit_ns < origin)) {
+			origin = events[i].submit_ns;
+		}
+	}
+
+	fprintf(file, "{\"traceEvents\":[");
+	for (i = 0; i < count; i++) {
+		event = &events[i];
+		async = (event->flags & HACKRF_TRACE_FLAG_ASYNC) != 0;
+		fprintf(file,
+			"%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\","
+			"\"ts\":%.3f,\"dur\":%.3f,\"pid\":0,\"tid\":%d,"
+			"\"args\":{\"request\":%u,\"value\":%u,\"index\":%u,"
+			"\"length\":%u,\"result\":%d}}",
+			(i == 0) ? "" : ",",
+			hackrf_vendor_request_name(event->request),
+			async ? "async" : "sync",
+			(event->submit_ns - origin) / 1e3,
+			(event->complete_ns - event->submit_ns) / 1e3,
+			async ? 1 : 0,
+			event->request,
+			event->value,
+			event->index,
+			event->length,
+			event->result);
+	}
+	fprintf(file, "\n]}\n");
+	return !ferror(file);
+}
+
+int ADDCALL hackrf_trace_dump(
+	hackrf_device* device,
+	const char* path,
+	enum hackrf_trace_format format)
+{
+	hackrf_trace_event* events;
+	uint32_t position = 0;
+	FILE* file;
+	bool written;
+	int count;
+
+	if ((path == NULL) ||
+	    ((format != HACKRF_TRACE_FORMAT_CHROME_JSON) &&
+	     (format != HACKRF_TRACE_FORMAT_BINARY))) {
+		return HACKRF_ERROR_INVALID_PARAM;
+	}
+
+	count = 0;
+	events = NULL;
+	if (device->trace_slots != NULL) {
+		events = (hackrf_trace_event*) malloc(
+			(device->trace_mask + 1) * sizeof(hackrf_trace_event));
+		if (events == NULL) {
+			return HACKRF_ERROR_NO_MEM;
+		}
+		count = hackrf_trace_read(
+			device,
+			&position,
+			events,
+			device->trace_mask + 1);
+	}
+
+	file = fopen(path, "wb");
+	if (file == NULL) {
+		free(events);
+		return HACKRF_ERROR_OTHER;
+	}
+	if (format == HACKRF_TRACE_FORMAT_BINARY) {
+		written = trace_write_binary(file, events, count);
+	} else {
+		written = trace_write_chrome_json(file, events, count);
+	}
+	free(events);
+	if ((fclose(file) != 0) || !written) {
+		return HACKRF_ERROR_OTHER;
+	}
+	return HACKRF_SUCCESS;
+}
+
 int ADDCALL hackrf_set_tx_underrun_limit(hackrf_device* device, uint32_t value)
 {
 	USB_API_REQUIRED(device, 0x0106)
 	int result;
 
-	result = libusb_control_transfer(
-		device->usb_device,
+	result = control_transfer(
+		device,
 		LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR |
 			LIBUSB_RECIPIENT_DEVICE,
 		HACKRF_VENDOR_REQUEST_SET_TX_UNDERRUN_LIMIT,
@@ -1157,8 +2048,8 @@ int ADDCALL hackrf_set_rx_overrun_limit(hackrf_device* device, uint32_t value)
 	USB_API_REQUIRED(device, 0x0106)
 	int result;
 
-	result = libusb_control_transfer(
-		device->usb_device,
+	result = control_transfer(
+		device,
 		LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR |
 			LIBUSB_RECIPIENT_DEVICE,
 		HACKRF_VENDOR_REQUEST_SET_RX_OVERRUN_LIMIT,
@@ -1179,8 +2070,8 @@ int ADDCALL hackrf_set_rx_overrun_limit(hackrf_device* device, uint32_t value)
 int ADDCALL hackrf_spiflash_erase(hackrf_device* device)
 {
 	int result;
-	result = libusb_control_transfer(
-		device->usb_device,
+	result = control_transfer(
+		device,
 		LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR |
 			LIBUSB_RECIPIENT_DEVICE,
 		HACKRF_VENDOR_REQUEST_SPIFLASH_ERASE,
@@ -1210,8 +2101,8 @@ int ADDCALL hackrf_spiflash_write(
 		return HACKRF_ERROR_INVALID_PARAM;
 	}
 
-	result = libusb_control_transfer(
-		device->usb_device,
+	result = control_transfer(
+		device,
 		LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR |
 			LIBUSB_RECIPIENT_DEVICE,
 		HACKRF_VENDOR_REQUEST_SPIFLASH_WRITE,
@@ -1241,8 +2132,8 @@ int ADDCALL hackrf_spiflash_read(
 		return HACKRF_ERROR_INVALID_PARAM;
 	}
 
-	result = libusb_control_transfer(
-		device->usb_device,
+	result = control_transfer(
+		device,
 		LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
 		HACKRF_VENDOR_REQUEST_SPIFLASH_READ,
 		address >> 16,
@@ -1259,13 +2150,150 @@ int ADDCALL hackrf_spiflash_read(
 	}
 }
 
+uint32_t ADDCALL hackrf_compute_crc32(const unsigned char* data, const uint32_t length)
+{
+	crc32_t crc;
+
+	crc32_init(&crc);
+	crc32_update(&crc, data, length);
+	return crc32_digest(&crc);
+}
+
+/* Bytes per bulk transfer when streaming an image to the SPI flash. */
+#define SPIFLASH_PROGRAM_CHUNK 0x4000
+#define SPIFLASH_SECTOR_SIZE   0x1000
+
+/* State reported by the firmware while programming the SPI flash. */
+#define SPIFLASH_PROGRAM_BUSY 1
+#define SPIFLASH_PROGRAM_DONE 2
+
+/*
+ * Interval between status polls, and how long to wait for the last chunk
+ * to be erased, written and read back before giving up.
+ */
+#define SPIFLASH_PROGRAM_POLL_MS    5
+#define SPIFLASH_PROGRAM_TIMEOUT_MS 10000
+
+static void spiflash_program_sleep(const unsigned int ms)
+{
+#ifdef _WIN32
+	Sleep(ms);
+#else
+	usleep(ms * 1000);
+#endif
+}
+
+int ADDCALL hackrf_spiflash_program(
+	hackrf_device* device,
+	const uint32_t address,
+	const unsigned char* data,
+	const uint32_t length,
+	uint32_t* crc)
+{
+	USB_API_REQUIRED(device, 0x0109)
+	int result, transferred;
+	uint32_t offset, chunk;
+	unsigned int waited;
+	unsigned char request[4];
+	unsigned char status[12];
+
+	if ((address % SPIFLASH_SECTOR_SIZE) || (length == 0) || (address > 0x0FFFFF) ||
+	    (length > (0x100000 - address))) {
+		return HACKRF_ERROR_INVALID_PARAM;
+	}
+
+	request[0] = length & 0xff;
+	request[1] = (length >> 8) & 0xff;
+	request[2] = (length >> 16) & 0xff;
+	request[3] = (length >> 24) & 0xff;
+	result = control_transfer(
+		device,
+		LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR |
+			LIBUSB_RECIPIENT_DEVICE,
+		HACKRF_VENDOR_REQUEST_SPIFLASH_PROGRAM,
+		address >> 16,
+		address & 0xFFFF,
+		request,
+		sizeof(request),
+		0);
+	if (result < (int) sizeof(request)) {
+		last_libusb_error = result;
+		return HACKRF_ERROR_LIBUSB;
+	}
+
+	for (offset = 0; offset < length; offset += chunk) {
+		chunk = length - offset;
+		if (chunk > SPIFLASH_PROGRAM_CHUNK) {
+			chunk = SPIFLASH_PROGRAM_CHUNK;
+		}
+		result = libusb_bulk_transfer(
+			device->usb_device,
+			TX_ENDPOINT_ADDRESS,
+			(unsigned char*) &data[offset],
+			chunk,
+			&transferred,
+			10000 // long timeout to allow for erasing
+		);
+		if (result != LIBUSB_SUCCESS) {
+			last_libusb_error = result;
+			hackrf_set_transceiver_mode(device, HACKRF_TRANSCEIVER_MODE_OFF);
+			return HACKRF_ERROR_LIBUSB;
+		}
+		if (transferred != (int) chunk) {
+			hackrf_set_transceiver_mode(device, HACKRF_TRANSCEIVER_MODE_OFF);
+			return HACKRF_ERROR_OTHER;
+		}
+	}
+
+	// Wait for the last chunk to be written and the checksum computed.
+	waited = 0;
+	for (;;) {
+		result = control_transfer(
+			device,
+			LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR |
+				LIBUSB_RECIPIENT_DEVICE,
+			HACKRF_VENDOR_REQUEST_SPIFLASH_PROGRAM_STATUS,
+			0,
+			0,
+			status,
+			sizeof(status),
+			0);
+		if (result < (int) sizeof(status)) {
+			last_libusb_error = result;
+			hackrf_set_transceiver_mode(device, HACKRF_TRANSCEIVER_MODE_OFF);
+			return HACKRF_ERROR_LIBUSB;
+		}
+		if (status[8] != SPIFLASH_PROGRAM_BUSY) {
+			break;
+		}
+		if (waited >= SPIFLASH_PROGRAM_TIMEOUT_MS) {
+			hackrf_set_transceiver_mode(device, HACKRF_TRANSCEIVER_MODE_OFF);
+			return HACKRF_ERROR_OTHER;
+		}
+		spiflash_program_sleep(SPIFLASH_PROGRAM_POLL_MS);
+		waited += SPIFLASH_PROGRAM_POLL_MS;
+	}
+
+	result = hackrf_set_transceiver_mode(device, HACKRF_TRANSCEIVER_MODE_OFF);
+	if (result != HACKRF_SUCCESS) {
+		return result;
+	}
+	if (status[8] != SPIFLASH_PROGRAM_DONE) {
+		return HACKRF_ERROR_OTHER;
+	}
+
+	*crc = status[4] | (status[5] << 8) | (status[6] << 16) |
+		((uint32_t) status[7] << 24);
+	return HACKRF_SUCCESS;
+}
+
 int ADDCALL hackrf_spiflash_status(hackrf_device* device, uint8_t* data)
 {
 	USB_API_REQUIRED(device, 0x0103)
 	int result;
 
-	result = libusb_control_transfer(
-		device->usb_device,
+	result = control_transfer(
+		device,
 		LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
 		HACKRF_VENDOR_REQUEST_SPIFLASH_STATUS,
 		0,
@@ -1286,8 +2314,8 @@ int ADDCALL hackrf_spiflash_clear_status(hackrf_device* device)
 {
 	USB_API_REQUIRED(device, 0x0103)
 	int result;
-	result = libusb_control_transfer(
-		device->usb_device,
+	result = control_transfer(
+		device,
 		LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR |
 			LIBUSB_RECIPIENT_DEVICE,
 		HACKRF_VENDOR_REQUEST_SPIFLASH_CLEAR_STATUS,
@@ -1340,8 +2368,8 @@ int ADDCALL hackrf_cpld_write(
 int ADDCALL hackrf_board_id_read(hackrf_device* device, uint8_t* value)
 {
 	int result;
-	result = libusb_control_transfer(
-		device->usb_device,
+	result = control_transfer(
+		device,
 		LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
 		HACKRF_VENDOR_REQUEST_BOARD_ID_READ,
 		0,
@@ -1364,8 +2392,8 @@ int ADDCALL hackrf_version_string_read(
 	uint8_t length)
 {
 	int result;
-	result = libusb_control_transfer(
-		device->usb_device,
+	result = control_transfer(
+		device,
 		LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
 		HACKRF_VENDOR_REQUEST_VERSION_STRING_READ,
 		0,
@@ -1387,17 +2415,7 @@ extern ADDAPI int ADDCALL hackrf_usb_api_version_read(
 	hackrf_device* device,
 	uint16_t* version)
 {
-	int result;
-	libusb_device* dev;
-	struct libusb_device_descriptor desc;
-	dev = libusb_get_device(device->usb_device);
-	result = libusb_get_device_descriptor(dev, &desc);
-	if (result < 0) {
-		last_libusb_error = result;
-		return HACKRF_ERROR_LIBUSB;
-	}
-
-	*version = desc.bcdDevice;
+	*version = device->info.usb_api_version;
 	return HACKRF_SUCCESS;
 }
 
@@ -1409,23 +2427,29 @@ typedef struct {
 
 #define FREQ_ONE_MHZ (1000 * 1000ull)
 
-int ADDCALL hackrf_set_freq(hackrf_device* device, const uint64_t freq_hz)
+static void set_freq_params_fill(const uint64_t freq_hz, set_freq_params_t* params)
 {
 	uint32_t l_freq_mhz;
 	uint32_t l_freq_hz;
-	set_freq_params_t set_freq_params;
-	uint8_t length;
-	int result;
 
 	/* Convert Freq Hz 64bits to Freq MHz (32bits) & Freq Hz (32bits) */
 	l_freq_mhz = (uint32_t) (freq_hz / FREQ_ONE_MHZ);
 	l_freq_hz = (uint32_t) (freq_hz - (((uint64_t) l_freq_mhz) * FREQ_ONE_MHZ));
-	set_freq_params.freq_mhz = TO_LE(l_freq_mhz);
-	set_freq_params.freq_hz = TO_LE(l_freq_hz);
+	params->freq_mhz = TO_LE(l_freq_mhz);
+	params->freq_hz = TO_LE(l_freq_hz);
+}
+
+int ADDCALL hackrf_set_freq(hackrf_device* device, const uint64_t freq_hz)
+{
+	set_freq_params_t set_freq_params;
+	uint8_t length;
+	int result;
+
+	set_freq_params_fill(freq_hz, &set_freq_params);
 	length = sizeof(set_freq_params_t);
 
-	result = libusb_control_transfer(
-		device->usb_device,
+	result = control_transfer(
+		device,
 		LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR |
 			LIBUSB_RECIPIENT_DEVICE,
 		HACKRF_VENDOR_REQUEST_SET_FREQ,
@@ -1484,8 +2508,8 @@ int ADDCALL hackrf_set_freq_explicit(
 	params.path = (uint8_t) path;
 	length = sizeof(struct set_freq_explicit_params);
 
-	result = libusb_control_transfer(
-		device->usb_device,
+	result = control_transfer(
+		device,
 		LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR |
 			LIBUSB_RECIPIENT_DEVICE,
 		HACKRF_VENDOR_REQUEST_SET_FREQ_EXPLICIT,
@@ -1526,8 +2550,8 @@ int ADDCALL hackrf_set_sample_rate_manual(
 	set_fracrate_params.divider = TO_LE(divider);
 	length = sizeof(set_fracrate_params_t);
 
-	result = libusb_control_transfer(
-		device->usb_device,
+	result = control_transfer(
+		device,
 		LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR |
 			LIBUSB_RECIPIENT_DEVICE,
 		HACKRF_VENDOR_REQUEST_SAMPLE_RATE_SET,
@@ -1598,8 +2622,8 @@ int ADDCALL hackrf_set_sample_rate(hackrf_device* device, const double freq)
 int ADDCALL hackrf_set_amp_enable(hackrf_device* device, const uint8_t value)
 {
 	int result;
-	result = libusb_control_transfer(
-		device->usb_device,
+	result = control_transfer(
+		device,
 		LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR |
 			LIBUSB_RECIPIENT_DEVICE,
 		HACKRF_VENDOR_REQUEST_AMP_ENABLE,
@@ -1625,8 +2649,8 @@ int ADDCALL hackrf_board_partid_serialno_read(
 	int result;
 
 	length = sizeof(read_partid_serialno_t);
-	result = libusb_control_transfer(
-		device->usb_device,
+	result = control_transfer(
+		device,
 		LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
 		HACKRF_VENDOR_REQUEST_BOARD_PARTID_SERIALNO_READ,
 		0,
@@ -1666,8 +2690,8 @@ int ADDCALL hackrf_set_lna_gain(hackrf_device* device, uint32_t value)
 	}
 
 	value &= ~0x07;
-	result = libusb_control_transfer(
-		device->usb_device,
+	result = control_transfer(
+		device,
 		LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
 		HACKRF_VENDOR_REQUEST_SET_LNA_GAIN,
 		0,
@@ -1693,8 +2717,8 @@ int ADDCALL hackrf_set_vga_gain(hackrf_device* device, uint32_t value)
 	}
 
 	value &= ~0x01;
-	result = libusb_control_transfer(
-		device->usb_device,
+	result = control_transfer(
+		device,
 		LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
 		HACKRF_VENDOR_REQUEST_SET_VGA_GAIN,
 		0,
@@ -1719,8 +2743,8 @@ int ADDCALL hackrf_set_txvga_gain(hackrf_device* device, uint32_t value)
 		return HACKRF_ERROR_INVALID_PARAM;
 	}
 
-	result = libusb_control_transfer(
-		device->usb_device,
+	result = control_transfer(
+		device,
 		LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
 		HACKRF_VENDOR_REQUEST_SET_TXVGA_GAIN,
 		0,
@@ -1729,18 +2753,580 @@ int ADDCALL hackrf_set_txvga_gain(hackrf_device* device, uint32_t value)
 		1,
 		0);
 
-	if (result != 1 || !retval) {
-		return HACKRF_ERROR_INVALID_PARAM;
-	} else {
-		return HACKRF_SUCCESS;
+	if (result != 1 || !retval) {
+		return HACKRF_ERROR_INVALID_PARAM;
+	} else {
+		return HACKRF_SUCCESS;
+	}
+}
+
+#define CONFIG_BUNDLE_MAX_LENGTH   32
+#define CONFIG_TAG_FREQ            1
+#define CONFIG_TAG_BASEBAND_FILTER 2
+#define CONFIG_TAG_LNA_GAIN        3
+#define CONFIG_TAG_VGA_GAIN        4
+#define CONFIG_TAG_TXVGA_GAIN      5
+#define CONFIG_TAG_AMP_ENABLE      6
+
+/* Flag for schedule_commands requests. */
+#define SCHEDULE_FLAG_CLEAR (1 << 0)
+
+/* Append a tag, length and little-endian value to a configuration bundle. */
+static int config_bundle_add(
+	unsigned char* const bundle,
+	int length,
+	const uint8_t tag,
+	const uint64_t value,
+	const uint8_t size)
+{
+	uint8_t i;
+
+	bundle[length++] = tag;
+	bundle[length++] = size;
+	for (i = 0; i < size; i++) {
+		bundle[length++] = (value >> (8 * i)) & 0xff;
+	}
+	return length;
+}
+
+/*
+ * Build the bundle for an apply_config request. Returns its length, or an
+ * error if a setting is out of range or none is selected.
+ */
+static int config_bundle_build(const hackrf_config* config, unsigned char* bundle)
+{
+	int length = 0;
+
+	if ((config == NULL) ||
+	    ((config->flags & HACKRF_CONFIG_LNA_GAIN) && (config->lna_gain > 40)) ||
+	    ((config->flags & HACKRF_CONFIG_VGA_GAIN) && (config->vga_gain > 62)) ||
+	    ((config->flags & HACKRF_CONFIG_TXVGA_GAIN) && (config->txvga_gain > 47))) {
+		return HACKRF_ERROR_INVALID_PARAM;
+	}
+
+	if (config->flags & HACKRF_CONFIG_FREQ) {
+		length = config_bundle_add(
+			bundle,
+			length,
+			CONFIG_TAG_FREQ,
+			config->freq_hz,
+			8);
+	}
+	if (config->flags & HACKRF_CONFIG_BASEBAND_FILTER) {
+		length = config_bundle_add(
+			bundle,
+			length,
+			CONFIG_TAG_BASEBAND_FILTER,
+			config->baseband_filter_bw_hz,
+			4);
+	}
+	if (config->flags & HACKRF_CONFIG_LNA_GAIN) {
+		length = config_bundle_add(
+			bundle,
+			length,
+			CONFIG_TAG_LNA_GAIN,
+			config->lna_gain & ~0x07,
+			1);
+	}
+	if (config->flags & HACKRF_CONFIG_VGA_GAIN) {
+		length = config_bundle_add(
+			bundle,
+			length,
+			CONFIG_TAG_VGA_GAIN,
+			config->vga_gain & ~0x01,
+			1);
+	}
+	if (config->flags & HACKRF_CONFIG_TXVGA_GAIN) {
+		length = config_bundle_add(
+			bundle,
+			length,
+			CONFIG_TAG_TXVGA_GAIN,
+			config->txvga_gain,
+			1);
+	}
+	if (config->flags & HACKRF_CONFIG_AMP_ENABLE) {
+		length = config_bundle_add(
+			bundle,
+			length,
+			CONFIG_TAG_AMP_ENABLE,
+			config->amp_enable ? 1 : 0,
+			1);
+	}
+	if (length == 0) {
+		return HACKRF_ERROR_INVALID_PARAM;
+	}
+	return length;
+}
+
+int ADDCALL hackrf_apply_config(hackrf_device* device, const hackrf_config* config)
+{
+	USB_API_REQUIRED(device, 0x0109)
+	unsigned char bundle[CONFIG_BUNDLE_MAX_LENGTH];
+	int length;
+	int result;
+
+	length = config_bundle_build(config, bundle);
+	if (length < 0) {
+		return length;
+	}
+
+	result = control_transfer(
+		device,
+		LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR |
+			LIBUSB_RECIPIENT_DEVICE,
+		HACKRF_VENDOR_REQUEST_APPLY_CONFIG,
+		0,
+		0,
+		bundle,
+		length,
+		0);
+
+	if (result < length) {
+		last_libusb_error = result;
+		return HACKRF_ERROR_LIBUSB;
+	} else {
+		return HACKRF_SUCCESS;
+	}
+}
+
+/*
+ * Convert a scheduled command for the firmware, rounding gains down as the
+ * individual setters do.
+ */
+static int command_build(const hackrf_command* command, command_t* out)
+{
+	uint8_t port_a, port_b;
+
+	out->when = command->when;
+	out->type = command->type;
+	out->value = command->value;
+
+	switch (command->type) {
+	case HACKRF_COMMAND_LNA_GAIN:
+		out->value &= ~0x07;
+		break;
+	case HACKRF_COMMAND_VGA_GAIN:
+		out->value &= ~0x01;
+		break;
+	case HACKRF_COMMAND_AMP_ENABLE:
+		out->value = command->value ? 1 : 0;
+		break;
+	case HACKRF_COMMAND_OPERACAKE_PORTS:
+		port_a = (command->value >> 8) & 0xff;
+		port_b = (command->value >> 16) & 0xff;
+		if (!hackrf_operacake_valid_address(command->value & 0xff) ||
+		    (port_a > OPERACAKE_PB4) || (port_b > OPERACAKE_PB4) ||
+		    ((port_a <= OPERACAKE_PA4) == (port_b <= OPERACAKE_PA4))) {
+			return HACKRF_ERROR_INVALID_PARAM;
+		}
+		break;
+	default:
+		break;
+	}
+
+	if (!command_valid(out)) {
+		return HACKRF_ERROR_INVALID_PARAM;
+	}
+	return HACKRF_SUCCESS;
+}
+
+static int schedule_commands(
+	hackrf_device* device,
+	const hackrf_command* commands,
+	const int count,
+	const uint16_t flags)
+{
+	unsigned char data[COMMAND_QUEUE_SIZE * COMMAND_SIZE];
+	command_t command;
+	int length = count * COMMAND_SIZE;
+	int result;
+	int i;
+
+	if ((count < 0) || (count > COMMAND_QUEUE_SIZE) ||
+	    ((count > 0) && (commands == NULL))) {
+		return HACKRF_ERROR_INVALID_PARAM;
+	}
+	for (i = 0; i < count; i++) {
+		result = command_build(&commands[i], &command);
+		if (result != HACKRF_SUCCESS) {
+			return result;
+		}
+		command_pack(&command, &data[i * COMMAND_SIZE]);
+	}
+
+	result = control_transfer(
+		device,
+		LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR |
+			LIBUSB_RECIPIENT_DEVICE,
+		HACKRF_VENDOR_REQUEST_SCHEDULE_COMMANDS,
+		flags,
+		0,
+		data,
+		length,
+		0);
+
+	if (result < length) {
+		last_libusb_error = result;
+		return HACKRF_ERROR_LIBUSB;
+	} else {
+		return HACKRF_SUCCESS;
+	}
+}
+
+int ADDCALL hackrf_schedule_command(hackrf_device* device, const hackrf_command* command)
+{
+	USB_API_REQUIRED(device, 0x0109)
+	if (command == NULL) {
+		return HACKRF_ERROR_INVALID_PARAM;
+	}
+	return schedule_commands(device, command, 1, 0);
+}
+
+int ADDCALL hackrf_schedule_commands(
+	hackrf_device* device,
+	const hackrf_command* commands,
+	const int count)
+{
+	USB_API_REQUIRED(device, 0x0109)
+	if (count == 0) {
+		return HACKRF_ERROR_INVALID_PARAM;
+	}
+	return schedule_commands(device, commands, count, 0);
+}
+
+int ADDCALL hackrf_clear_commands(hackrf_device* device)
+{
+	USB_API_REQUIRED(device, 0x0109)
+	return schedule_commands(device, NULL, 0, SCHEDULE_FLAG_CLEAR);
+}
+
+typedef struct {
+	hackrf_device* device;
+	hackrf_control_cb_fn callback;
+	void* ctx;
+	uint16_t length;
+	bool check_retval;  /* IN requests that return a non-zero byte on success */
+	uint64_t submit_ns; /* 0 unless the request is traced */
+} control_async_t;
+
+static void LIBUSB_CALL hackrf_libusb_control_callback(
+	struct libusb_transfer* usb_transfer)
+{
+	control_async_t* request = (control_async_t*) usb_transfer->user_data;
+	hackrf_device* device = request->device;
+	struct libusb_control_setup* setup;
+	int result = HACKRF_SUCCESS;
+	int usb_result;
+
+	switch (usb_transfer->status) {
+	case LIBUSB_TRANSFER_COMPLETED:
+		usb_result = usb_transfer->actual_length;
+		if (usb_transfer->actual_length < request->length) {
+			result = HACKRF_ERROR_LIBUSB;
+		} else if (
+			request->check_retval &&
+			!libusb_control_transfer_get_data(usb_transfer)[0]) {
+			result = HACKRF_ERROR_INVALID_PARAM;
+		}
+		break;
+	case LIBUSB_TRANSFER_TIMED_OUT:
+		usb_result = LIBUSB_ERROR_TIMEOUT;
+		result = HACKRF_ERROR_LIBUSB;
+		break;
+	case LIBUSB_TRANSFER_STALL:
+		usb_result = LIBUSB_ERROR_PIPE;
+		result = HACKRF_ERROR_LIBUSB;
+		break;
+	case LIBUSB_TRANSFER_NO_DEVICE:
+		usb_result = LIBUSB_ERROR_NO_DEVICE;
+		result = HACKRF_ERROR_LIBUSB;
+		break;
+	default:
+		usb_result = LIBUSB_ERROR_IO;
+		result = HACKRF_ERROR_LIBUSB;
+		break;
+	}
+	if (result == HACKRF_ERROR_LIBUSB) {
+		last_libusb_error = usb_result;
+	}
+
+	if (request->submit_ns != 0) {
+		setup = libusb_control_transfer_get_setup(usb_transfer);
+		trace_record(
+			device,
+			setup->bmRequestType,
+			setup->bRequest,
+			libusb_le16_to_cpu(setup->wValue),
+			libusb_le16_to_cpu(setup->wIndex),
+			request->length,
+			usb_result,
+			true,
+			request->submit_ns);
+	}
+
+	if (request->callback != NULL) {
+		request->callback(device, result, request->ctx);
+	}
+	free(request);
+
+	pthread_mutex_lock(&device->transfer_lock);
+	device->active_control_transfers--;
+	pthread_cond_broadcast(&device->all_finished_cv);
+	pthread_mutex_unlock(&device->transfer_lock);
+}
+
+/*
+ * Submit a vendor request without waiting for it. The transfer thread
+ * calls the callback on completion, then libusb frees the transfer and
+ * its buffer.
+ */
+static int control_transfer_async(
+	hackrf_device* device,
+	const uint8_t direction,
+	const uint8_t vendor_request,
+	const uint16_t value,
+	const uint16_t index,
+	const unsigned char* data,
+	const uint16_t length,
+	const bool check_retval,
+	hackrf_control_cb_fn callback,
+	void* ctx)
+{
+	struct libusb_transfer* usb_transfer;
+	control_async_t* request;
+	unsigned char* buffer;
+	int result;
+
+	usb_transfer = libusb_alloc_transfer(0);
+	buffer = (unsigned char*) calloc(1, LIBUSB_CONTROL_SETUP_SIZE + length);
+	request = (control_async_t*) malloc(sizeof(*request));
+	if ((usb_transfer == NULL) || (buffer == NULL) || (request == NULL)) {
+		libusb_free_transfer(usb_transfer);
+		free(buffer);
+		free(request);
+		return HACKRF_ERROR_NO_MEM;
+	}
+
+	request->device = device;
+	request->callback = callback;
+	request->ctx = ctx;
+	request->length = length;
+	request->check_retval = check_retval;
+	request->submit_ns = 0;
+
+	libusb_fill_control_setup(
+		buffer,
+		direction | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
+		vendor_request,
+		value,
+		index,
+		length);
+	if ((direction == LIBUSB_ENDPOINT_OUT) && (length > 0)) {
+		memcpy(buffer + LIBUSB_CONTROL_SETUP_SIZE, data, length);
+	}
+	libusb_fill_control_transfer(
+		usb_transfer,
+		device->usb_device,
+		buffer,
+		hackrf_libusb_control_callback,
+		request,
+		device->control_timeout_ms);
+	usb_transfer->flags = LIBUSB_TRANSFER_FREE_BUFFER | LIBUSB_TRANSFER_FREE_TRANSFER;
+
+	pthread_mutex_lock(&device->transfer_lock);
+	device->active_control_transfers++;
+	pthread_mutex_unlock(&device->transfer_lock);
+
+	if (device->trace_enabled) {
+		request->submit_ns = trace_time_ns();
+	}
+	result = libusb_submit_transfer(usb_transfer);
+	if (result != 0) {
+		pthread_mutex_lock(&device->transfer_lock);
+		device->active_control_transfers--;
+		pthread_mutex_unlock(&device->transfer_lock);
+		free(request);
+		libusb_free_transfer(usb_transfer);
+		last_libusb_error = result;
+		return HACKRF_ERROR_LIBUSB;
+	}
+	return HACKRF_SUCCESS;
+}
+
+int ADDCALL hackrf_set_control_timeout(hackrf_device* device, const uint32_t timeout_ms)
+{
+	// libusb treats 0 as no timeout, which would let hackrf_close() wait forever.
+	if (timeout_ms == 0) {
+		return HACKRF_ERROR_INVALID_PARAM;
+	}
+	device->control_timeout_ms = timeout_ms;
+	return HACKRF_SUCCESS;
+}
+
+int ADDCALL hackrf_set_freq_async(
+	hackrf_device* device,
+	const uint64_t freq_hz,
+	hackrf_control_cb_fn callback,
+	void* ctx)
+{
+	set_freq_params_t set_freq_params;
+
+	set_freq_params_fill(freq_hz, &set_freq_params);
+	return control_transfer_async(
+		device,
+		LIBUSB_ENDPOINT_OUT,
+		HACKRF_VENDOR_REQUEST_SET_FREQ,
+		0,
+		0,
+		(unsigned char*) &set_freq_params,
+		sizeof(set_freq_params),
+		false,
+		callback,
+		ctx);
+}
+
+int ADDCALL hackrf_set_baseband_filter_bandwidth_async(
+	hackrf_device* device,
+	const uint32_t bandwidth_hz,
+	hackrf_control_cb_fn callback,
+	void* ctx)
+{
+	return control_transfer_async(
+		device,
+		LIBUSB_ENDPOINT_OUT,
+		HACKRF_VENDOR_REQUEST_BASEBAND_FILTER_BANDWIDTH_SET,
+		bandwidth_hz & 0xffff,
+		bandwidth_hz >> 16,
+		NULL,
+		0,
+		false,
+		callback,
+		ctx);
+}
+
+int ADDCALL hackrf_set_amp_enable_async(
+	hackrf_device* device,
+	const uint8_t value,
+	hackrf_control_cb_fn callback,
+	void* ctx)
+{
+	return control_transfer_async(
+		device,
+		LIBUSB_ENDPOINT_OUT,
+		HACKRF_VENDOR_REQUEST_AMP_ENABLE,
+		value,
+		0,
+		NULL,
+		0,
+		false,
+		callback,
+		ctx);
+}
+
+int ADDCALL hackrf_set_lna_gain_async(
+	hackrf_device* device,
+	uint32_t value,
+	hackrf_control_cb_fn callback,
+	void* ctx)
+{
+	if (value > 40) {
+		return HACKRF_ERROR_INVALID_PARAM;
+	}
+
+	value &= ~0x07;
+	return control_transfer_async(
+		device,
+		LIBUSB_ENDPOINT_IN,
+		HACKRF_VENDOR_REQUEST_SET_LNA_GAIN,
+		0,
+		value,
+		NULL,
+		1,
+		true,
+		callback,
+		ctx);
+}
+
+int ADDCALL hackrf_set_vga_gain_async(
+	hackrf_device* device,
+	uint32_t value,
+	hackrf_control_cb_fn callback,
+	void* ctx)
+{
+	if (value > 62) {
+		return HACKRF_ERROR_INVALID_PARAM;
+	}
+
+	value &= ~0x01;
+	return control_transfer_async(
+		device,
+		LIBUSB_ENDPOINT_IN,
+		HACKRF_VENDOR_REQUEST_SET_VGA_GAIN,
+		0,
+		value,
+		NULL,
+		1,
+		true,
+		callback,
+		ctx);
+}
+
+int ADDCALL hackrf_set_txvga_gain_async(
+	hackrf_device* device,
+	uint32_t value,
+	hackrf_control_cb_fn callback,
+	void* ctx)
+{
+	if (value > 47) {
+		return HACKRF_ERROR_INVALID_PARAM;
+	}
+
+	return control_transfer_async(
+		device,
+		LIBUSB_ENDPOINT_IN,
+		HACKRF_VENDOR_REQUEST_SET_TXVGA_GAIN,
+		0,
+		value,
+		NULL,
+		1,
+		true,
+		callback,
+		ctx);
+}
+
+int ADDCALL hackrf_apply_config_async(
+	hackrf_device* device,
+	const hackrf_config* config,
+	hackrf_control_cb_fn callback,
+	void* ctx)
+{
+	USB_API_REQUIRED(device, 0x0109)
+	unsigned char bundle[CONFIG_BUNDLE_MAX_LENGTH];
+	int length;
+
+	length = config_bundle_build(config, bundle);
+	if (length < 0) {
+		return length;
 	}
+
+	return control_transfer_async(
+		device,
+		LIBUSB_ENDPOINT_OUT,
+		HACKRF_VENDOR_REQUEST_APPLY_CONFIG,
+		0,
+		0,
+		bundle,
+		length,
+		false,
+		callback,
+		ctx);
 }
 
 int ADDCALL hackrf_set_antenna_enable(hackrf_device* device, const uint8_t value)
 {
 	int result;
-	result = libusb_control_transfer(
-		device->usb_device,
+	result = control_transfer(
+		device,
 		LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR |
 			LIBUSB_RECIPIENT_DEVICE,
 		HACKRF_VENDOR_REQUEST_ANTENNA_ENABLE,
@@ -2109,8 +3695,29 @@ int ADDCALL hackrf_close(hackrf_device* device)
 	result2 = HACKRF_SUCCESS;
 
 	if (device != NULL) {
+		/*
+		 * The transfer thread can't wait for its own callbacks to
+		 * finish, or join itself.
+		 */
+		if (device->transfer_thread_started &&
+		    pthread_equal(pthread_self(), device->transfer_thread)) {
+			return HACKRF_ERROR_THREAD;
+		}
+
 		result1 = hackrf_stop_cmd(device);
 
+		/*
+		 * Let asynchronous control transfers complete or time out.
+		 * Each has a nonzero timeout, so this wait is bounded.
+		 */
+		pthread_mutex_lock(&device->transfer_lock);
+		while (device->active_control_transfers > 0) {
+			pthread_cond_wait(
+				&device->all_finished_cv,
+				&device->transfer_lock);
+		}
+		pthread_mutex_unlock(&device->transfer_lock);
+
 		/*
 		 * Finally kill the transfer thread, which will
 		 * also cancel any pending transmit/receive transfers.
@@ -2127,6 +3734,7 @@ int ADDCALL hackrf_close(hackrf_device* device)
 		pthread_mutex_destroy(&device->transfer_lock);
 		pthread_cond_destroy(&device->all_finished_cv);
 
+		free(device->trace_slots);
 		free(device);
 	}
 	open_devices--;
@@ -2275,6 +3883,126 @@ const char* ADDCALL hackrf_filter_path_name(const enum rf_path_filter path)
 	}
 }
 
+const char* ADDCALL hackrf_vendor_request_name(const uint8_t request)
+{
+	switch (request) {
+	case HACKRF_VENDOR_REQUEST_SET_TRANSCEIVER_MODE:
+		return "set_transceiver_mode";
+	case HACKRF_VENDOR_REQUEST_MAX2837_WRITE:
+		return "max2837_write";
+	case HACKRF_VENDOR_REQUEST_MAX2837_READ:
+		return "max2837_read";
+	case HACKRF_VENDOR_REQUEST_SI5351C_WRITE:
+		return "si5351c_write";
+	case HACKRF_VENDOR_REQUEST_SI5351C_READ:
+		return "si5351c_read";
+	case HACKRF_VENDOR_REQUEST_SAMPLE_RATE_SET:
+		return "sample_rate_set";
+	case HACKRF_VENDOR_REQUEST_BASEBAND_FILTER_BANDWIDTH_SET:
+		return "baseband_filter_bandwidth_set";
+	case HACKRF_VENDOR_REQUEST_RFFC5071_WRITE:
+		return "rffc5071_write";
+	case HACKRF_VENDOR_REQUEST_RFFC5071_READ:
+		return "rffc5071_read";
+	case HACKRF_VENDOR_REQUEST_SPIFLASH_ERASE:
+		return "spiflash_erase";
+	case HACKRF_VENDOR_REQUEST_SPIFLASH_WRITE:
+		return "spiflash_write";
+	case HACKRF_VENDOR_REQUEST_SPIFLASH_READ:
+		return "spiflash_read";
+	case HACKRF_VENDOR_REQUEST_BOARD_ID_READ:
+		return "board_id_read";
+	case HACKRF_VENDOR_REQUEST_VERSION_STRING_READ:
+		return "version_string_read";
+	case HACKRF_VENDOR_REQUEST_SET_FREQ:
+		return "set_freq";
+	case HACKRF_VENDOR_REQUEST_AMP_ENABLE:
+		return "amp_enable";
+	case HACKRF_VENDOR_REQUEST_BOARD_PARTID_SERIALNO_READ:
+		return "board_partid_serialno_read";
+	case HACKRF_VENDOR_REQUEST_SET_LNA_GAIN:
+		return "set_lna_gain";
+	case HACKRF_VENDOR_REQUEST_SET_VGA_GAIN:
+		return "set_vga_gain";
+	case HACKRF_VENDOR_REQUEST_SET_TXVGA_GAIN:
+		return "set_txvga_gain";
+	case HACKRF_VENDOR_REQUEST_ANTENNA_ENABLE:
+		return "antenna_enable";
+	case HACKRF_VENDOR_REQUEST_SET_FREQ_EXPLICIT:
+		return "set_freq_explicit";
+	case HACKRF_VENDOR_REQUEST_USB_WCID_VENDOR_REQ:
+		return "usb_wcid_vendor_req";
+	case HACKRF_VENDOR_REQUEST_INIT_SWEEP:
+		return "init_sweep";
+	case HACKRF_VENDOR_REQUEST_OPERACAKE_GET_BOARDS:
+		return "operacake_get_boards";
+	case HACKRF_VENDOR_REQUEST_OPERACAKE_SET_PORTS:
+		return "operacake_set_ports";
+	case HACKRF_VENDOR_REQUEST_SET_HW_SYNC_MODE:
+		return "set_hw_sync_mode";
+	case HACKRF_VENDOR_REQUEST_RESET:
+		return "reset";
+	case HACKRF_VENDOR_REQUEST_OPERACAKE_SET_RANGES:
+		return "operacake_set_ranges";
+	case HACKRF_VENDOR_REQUEST_CLKOUT_ENABLE:
+		return "clkout_enable";
+	case HACKRF_VENDOR_REQUEST_SPIFLASH_STATUS:
+		return "spiflash_status";
+	case HACKRF_VENDOR_REQUEST_SPIFLASH_CLEAR_STATUS:
+		return "spiflash_clear_status";
+	case HACKRF_VENDOR_REQUEST_OPERACAKE_GPIO_TEST:
+		return "operacake_gpio_test";
+	case HACKRF_VENDOR_REQUEST_CPLD_CHECKSUM:
+		return "cpld_checksum";
+	case HACKRF_VENDOR_REQUEST_UI_ENABLE:
+		return "ui_enable";
+	case HACKRF_VENDOR_REQUEST_OPERACAKE_SET_MODE:
+		return "operacake_set_mode";
+	case HACKRF_VENDOR_REQUEST_OPERACAKE_GET_MODE:
+		return "operacake_get_mode";
+	case HACKRF_VENDOR_REQUEST_OPERACAKE_SET_DWELL_TIMES:
+		return "operacake_set_dwell_times";
+	case HACKRF_VENDOR_REQUEST_GET_M0_STATE:
+		return "get_m0_state";
+	case HACKRF_VENDOR_REQUEST_SET_TX_UNDERRUN_LIMIT:
+		return "set_tx_underrun_limit";
+	case HACKRF_VENDOR_REQUEST_SET_RX_OVERRUN_LIMIT:
+		return "set_rx_overrun_limit";
+	case HACKRF_VENDOR_REQUEST_GET_CLKIN_STATUS:
+		return "get_clkin_status";
+	case HACKRF_VENDOR_REQUEST_BOARD_REV_READ:
+		return "board_rev_read";
+	case HACKRF_VENDOR_REQUEST_SUPPORTED_PLATFORM_READ:
+		return "supported_platform_read";
+	case HACKRF_VENDOR_REQUEST_SET_LEDS:
+		return "set_leds";
+	case HACKRF_VENDOR_REQUEST_SET_USER_BIAS_T_OPTS:
+		return "set_user_bias_t_opts";
+	case HACKRF_VENDOR_REQUEST_SET_SWEEP_TIMING:
+		return "set_sweep_timing";
+	case HACKRF_VENDOR_REQUEST_SET_TUNING_TABLE:
+		return "set_tuning_table";
+	case HACKRF_VENDOR_REQUEST_INIT_SWEEP_LIST:
+		return "init_sweep_list";
+	case HACKRF_VENDOR_REQUEST_SET_SWEEP_SPECTRUM:
+		return "set_sweep_spectrum";
+	case HACKRF_VENDOR_REQUEST_SPIFLASH_PROGRAM:
+		return "spiflash_program";
+	case HACKRF_VENDOR_REQUEST_SPIFLASH_PROGRAM_STATUS:
+		return "spiflash_program_status";
+	case HACKRF_VENDOR_REQUEST_APPLY_CONFIG:
+		return "apply_config";
+	case HACKRF_VENDOR_REQUEST_SCHEDULE_COMMANDS:
+		return "schedule_commands";
+	case HACKRF_VENDOR_REQUEST_SET_HOP_TABLE:
+		return "set_hop_table";
+	case HACKRF_VENDOR_REQUEST_GET_M0_TELEMETRY:
+		return "get_m0_telemetry";
+	default:
+		return "unknown";
+	}
+}
+
 /* Return final bw round down and less than expected bw. */
 uint32_t ADDCALL hackrf_compute_baseband_filter_bw_round_down_lt(
 	const uint32_t bandwidth_hz)
@@ -2318,8 +4046,8 @@ uint32_t ADDCALL hackrf_compute_baseband_filter_bw(const uint32_t bandwidth_hz)
 int ADDCALL hackrf_set_hw_sync_mode(hackrf_device* device, const uint8_t value)
 {
 	USB_API_REQUIRED(device, 0x0102)
-	int result = libusb_control_transfer(
-		device->usb_device,
+	int result = control_transfer(
+		device,
 		LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR |
 			LIBUSB_RECIPIENT_DEVICE,
 		HACKRF_VENDOR_REQUEST_SET_HW_SYNC_MODE,
@@ -2369,11 +4097,11 @@ int ADDCALL hackrf_init_sweep(
 		return HACKRF_ERROR_INVALID_PARAM;
 	}
 
-	if (num_bytes % BYTES_PER_BLOCK) {
+	if (num_bytes % MIN_BYTES_PER_BLOCK) {
 		return HACKRF_ERROR_INVALID_PARAM;
 	}
 
-	if (BYTES_PER_BLOCK > num_bytes) {
+	if (MIN_BYTES_PER_BLOCK > num_bytes) {
 		return HACKRF_ERROR_INVALID_PARAM;
 	}
 
@@ -2385,6 +4113,11 @@ int ADDCALL hackrf_init_sweep(
 		return HACKRF_ERROR_INVALID_PARAM;
 	}
 
+	/* Interleaved tunings are a quarter and three quarters of a step apart. */
+	if ((INTERLEAVED == style) && (step_width % 4)) {
+		return HACKRF_ERROR_INVALID_PARAM;
+	}
+
 	data[0] = step_width & 0xff;
 	data[1] = (step_width >> 8) & 0xff;
 	data[2] = (step_width >> 16) & 0xff;
@@ -2399,8 +4132,8 @@ int ADDCALL hackrf_init_sweep(
 		data[10 + i * 2] = (frequency_list[i] >> 8) & 0xff;
 	}
 
-	result = libusb_control_transfer(
-		device->usb_device,
+	result = control_transfer(
+		device,
 		LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR |
 			LIBUSB_RECIPIENT_DEVICE,
 		HACKRF_VENDOR_REQUEST_INIT_SWEEP,
@@ -2418,6 +4151,307 @@ int ADDCALL hackrf_init_sweep(
 	}
 }
 
+/* Entries per control transfer when sending a sweep list. */
+#define SWEEP_LIST_CHUNK 64
+
+/* Highest frequency the firmware tunes to, 7250MHz and any fraction of a MHz. */
+#define MAX_TUNED_FREQ_HZ 7250999999ULL
+
+int ADDCALL hackrf_init_sweep_list(
+	hackrf_device* device,
+	const hackrf_sweep_entry* entries,
+	const int num_entries,
+	const uint32_t offset)
+{
+	USB_API_REQUIRED(device, 0x0109)
+	int result, i, j, first, chunk, size;
+	unsigned char data[8 + SWEEP_LIST_CHUNK * 12];
+	unsigned char* entry;
+	uint64_t frequency;
+	uint32_t dwell;
+
+	if ((num_entries < 1) || (num_entries > MAX_SWEEP_LIST_ENTRIES)) {
+		return HACKRF_ERROR_INVALID_PARAM;
+	}
+
+	for (i = 0; i < num_entries; i++) {
+		if ((MIN_BYTES_PER_BLOCK > entries[i].dwell) ||
+		    (entries[i].dwell % MIN_BYTES_PER_BLOCK) ||
+		    (entries[i].frequency > (MAX_TUNED_FREQ_HZ - offset))) {
+			return HACKRF_ERROR_INVALID_PARAM;
+		}
+	}
+
+	/*
+	 * Each request repeats the header, and the firmware starts using the
+	 * list once the last entry has arrived.
+	 */
+	data[0] = offset & 0xff;
+	data[1] = (offset >> 8) & 0xff;
+	data[2] = (offset >> 16) & 0xff;
+	data[3] = (offset >> 24) & 0xff;
+	data[6] = num_entries & 0xff;
+	data[7] = (num_entries >> 8) & 0xff;
+	for (first = 0; first < num_entries; first += chunk) {
+		chunk = num_entries - first;
+		if (chunk > SWEEP_LIST_CHUNK) {
+			chunk = SWEEP_LIST_CHUNK;
+		}
+		data[4] = first & 0xff;
+		data[5] = (first >> 8) & 0xff;
+		for (i = 0; i < chunk; i++) {
+			entry = &data[8 + i * 12];
+			frequency = entries[first + i].frequency;
+			dwell = entries[first + i].dwell;
+			for (j = 0; j < 8; j++) {
+				entry[j] = (frequency >> (8 * j)) & 0xff;
+			}
+			for (j = 0; j < 4; j++) {
+				entry[8 + j] = (dwell >> (8 * j)) & 0xff;
+			}
+		}
+		size = 8 + chunk * 12;
+
+		result = control_transfer(
+			device,
+			LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR |
+				LIBUSB_RECIPIENT_DEVICE,
+			HACKRF_VENDOR_REQUEST_INIT_SWEEP_LIST,
+			0,
+			0,
+			data,
+			size,
+			0);
+
+		if (result < size) {
+			last_libusb_error = result;
+			return HACKRF_ERROR_LIBUSB;
+		}
+	}
+
+	return HACKRF_SUCCESS;
+}
+
+int ADDCALL hackrf_set_sweep_timing(
+	hackrf_device* device,
+	const uint32_t block_bytes,
+	const uint32_t settle_samples)
+{
+	USB_API_REQUIRED(device, 0x0109)
+	int result;
+
+	if ((MIN_BYTES_PER_BLOCK > block_bytes) || (BYTES_PER_BLOCK < block_bytes) ||
+	    (block_bytes & (block_bytes - 1))) {
+		return HACKRF_ERROR_INVALID_PARAM;
+	}
+
+	if (0xffff < settle_samples) {
+		return HACKRF_ERROR_INVALID_PARAM;
+	}
+
+	result = control_transfer(
+		device,
+		LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR |
+			LIBUSB_RECIPIENT_DEVICE,
+		HACKRF_VENDOR_REQUEST_SET_SWEEP_TIMING,
+		settle_samples,
+		block_bytes,
+		NULL,
+		0,
+		0);
+
+	if (result != 0) {
+		last_libusb_error = result;
+		return HACKRF_ERROR_LIBUSB;
+	} else {
+		return HACKRF_SUCCESS;
+	}
+}
+
+int ADDCALL hackrf_set_sweep_spectrum(hackrf_device* device, const uint16_t fft_size)
+{
+	USB_API_REQUIRED(device, 0x0109)
+	spectrum_t spectrum;
+	int result;
+
+	if ((0 != fft_size) && !spectrum_init(&spectrum, fft_size)) {
+		return HACKRF_ERROR_INVALID_PARAM;
+	}
+
+	result = control_transfer(
+		device,
+		LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR |
+			LIBUSB_RECIPIENT_DEVICE,
+		HACKRF_VENDOR_REQUEST_SET_SWEEP_SPECTRUM,
+		fft_size,
+		0,
+		NULL,
+		0,
+		0);
+
+	if (result != 0) {
+		last_libusb_error = result;
+		return HACKRF_ERROR_LIBUSB;
+	} else {
+		return HACKRF_SUCCESS;
+	}
+}
+
+int ADDCALL hackrf_compute_sweep_spectrum(
+	const int8_t* samples,
+	const uint32_t block_bytes,
+	const uint32_t num_blocks,
+	const uint16_t fft_size,
+	const uint64_t frequency,
+	uint8_t* record)
+{
+	spectrum_t spectrum;
+	uint32_t i;
+
+	if ((NULL == samples) || (NULL == record) ||
+	    !spectrum_init(&spectrum, fft_size)) {
+		return HACKRF_ERROR_INVALID_PARAM;
+	}
+
+	for (i = 0; i < num_blocks; i++) {
+		spectrum_add_block(&spectrum, &samples[i * block_bytes], block_bytes);
+	}
+	spectrum_write_record(&spectrum, frequency, record);
+
+	return HACKRF_SUCCESS;
+}
+
+/* Entries per control transfer when uploading the tuning table. */
+#define TUNING_TABLE_CHUNK 32
+
+int ADDCALL hackrf_set_tuning_table(
+	hackrf_device* device,
+	const uint64_t* frequencies,
+	const int count)
+{
+	USB_API_REQUIRED(device, 0x0109)
+	int result, i, first, chunk, size;
+	uint64_t data[TUNING_TABLE_CHUNK];
+
+	if ((count < 0) || (count > MAX_TUNING_TABLE_ENTRIES) ||
+	    ((count > 0) && (frequencies == NULL))) {
+		return HACKRF_ERROR_INVALID_PARAM;
+	}
+
+	/*
+	 * The firmware plans the settings for each frequency once the last
+	 * chunk arrives. Each request carries the length of the whole table,
+	 * the chunks are sent in order, and an empty table clears it.
+	 */
+	first = 0;
+	do {
+		chunk = count - first;
+		if (chunk > TUNING_TABLE_CHUNK) {
+			chunk = TUNING_TABLE_CHUNK;
+		}
+		for (i = 0; i < chunk; i++) {
+			if (frequencies[first + i] > MAX_TUNED_FREQ_HZ) {
+				return HACKRF_ERROR_INVALID_PARAM;
+			}
+			data[i] = TO_LE64(frequencies[first + i]);
+		}
+		size = chunk * sizeof(data[0]);
+
+		result = control_transfer(
+			device,
+			LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR |
+				LIBUSB_RECIPIENT_DEVICE,
+			HACKRF_VENDOR_REQUEST_SET_TUNING_TABLE,
+			first,
+			count,
+			(unsigned char*) data,
+			size,
+			0);
+
+		if (result < size) {
+			last_libusb_error = result;
+			return HACKRF_ERROR_LIBUSB;
+		}
+		first += chunk;
+	} while (first < count);
+
+	return HACKRF_SUCCESS;
+}
+
+/* Entries per control transfer when uploading the hop table. */
+#define HOP_TABLE_CHUNK 32
+
+int ADDCALL hackrf_set_hop_table(
+	hackrf_device* device,
+	const hackrf_hop_entry* entries,
+	const int count,
+	const uint16_t gap_samples)
+{
+	USB_API_REQUIRED(device, 0x0109)
+	int result, i, first, chunk, size;
+	uint64_t frequencies[MAX_HOP_TABLE_ENTRIES];
+	unsigned char data[HOP_TABLE_CHUNK * HOP_ENTRY_SIZE];
+	hop_entry_t entry;
+
+	if ((count < 0) || (count > MAX_HOP_TABLE_ENTRIES) ||
+	    ((count > 0) && (entries == NULL)) || !hop_samples_valid(gap_samples)) {
+		return HACKRF_ERROR_INVALID_PARAM;
+	}
+	for (i = 0; i < count; i++) {
+		frequencies[i] = entries[i].freq_hz;
+	}
+
+	result = hackrf_set_tuning_table(device, frequencies, count);
+	if (result != HACKRF_SUCCESS) {
+		return result;
+	}
+
+	first = 0;
+	do {
+		chunk = count - first;
+		if (chunk > HOP_TABLE_CHUNK) {
+			chunk = HOP_TABLE_CHUNK;
+		}
+		for (i = 0; i < chunk; i++) {
+			entry.freq = entries[first + i].freq_hz;
+			entry.dwell = entries[first + i].dwell_samples;
+			entry.lna_gain = entries[first + i].lna_gain;
+			if (entry.lna_gain != HOP_GAIN_UNCHANGED) {
+				entry.lna_gain &= ~0x07;
+			}
+			entry.vga_gain = entries[first + i].vga_gain;
+			if (entry.vga_gain != HOP_GAIN_UNCHANGED) {
+				entry.vga_gain &= ~0x01;
+			}
+			entry.txvga_gain = entries[first + i].txvga_gain;
+			if (!hop_entry_valid(&entry)) {
+				return HACKRF_ERROR_INVALID_PARAM;
+			}
+			hop_entry_pack(&entry, &data[i * HOP_ENTRY_SIZE]);
+		}
+		size = chunk * HOP_ENTRY_SIZE;
+
+		result = control_transfer(
+			device,
+			LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR |
+				LIBUSB_RECIPIENT_DEVICE,
+			HACKRF_VENDOR_REQUEST_SET_HOP_TABLE,
+			first,
+			gap_samples,
+			data,
+			size,
+			0);
+
+		if (result < size) {
+			last_libusb_error = result;
+			return HACKRF_ERROR_LIBUSB;
+		}
+		first += chunk;
+	} while (first < count);
+
+	return HACKRF_SUCCESS;
+}
+
 bool hackrf_operacake_valid_address(uint8_t address)
 {
 	return address < HACKRF_OPERACAKE_MAX_BOARDS;
@@ -2434,8 +4468,8 @@ int ADDCALL hackrf_get_operacake_boards(hackrf_device* device, uint8_t* boards)
 {
 	USB_API_REQUIRED(device, 0x0105)
 	int result;
-	result = libusb_control_transfer(
-		device->usb_device,
+	result = control_transfer(
+		device,
 		LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
 		HACKRF_VENDOR_REQUEST_OPERACAKE_GET_BOARDS,
 		0,
@@ -2472,8 +4506,8 @@ int ADDCALL hackrf_set_operacake_mode(
 	}
 
 	int result;
-	result = libusb_control_transfer(
-		device->usb_device,
+	result = control_transfer(
+		device,
 		LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR |
 			LIBUSB_RECIPIENT_DEVICE,
 		HACKRF_VENDOR_REQUEST_OPERACAKE_SET_MODE,
@@ -2512,8 +4546,8 @@ int ADDCALL hackrf_get_operacake_mode(
 
 	int result;
 	uint8_t buf;
-	result = libusb_control_transfer(
-		device->usb_device,
+	result = control_transfer(
+		device,
 		LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
 		HACKRF_VENDOR_REQUEST_OPERACAKE_GET_MODE,
 		address,
@@ -2554,8 +4588,8 @@ int ADDCALL hackrf_set_operacake_ports(
 	    ((port_a > OPERACAKE_PA4) && (port_b > OPERACAKE_PA4))) {
 		return HACKRF_ERROR_INVALID_PARAM;
 	}
-	result = libusb_control_transfer(
-		device->usb_device,
+	result = control_transfer(
+		device,
 		LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR |
 			LIBUSB_RECIPIENT_DEVICE,
 		HACKRF_VENDOR_REQUEST_OPERACAKE_SET_PORTS,
@@ -2576,8 +4610,8 @@ int ADDCALL hackrf_set_operacake_ports(
 int ADDCALL hackrf_reset(hackrf_device* device)
 {
 	USB_API_REQUIRED(device, 0x0102)
-	int result = libusb_control_transfer(
-		device->usb_device,
+	int result = control_transfer(
+		device,
 		LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR |
 			LIBUSB_RECIPIENT_DEVICE,
 		HACKRF_VENDOR_REQUEST_RESET,
@@ -2606,8 +4640,8 @@ int ADDCALL hackrf_set_operacake_ranges(
 	USB_API_REQUIRED(device, 0x0103)
 
 	int result;
-	result = libusb_control_transfer(
-		device->usb_device,
+	result = control_transfer(
+		device,
 		LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR |
 			LIBUSB_RECIPIENT_DEVICE,
 		HACKRF_VENDOR_REQUEST_OPERACAKE_SET_RANGES,
@@ -2647,8 +4681,8 @@ int ADDCALL hackrf_set_operacake_freq_ranges(
 
 	int result;
 	int len_ranges = count * 5;
-	result = libusb_control_transfer(
-		device->usb_device,
+	result = control_transfer(
+		device,
 		LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR |
 			LIBUSB_RECIPIENT_DEVICE,
 		HACKRF_VENDOR_REQUEST_OPERACAKE_SET_RANGES,
@@ -2689,8 +4723,8 @@ int ADDCALL hackrf_set_operacake_dwell_times(
 
 	int data_len = count * DWELL_TIME_SIZE;
 	int result;
-	result = libusb_control_transfer(
-		device->usb_device,
+	result = control_transfer(
+		device,
 		LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR |
 			LIBUSB_RECIPIENT_DEVICE,
 		HACKRF_VENDOR_REQUEST_OPERACAKE_SET_DWELL_TIMES,
@@ -2712,8 +4746,8 @@ int ADDCALL hackrf_set_clkout_enable(hackrf_device* device, const uint8_t value)
 {
 	USB_API_REQUIRED(device, 0x0103)
 	int result;
-	result = libusb_control_transfer(
-		device->usb_device,
+	result = control_transfer(
+		device,
 		LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR |
 			LIBUSB_RECIPIENT_DEVICE,
 		HACKRF_VENDOR_REQUEST_CLKOUT_ENABLE,
@@ -2735,8 +4769,8 @@ int ADDCALL hackrf_get_clkin_status(hackrf_device* device, uint8_t* status)
 {
 	USB_API_REQUIRED(device, 0x0106)
 	int result;
-	result = libusb_control_transfer(
-		device->usb_device,
+	result = control_transfer(
+		device,
 		LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
 		HACKRF_VENDOR_REQUEST_GET_CLKIN_STATUS,
 		0,
@@ -2764,8 +4798,8 @@ int ADDCALL hackrf_operacake_gpio_test(
 	}
 
 	int result;
-	result = libusb_control_transfer(
-		device->usb_device,
+	result = control_transfer(
+		device,
 		LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
 		HACKRF_VENDOR_REQUEST_OPERACAKE_GPIO_TEST,
 		address,
@@ -2790,8 +4824,8 @@ int ADDCALL hackrf_cpld_checksum(hackrf_device* device, uint32_t* crc)
 	int result;
 
 	length = sizeof(*crc);
-	result = libusb_control_transfer(
-		device->usb_device,
+	result = control_transfer(
+		device,
 		LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
 		HACKRF_VENDOR_REQUEST_CPLD_CHECKSUM,
 		0,
@@ -2814,8 +4848,8 @@ int ADDCALL hackrf_set_ui_enable(hackrf_device* device, const uint8_t value)
 {
 	USB_API_REQUIRED(device, 0x0104)
 	int result;
-	result = libusb_control_transfer(
-		device->usb_device,
+	result = control_transfer(
+		device,
 		LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR |
 			LIBUSB_RECIPIENT_DEVICE,
 		HACKRF_VENDOR_REQUEST_UI_ENABLE,
@@ -2849,6 +4883,41 @@ int ADDCALL hackrf_start_rx_sweep(
 	return result;
 }
 
+int ADDCALL hackrf_start_rx_hop(
+	hackrf_device* device,
+	hackrf_sample_block_cb_fn callback,
+	void* rx_ctx)
+{
+	USB_API_REQUIRED(device, 0x0109)
+	int result;
+	const uint8_t endpoint_address = RX_ENDPOINT_ADDRESS;
+	result = hackrf_set_transceiver_mode(device, TRANSCEIVER_MODE_RX_HOP);
+	if (HACKRF_SUCCESS == result) {
+		device->rx_ctx = rx_ctx;
+		result = prepare_setup_transfers(device, endpoint_address, callback);
+	}
+	return result;
+}
+
+int ADDCALL hackrf_start_tx_hop(
+	hackrf_device* device,
+	hackrf_sample_block_cb_fn callback,
+	void* tx_ctx)
+{
+	USB_API_REQUIRED(device, 0x0109)
+	int result;
+	const uint8_t endpoint_address = TX_ENDPOINT_ADDRESS;
+	if (device->flush_transfer != NULL) {
+		device->flush = true;
+	}
+	result = hackrf_set_transceiver_mode(device, TRANSCEIVER_MODE_TX_HOP);
+	if (HACKRF_SUCCESS == result) {
+		device->tx_ctx = tx_ctx;
+		result = prepare_setup_transfers(device, endpoint_address, callback);
+	}
+	return result;
+}
+
 /**
  * Get USB transfer buffer size.
  * @return size in bytes
@@ -2873,8 +4942,8 @@ int ADDCALL hackrf_board_rev_read(hackrf_device* device, uint8_t* value)
 {
 	USB_API_REQUIRED(device, 0x0106)
 	int result;
-	result = libusb_control_transfer(
-		device->usb_device,
+	result = control_transfer(
+		device,
 		LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
 		HACKRF_VENDOR_REQUEST_BOARD_REV_READ,
 		0,
@@ -2933,8 +5002,8 @@ int ADDCALL hackrf_supported_platform_read(hackrf_device* device, uint32_t* valu
 	unsigned char data[4];
 	USB_API_REQUIRED(device, 0x0106)
 	int result;
-	result = libusb_control_transfer(
-		device->usb_device,
+	result = control_transfer(
+		device,
 		LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
 		HACKRF_VENDOR_REQUEST_SUPPORTED_PLATFORM_READ,
 		0,
@@ -2952,11 +5021,20 @@ int ADDCALL hackrf_supported_platform_read(hackrf_device* device, uint32_t* valu
 	}
 }
 
+int ADDCALL hackrf_get_device_info(hackrf_device* device, hackrf_device_info* info)
+{
+	if (info == NULL) {
+		return HACKRF_ERROR_INVALID_PARAM;
+	}
+	*info = device->info;
+	return HACKRF_SUCCESS;
+}
+
 int ADDCALL hackrf_set_leds(hackrf_device* device, const uint8_t state)
 {
 	USB_API_REQUIRED(device, 0x0107)
-	int result = libusb_control_transfer(
-		device->usb_device,
+	int result = control_transfer(
+		device,
 		LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR |
 			LIBUSB_RECIPIENT_DEVICE,
 		HACKRF_VENDOR_REQUEST_SET_LEDS,
@@ -3001,8 +5079,8 @@ int ADDCALL hackrf_set_user_bias_t_opts(
 		}
 	}
 
-	int result = libusb_control_transfer(
-		device->usb_device,
+	int result = control_transfer(
+		device,
 		LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR |
 			LIBUSB_RECIPIENT_DEVICE,
 		HACKRF_VENDOR_REQUEST_SET_USER_BIAS_T_OPTS,
@@ -91,7 +91,7 @@ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSI
  * # USB API versions
  * As all functionality of HackRF devices requires cooperation between the firmware and the host, both devices can have outdated software. If host machine software is outdated, the new functions will be unavailable in `hackrf.h`, causing linking errors. If the device firmware is outdated, the functions will return @ref HACKRF_ERROR_USB_API_VERSION.
  * Since device firmware and USB API are separate (but closely related), USB API has its own version numbers.
- * Here is a list of all the functions that require a certain minimum USB API version, up to version 0x0107
+ * Here is a list of all the functions that require a certain minimum USB API version, up to version 0x0109
  * ## 0x0102
  * - @ref hackrf_set_hw_sync_mode
  * - @ref hackrf_init_sweep
@@ -122,6 +122,21 @@ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSI
  * - @ref hackrf_supported_platform_read
  * ## 0x0107
  * - @ref hackrf_set_leds
+ * ## 0x0109
+ * - @ref hackrf_set_sweep_timing
+ * - @ref hackrf_set_tuning_table
+ * - @ref hackrf_init_sweep_list
+ * - @ref hackrf_set_sweep_spectrum
+ * - @ref hackrf_spiflash_program
+ * - @ref hackrf_apply_config
+ * - @ref hackrf_apply_config_async
+ * - @ref hackrf_schedule_command
+ * - @ref hackrf_schedule_commands
+ * - @ref hackrf_clear_commands
+ * - @ref hackrf_set_hop_table
+ * - @ref hackrf_start_rx_hop
+ * - @ref hackrf_start_tx_hop
+ * - @ref hackrf_get_m0_telemetry
  */
 
 /**
@@ -147,6 +162,10 @@ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSI
  * 
  * This struct lists all devices and their serial numbers. Any one of them can be opened by @ref hackrf_device_list_open. All the fields should be treated read-only!
  * 
+ * ## Device registry and hotplug
+ * 
+ * Once @ref hackrf_enable_device_registry or @ref hackrf_set_hotplug_callback has been called, and where libusb supports hotplug events, libhackrf keeps a registry of connected devices and their serial numbers, updated by a thread of its own as devices are plugged in and removed. The callback reports devices as they arrive and leave. @ref hackrf_device_list and @ref hackrf_open_by_serial then use the registry to avoid opening every device to read its serial number. Without it, or for a device whose serial number couldn't be read yet, they scan the bus. The registry is not started by @ref hackrf_init, so by default every lookup scans the bus. The registry runs until @ref hackrf_exit.
+ * 
  * # Closing devices
  * 
  * If the device is not needed anymore, then it can be closed via @ref hackrf_close. Closing a device terminates all ongoing transfers, and resets the device to IDLE mode.
@@ -205,6 +224,10 @@ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSI
  * 
  * Identifies the platform supported by the firmware of the HackRF device. Read via @ref hackrf_supported_platform_read. Returns a bitfield. Can identify bad firmware version on device.
  * 
+ * ## Cached device information
+ * 
+ * The USB API version, board ID, board revision and supported platform are read once when the device is opened. @ref hackrf_get_device_info returns these values without any USB traffic, and functions that require a minimum USB API version check it against the cached value.
+ * 
  */
 
 /**
@@ -231,6 +254,20 @@ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSI
  * - TX IF gain in the MAX2837 ("IF" or "VGA") - 0-47dB in 1dB steps, configurable via @ref hackrf_set_txvga_gain
  * - TX RF amplifier near the antenna port ("RF") - 0 or ~11dB, either enabled or disabled via the @ref hackrf_set_amp_enable (same function is used for enabling/disabling the RX RF amp in RX mode)
  * 
+ * # Changing several settings at once
+ * 
+ * @ref hackrf_apply_config changes the frequency, baseband filter bandwidth, gains and RF amplifier in a single USB request, so the device is not left with a mix of old and new settings between round trips.
+ * 
+ * # Scheduled commands
+ * 
+ * @ref hackrf_schedule_command queues a command for the firmware to carry out when the stream reaches a given position, instead of when the request arrives. Positions are byte counts since streaming started, as in @ref hackrf_m0_state.m0_count, in multiples of @ref HACKRF_COMMAND_ALIGNMENT. Settings such as the frequency and gains are applied as soon as the position is reached. Pausing and resuming take effect at exactly that position. Several commands can be queued at once with @ref hackrf_schedule_commands, for example to hop between frequencies without a round trip per hop.
+ * 
+ * Commands can be queued before streaming starts. The queue is cleared when streaming stops, or by @ref hackrf_clear_commands. Commands only run while streaming in RX or TX mode, not in sweep mode.
+ * 
+ * # Asynchronous requests
+ * 
+ * The setter functions block until the device has handled the request. @ref hackrf_set_freq_async, @ref hackrf_set_baseband_filter_bandwidth_async, @ref hackrf_set_amp_enable_async, @ref hackrf_set_lna_gain_async, @ref hackrf_set_vga_gain_async, @ref hackrf_set_txvga_gain_async and @ref hackrf_apply_config_async instead submit the request and return immediately. Several requests can be in flight at once, including while streaming. The device handles them in the order they were submitted, and a @ref hackrf_control_cb_fn callback reports each result from the transfer thread. Each request is given the timeout set by @ref hackrf_set_control_timeout, and @ref hackrf_close waits for outstanding requests to finish or time out. Callbacks must not close the device.
+ * 
  * # Tuning
  * 
  * The HackRF One can tune to nearly any frequency between 1-6000MHz (and the theoretical limit is even a bit higher). This is achieved via up/downconverting the RF section of the MAX2837 transceiver IC with the RFFC5072 mixer/synthesizer's local oscillator. The mixer produces the sum and difference frequencies of the IF and LO frequencies, and a LPF or HPF filter can be used to select one of the resulting frequencies. There is also the possibility to bypass the filter and use the IF as-is. The IF and LO frequencies can be programmed independently, and the behaviour is selectable. See the function @ref hackrf_set_freq_explicit for more details on it.
@@ -406,6 +443,10 @@ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSI
  * 
  * See [hackrf_sweep.c](https://github.com/greatscottgadgets/hackrf/blob/master/host/hackrf-tools/src/hackrf_sweep.c#L236-L249) for a full example, and especially [the start of the RX callback](https://github.com/greatscottgadgets/hackrf/blob/eff4a20022ca5d7f11405c3cdeea6c4195e347d0/host/hackrf-tools/src/hackrf_sweep.c#L236-L249) for parsing the frequency header.
  * 
+ * ## Hopping
+ * 
+ * Hop mode cycles through a table of frequencies, each with its own dwell time and gains, in either RX or TX. The table is uploaded once with @ref hackrf_set_hop_table, and hopping is started with @ref hackrf_start_rx_hop or @ref hackrf_start_tx_hop. The device stops the stream at the end of each dwell, retunes during a fixed gap, and resumes at the end of the gap, so every hop happens at a known sample position. In RX, the first @ref HACKRF_HOP_TAG_SIZE bytes of each gap hold a tag describing the hop, see @ref hackrf_set_hop_table.
+ * 
  * ## HW sync mode
  * 
  * @ref hackrf_set_hw_sync_mode can be used to setup HW sync mode ([see the documentation on this mode](https://hackrf.readthedocs.io/en/latest/hardware_triggering.html)). This mode allows multiple HackRF Ones to synchronize operations, or one HackRF One to synchronize on an external trigger source.
@@ -465,6 +506,12 @@ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSI
  * Its bitstream is auto-loaded on reset by the ARM MCU (from the firmware image), but in older versions, it was possible to reconfigure it via @ref hackrf_cpld_write, and the (since temporarily removed) `hackrf_cpld_checksum` function could verify the firmware in the configuration flash (again, overwritten on startup, so irrelevant).
  * 
  * See <a href="https://github.com/greatscottgadgets/hackrf/issues/609">issue 608</a>, <a href="https://github.com/greatscottgadgets/hackrf/issues/1140">issue 1140</a> and <a href="https://github.com/greatscottgadgets/hackrf/issues/1141">issue 1141</a> for some more details on this!
+ * 
+ * # Request tracing
+ * 
+ * libhackrf can record every vendor request it sends to a device, with its parameters, result and the time it was submitted and completed. Tracing is off by default and costs one branch per request while off. It is switched on and off at runtime with @ref hackrf_trace_enable and @ref hackrf_trace_disable. Events are kept in a fixed-size ring per device, overwriting the oldest, and can be polled while tracing with @ref hackrf_trace_read or written to a file with @ref hackrf_trace_dump.
+ * 
+ * `hackrf_debug --latency-file` prints the latency of each request type in a dump saved with @ref HACKRF_TRACE_FORMAT_BINARY, so an application's own requests can be examined. `hackrf_debug --latency` instead times read-only requests that it issues itself, as a baseline for the device and USB connection.
  */
 
 /**
@@ -517,12 +564,103 @@ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSI
  */
 #define BYTES_PER_BLOCK 16384
 
+/**
+ * Smallest block size for sweeping, see @ref hackrf_set_sweep_timing
+ * @ingroup streaming
+ */
+#define MIN_BYTES_PER_BLOCK 2048
+
+/**
+ * Number of bytes in the header at the start of each sweep block, see @ref hackrf_init_sweep. Firmware older than USB API version 0x0109 sends only the first 10 bytes
+ * @ingroup streaming
+ */
+#define SWEEP_BLOCK_HEADER_SIZE 24
+
+/**
+ * Sweep block header flag: the device dropped samples while receiving this block, so the block is not contiguous
+ * @ingroup streaming
+ */
+#define SWEEP_BLOCK_FLAG_SHORTFALL (1 << 0)
+
+/**
+ * Sweep block header flag: the device failed to retune to this block's frequency, so the samples were received at some other frequency
+ * @ingroup streaming
+ */
+#define SWEEP_BLOCK_FLAG_RETUNE_FAILED (1 << 1)
+
 /**
  * Maximum number of sweep ranges to be specified for @ref hackrf_init_sweep
  * @ingroup streaming
  */
 #define MAX_SWEEP_RANGES 10
 
+/**
+ * Maximum number of frequencies for @ref hackrf_init_sweep_list
+ * @ingroup streaming
+ */
+#define MAX_SWEEP_LIST_ENTRIES 512
+
+/**
+ * Maximum number of entries in the tuning table, see @ref hackrf_set_tuning_table
+ * @ingroup streaming
+ */
+#define MAX_TUNING_TABLE_ENTRIES 128
+
+/**
+ * Maximum number of entries in the hop table, see @ref hackrf_set_hop_table
+ * @ingroup streaming
+ */
+#define MAX_HOP_TABLE_ENTRIES 128
+
+/**
+ * Smallest dwell or gap for @ref hackrf_set_hop_table, in samples, long enough for a retune. Dwells and gaps must also be multiples of 16 samples
+ * @ingroup streaming
+ */
+#define MIN_HOP_SAMPLES 8192
+
+/**
+ * Gain value in a @ref hackrf_hop_entry that leaves the gain unchanged
+ * @ingroup streaming
+ */
+#define HACKRF_HOP_GAIN_UNCHANGED 0xff
+
+/**
+ * Number of bytes in the tag at the start of each gap in RX hop mode, see @ref hackrf_set_hop_table
+ * @ingroup streaming
+ */
+#define HACKRF_HOP_TAG_SIZE 32
+
+/**
+ * Hop tag flag: the hop is later than the table gives, because the device missed the end of the previous dwell or was still retuning when the gap ended. In the latter case the first samples of the dwell may be at the wrong frequency or gain
+ * @ingroup streaming
+ */
+#define HACKRF_HOP_TAG_FLAG_LATE (1 << 0)
+
+/**
+ * Smallest FFT size for @ref hackrf_set_sweep_spectrum
+ * @ingroup streaming
+ */
+#define MIN_SWEEP_SPECTRUM_SIZE 16
+
+/**
+ * Largest FFT size for @ref hackrf_set_sweep_spectrum
+ * @ingroup streaming
+ */
+#define MAX_SWEEP_SPECTRUM_SIZE 256
+
+/**
+ * Number of bytes in the header of each spectrum record, see @ref hackrf_set_sweep_spectrum
+ * @ingroup streaming
+ */
+#define SWEEP_SPECTRUM_HEADER_SIZE 16
+
+/**
+ * Number of bytes per spectrum record for an FFT size, see @ref hackrf_set_sweep_spectrum
+ * @ingroup streaming
+ */
+#define SWEEP_SPECTRUM_RECORD_SIZE(fft_size) \
+	((8 * (fft_size) > 512) ? (8 * (fft_size)) : 512)
+
 /**
  * Invalid Opera Cake add-on board address, placeholder in @ref hackrf_get_operacake_boards
  * @ingroup operacake
@@ -547,6 +685,30 @@ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSI
  */
 #define HACKRF_OPERACAKE_MAX_FREQ_RANGES 8
 
+/**
+ * Number of recent shortfalls reported in @ref hackrf_m0_telemetry
+ * @ingroup debug
+ */
+#define HACKRF_M0_SHORTFALL_LOG_SIZE 32
+
+/**
+ * Number of bins in the shortfall length histogram of @ref hackrf_m0_telemetry
+ * @ingroup debug
+ */
+#define HACKRF_M0_SHORTFALL_HISTOGRAM_BINS 16
+
+/**
+ * @ref hackrf_trace_event flag: the request was sent asynchronously
+ * @ingroup debug
+ */
+#define HACKRF_TRACE_FLAG_ASYNC (1 << 0)
+
+/**
+ * @ref hackrf_trace_event flag: the request is device-to-host
+ * @ingroup debug
+ */
+#define HACKRF_TRACE_FLAG_IN (1 << 1)
+
 /**
  * error enum, returned by many libhackrf functions
  * 
@@ -851,6 +1013,21 @@ enum sweep_style {
 	INTERLEAVED = 1,
 };
 
+/**
+ * Request trace file format, used by @ref hackrf_trace_dump
+ * @ingroup debug
+ */
+enum hackrf_trace_format {
+	/**
+	 * JSON in the Chrome trace event format, for chrome://tracing or Perfetto. Times are in microseconds from the first event.
+	 */
+	HACKRF_TRACE_FORMAT_CHROME_JSON = 0,
+	/**
+	 * The 8 byte magic "HACKRFTR", a 32-bit format version (1) and a 32-bit event count, followed by one 32 byte record per event holding the fields of @ref hackrf_trace_event in declaration order, padded with zeros. All values are little-endian.
+	 */
+	HACKRF_TRACE_FORMAT_BINARY = 1,
+};
+
 /**
  * Opaque struct for hackrf device info. Object can be created via @ref hackrf_open, @ref hackrf_device_list_open or @ref hackrf_open_by_serial and be destroyed via @ref hackrf_close
  * @ingroup device
@@ -928,6 +1105,213 @@ typedef struct {
 	uint8_t port;
 } hackrf_operacake_freq_range;
 
+/**
+ * Sweep frequency for @ref hackrf_init_sweep_list
+ * @ingroup streaming
+ */
+typedef struct {
+	/**
+	 * Frequency (in Hz) reported in the block header. The HackRF tunes to this plus the sweep offset
+	 */
+	uint64_t frequency;
+	/**
+	 * Number of bytes to capture at this frequency, must be a multiple of @ref MIN_BYTES_PER_BLOCK and at least the block size when the sweep starts
+	 */
+	uint32_t dwell;
+} hackrf_sweep_entry;
+
+/**
+ * Device information read when the device is opened, see @ref hackrf_get_device_info
+ * @ingroup device
+ */
+typedef struct {
+	/**
+	 * USB API version, as returned by @ref hackrf_usb_api_version_read
+	 */
+	uint16_t usb_api_version;
+	/**
+	 * Board ID, one of @ref hackrf_board_id
+	 */
+	uint8_t board_id;
+	/**
+	 * Board revision, one of @ref hackrf_board_rev. @ref BOARD_REV_UNDETECTED if the firmware does not report it
+	 */
+	uint8_t board_rev;
+	/**
+	 * Supported platform bitfield, as returned by @ref hackrf_supported_platform_read. Zero if the firmware does not report it
+	 */
+	uint32_t supported_platform;
+} hackrf_device_info;
+
+/**
+ * Frequency flag for @ref hackrf_config
+ * @ingroup configuration
+ */
+#define HACKRF_CONFIG_FREQ (1 << 0)
+/**
+ * Baseband filter bandwidth flag for @ref hackrf_config
+ * @ingroup configuration
+ */
+#define HACKRF_CONFIG_BASEBAND_FILTER (1 << 1)
+/**
+ * RX LNA gain flag for @ref hackrf_config
+ * @ingroup configuration
+ */
+#define HACKRF_CONFIG_LNA_GAIN (1 << 2)
+/**
+ * RX VGA gain flag for @ref hackrf_config
+ * @ingroup configuration
+ */
+#define HACKRF_CONFIG_VGA_GAIN (1 << 3)
+/**
+ * TX VGA gain flag for @ref hackrf_config
+ * @ingroup configuration
+ */
+#define HACKRF_CONFIG_TXVGA_GAIN (1 << 4)
+/**
+ * RF amplifier flag for @ref hackrf_config
+ * @ingroup configuration
+ */
+#define HACKRF_CONFIG_AMP_ENABLE (1 << 5)
+
+/**
+ * Settings for @ref hackrf_apply_config. Only the fields selected in @ref flags are changed
+ * @ingroup configuration
+ */
+typedef struct {
+	/**
+	 * Fields to apply, a combination of @ref HACKRF_CONFIG_FREQ, @ref HACKRF_CONFIG_BASEBAND_FILTER, @ref HACKRF_CONFIG_LNA_GAIN, @ref HACKRF_CONFIG_VGA_GAIN, @ref HACKRF_CONFIG_TXVGA_GAIN and @ref HACKRF_CONFIG_AMP_ENABLE
+	 */
+	uint32_t flags;
+	/**
+	 * Center frequency in Hz, as for @ref hackrf_set_freq
+	 */
+	uint64_t freq_hz;
+	/**
+	 * Baseband filter bandwidth in Hz, as for @ref hackrf_set_baseband_filter_bandwidth
+	 */
+	uint32_t baseband_filter_bw_hz;
+	/**
+	 * RX LNA (IF) gain in dB, as for @ref hackrf_set_lna_gain
+	 */
+	uint32_t lna_gain;
+	/**
+	 * RX VGA (baseband) gain in dB, as for @ref hackrf_set_vga_gain
+	 */
+	uint32_t vga_gain;
+	/**
+	 * TX VGA (IF) gain in dB, as for @ref hackrf_set_txvga_gain
+	 */
+	uint32_t txvga_gain;
+	/**
+	 * RF amplifier enable, as for @ref hackrf_set_amp_enable
+	 */
+	uint8_t amp_enable;
+} hackrf_config;
+
+/**
+ * Required alignment of @ref hackrf_command.when
+ * @ingroup configuration
+ */
+#define HACKRF_COMMAND_ALIGNMENT 32
+
+/**
+ * Minimum distance in bytes of @ref HACKRF_COMMAND_PAUSE and @ref HACKRF_COMMAND_RESUME from the current position and from each other, see @ref hackrf_schedule_command
+ * @ingroup configuration
+ */
+#define HACKRF_COMMAND_ARM_GUARD 512
+
+/**
+ * Maximum number of commands queued at once, see @ref hackrf_schedule_commands
+ * @ingroup configuration
+ */
+#define HACKRF_MAX_SCHEDULED_COMMANDS 32
+
+/**
+ * Scheduled command type, see @ref hackrf_command
+ * @ingroup configuration
+ */
+enum hackrf_command_type {
+	/**
+	 * Tune to @ref hackrf_command.value Hz, as @ref hackrf_set_freq. A matching tuning table entry is used if there is one, see @ref hackrf_set_tuning_table
+	 */
+	HACKRF_COMMAND_SET_FREQ = 1,
+	/**
+	 * Set the RX LNA (IF) gain in dB, as @ref hackrf_set_lna_gain
+	 */
+	HACKRF_COMMAND_LNA_GAIN = 2,
+	/**
+	 * Set the RX VGA (baseband) gain in dB, as @ref hackrf_set_vga_gain
+	 */
+	HACKRF_COMMAND_VGA_GAIN = 3,
+	/**
+	 * Set the TX VGA (IF) gain in dB, as @ref hackrf_set_txvga_gain
+	 */
+	HACKRF_COMMAND_TXVGA_GAIN = 4,
+	/**
+	 * Enable (1) or disable (0) the RF amplifier, as @ref hackrf_set_amp_enable
+	 */
+	HACKRF_COMMAND_AMP_ENABLE = 5,
+	/**
+	 * Set Opera Cake ports, as @ref hackrf_set_operacake_ports. The value is the address, port A shifted left by 8 and port B shifted left by 16
+	 */
+	HACKRF_COMMAND_OPERACAKE_PORTS = 6,
+	/**
+	 * Stop receiving or transmitting samples while the position keeps advancing. In RX mode, the blocks received while paused hold stale data. In TX mode, the device transmits zeroes while paused, and the samples sent for the paused span are skipped. The value must be 0
+	 */
+	HACKRF_COMMAND_PAUSE = 7,
+	/**
+	 * Resume receiving or transmitting samples after @ref HACKRF_COMMAND_PAUSE. The value must be 0
+	 */
+	HACKRF_COMMAND_RESUME = 8,
+};
+
+/**
+ * Command for @ref hackrf_schedule_command
+ * @ingroup configuration
+ */
+typedef struct {
+	/**
+	 * Stream position at which to run the command, in bytes since streaming started. Must be a multiple of @ref HACKRF_COMMAND_ALIGNMENT and wraps at 2^32
+	 */
+	uint32_t when;
+	/**
+	 * Command to run
+	 */
+	enum hackrf_command_type type;
+	/**
+	 * Command parameter, see @ref hackrf_command_type
+	 */
+	uint64_t value;
+} hackrf_command;
+
+/**
+ * Hop table entry, see @ref hackrf_set_hop_table
+ * @ingroup streaming
+ */
+typedef struct {
+	/**
+	 * Frequency in Hz, no higher than 7250MHz
+	 */
+	uint64_t freq_hz;
+	/**
+	 * Number of samples to stay at this frequency. At least @ref MIN_HOP_SAMPLES, and a multiple of 16
+	 */
+	uint32_t dwell_samples;
+	/**
+	 * RX LNA (IF) gain in dB as for @ref hackrf_set_lna_gain, or @ref HACKRF_HOP_GAIN_UNCHANGED
+	 */
+	uint8_t lna_gain;
+	/**
+	 * RX VGA (baseband) gain in dB as for @ref hackrf_set_vga_gain, or @ref HACKRF_HOP_GAIN_UNCHANGED
+	 */
+	uint8_t vga_gain;
+	/**
+	 * TX VGA (IF) gain in dB as for @ref hackrf_set_txvga_gain, or @ref HACKRF_HOP_GAIN_UNCHANGED
+	 */
+	uint8_t txvga_gain;
+} hackrf_hop_entry;
+
 /** 
  * Helper struct for hackrf_bias_t_user_setting.  If 'do_update' is true, then the values of 'change_on_mode_entry'
  * and 'enabled' will be used as the new default.  If 'do_update' is false, the current default will not change.
@@ -979,6 +1363,61 @@ typedef struct {
 	uint32_t error;
 } hackrf_m0_state;
 
+/**
+ * A shortfall recorded by the M0, see @ref hackrf_m0_telemetry
+ * @ingroup debug
+ */
+typedef struct {
+	/** Value of @ref hackrf_m0_state.m0_count when the shortfall started. */
+	uint32_t start;
+	/** Length of the shortfall in bytes, so far if it is still ongoing. */
+	uint32_t length;
+} hackrf_m0_shortfall;
+
+/**
+ * Detailed statistics on the buffer shared by the M0 and USB, since streaming last started.
+ * 
+ * Together, the histogram and the recent shortfalls show whether shortfalls are periodic, bursty or steady.
+ * @ingroup debug
+ */
+typedef struct {
+	/** Smallest buffer margin in bytes seen outside of a shortfall: the free space in RX, or the data waiting in TX, less the 32 bytes being transferred. */
+	uint32_t min_margin;
+	/** Number of shortfalls, as in @ref hackrf_m0_state.num_shortfalls */
+	uint32_t num_shortfalls;
+	/** Number of shortfalls logged faster than the firmware could bin them, which are missing from the histogram. */
+	uint32_t histogram_missed;
+	/** Completed shortfalls by length. Bin i counts lengths from 32 << i bytes up to (but not including) 64 << i bytes, and the last bin also counts anything longer. */
+	uint32_t histogram[HACKRF_M0_SHORTFALL_HISTOGRAM_BINS];
+	/** Number of valid entries in recent. */
+	uint32_t num_recent;
+	/** The most recent shortfalls, oldest first. */
+	hackrf_m0_shortfall recent[HACKRF_M0_SHORTFALL_LOG_SIZE];
+} hackrf_m0_telemetry;
+
+/**
+ * A vendor request recorded by request tracing, see @ref hackrf_trace_enable
+ * @ingroup debug
+ */
+typedef struct {
+	/** Monotonic time in nanoseconds at which the request was submitted. */
+	uint64_t submit_ns;
+	/** Monotonic time in nanoseconds at which the request completed. */
+	uint64_t complete_ns;
+	/** Number of bytes transferred, or a negative libusb error code. */
+	int32_t result;
+	/** wValue of the request */
+	uint16_t value;
+	/** wIndex of the request */
+	uint16_t index;
+	/** wLength of the request */
+	uint16_t length;
+	/** Vendor request number, see @ref hackrf_vendor_request_name */
+	uint8_t request;
+	/** Any of the HACKRF_TRACE_FLAG_* flags */
+	uint8_t flags;
+} hackrf_trace_event;
+
 /**
  * List of connected HackRF devices
  * 
@@ -1023,7 +1462,7 @@ typedef struct hackrf_device_list hackrf_device_list_t;
  * 
  * In RX mode, it should copy/process the contents of the transfer buffer's valid part.
  * 
- * In RX SWEEP mode, it receives multiple "blocks" of data, each with a 10-byte header containing the tuned frequency followed by the samples. See @ref hackrf_init_sweep for more info.
+ * In RX SWEEP mode, it receives multiple "blocks" of data, each with a header containing the tuned frequency followed by the samples. See @ref hackrf_init_sweep for more info.
  * 
  * The callback should return 0 if it wants to be called again, and any other value otherwise. Stopping the RX/TX/SWEEP is still done with @ref hackrf_stop_rx and @ref hackrf_stop_tx, and those should be called from the main thread, so this callback should signal the main thread that it should stop. Signaling the main thread to stop TX should be done from the flush callback in order to guarantee that no samples are discarded, see @ref hackrf_flush_cb_fn
  * @ingroup streaming
@@ -1046,6 +1485,41 @@ typedef void (*hackrf_tx_block_complete_cb_fn)(hackrf_transfer* transfer, int);
  */
 typedef void (*hackrf_flush_cb_fn)(void* flush_ctx, int);
 
+/**
+ * Asynchronous request completion callback
+ * 
+ * Called from the transfer thread when a request submitted with one of the `_async` functions (such as @ref hackrf_set_freq_async) completes, fails or times out. @p result is @ref HACKRF_SUCCESS or the error the synchronous function would have returned. Like the other callbacks, it must not make synchronous libhackrf calls or close the device, but it may submit further asynchronous requests.
+ * @ingroup configuration
+ */
+typedef void (*hackrf_control_cb_fn)(hackrf_device* device, int result, void* ctx);
+
+/**
+ * Hotplug event, see @ref hackrf_hotplug_cb_fn
+ * @ingroup device
+ */
+enum hackrf_hotplug_event {
+	/**
+	 * A device was plugged in, or was already present when the callback was set
+	 */
+	HACKRF_HOTPLUG_ARRIVED = 1,
+	/**
+	 * A device was removed
+	 */
+	HACKRF_HOTPLUG_LEFT = 2,
+};
+
+/**
+ * Hotplug callback
+ * 
+ * Set via @ref hackrf_set_hotplug_callback. Called from a libhackrf thread, or from the thread calling @ref hackrf_set_hotplug_callback for devices already present. @p serial_number is NULL if the serial number could not be read, and is only valid during the call. The callback may call @ref hackrf_open_by_serial but must not call @ref hackrf_set_hotplug_callback or @ref hackrf_exit.
+ * @ingroup device
+ */
+typedef void (*hackrf_hotplug_cb_fn)(
+	enum hackrf_hotplug_event event,
+	const char* serial_number,
+	enum hackrf_usb_board_id board_id,
+	void* ctx);
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -1113,6 +1587,28 @@ extern ADDAPI int ADDCALL hackrf_device_list_open(
  */
 extern ADDAPI void ADDCALL hackrf_device_list_free(hackrf_device_list_t* list);
 
+/**
+ * Start the device registry
+ * 
+ * Starts the device registry and its thread if they aren't already running, so that @ref hackrf_device_list and @ref hackrf_open_by_serial can find devices without opening each one to read its serial number. Devices already present are added before this returns. The registry keeps running until @ref hackrf_exit. Requires @ref hackrf_init to have been called, and libusb support for hotplug events.
+ * @return @ref HACKRF_SUCCESS on success, @ref HACKRF_ERROR_LIBUSB if hotplug events are not supported or other @ref hackrf_error variant
+ * @ingroup device
+ */
+extern ADDAPI int ADDCALL hackrf_enable_device_registry(void);
+
+/**
+ * Set a callback to be notified when HackRF devices are plugged in or removed
+ * 
+ * Starts the device registry and its thread if they aren't already running, then calls @p callback with @ref HACKRF_HOTPLUG_ARRIVED for every device already present before returning. The registry keeps running until @ref hackrf_exit, even if @p callback is NULL. Requires @ref hackrf_init to have been called, and libusb support for hotplug events.
+ * @param callback callback to call, or NULL to stop notifications
+ * @param ctx context passed to @p callback
+ * @return @ref HACKRF_SUCCESS on success, @ref HACKRF_ERROR_LIBUSB if hotplug events are not supported or other @ref hackrf_error variant
+ * @ingroup device
+ */
+extern ADDAPI int ADDCALL hackrf_set_hotplug_callback(
+	hackrf_hotplug_cb_fn callback,
+	void* ctx);
+
 /**
  * Open first available HackRF device
  * @param[out] device device handle
@@ -1134,8 +1630,11 @@ extern ADDAPI int ADDCALL hackrf_open_by_serial(
 
 /**
  * Close a previously opened device
+ * 
+ * Waits for outstanding asynchronous requests to complete or time out. Must not be called from a libhackrf callback, as those run on the transfer thread that closing stops.
+ * 
  * @param[in] device device to close
- * @return @ref HACKRF_SUCCESS on success or variant of @ref hackrf_error
+ * @return @ref HACKRF_SUCCESS on success, @ref HACKRF_ERROR_THREAD if called from the transfer thread, or variant of @ref hackrf_error
  * @ingroup device
  */
 extern ADDAPI int ADDCALL hackrf_close(hackrf_device* device);
@@ -1237,6 +1736,68 @@ extern ADDAPI int ADDCALL hackrf_get_m0_state(
 	hackrf_device* device,
 	hackrf_m0_state* value);
 
+/**
+ * Get detailed buffer statistics from the M0 code on the LPC43xx MCU
+ * 
+ * Requires USB API version 0x0109 or above!
+ * @param[in] device device to query
+ * @param[out] value buffer statistics
+ * @return @ref HACKRF_SUCCESS on success or @ref hackrf_error variant
+ * @ingroup debug
+ */
+extern ADDAPI int ADDCALL hackrf_get_m0_telemetry(
+	hackrf_device* device,
+	hackrf_m0_telemetry* value);
+
+/**
+ * Start recording vendor requests sent to the device
+ * 
+ * The trace ring is allocated on the first call and kept until the device is closed, so @p capacity only has an effect on the first call. Tracing itself only touches the ring and may be enabled and disabled at any time, from any thread.
+ * @param device device to trace
+ * @param capacity number of events kept, rounded up to a power of two
+ * @return @ref HACKRF_SUCCESS on success, @ref HACKRF_ERROR_INVALID_PARAM or @ref HACKRF_ERROR_NO_MEM
+ * @ingroup debug
+ */
+extern ADDAPI int ADDCALL hackrf_trace_enable(hackrf_device* device, uint32_t capacity);
+
+/**
+ * Stop recording vendor requests. Events already recorded are kept.
+ * @param device device to stop tracing
+ * @return @ref HACKRF_SUCCESS
+ * @ingroup debug
+ */
+extern ADDAPI int ADDCALL hackrf_trace_disable(hackrf_device* device);
+
+/**
+ * Copy recorded events, oldest first
+ * 
+ * @p position is the sequence number of the next event to read, and is advanced past the events copied. Start from 0. Events overwritten before they could be read are skipped. Reading stops at the first event that is still being recorded, which will be returned by the next call.
+ * @param device device to read from
+ * @param[in,out] position sequence number of the next event
+ * @param[out] events buffer for at least @p count events
+ * @param count maximum number of events to copy
+ * @return number of events copied, or @ref HACKRF_ERROR_INVALID_PARAM
+ * @ingroup debug
+ */
+extern ADDAPI int ADDCALL hackrf_trace_read(
+	hackrf_device* device,
+	uint32_t* position,
+	hackrf_trace_event* events,
+	int count);
+
+/**
+ * Write all events currently held in the trace ring to a file
+ * @param device device to dump
+ * @param path file to write, replaced if it exists
+ * @param format file format
+ * @return @ref HACKRF_SUCCESS on success, @ref HACKRF_ERROR_INVALID_PARAM, @ref HACKRF_ERROR_NO_MEM or @ref HACKRF_ERROR_OTHER if the file could not be written
+ * @ingroup debug
+ */
+extern ADDAPI int ADDCALL hackrf_trace_dump(
+	hackrf_device* device,
+	const char* path,
+	enum hackrf_trace_format format);
+
 /**
  * Set transmit underrun limit
  * 
@@ -1461,6 +2022,43 @@ extern ADDAPI int ADDCALL hackrf_spiflash_status(hackrf_device* device, uint8_t*
  */
 extern ADDAPI int ADDCALL hackrf_spiflash_clear_status(hackrf_device* device);
 
+/**
+ * Write an image to the SPI flash over the bulk endpoint
+ * 
+ * A faster alternative to @ref hackrf_spiflash_erase followed by @ref hackrf_spiflash_write. The image is streamed to the device in large chunks, and the firmware writes each chunk while the next one is being received. Only the 4 KiB sectors whose contents differ are erased and programmed, using 64 KiB block erases where a whole block of the image changes. Flash beyond the end of the image is left as it was, apart from the rest of the last sector if that is rewritten.
+ * 
+ * The firmware reads each sector back after writing it, and returns the CRC-32 of the whole region, so the image can be verified by comparing it with @ref hackrf_compute_crc32 of @p data instead of reading it back. The device is left idle afterwards.
+ * 
+ * Requires USB API version 0x0109 or above!
+ * @param[in] device device to write to
+ * @param[in] address address to write the image at. Must be a multiple of 4096
+ * @param[in] data image to write
+ * @param[in] length length of @p data in bytes. The image must fit within the 1 MiB flash
+ * @param[out] crc CRC-32 of the region as read back from the flash
+ * @return @ref HACKRF_SUCCESS on success, @ref HACKRF_ERROR_OTHER if the firmware failed to write the image, accepted only part of it or did not finish within 10 seconds of the last chunk, or another @ref hackrf_error variant
+ * @ingroup debug
+ */
+extern ADDAPI int ADDCALL hackrf_spiflash_program(
+	hackrf_device* device,
+	const uint32_t address,
+	const unsigned char* data,
+	const uint32_t length,
+	uint32_t* crc);
+
+/**
+ * Compute the CRC-32 of a firmware image or other data
+ * 
+ * Uses the same code as the firmware, with the standard CRC-32 polynomial as used by zlib, so the result can be compared with checksums computed on the device.
+ * 
+ * @param data data to checksum
+ * @param length length of @p data in bytes
+ * @return CRC-32 of @p data
+ * @ingroup debug
+ */
+extern ADDAPI uint32_t ADDCALL hackrf_compute_crc32(
+	const unsigned char* data,
+	const uint32_t length);
+
 /* device will need to be reset after hackrf_cpld_write */
 
 /**
@@ -1509,7 +2107,7 @@ extern ADDAPI int ADDCALL hackrf_version_string_read(
 /**
  * Read HackRF USB API version
  * 
- * Read version as MM.mm 16-bit value, where MM is the major and mm is the minor version, encoded as the hex digits of the 16-bit number. 
+ * Read version as MM.mm 16-bit value, where MM is the major and mm is the minor version, encoded as the hex digits of the 16-bit number. The value is read from the device descriptor when the device is opened, so this does not communicate with the device.
  * 
  * Example code from `hackrf_info.c` displaying the result:
  * ```c
@@ -1654,6 +2252,208 @@ extern ADDAPI int ADDCALL hackrf_set_vga_gain(hackrf_device* device, uint32_t va
  */
 extern ADDAPI int ADDCALL hackrf_set_txvga_gain(hackrf_device* device, uint32_t value);
 
+/**
+ * Apply several settings in one request
+ * 
+ * Changes the settings selected in @p config->flags with a single USB control transfer. The firmware checks the whole request before changing anything, and applies the baseband filter bandwidth, frequency, gains and RF amplifier in that order. If the firmware then rejects the bandwidth or frequency, the settings after it are not applied. If a tuning table has been uploaded with @ref hackrf_set_tuning_table, a matching entry is used to tune.
+ * 
+ * Gains are rounded down to valid steps as by the individual setter functions.
+ * 
+ * Requires USB API version 0x0109 or above!
+ * @param device device to configure
+ * @param config settings to apply
+ * @return @ref HACKRF_SUCCESS on success, @ref HACKRF_ERROR_INVALID_PARAM if a setting is out of range or @ref hackrf_error variant
+ * @ingroup configuration
+ */
+extern ADDAPI int ADDCALL hackrf_apply_config(
+	hackrf_device* device,
+	const hackrf_config* config);
+
+/**
+ * Schedule a command to run at a given stream position
+ * 
+ * The position must be after the current position, which is zero before streaming starts. Commands for the same position run in the order they were scheduled.
+ * 
+ * @ref HACKRF_COMMAND_PAUSE and @ref HACKRF_COMMAND_RESUME must be at least @ref HACKRF_COMMAND_ARM_GUARD bytes after the current position and from any other queued pause or resume, so that the firmware has time to hand each one to the M0.
+ * 
+ * Requires USB API version 0x0109 or above!
+ * @param device device to configure
+ * @param command command to schedule
+ * @return @ref HACKRF_SUCCESS on success, @ref HACKRF_ERROR_INVALID_PARAM if the command is invalid, @ref HACKRF_ERROR_LIBUSB if the device rejected it because its position has passed or is too close, or the queue is full, or other @ref hackrf_error variant
+ * @ingroup configuration
+ */
+extern ADDAPI int ADDCALL hackrf_schedule_command(
+	hackrf_device* device,
+	const hackrf_command* command);
+
+/**
+ * Schedule several commands in one request
+ * 
+ * As @ref hackrf_schedule_command, but the device checks every command before queueing any of them. Up to @ref HACKRF_MAX_SCHEDULED_COMMANDS can be queued at once, in any order.
+ * 
+ * Requires USB API version 0x0109 or above!
+ * @param device device to configure
+ * @param commands commands to schedule
+ * @param count number of commands
+ * @return @ref HACKRF_SUCCESS on success, @ref HACKRF_ERROR_INVALID_PARAM if a command is invalid or @p count is out of range, @ref HACKRF_ERROR_LIBUSB if the device rejected the commands or other @ref hackrf_error variant
+ * @ingroup configuration
+ */
+extern ADDAPI int ADDCALL hackrf_schedule_commands(
+	hackrf_device* device,
+	const hackrf_command* commands,
+	const int count);
+
+/**
+ * Discard all scheduled commands that have not run yet
+ * 
+ * Requires USB API version 0x0109 or above!
+ * @param device device to configure
+ * @return @ref HACKRF_SUCCESS on success or @ref hackrf_error variant
+ * @ingroup configuration
+ */
+extern ADDAPI int ADDCALL hackrf_clear_commands(hackrf_device* device);
+
+/**
+ * Set the timeout of asynchronous requests
+ * 
+ * Applies to requests submitted after this call. Defaults to 1000ms. The timeout also bounds how long @ref hackrf_close waits for outstanding requests, so it can't be 0.
+ * 
+ * @param device device to configure
+ * @param timeout_ms timeout in milliseconds, greater than 0
+ * @return @ref HACKRF_SUCCESS, or @ref HACKRF_ERROR_INVALID_PARAM if @p timeout_ms is 0
+ * @ingroup configuration
+ */
+extern ADDAPI int ADDCALL hackrf_set_control_timeout(
+	hackrf_device* device,
+	const uint32_t timeout_ms);
+
+/**
+ * Set the center frequency without waiting for the device
+ * 
+ * Asynchronous version of @ref hackrf_set_freq.
+ * 
+ * @param device device to configure
+ * @param freq_hz center frequency in Hz
+ * @param callback called when the request completes, may be NULL
+ * @param ctx passed to @p callback
+ * @return @ref HACKRF_SUCCESS if the request was submitted or @ref hackrf_error variant
+ * @ingroup configuration
+ */
+extern ADDAPI int ADDCALL hackrf_set_freq_async(
+	hackrf_device* device,
+	const uint64_t freq_hz,
+	hackrf_control_cb_fn callback,
+	void* ctx);
+
+/**
+ * Set the baseband filter bandwidth without waiting for the device
+ * 
+ * Asynchronous version of @ref hackrf_set_baseband_filter_bandwidth.
+ * 
+ * @param device device to configure
+ * @param bandwidth_hz baseband filter bandwidth in Hz
+ * @param callback called when the request completes, may be NULL
+ * @param ctx passed to @p callback
+ * @return @ref HACKRF_SUCCESS if the request was submitted or @ref hackrf_error variant
+ * @ingroup configuration
+ */
+extern ADDAPI int ADDCALL hackrf_set_baseband_filter_bandwidth_async(
+	hackrf_device* device,
+	const uint32_t bandwidth_hz,
+	hackrf_control_cb_fn callback,
+	void* ctx);
+
+/**
+ * Enable or disable the RF amplifier without waiting for the device
+ * 
+ * Asynchronous version of @ref hackrf_set_amp_enable.
+ * 
+ * @param device device to configure
+ * @param value enable (1) or disable (0) the amplifier
+ * @param callback called when the request completes, may be NULL
+ * @param ctx passed to @p callback
+ * @return @ref HACKRF_SUCCESS if the request was submitted or @ref hackrf_error variant
+ * @ingroup configuration
+ */
+extern ADDAPI int ADDCALL hackrf_set_amp_enable_async(
+	hackrf_device* device,
+	const uint8_t value,
+	hackrf_control_cb_fn callback,
+	void* ctx);
+
+/**
+ * Set the RX LNA gain without waiting for the device
+ * 
+ * Asynchronous version of @ref hackrf_set_lna_gain. The range is checked before submitting, and the callback receives @ref HACKRF_ERROR_INVALID_PARAM if the device rejects the value.
+ * 
+ * @param device device to configure
+ * @param value RX IF gain value in dB
+ * @param callback called when the request completes, may be NULL
+ * @param ctx passed to @p callback
+ * @return @ref HACKRF_SUCCESS if the request was submitted or @ref hackrf_error variant
+ * @ingroup configuration
+ */
+extern ADDAPI int ADDCALL hackrf_set_lna_gain_async(
+	hackrf_device* device,
+	uint32_t value,
+	hackrf_control_cb_fn callback,
+	void* ctx);
+
+/**
+ * Set the RX VGA gain without waiting for the device
+ * 
+ * Asynchronous version of @ref hackrf_set_vga_gain. The range is checked before submitting, and the callback receives @ref HACKRF_ERROR_INVALID_PARAM if the device rejects the value.
+ * 
+ * @param device device to configure
+ * @param value RX BB gain value in dB
+ * @param callback called when the request completes, may be NULL
+ * @param ctx passed to @p callback
+ * @return @ref HACKRF_SUCCESS if the request was submitted or @ref hackrf_error variant
+ * @ingroup configuration
+ */
+extern ADDAPI int ADDCALL hackrf_set_vga_gain_async(
+	hackrf_device* device,
+	uint32_t value,
+	hackrf_control_cb_fn callback,
+	void* ctx);
+
+/**
+ * Set the TX VGA gain without waiting for the device
+ * 
+ * Asynchronous version of @ref hackrf_set_txvga_gain. The range is checked before submitting, and the callback receives @ref HACKRF_ERROR_INVALID_PARAM if the device rejects the value.
+ * 
+ * @param device device to configure
+ * @param value TX IF gain value in dB
+ * @param callback called when the request completes, may be NULL
+ * @param ctx passed to @p callback
+ * @return @ref HACKRF_SUCCESS if the request was submitted or @ref hackrf_error variant
+ * @ingroup configuration
+ */
+extern ADDAPI int ADDCALL hackrf_set_txvga_gain_async(
+	hackrf_device* device,
+	uint32_t value,
+	hackrf_control_cb_fn callback,
+	void* ctx);
+
+/**
+ * Apply several settings without waiting for the device
+ * 
+ * Asynchronous version of @ref hackrf_apply_config.
+ * 
+ * Requires USB API version 0x0109 or above!
+ * @param device device to configure
+ * @param config settings to apply
+ * @param callback called when the request completes, may be NULL
+ * @param ctx passed to @p callback
+ * @return @ref HACKRF_SUCCESS if the request was submitted or @ref hackrf_error variant
+ * @ingroup configuration
+ */
+extern ADDAPI int ADDCALL hackrf_apply_config_async(
+	hackrf_device* device,
+	const hackrf_config* config,
+	hackrf_control_cb_fn callback,
+	void* ctx);
+
 /**
  * Enable / disable bias-tee (antenna port power)
  * 
@@ -1714,6 +2514,14 @@ extern ADDAPI const char* ADDCALL hackrf_usb_board_id_name(
  */
 extern ADDAPI const char* ADDCALL hackrf_filter_path_name(const enum rf_path_filter path);
 
+/**
+ * Convert a vendor request number from @ref hackrf_trace_event into a human-readable string
+ * @param request vendor request number
+ * @return name of the request, or "unknown"
+ * @ingroup debug
+ */
+extern ADDAPI const char* ADDCALL hackrf_vendor_request_name(const uint8_t request);
+
 /**
  * Compute nearest valid baseband filter bandwidth lower than a specified value
  * 
@@ -1758,14 +2566,23 @@ extern ADDAPI int ADDCALL hackrf_set_hw_sync_mode(
 /**
  * Initialize sweep mode
  * 
- * In this mode, in a single data transfer (single call to the RX transfer callback), multiple blocks of size @p num_bytes bytes are received with different center frequencies. At the beginning of each block, a 10-byte frequency header is present in `0x7F - 0x7F - uint64_t frequency (LSBFIRST, in Hz)` format, followed by the actual samples.
+ * In this mode, in a single data transfer (single call to the RX transfer callback), multiple blocks of size @p num_bytes bytes are received with different center frequencies. At the beginning of each block, a @ref SWEEP_BLOCK_HEADER_SIZE byte header is present, followed by the actual samples. All fields are little-endian:
+ * - `0x7F 0x7F`
+ * - `uint64_t` frequency in Hz
+ * - `uint32_t` sweep sequence number, counting completed sweeps from 0
+ * - `uint16_t` index of the tuning within the sweep
+ * - `uint16_t` index of the block at that tuning
+ * - `uint16_t` flags, see @ref SWEEP_BLOCK_FLAG_SHORTFALL and @ref SWEEP_BLOCK_FLAG_RETUNE_FAILED
+ * - `uint32_t` device sample byte counter at the start of the block, counting skipped samples too
+ * 
+ * Gaps in the sequence of tunings and blocks show where blocks were lost. Firmware older than USB API version 0x0109 only sends the first two fields, a 10-byte header.
  * 
  * Requires USB API version 0x0102 or above!
  * @param device device to configure
  * @param frequency_list list of start-stop frequency pairs in MHz
  * @param num_ranges length of array @p frequency_list (in pairs, so total array length / 2!). Must be less than @ref MAX_SWEEP_RANGES
- * @param num_bytes number of bytes to capture per tuning, must be a multiple of @ref BYTES_PER_BLOCK
- * @param step_width width of each tuning step in Hz
+ * @param num_bytes number of bytes to capture per tuning, must be a multiple of the block size (@ref BYTES_PER_BLOCK unless changed with @ref hackrf_set_sweep_timing). @ref hackrf_start_rx_sweep fails if it is less than one block
+ * @param step_width width of each tuning step in Hz. In @ref INTERLEAVED style, must be a multiple of 4
  * @param offset frequency offset added to tuned frequencies. sample_rate / 2 is a good value
  * @param style sweep style
  * @return @ref HACKRF_SUCCESS on success or @ref hackrf_error variant
@@ -1780,6 +2597,110 @@ extern ADDAPI int ADDCALL hackrf_init_sweep(
 	const uint32_t offset,
 	const enum sweep_style style);
 
+/**
+ * Initialize sweep mode with a list of frequencies
+ * 
+ * Alternative to @ref hackrf_init_sweep that visits the frequencies in @p entries in order, then starts over, instead of stepping through ranges. Each frequency is given in Hz and has its own dwell, so sweeps can cover many narrow, non-contiguous channels without spending time on the spectrum between them. Blocks have the same format as with @ref hackrf_init_sweep, and their header carries the entry's frequency.
+ * 
+ * Each frequency plus @p offset must be within 0-7250MHz. Unlike @ref hackrf_init_sweep, this function keeps the settings made with @ref hackrf_set_sweep_timing and @ref hackrf_set_sweep_spectrum, so they may be made before or after it. @ref hackrf_start_rx_sweep fails if any dwell is shorter than the block size.
+ * 
+ * Requires USB API version 0x0109 or above!
+ * @param device device to configure
+ * @param entries list of frequencies and dwells
+ * @param num_entries length of @p entries, 1-@ref MAX_SWEEP_LIST_ENTRIES
+ * @param offset frequency offset added to tuned frequencies. sample_rate / 2 is a good value
+ * @return @ref HACKRF_SUCCESS on success or @ref hackrf_error variant
+ * @ingroup streaming
+ */
+extern ADDAPI int ADDCALL hackrf_init_sweep_list(
+	hackrf_device* device,
+	const hackrf_sweep_entry* entries,
+	const int num_entries,
+	const uint32_t offset);
+
+/**
+ * Configure sweep block size and settle time
+ * 
+ * By default, each sweep block is @ref BYTES_PER_BLOCK bytes long and is followed by two blocks' worth of discarded samples, giving the tuner time to settle after each retune. This function instead discards @p settle_samples samples counted from the moment each retune completes, and lets the blocks be shorter. Blocks at the same tuning are then captured back to back. As each block starts at a multiple of the block size, shorter blocks also give a finer settle time.
+ * 
+ * The setting is reset by @ref hackrf_init_sweep, so this function must be called after it, and before @ref hackrf_start_rx_sweep. @ref hackrf_init_sweep_list keeps it. Each block keeps the @ref SWEEP_BLOCK_HEADER_SIZE byte header, and one transfer holds a whole number of blocks.
+ * 
+ * Requires USB API version 0x0109 or above!
+ * @param device device to configure
+ * @param block_bytes size of each block in bytes. Must be a power of two between @ref MIN_BYTES_PER_BLOCK and @ref BYTES_PER_BLOCK
+ * @param settle_samples number of samples to discard after each retune, 0-65535
+ * @return @ref HACKRF_SUCCESS on success or @ref hackrf_error variant
+ * @ingroup streaming
+ */
+extern ADDAPI int ADDCALL hackrf_set_sweep_timing(
+	hackrf_device* device,
+	const uint32_t block_bytes,
+	const uint32_t settle_samples);
+
+/**
+ * Upload precomputed tuning settings
+ * 
+ * Uploads the frequencies in @p frequencies to the device, which computes the filter, mixer and IF synthesizer settings for each one in advance. When the firmware later retunes to one of these frequencies during a sweep, it programs the stored settings instead of working them out again, which shortens each retune. Entries are looked up by frequency, so they should be the frequencies actually tuned to, including any offset passed to @ref hackrf_init_sweep. Frequencies not in the table are tuned as usual.
+ * 
+ * The list should be in the order the frequencies will be tuned to. Runs of consecutive entries that are close enough together are given a shared mixer LO, with the IF moved instead, so that the firmware only reprograms the mixer when moving from one run to the next. Each entry tunes to the same RF frequency as @ref hackrf_set_freq would, although the split between LO and IF may differ.
+ * 
+ * The device plans the whole table once its last entry has arrived, and only uses it if every frequency can be tuned to. Otherwise this function fails and the device is left without a table. The table stays in place until it is replaced or cleared by calling this function with @p count set to 0. On boards without an RFFC5071 mixer (rad1o), the table is accepted but not used.
+ * 
+ * Requires USB API version 0x0109 or above!
+ * @param device device to configure
+ * @param frequencies list of frequencies in Hz, each no higher than 7250MHz
+ * @param count number of entries in @p frequencies, up to @ref MAX_TUNING_TABLE_ENTRIES
+ * @return @ref HACKRF_SUCCESS on success or @ref hackrf_error variant
+ * @ingroup streaming
+ */
+extern ADDAPI int ADDCALL hackrf_set_tuning_table(
+	hackrf_device* device,
+	const uint64_t* frequencies,
+	const int count);
+
+/**
+ * Average power spectra on the device while sweeping
+ * 
+ * Instead of sending the samples of every block, the firmware computes a Hann-windowed fixed-point FFT of every @p fft_size samples in each block, averages the power in each bin over all blocks at the same tuning, and sends one record per tuning. This greatly reduces the USB bandwidth a sweep needs, at the cost of a fixed, coarser FFT size.
+ * 
+ * Each record is @ref SWEEP_SPECTRUM_RECORD_SIZE bytes, a power of two so that records never straddle transfers. It starts with 0x7f 0x7f and the frequency (uint64), like a block header, followed by the number of FFTs averaged (uint16, saturating), @p fft_size (uint16) and the number of blocks left out of the average (uint16, saturating), and then the mean power of each bin (uint32) in FFT order, starting with DC. The rest of the record is zero. The power is the squared magnitude of FFT outputs in Q15 format, scaled by 1 / @p fft_size, so a full scale tone with the window applied reads 2^28. Use @ref hackrf_compute_sweep_spectrum to compute the same records on the host.
+ * 
+ * The setting is reset by @ref hackrf_init_sweep, so this function must be called after it, and before @ref hackrf_start_rx_sweep. @ref hackrf_init_sweep_list keeps it.
+ * 
+ * Averaging is slower than real time above about 2.8 Msps: a 256-point FFT takes about 90 us on the device. While it averages one block, the device runs out of room for the samples that follow, and blocks that lost samples, or that were received at the wrong frequency, are left out of the average and counted in the record. At 20 Msps, only about one sample in seven is averaged. The number of FFTs averaged per record shows how much of each dwell was used.
+ * 
+ * Requires USB API version 0x0109 or above!
+ * @param device device to configure
+ * @param fft_size FFT size, a power of 4 from @ref MIN_SWEEP_SPECTRUM_SIZE to @ref MAX_SWEEP_SPECTRUM_SIZE, or 0 to send samples
+ * @return @ref HACKRF_SUCCESS on success or @ref hackrf_error variant
+ * @ingroup streaming
+ */
+extern ADDAPI int ADDCALL hackrf_set_sweep_spectrum(
+	hackrf_device* device,
+	const uint16_t fft_size);
+
+/**
+ * Compute a sweep spectrum record on the host
+ * 
+ * Runs the same fixed-point code as the firmware does in @ref hackrf_set_sweep_spectrum mode, producing a bit-identical record for the same samples. This is intended for testing and for checking the device's output.
+ * 
+ * @param samples interleaved 8-bit I/Q samples of @p num_blocks consecutive blocks, as captured at one tuning
+ * @param block_bytes size of each block in bytes
+ * @param num_blocks number of blocks in @p samples
+ * @param fft_size FFT size, as for @ref hackrf_set_sweep_spectrum
+ * @param frequency frequency to write in the record header
+ * @param record buffer of @ref SWEEP_SPECTRUM_RECORD_SIZE bytes to write the record to
+ * @return @ref HACKRF_SUCCESS on success or @ref HACKRF_ERROR_INVALID_PARAM
+ * @ingroup streaming
+ */
+extern ADDAPI int ADDCALL hackrf_compute_sweep_spectrum(
+	const int8_t* samples,
+	const uint32_t block_bytes,
+	const uint32_t num_blocks,
+	const uint16_t fft_size,
+	const uint64_t frequency,
+	uint8_t* record);
+
 /**
  * Query connected Opera Cake boards
  * 
@@ -1989,7 +2910,7 @@ extern ADDAPI int ADDCALL hackrf_set_ui_enable(hackrf_device* device, const uint
 /**
  * Start RX sweep
  * 
- * See @ref hackrf_init_sweep for more info
+ * See @ref hackrf_init_sweep for more info. Fails if a dwell set with @ref hackrf_init_sweep or @ref hackrf_init_sweep_list is shorter than the block size.
  *
  * Requires USB API version 0x0104 or above!
  * @param device device to start sweeping
@@ -2003,6 +2924,74 @@ extern ADDAPI int ADDCALL hackrf_start_rx_sweep(
 	hackrf_sample_block_cb_fn callback,
 	void* rx_ctx);
 
+/**
+ * Upload the hop table used by @ref hackrf_start_rx_hop and @ref hackrf_start_tx_hop
+ * 
+ * The device tunes to the first entry when hopping starts. At the end of each entry's dwell, the device skips @p gap_samples samples while it tunes to the next entry and sets its gains, returning to the first entry after the last. The stream position of every hop therefore follows from the table: the first dwell starts at sample 0, and each dwell starts @p gap_samples samples after the previous one ends.
+ * 
+ * In RX, the samples received during a gap are not valid, and the gap instead starts with a @ref HACKRF_HOP_TAG_SIZE byte tag. All fields are little-endian:
+ * - 2 bytes: 0x7f, 0x7f
+ * - 8 bytes: frequency of the next entry in Hz
+ * - 4 bytes: number of times the whole table has been completed
+ * - 2 bytes: index of the next entry
+ * - 2 bytes: flags, see @ref HACKRF_HOP_TAG_FLAG_LATE
+ * - 4 bytes: byte position in the stream at which the next dwell starts
+ * - 10 bytes: zero
+ * 
+ * In TX, the samples sent for a gap are skipped, and the device transmits zeroes while it retunes.
+ * 
+ * The gap should be long enough to retune, including any settling time. This function also uploads the table's frequencies with @ref hackrf_set_tuning_table to shorten each retune, replacing any tuning table. If the device is too late to stop at the end of a dwell or resume at the end of a gap, for example while it handles a slow request such as @ref hackrf_set_freq, the hop and all following positions are delayed. In RX, the tag is then flagged with @ref HACKRF_HOP_TAG_FLAG_LATE, and gives the actual position.
+ * 
+ * The table can't be changed while hopping. Gains are rounded down to valid steps as by the individual setter functions.
+ * 
+ * Requires USB API version 0x0109 or above!
+ * @param device device to configure
+ * @param entries hop table entries
+ * @param count number of entries, up to @ref MAX_HOP_TABLE_ENTRIES. 0 clears the table
+ * @param gap_samples number of samples to skip at each hop. At least @ref MIN_HOP_SAMPLES, and a multiple of 16
+ * @return @ref HACKRF_SUCCESS on success or @ref hackrf_error variant
+ * @ingroup streaming
+ */
+extern ADDAPI int ADDCALL hackrf_set_hop_table(
+	hackrf_device* device,
+	const hackrf_hop_entry* entries,
+	const int count,
+	const uint16_t gap_samples);
+
+/**
+ * Start receiving in hop mode
+ * 
+ * See @ref hackrf_set_hop_table for more info. With an empty hop table, this receives as @ref hackrf_start_rx does.
+ *
+ * Requires USB API version 0x0109 or above!
+ * @param device device to start hopping
+ * @param callback rx callback processing the received data
+ * @param rx_ctx User provided RX context. Not used by the library, but available to @p callback as @ref hackrf_transfer.rx_ctx.
+ * @return @ref HACKRF_SUCCESS on success or @ref hackrf_error variant
+ * @ingroup streaming
+ */
+extern ADDAPI int ADDCALL hackrf_start_rx_hop(
+	hackrf_device* device,
+	hackrf_sample_block_cb_fn callback,
+	void* rx_ctx);
+
+/**
+ * Start transmitting in hop mode
+ * 
+ * See @ref hackrf_set_hop_table for more info. With an empty hop table, this transmits as @ref hackrf_start_tx does. Stop with @ref hackrf_stop_tx.
+ *
+ * Requires USB API version 0x0109 or above!
+ * @param device device to start hopping
+ * @param callback tx callback filling the transfer buffers
+ * @param tx_ctx User provided TX context. Not used by the library, but available to @p callback as @ref hackrf_transfer.tx_ctx.
+ * @return @ref HACKRF_SUCCESS on success or @ref hackrf_error variant
+ * @ingroup streaming
+ */
+extern ADDAPI int ADDCALL hackrf_start_tx_hop(
+	hackrf_device* device,
+	hackrf_sample_block_cb_fn callback,
+	void* tx_ctx);
+
 // docsstring partly from hackrf.c
 /**
  * Get USB transfer buffer size.
@@ -2056,6 +3045,20 @@ extern ADDAPI int ADDCALL hackrf_supported_platform_read(
 	hackrf_device* device,
 	uint32_t* value);
 
+/**
+ * Get device information cached when the device was opened
+ * 
+ * Returns the USB API version, board ID, board revision and supported platform without communicating with the device. Values that the firmware could not report are left at @ref BOARD_ID_UNDETECTED, @ref BOARD_REV_UNDETECTED or zero.
+ * 
+ * @param[in] device device to query
+ * @param[out] info device information
+ * @return @ref HACKRF_SUCCESS on success or @ref HACKRF_ERROR_INVALID_PARAM if @p info is NULL
+ * @ingroup device
+ */
+extern ADDAPI int ADDCALL hackrf_get_device_info(
+	hackrf_device* device,
+	hackrf_device_info* info);
+
 /**
  * Turn on or off (override) the LEDs of the HackRF device
  * 
@@ -0,0 +1,80 @@
+/*
+ * Copyright 2026 Great Scott Gadgets <info@greatscottgadgets.com>
+ *
+ * This file is part of HackRF.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __TEST_H__
+#define __TEST_H__
+
+#include <stdio.h>
+
+/*
+ * Each test program counts failed checks and returns nonzero if there
+ * were any. A failed check reports where it was and carries on.
+ */
+static int test_failures = 0;
+
+#define CHECK(condition)                                         \
+	do {                                                     \
+		if (!(condition)) {                              \
+			fprintf(stderr,                          \
+				"%s:%d: check failed: %s\n",     \
+				__FILE__,                        \
+				__LINE__,                        \
+				#condition);                     \
+			test_failures++;                         \
+		}                                                \
+	} while (0)
+
+#define CHECK_EQUAL(actual, expected)                                      \
+	do {                                                               \
+		unsigned long long a_ = (unsigned long long) (actual);     \
+		unsigned long long e_ = (unsigned long long) (expected);   \
+		if (a_ != e_) {                                            \
+			fprintf(stderr,                                    \
+				"%s:%d: %s is %llu, expected %llu\n",      \
+				__FILE__,                                  \
+				__LINE__,                                  \
+				#actual,                                   \
+				a_,                                        \
+				e_);                                       \
+			test_failures++;                                   \
+		}                                                          \
+	} while (0)
+
+static int test_result(const char* const name)
+{
+	if (test_failures > 0) {
+		fprintf(stderr, "%s: %d checks failed\n", name, test_failures);
+		return 1;
+	}
+	printf("%s: all checks passed\n", name);
+	return 0;
+}
+
+/* Small deterministic generator, so that failures can be reproduced. */
+static unsigned long test_random_state = 1;
+
+static inline unsigned long test_random(void)
+{
+	test_random_state = test_random_state * 1103515245 + 12345;
+	return (test_random_state >> 16) & 0x7fff;
+}
+
+#endif /*__TEST_H__*/
@@ -0,0 +1,231 @@
+/*
+ * Copyright 2026 Great Scott Gadgets <info@greatscottgadgets.com>
+ *
+ * This file is part of HackRF.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "command_queue.h"
+#include "test.h"
+
+#include <stdint.h>
+#include <string.h>
+
+static command_t make_command(const uint32_t when, const uint8_t type, const uint64_t value)
+{
+	command_t command;
+
+	memset(&command, 0, sizeof(command));
+	command.when = when;
+	command.type = type;
+	command.value = value;
+	return command;
+}
+
+/* Commands come out in order of position, then of insertion. */
+static void test_ordering(void)
+{
+	command_queue_t queue;
+	command_t command;
+	uint32_t last_when = 0;
+	uint64_t last_value = 0;
+	int i;
+
+	command_queue_init(&queue);
+	for (i = 0; i < COMMAND_QUEUE_SIZE; i++) {
+		command = make_command(
+			(1 + (test_random() % 8)) * COMMAND_ALIGNMENT,
+			COMMAND_SET_FREQ,
+			i);
+		CHECK(command_queue_insert(&queue, &command, 0));
+	}
+	CHECK_EQUAL(command_queue_space(&queue), 0);
+
+	// A full queue takes nothing more.
+	command = make_command(COMMAND_ALIGNMENT, COMMAND_SET_FREQ, 0);
+	CHECK(!command_queue_insert(&queue, &command, 0));
+
+	for (i = 0; i < COMMAND_QUEUE_SIZE; i++) {
+		CHECK(command_queue_due(&queue, 8 * COMMAND_ALIGNMENT));
+		command = *command_queue_head(&queue);
+		CHECK(command.when >= last_when);
+		if (command.when == last_when) {
+			CHECK(command.value > last_value);
+		}
+		last_when = command.when;
+		last_value = command.value;
+		command_queue_pop(&queue);
+	}
+	CHECK(command_queue_head(&queue) == NULL);
+	CHECK(!command_queue_due(&queue, 8 * COMMAND_ALIGNMENT));
+	CHECK_EQUAL(command_queue_space(&queue), COMMAND_QUEUE_SIZE);
+}
+
+/* Positions wrap at 2^32, and only positions after now are accepted. */
+static void test_wrap(void)
+{
+	const uint32_t now = 0xffffff00;
+	command_queue_t queue;
+	command_t command;
+
+	command_queue_init(&queue);
+	command = make_command(0x40, COMMAND_SET_FREQ, 1);
+	CHECK(command_queue_insert(&queue, &command, now));
+	command = make_command(0xffffffe0, COMMAND_SET_FREQ, 2);
+	CHECK(command_queue_insert(&queue, &command, now));
+
+	// Now, or just before it, has already passed.
+	command = make_command(now, COMMAND_SET_FREQ, 3);
+	CHECK(!command_queue_insert(&queue, &command, now));
+	command = make_command(now - COMMAND_ALIGNMENT, COMMAND_SET_FREQ, 3);
+	CHECK(!command_queue_insert(&queue, &command, now));
+
+	// The position before the wrap comes first.
+	CHECK(!command_queue_due(&queue, now));
+	CHECK(command_queue_due(&queue, 0xffffffe0));
+	CHECK_EQUAL(command_queue_head(&queue)->value, 2);
+	command_queue_pop(&queue);
+	CHECK(!command_queue_due(&queue, 0xffffffe0));
+	CHECK(command_queue_due(&queue, 0x40));
+	CHECK_EQUAL(command_queue_head(&queue)->value, 1);
+}
+
+/* Pause and resume must leave the M4 time to arm them. */
+static void test_arm_guard(void)
+{
+	const uint32_t now = 0xfffffe00;
+	command_queue_t queue;
+	command_t command;
+
+	command_queue_init(&queue);
+	command = make_command(now + COMMAND_ARM_GUARD - COMMAND_ALIGNMENT, COMMAND_PAUSE, 0);
+	CHECK(!command_queue_insert(&queue, &command, now));
+	command = make_command(now + COMMAND_ARM_GUARD, COMMAND_PAUSE, 0);
+	CHECK(command_queue_insert(&queue, &command, now));
+
+	// Other settings may be close to now and to a mode switch.
+	command = make_command(now + COMMAND_ALIGNMENT, COMMAND_LNA_GAIN, 8);
+	CHECK(command_queue_insert(&queue, &command, now));
+	command = make_command(now + COMMAND_ARM_GUARD, COMMAND_VGA_GAIN, 8);
+	CHECK(command_queue_insert(&queue, &command, now));
+
+	// Mode switches must be a guard apart, either side of another.
+	command = make_command(
+		now + 2 * COMMAND_ARM_GUARD - COMMAND_ALIGNMENT,
+		COMMAND_RESUME,
+		0);
+	CHECK(!command_queue_insert(&queue, &command, now));
+	command = make_command(now + 3 * COMMAND_ARM_GUARD, COMMAND_RESUME, 0);
+	CHECK(command_queue_insert(&queue, &command, now));
+	command = make_command(
+		now + 2 * COMMAND_ARM_GUARD + COMMAND_ALIGNMENT,
+		COMMAND_PAUSE,
+		0);
+	CHECK(!command_queue_insert(&queue, &command, now));
+	command = make_command(now + 2 * COMMAND_ARM_GUARD, COMMAND_PAUSE, 0);
+	CHECK(command_queue_insert(&queue, &command, now));
+	CHECK_EQUAL(command_queue_space(&queue), COMMAND_QUEUE_SIZE - 5);
+}
+
+/* A late mode switch is moved to the first aligned position still safe. */
+static void test_arm_position(void)
+{
+	uint32_t now, when, position;
+	int n;
+
+	CHECK_EQUAL(command_arm_position(0x1000, 0), 0x1000);
+	CHECK_EQUAL(command_arm_position(0x1000, 0x1000 - COMMAND_ARM_GUARD), 0x1000);
+	CHECK_EQUAL(command_arm_position(0x1000, 0x1001 - COMMAND_ARM_GUARD), 0x1020);
+	CHECK_EQUAL(command_arm_position(0x1000, 0x2000), 0x2000 + COMMAND_ARM_GUARD);
+	CHECK_EQUAL(command_arm_position(0x20, 0xfffffff8), 0x200);
+
+	// The M0 count always advances a whole COMMAND_ALIGNMENT at a time.
+	for (n = 0; n < 10000; n++) {
+		now = ((uint32_t) test_random() << 17) ^ ((uint32_t) test_random() << 5);
+		when = now + (((uint32_t) test_random() % 64) - 16) * COMMAND_ALIGNMENT;
+		position = command_arm_position(when, now);
+		CHECK_EQUAL(position % COMMAND_ALIGNMENT, 0);
+		CHECK((int32_t) (position - now) >= COMMAND_ARM_GUARD);
+		CHECK((int32_t) (position - when) >= 0);
+		if ((int32_t) (when - now) >= COMMAND_ARM_GUARD) {
+			CHECK_EQUAL(position, when);
+		} else {
+			CHECK((int32_t) (position - now) < COMMAND_ARM_GUARD + COMMAND_ALIGNMENT);
+		}
+	}
+}
+
+static void test_valid(void)
+{
+	command_t command;
+
+	command = make_command(COMMAND_ALIGNMENT, COMMAND_LNA_GAIN, 40);
+	CHECK(command_valid(&command));
+	command.when++;
+	CHECK(!command_valid(&command));
+	command = make_command(0, COMMAND_LNA_GAIN, 12);
+	CHECK(!command_valid(&command));
+	command = make_command(0, COMMAND_VGA_GAIN, 63);
+	CHECK(!command_valid(&command));
+	command = make_command(0, COMMAND_TXVGA_GAIN, 48);
+	CHECK(!command_valid(&command));
+	command = make_command(0, COMMAND_AMP_ENABLE, 2);
+	CHECK(!command_valid(&command));
+	command = make_command(0, COMMAND_OPERACAKE_PORTS, 0x1000000);
+	CHECK(!command_valid(&command));
+	command = make_command(0, COMMAND_PAUSE, 1);
+	CHECK(!command_valid(&command));
+	command = make_command(0, COMMAND_TYPE_COUNT, 0);
+	CHECK(!command_valid(&command));
+	command = make_command(0, COMMAND_RESUME, 0);
+	CHECK(command_valid(&command));
+	CHECK(command_switches_mode(&command));
+	command = make_command(0, COMMAND_SET_FREQ, 2450000000ULL);
+	CHECK(command_valid(&command));
+	CHECK(!command_switches_mode(&command));
+}
+
+static void test_packing(void)
+{
+	// clang-format off
+	const uint8_t expected[COMMAND_SIZE] = {
+		0x20, 0x43, 0x65, 0x87, 0x06, 0x00, 0x00, 0x00,
+		0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef,
+	};
+	// clang-format on
+	uint8_t data[COMMAND_SIZE];
+	command_t command, unpacked;
+
+	command = make_command(0x87654320, COMMAND_OPERACAKE_PORTS, 0xefcdab8967452301ULL);
+	command_pack(&command, data);
+	CHECK_EQUAL(memcmp(data, expected, COMMAND_SIZE), 0);
+	command_unpack(data, &unpacked);
+	CHECK_EQUAL(unpacked.when, command.when);
+	CHECK_EQUAL(unpacked.type, command.type);
+	CHECK_EQUAL(unpacked.value, command.value);
+}
+
+int main(void)
+{
+	test_ordering();
+	test_wrap();
+	test_arm_guard();
+	test_arm_position();
+	test_valid();
+	test_packing();
+	return test_result("command_queue");
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2026 Great Scott Gadgets <info@greatscottgadgets.com>
+ *
+ * This file is part of HackRF.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "config_bundle.h"
+#include "test.h"
+
+#include <stdint.h>
+
+static config_bundle_t config;
+
+static bool parse(const uint8_t* const data, const uint16_t length)
+{
+	return config_bundle_parse(data, length, &config);
+}
+
+static void test_valid(void)
+{
+	// 2.45GHz, 20MHz filter, LNA 16dB, VGA 20dB, TX VGA 47dB, amp on.
+	// clang-format off
+	const uint8_t bundle[] = {
+		1, 8, 0x80, 0x08, 0x08, 0x92, 0, 0, 0, 0,
+		2, 4, 0x00, 0x2d, 0x31, 0x01,
+		3, 1, 16,
+		4, 1, 20,
+		5, 1, 47,
+		6, 1, 1,
+	};
+	// clang-format on
+	const uint8_t short_values[] = {3, 1, 8, 1, 3, 0x80, 0x96, 0x98};
+
+	CHECK(parse(bundle, sizeof(bundle)));
+	CHECK_EQUAL(config.present, 0x7e);
+	CHECK_EQUAL(config.values[CONFIG_TAG_FREQ], 2450000000ULL);
+	CHECK_EQUAL(config.values[CONFIG_TAG_BASEBAND_FILTER], 20000000);
+	CHECK_EQUAL(config.values[CONFIG_TAG_LNA_GAIN], 16);
+	CHECK_EQUAL(config.values[CONFIG_TAG_VGA_GAIN], 20);
+	CHECK_EQUAL(config.values[CONFIG_TAG_TXVGA_GAIN], 47);
+	CHECK_EQUAL(config.values[CONFIG_TAG_AMP_ENABLE], 1);
+
+	// Values may use fewer bytes, and entries may come in any order.
+	CHECK(parse(short_values, sizeof(short_values)));
+	CHECK_EQUAL(config.present, (1 << CONFIG_TAG_FREQ) | (1 << CONFIG_TAG_LNA_GAIN));
+	CHECK_EQUAL(config.values[CONFIG_TAG_FREQ], 10000000);
+
+	CHECK(parse(bundle, 0));
+	CHECK_EQUAL(config.present, 0);
+}
+
+static void test_malformed(void)
+{
+	const uint8_t duplicate[] = {3, 1, 8, 3, 1, 16};
+	const uint8_t truncated[] = {1, 8, 0x80, 0x08, 0x08};
+	const uint8_t no_length[] = {3, 1, 8, 4};
+	const uint8_t bad_tag[] = {7, 1, 0};
+	const uint8_t zero_tag[] = {0, 1, 0};
+	const uint8_t empty_value[] = {3, 0};
+	const uint8_t long_value[] = {1, 9, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+	CHECK(!parse(duplicate, sizeof(duplicate)));
+	CHECK(!parse(truncated, sizeof(truncated)));
+	CHECK(!parse(no_length, sizeof(no_length)));
+	CHECK(!parse(bad_tag, sizeof(bad_tag)));
+	CHECK(!parse(zero_tag, sizeof(zero_tag)));
+	CHECK(!parse(empty_value, sizeof(empty_value)));
+	CHECK(!parse(long_value, sizeof(long_value)));
+}
+
+static void test_range(void)
+{
+	const uint8_t freq_high[] = {1, 5, 0xc0, 0x7a, 0x31, 0xb0, 0x01};
+	const uint8_t freq_max[] = {1, 5, 0xbf, 0x7a, 0x31, 0xb0, 0x01};
+	const uint8_t filter_high[] = {2, 5, 0, 0, 0, 0, 1};
+	const uint8_t lna_odd[] = {3, 1, 12};
+	const uint8_t lna_high[] = {3, 1, 48};
+	const uint8_t vga_odd[] = {4, 1, 21};
+	const uint8_t vga_high[] = {4, 1, 64};
+	const uint8_t txvga_high[] = {5, 1, 48};
+	const uint8_t amp_high[] = {6, 1, 2};
+
+	// Just under 7251MHz is the highest frequency that can be tuned to.
+	CHECK(parse(freq_max, sizeof(freq_max)));
+	CHECK_EQUAL(config.values[CONFIG_TAG_FREQ], 7250999999ULL);
+	CHECK(!parse(freq_high, sizeof(freq_high)));
+
+	CHECK(!parse(filter_high, sizeof(filter_high)));
+	CHECK(!parse(lna_odd, sizeof(lna_odd)));
+	CHECK(!parse(lna_high, sizeof(lna_high)));
+	CHECK(!parse(vga_odd, sizeof(vga_odd)));
+	CHECK(!parse(vga_high, sizeof(vga_high)));
+	CHECK(!parse(txvga_high, sizeof(txvga_high)));
+	CHECK(!parse(amp_high, sizeof(amp_high)));
+}
+
+int main(void)
+{
+	test_valid();
+	test_malformed();
+	test_range();
+	return test_result("config_bundle");
+}
@@ -0,0 +1,140 @@
+/*
+ * Copyright 2026 Great Scott Gadgets <info@greatscottgadgets.com>
+ *
+ * This file is part of HackRF.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Included rather than linked, to compare against the bitwise update. */
+#include "crc.c"
+#include "test.h"
+
+#include <time.h>
+
+#define BUFFER_SIZE 4096
+
+static uint8_t buffer[BUFFER_SIZE];
+
+static uint32_t table_crc(const uint8_t* const data, const size_t length)
+{
+	crc32_t crc;
+
+	crc32_init(&crc);
+	crc32_update(&crc, data, length);
+	return crc32_digest(&crc);
+}
+
+static uint32_t bitwise_crc(const uint8_t* const data, const size_t length)
+{
+	crc32_t crc;
+
+	crc32_init(&crc);
+	crc32_update_bitwise(&crc, data, length);
+	return crc32_digest(&crc);
+}
+
+static void test_check_values(void)
+{
+	const uint8_t check[] = "123456789";
+	crc32_t crc;
+
+	CHECK_EQUAL(table_crc(check, 9), 0xcbf43926);
+	CHECK_EQUAL(bitwise_crc(check, 9), 0xcbf43926);
+	CHECK_EQUAL(table_crc(check, 0), 0);
+
+	// Other polynomials fall back to the bitwise update (CRC-32C here).
+	crc32_init(&crc);
+	crc.reversed_polynomial = 0x82f63b78;
+	crc32_update(&crc, check, 9);
+	CHECK_EQUAL(crc32_digest(&crc), 0xe3069283);
+}
+
+/* The stored slice tables follow from the byte table. */
+static void test_slices(void)
+{
+	uint32_t remainder;
+	int i, slice;
+
+	for (i = 0; i < 256; i++) {
+		remainder = crc32_table[i];
+		for (slice = 0; slice < 3; slice++) {
+			remainder = (remainder >> 8) ^ crc32_table[remainder & 0xff];
+			CHECK_EQUAL(crc32_slices[slice][i], remainder);
+		}
+	}
+}
+
+/* Random buffers, lengths and alignments, in one or several updates. */
+static void test_random_buffers(void)
+{
+	crc32_t crc;
+	size_t offset, length, split;
+	int i, n;
+
+	for (n = 0; n < 1000; n++) {
+		for (i = 0; i < BUFFER_SIZE; i++) {
+			buffer[i] = test_random();
+		}
+		offset = test_random() % 8;
+		length = test_random() % (BUFFER_SIZE - 8);
+		CHECK_EQUAL(
+			table_crc(&buffer[offset], length),
+			bitwise_crc(&buffer[offset], length));
+
+		split = length ? (test_random() % length) : 0;
+		crc32_init(&crc);
+		crc32_update(&crc, &buffer[offset], split);
+		crc32_update(&crc, &buffer[offset + split], length - split);
+		CHECK_EQUAL(crc32_digest(&crc), bitwise_crc(&buffer[offset], length));
+	}
+}
+
+/* Report throughput of both updates. This doesn't fail the test. */
+static void measure_throughput(void)
+{
+	crc32_t crc;
+	clock_t start;
+	double table_seconds, bitwise_seconds;
+	int i;
+
+	crc32_init(&crc);
+	start = clock();
+	for (i = 0; i < 4096; i++) {
+		crc32_update(&crc, buffer, BUFFER_SIZE);
+	}
+	table_seconds = (double) (clock() - start) / CLOCKS_PER_SEC;
+
+	start = clock();
+	for (i = 0; i < 64; i++) {
+		crc32_update_bitwise(&crc, buffer, BUFFER_SIZE);
+	}
+	bitwise_seconds = (double) (clock() - start) / CLOCKS_PER_SEC;
+
+	printf("crc32_update: %.1f MB/s, bitwise: %.1f MB/s (%08x)\n",
+	       (4096.0 * BUFFER_SIZE / 1e6) / (table_seconds + 1e-9),
+	       (64.0 * BUFFER_SIZE / 1e6) / (bitwise_seconds + 1e-9),
+	       (unsigned int) crc32_digest(&crc));
+}
+
+int main(void)
+{
+	test_check_values();
+	test_slices();
+	test_random_buffers();
+	measure_throughput();
+	return test_result("crc");
+}
@@ -0,0 +1,193 @@
+/*
+ * Copyright 2026 Great Scott Gadgets <info@greatscottgadgets.com>
+ *
+ * This file is part of HackRF.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "hop_schedule.h"
+#include "test.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * A model of the M0 in TX hop mode. It either transmits or, in the gap
+ * mode, writes zeros, and switches to the next mode when its count
+ * reaches the threshold, as jump_next_mode does.
+ */
+#define MODE_MUTED 0
+#define MODE_TX    1
+
+typedef struct {
+	uint32_t count;
+	int mode;
+	int next_mode;
+	uint32_t threshold;
+} m0_model_t;
+
+static int m0_exchange(m0_model_t* const m0)
+{
+	const int mode = m0->mode;
+
+	m0->count += 32;
+	if (m0->count == m0->threshold) {
+		m0->mode = m0->next_mode;
+	}
+	return mode;
+}
+
+#define GAP_BYTES   16384
+#define NUM_ENTRIES 3
+static const uint32_t dwells[NUM_ENTRIES] = {8192, 16384, 24576};
+
+typedef struct {
+	hop_schedule_t schedule;
+	m0_model_t m0;
+	/* Entry the radio is tuned to. */
+	int tuned;
+	int retunes;
+	/* Set if a retune happened while the M0 was transmitting. */
+	bool retuned_on_air;
+	bool late;
+} hop_model_t;
+
+static void hop_model_start(hop_model_t* const model)
+{
+	hop_schedule_start(&model->schedule, GAP_BYTES, dwells[0]);
+	model->m0.count = 0;
+	model->m0.mode = MODE_TX;
+	model->m0.next_mode = MODE_MUTED;
+	model->m0.threshold = model->schedule.boundary;
+	model->tuned = 0;
+	model->retunes = 0;
+	model->retuned_on_air = false;
+	model->late = false;
+}
+
+/* What hop_run() does, with the retune reduced to a change of entry. */
+static void hop_model_run(hop_model_t* const model)
+{
+	hop_schedule_t* const schedule = &model->schedule;
+	m0_model_t* const m0 = &model->m0;
+
+	switch (hop_schedule_step(schedule, m0->count, dwells[model->tuned])) {
+	case HOP_STEP_NONE:
+		break;
+	case HOP_STEP_DWELL:
+		m0->next_mode = MODE_MUTED;
+		m0->threshold = schedule->boundary;
+		break;
+	case HOP_STEP_GAP:
+		m0->next_mode = MODE_TX;
+		m0->threshold = schedule->resume;
+		if (m0->mode != MODE_MUTED) {
+			model->retuned_on_air = true;
+		}
+		model->tuned = (model->tuned + 1) % NUM_ENTRIES;
+		model->retunes++;
+		if (schedule->late) {
+			model->late = true;
+		}
+		schedule->late = false;
+		break;
+	}
+}
+
+/*
+ * With the M4 on time, the stream is exactly the table: each dwell is
+ * transmitted at its own entry, and every gap is muted.
+ */
+static void test_on_time(void)
+{
+	hop_model_t model;
+	uint32_t position = 0;
+	uint32_t end;
+	int entry = 0;
+	int hops;
+
+	hop_model_start(&model);
+	for (hops = 0; hops < 2 * NUM_ENTRIES; hops++) {
+		end = position + dwells[entry] * 2;
+		while (model.m0.count < end) {
+			hop_model_run(&model);
+			CHECK_EQUAL(model.tuned, entry);
+			CHECK_EQUAL(m0_exchange(&model.m0), MODE_TX);
+		}
+		end += GAP_BYTES;
+		while (model.m0.count < end) {
+			hop_model_run(&model);
+			CHECK_EQUAL(m0_exchange(&model.m0), MODE_MUTED);
+		}
+		position = end;
+		entry = (entry + 1) % NUM_ENTRIES;
+	}
+	CHECK_EQUAL(model.retunes, 2 * NUM_ENTRIES);
+	CHECK(!model.retuned_on_air);
+	CHECK(!model.late);
+}
+
+/*
+ * With the M4 held up, for example by a slow control request, gaps and
+ * dwells move later and may grow, but the radio is still only retuned
+ * while the M0 is muted, and no dwell is cut short.
+ */
+static void test_late(void)
+{
+	hop_model_t model;
+	uint32_t run = 0;
+	int mode = MODE_TX;
+	int tuned = 0;
+	int exchange;
+	int result;
+
+	hop_model_start(&model);
+	for (exchange = 0; exchange < 40000; exchange++) {
+		// The M4 misses 1000 exchanges out of every 3000.
+		if ((exchange % 3000) >= 1000) {
+			hop_model_run(&model);
+		}
+		result = m0_exchange(&model.m0);
+		if (result != mode) {
+			if (mode == MODE_TX) {
+				CHECK(run >= dwells[tuned] * 2);
+			} else {
+				CHECK(run >= GAP_BYTES);
+			}
+			mode = result;
+			run = 0;
+		}
+		if (result == MODE_TX) {
+			// The whole dwell is sent at the same entry.
+			if (run == 0) {
+				tuned = model.tuned;
+			}
+			CHECK_EQUAL(model.tuned, tuned);
+		}
+		run += 32;
+	}
+	CHECK(model.retunes > NUM_ENTRIES);
+	CHECK(!model.retuned_on_air);
+	CHECK(model.late);
+}
+
+int main(void)
+{
+	test_on_time();
+	test_late();
+	return test_result("hop_schedule");
+}
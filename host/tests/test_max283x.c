@@ -0,0 +1,251 @@
+/*
+ * Copyright 2026 Great Scott Gadgets <info@greatscottgadgets.com>
+ *
+ * This file is part of HackRF.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "max2837.h"
+#include "max2839.h"
+#include "test.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#define NUM_REGS 32
+
+#define REG_SYN_FRAC_LO 17
+#define REG_SYN_FRAC_HI 18
+#define REG_SYN_INT     19
+
+/*
+ * Mock transceiver on a mock SPI bus. Every word written updates the
+ * mock's registers, and each spi_bus_transfer_frames() call is counted
+ * along with the order in which its words arrived. The driver's copy of
+ * the registers must always match the mock's once committed.
+ */
+typedef struct {
+	uint16_t regs[NUM_REGS];
+	int transfers;
+	int batches;
+	int words;
+	int last_batch_start;
+	int sequence;
+	int written_at[NUM_REGS];
+	uint32_t written;
+} mock_chip_t;
+
+static mock_chip_t chip;
+
+static void mock_word(const uint16_t word)
+{
+	const int r = (word >> 10) & 0x1f;
+
+	CHECK(!(word & 0x8000));
+	chip.regs[r] = word & 0x3ff;
+	chip.written_at[r] = chip.sequence++;
+	chip.written |= 1 << r;
+	chip.words++;
+}
+
+static void mock_start(spi_bus_t* const bus, const void* const config)
+{
+	(void) bus;
+	(void) config;
+}
+
+static void mock_stop(spi_bus_t* const bus)
+{
+	(void) bus;
+}
+
+static void mock_transfer(spi_bus_t* const bus, void* const data, const size_t count)
+{
+	(void) bus;
+	CHECK_EQUAL(count, 1);
+	mock_word(*(uint16_t*) data);
+	chip.transfers++;
+}
+
+static void mock_transfer_gather(
+	spi_bus_t* const bus,
+	const spi_transfer_t* const transfers,
+	const size_t count)
+{
+	(void) bus;
+	(void) transfers;
+	(void) count;
+	CHECK(0);
+}
+
+static void mock_transfer_frames(spi_bus_t* const bus, void* const data, const size_t count)
+{
+	const uint16_t* const words = data;
+	size_t i;
+
+	(void) bus;
+	CHECK(count > 0);
+	CHECK(count <= NUM_REGS);
+	chip.last_batch_start = chip.sequence;
+	for (i = 0; i < count; i++) {
+		// Registers are sent in order, each at most once per batch.
+		if (i > 0) {
+			CHECK(((words[i] >> 10) & 0x1f) > ((words[i - 1] >> 10) & 0x1f));
+		}
+		mock_word(words[i]);
+	}
+	chip.batches++;
+}
+
+static spi_bus_t mock_bus = {
+	.obj = NULL,
+	.config = NULL,
+	.start = mock_start,
+	.stop = mock_stop,
+	.transfer = mock_transfer,
+	.transfer_gather = mock_transfer_gather,
+	.transfer_frames = mock_transfer_frames,
+};
+
+/* Clear the counters. The mock's registers keep their values. */
+static void mock_reset(void)
+{
+	uint16_t regs[NUM_REGS];
+
+	memcpy(regs, chip.regs, sizeof(regs));
+	memset(&chip, 0, sizeof(chip));
+	memcpy(chip.regs, regs, sizeof(regs));
+	chip.sequence = 1;
+}
+
+static void max2837_target_init(max2837_driver_t* const drv)
+{
+	(void) drv;
+}
+
+static void max2837_target_set_mode(max2837_driver_t* const drv, const max2837_mode_t mode)
+{
+	drv->mode = mode;
+}
+
+static void max2839_target_init(max2839_driver_t* const drv)
+{
+	(void) drv;
+}
+
+static void max2839_target_set_mode(max2839_driver_t* const drv, const max2839_mode_t mode)
+{
+	drv->mode = mode;
+}
+
+static void check_synth_order(void)
+{
+	CHECK(chip.written & (1 << REG_SYN_INT));
+	CHECK(chip.written & (1 << REG_SYN_FRAC_HI));
+	CHECK(chip.written & (1 << REG_SYN_FRAC_LO));
+
+	// FRAC_LO starts VCO auto-select, so it must be written last.
+	CHECK(chip.written_at[REG_SYN_FRAC_LO] > chip.written_at[REG_SYN_INT]);
+	CHECK(chip.written_at[REG_SYN_FRAC_LO] > chip.written_at[REG_SYN_FRAC_HI]);
+	CHECK(chip.written_at[REG_SYN_FRAC_HI] < chip.last_batch_start);
+}
+
+static void test_max2837(void)
+{
+	max2837_driver_t drv;
+	uint32_t freq;
+	int r;
+
+	memset(&drv, 0, sizeof(drv));
+	drv.bus = &mock_bus;
+	drv.target_init = max2837_target_init;
+	drv.set_mode = max2837_target_set_mode;
+
+	// Setup writes every register, each commit in a single batch.
+	mock_reset();
+	max2837_setup(&drv);
+	CHECK_EQUAL(chip.batches, 2);
+	CHECK_EQUAL(chip.transfers, 0);
+	CHECK(chip.words >= NUM_REGS);
+	CHECK_EQUAL(drv.regs_dirty, 0);
+	for (r = 0; r < NUM_REGS; r++) {
+		CHECK_EQUAL(chip.regs[r], drv.regs[r]);
+	}
+
+	// Nothing dirty, nothing sent.
+	mock_reset();
+	max2837_regs_commit(&drv);
+	CHECK_EQUAL(chip.words, 0);
+
+	for (freq = 2170000000U; freq <= 2740000000U; freq += 10000000U) {
+		mock_reset();
+		max2837_set_frequency(&drv, freq);
+		CHECK(chip.batches <= 2);
+		CHECK_EQUAL(chip.transfers, 0);
+		check_synth_order();
+		for (r = 0; r < NUM_REGS; r++) {
+			CHECK_EQUAL(chip.regs[r], drv.regs[r]);
+		}
+	}
+
+	// Gain changes still write their single register directly.
+	mock_reset();
+	max2837_rx(&drv);
+	CHECK_EQUAL(chip.batches, 1);
+	CHECK(max2837_set_lna_gain(&drv, 16));
+	CHECK(max2837_set_vga_gain(&drv, 20));
+	CHECK_EQUAL(drv.mode, MAX2837_MODE_RX);
+	CHECK_EQUAL(drv.regs_dirty, 0);
+	for (r = 0; r < NUM_REGS; r++) {
+		CHECK_EQUAL(chip.regs[r], drv.regs[r]);
+	}
+}
+
+static void test_max2839(void)
+{
+	max2839_driver_t drv;
+	uint32_t freq;
+	int r;
+
+	memset(&drv, 0, sizeof(drv));
+	drv.bus = &mock_bus;
+	drv.target_init = max2839_target_init;
+	drv.set_mode = max2839_target_set_mode;
+
+	mock_reset();
+	max2839_setup(&drv);
+	CHECK_EQUAL(chip.transfers, 0);
+	CHECK_EQUAL(drv.regs_dirty, 0);
+	for (r = 0; r < NUM_REGS; r++) {
+		CHECK_EQUAL(chip.regs[r], drv.regs[r]);
+	}
+
+	for (freq = 2170000000U; freq <= 2740000000U; freq += 10000000U) {
+		mock_reset();
+		max2839_set_frequency(&drv, freq);
+		CHECK(chip.batches <= 2);
+		CHECK_EQUAL(chip.transfers, 0);
+		check_synth_order();
+	}
+}
+
+int main(void)
+{
+	test_max2837();
+	test_max2839();
+	return test_result("max283x");
+}
@@ -0,0 +1,161 @@
+/*
+ * Copyright 2026 Great Scott Gadgets <info@greatscottgadgets.com>
+ *
+ * This file is part of HackRF.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * The packed Q15 operations are private to spectrum.c, so it is included
+ * here to check them against the results the M4 instructions give.
+ */
+#include "spectrum.c"
+#include "test.h"
+
+#include <math.h>
+
+#ifndef M_PI
+	#define M_PI 3.14159265358979323846
+#endif
+
+static uint32_t pack_values(const int32_t re, const int32_t im)
+{
+	return ((uint32_t) re & 0xffff) | ((uint32_t) im << 16);
+}
+
+/* Edge cases of each operation, with results from the ARMv7-M manual. */
+static void test_operations(void)
+{
+	const uint32_t min = pack_values(INT16_MIN, INT16_MIN);
+	const uint32_t max = pack_values(INT16_MAX, INT16_MAX);
+
+	CHECK_EQUAL(halving_add(min, min), min);
+	CHECK_EQUAL(halving_add(max, max), max);
+	CHECK_EQUAL(halving_add(pack_values(-1, 1), 0), pack_values(-1, 0));
+	CHECK_EQUAL(halving_sub(max, min), max);
+	CHECK_EQUAL(halving_sub(min, max), min);
+	CHECK_EQUAL(
+		halving_add_sub(pack_values(100, 200), pack_values(30, -7)),
+		pack_values(46, 85));
+	CHECK_EQUAL(
+		halving_sub_add(pack_values(100, 200), pack_values(30, -7)),
+		pack_values(53, 115));
+	CHECK_EQUAL(dual_mul_add(min, min), 0x80000000);
+	CHECK_EQUAL(dual_mul_add(pack_values(3, -4), pack_values(5, 6)), (uint32_t) -9);
+	CHECK_EQUAL(dual_mul_sub_x(pack_values(3, -4), pack_values(5, 6)), 38);
+	CHECK_EQUAL(pack_q30(0x40000000, (uint32_t) -0x40000001), pack_values(32767, -32768));
+	CHECK_EQUAL(pack_q30(0x7fffffff, 0x80000000), pack_values(32767, -32768));
+	CHECK_EQUAL(pack_q30(3 << 15, (uint32_t) -(3 << 15) - 1), pack_values(3, -4));
+}
+
+/* Compare the FFT with a DFT in double precision, scaled by 1/size. */
+static void test_fft(const uint16_t size, const int32_t amplitude)
+{
+	static spectrum_t spectrum;
+	uint32_t data[SPECTRUM_MAX_SIZE];
+	double in_re[SPECTRUM_MAX_SIZE], in_im[SPECTRUM_MAX_SIZE];
+	double re, im, angle, error, max_error = 0;
+	uint32_t i, k;
+
+	CHECK(spectrum_init(&spectrum, size));
+	for (i = 0; i < size; i++) {
+		in_re[i] = (int32_t) (test_random() % (2 * amplitude + 1)) - amplitude;
+		in_im[i] = (int32_t) (test_random() % (2 * amplitude + 1)) - amplitude;
+		data[i] = pack_values(in_re[i], in_im[i]);
+	}
+	spectrum_fft(&spectrum, data);
+
+	for (k = 0; k < size; k++) {
+		re = 0;
+		im = 0;
+		for (i = 0; i < size; i++) {
+			angle = -2 * M_PI * i * k / size;
+			re += in_re[i] * cos(angle) - in_im[i] * sin(angle);
+			im += in_re[i] * sin(angle) + in_im[i] * cos(angle);
+		}
+		error = fabs(re / size - (int16_t) (data[k] & 0xffff));
+		max_error = (error > max_error) ? error : max_error;
+		error = fabs(im / size - (int16_t) (data[k] >> 16));
+		max_error = (error > max_error) ? error : max_error;
+	}
+
+	// Each stage truncates, losing up to one LSB.
+	if (max_error > 4) {
+		fprintf(stderr, "size %u: FFT error %.2f LSB\n", size, max_error);
+		test_failures++;
+	}
+}
+
+/* A tone centred on a bin puts nearly all of its power there. */
+static void test_tone(const uint16_t size, const uint32_t bin)
+{
+	static spectrum_t spectrum;
+	int8_t samples[2 * SPECTRUM_MAX_SIZE];
+	uint8_t record[SPECTRUM_RECORD_SIZE(SPECTRUM_MAX_SIZE)];
+	uint32_t i, power, peak = 0, total = 0;
+	const uint8_t* p;
+
+	CHECK(spectrum_init(&spectrum, size));
+	for (i = 0; i < size; i++) {
+		samples[2 * i] = lrint(100 * cos(2 * M_PI * bin * i / size));
+		samples[2 * i + 1] = lrint(100 * sin(2 * M_PI * bin * i / size));
+	}
+	CHECK_EQUAL(spectrum_add_block(&spectrum, samples, 2 * size), 1);
+	CHECK_EQUAL(spectrum_add_block(&spectrum, samples, 2 * size + 1), 1);
+	spectrum_skip_block(&spectrum);
+	spectrum_write_record(&spectrum, 915000000, record);
+
+	CHECK_EQUAL(record[0], 0x7f);
+	CHECK_EQUAL(record[1], 0x7f);
+	CHECK_EQUAL(record[10] | (record[11] << 8), 2);
+	CHECK_EQUAL(record[12] | (record[13] << 8), size);
+	CHECK_EQUAL(record[14] | (record[15] << 8), 1);
+	for (i = 0; i < size; i++) {
+		p = &record[SPECTRUM_HEADER_SIZE + 4 * i];
+		power = p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+		total += power;
+		if (i == bin) {
+			peak = power;
+		}
+	}
+	// The Hann window spreads a centred tone over three bins, in the
+	// ratio 1:4:1 by power.
+	CHECK(peak > 0);
+	CHECK(peak >= total * 6 / 10);
+
+	// The record resets the average and the skipped blocks.
+	CHECK_EQUAL(spectrum.frames, 0);
+	CHECK_EQUAL(spectrum.skipped, 0);
+}
+
+int main(void)
+{
+	static spectrum_t spectrum;
+	uint16_t size;
+
+	test_operations();
+	CHECK(!spectrum_init(&spectrum, 32));
+	CHECK(!spectrum_init(&spectrum, 1024));
+	for (size = SPECTRUM_MIN_SIZE; size <= SPECTRUM_MAX_SIZE; size *= 4) {
+		test_fft(size, 4096);
+		test_fft(size, INT16_MAX);
+		test_tone(size, 0);
+		test_tone(size, 3);
+		test_tone(size, size - 5);
+	}
+	return test_result("spectrum");
+}
@@ -0,0 +1,208 @@
+/*
+ * Copyright 2026 Great Scott Gadgets <info@greatscottgadgets.com>
+ *
+ * This file is part of HackRF.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "spiflash_image.h"
+#include "test.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#define FLASH_SIZE 0x100000
+#define PAGE_SIZE  256
+
+/* Bulk transfer size used by spiflash_program_mode(). */
+#define CHUNK_SIZE 0x4000
+
+/*
+ * Mock NOR flash, standing in for the w25q80bv driver. Erasing sets bytes
+ * to 0xff and programming can only clear bits, as on the real part, so
+ * programming a byte that wasn't erased first is caught.
+ */
+static uint8_t flash[FLASH_SIZE];
+static int sector_erases;
+static int block_erases;
+static int pages_programmed;
+
+static w25q80bv_driver_t drv = {
+	.page_len = PAGE_SIZE,
+	.num_pages = FLASH_SIZE / PAGE_SIZE,
+	.num_bytes = FLASH_SIZE,
+};
+
+void w25q80bv_read(
+	w25q80bv_driver_t* const drv,
+	uint32_t addr,
+	uint32_t len,
+	uint8_t* const data)
+{
+	(void) drv;
+	CHECK(addr + len <= FLASH_SIZE);
+	memcpy(data, &flash[addr], len);
+}
+
+void w25q80bv_program(w25q80bv_driver_t* const drv, uint32_t addr, uint32_t len, uint8_t* data)
+{
+	uint32_t i;
+
+	(void) drv;
+	CHECK(addr + len <= FLASH_SIZE);
+	CHECK((addr / PAGE_SIZE) == ((addr + len - 1) / PAGE_SIZE));
+	for (i = 0; i < len; i++) {
+		CHECK_EQUAL(flash[addr + i] & data[i], data[i]);
+		flash[addr + i] &= data[i];
+	}
+	pages_programmed++;
+}
+
+void w25q80bv_sector_erase(w25q80bv_driver_t* const drv, const uint32_t addr)
+{
+	(void) drv;
+	memset(&flash[addr & ~(W25Q80BV_SECTOR_LEN - 1)], 0xff, W25Q80BV_SECTOR_LEN);
+	sector_erases++;
+}
+
+void w25q80bv_block_erase(w25q80bv_driver_t* const drv, const uint32_t addr)
+{
+	(void) drv;
+	memset(&flash[addr & ~(W25Q80BV_BLOCK_LEN - 1)], 0xff, W25Q80BV_BLOCK_LEN);
+	block_erases++;
+}
+
+static uint8_t image_data[FLASH_SIZE];
+
+static void fill_random(uint8_t* const data, const uint32_t length)
+{
+	uint32_t i;
+
+	for (i = 0; i < length; i++) {
+		data[i] = test_random();
+	}
+}
+
+static uint32_t image_crc(const uint8_t* const data, const uint32_t length)
+{
+	crc32_t crc;
+
+	crc32_init(&crc);
+	crc32_update(&crc, data, length);
+	return crc32_digest(&crc);
+}
+
+/* Write an image in pieces of CHUNK_SIZE, as the firmware receives it. */
+static void write_image(const uint32_t addr, const uint32_t length)
+{
+	spiflash_image_t image;
+	uint32_t offset, piece;
+
+	sector_erases = 0;
+	block_erases = 0;
+	pages_programmed = 0;
+
+	CHECK(spiflash_image_init(&image, &drv, addr, length));
+	for (offset = 0; offset < length; offset += piece) {
+		piece = ((length - offset) > CHUNK_SIZE) ? CHUNK_SIZE : (length - offset);
+		spiflash_image_write(&image, addr + offset, &image_data[offset], piece);
+	}
+	CHECK_EQUAL(memcmp(&flash[addr], image_data, length), 0);
+	CHECK_EQUAL(spiflash_image_crc(&image), image_crc(image_data, length));
+}
+
+/* Flash holding old data gets a whole new image. */
+static void test_fresh(void)
+{
+	const uint32_t addr = 0x10000;
+	const uint32_t length = 0x32000;
+
+	fill_random(flash, FLASH_SIZE);
+	fill_random(image_data, length);
+	write_image(addr, length);
+
+	// Three whole blocks, then two sectors.
+	CHECK_EQUAL(block_erases, 3);
+	CHECK_EQUAL(sector_erases, 2);
+	CHECK_EQUAL(pages_programmed, length / PAGE_SIZE);
+}
+
+/* Writing the same image again changes nothing. */
+static void test_unchanged(void)
+{
+	const uint32_t addr = 0x10000;
+	const uint32_t length = 0x32000;
+
+	write_image(addr, length);
+	CHECK_EQUAL(block_erases, 0);
+	CHECK_EQUAL(sector_erases, 0);
+	CHECK_EQUAL(pages_programmed, 0);
+}
+
+/* Only the sectors that differ are erased and programmed. */
+static void test_partial(void)
+{
+	const uint32_t addr = 0x10000;
+	const uint32_t length = 0x32000;
+	uint8_t before[W25Q80BV_SECTOR_LEN];
+
+	memcpy(before, &flash[0x0f000], sizeof(before));
+	image_data[0x1234] ^= 0x01;
+	image_data[0x31fff] ^= 0x80;
+	write_image(addr, length);
+	CHECK_EQUAL(block_erases, 0);
+	CHECK_EQUAL(sector_erases, 2);
+	CHECK_EQUAL(pages_programmed, 2 * W25Q80BV_SECTOR_LEN / PAGE_SIZE);
+
+	// The sector before the image is left alone.
+	CHECK_EQUAL(memcmp(before, &flash[0x0f000], sizeof(before)), 0);
+}
+
+/* Blank pages are erased but not programmed, and odd lengths are fine. */
+static void test_blank_and_short(void)
+{
+	const uint32_t addr = 0xfe000;
+	const uint32_t length = 0x1234;
+
+	fill_random(image_data, length);
+	memset(image_data, 0xff, 2 * PAGE_SIZE);
+	write_image(addr, length);
+	CHECK_EQUAL(sector_erases, 2);
+	CHECK_EQUAL(pages_programmed, (length + PAGE_SIZE - 1) / PAGE_SIZE - 2);
+}
+
+static void test_invalid(void)
+{
+	spiflash_image_t image;
+
+	CHECK(!spiflash_image_init(&image, &drv, 0x100, 0x1000));
+	CHECK(!spiflash_image_init(&image, &drv, 0x1000, 0));
+	CHECK(!spiflash_image_init(&image, &drv, FLASH_SIZE, 0x1000));
+	CHECK(!spiflash_image_init(&image, &drv, 0xff000, 0x1001));
+	CHECK(spiflash_image_init(&image, &drv, 0xff000, 0x1000));
+	CHECK(spiflash_image_init(&image, &drv, 0, FLASH_SIZE));
+}
+
+int main(void)
+{
+	test_fresh();
+	test_unchanged();
+	test_partial();
+	test_blank_and_short();
+	test_invalid();
+	return test_result("spiflash_image");
+}
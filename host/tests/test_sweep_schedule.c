@@ -0,0 +1,190 @@
+/*
+ * Copyright 2026 Great Scott Gadgets <info@greatscottgadgets.com>
+ *
+ * This file is part of HackRF.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "sweep_schedule.h"
+#include "test.h"
+
+#include <stdint.h>
+
+#define RING_SIZE 0x10000
+#define GUARD     0x200
+
+/* Gapless blocks follow each other directly and wrap around the ring. */
+static void test_gapless(void)
+{
+	sweep_schedule_t schedule;
+	uint32_t i, start;
+
+	sweep_schedule_init(&schedule, RING_SIZE, 0x4000, 0, 0);
+	CHECK_EQUAL(sweep_schedule_block_end(&schedule), 0x4000);
+	for (i = 1; i < 10; i++) {
+		CHECK(sweep_schedule_gapless(&schedule, false));
+		start = sweep_schedule_next(&schedule, false, i * 0x4000);
+		CHECK_EQUAL(start, i * 0x4000);
+		CHECK_EQUAL(sweep_schedule_ring_offset(&schedule), (i * 0x4000) % RING_SIZE);
+		CHECK_EQUAL(sweep_schedule_sent(&schedule, start), start);
+	}
+	CHECK(!sweep_schedule_gapless(&schedule, true));
+}
+
+/* The default minimum gap skips two blocks after each one. */
+static void test_min_gap(void)
+{
+	sweep_schedule_t schedule;
+
+	sweep_schedule_init(&schedule, RING_SIZE, 0x4000, 0, 0x8000);
+	CHECK(!sweep_schedule_gapless(&schedule, false));
+	CHECK_EQUAL(sweep_schedule_next(&schedule, false, 0x4000), 0xc000);
+	CHECK_EQUAL(schedule.gap_count, 1);
+
+	// The skipped space is credited along with the block before it.
+	CHECK_EQUAL(sweep_schedule_sent(&schedule, 0x4000), 0xc000);
+	CHECK_EQUAL(schedule.gap_count, 0);
+}
+
+/* After a retune, the next block starts at least the settle time later. */
+static void test_settle(void)
+{
+	sweep_schedule_t schedule;
+
+	sweep_schedule_init(&schedule, RING_SIZE, 0x1000, 1000, 0);
+	CHECK_EQUAL(sweep_schedule_next(&schedule, true, 5000), 0x2000);
+
+	// Without a retune, the block is only held back by the guard.
+	sweep_schedule_init(&schedule, RING_SIZE, 0x800, 1000, 32);
+	CHECK_EQUAL(sweep_schedule_next(&schedule, false, 0x800 + 1000), 0x1000);
+	CHECK_EQUAL(sweep_schedule_next(&schedule, false, 0x1800), 0x2000);
+}
+
+/* A block whose end was armed too late is followed by a guarded gap. */
+static void test_missed(void)
+{
+	sweep_schedule_t schedule;
+	uint32_t start;
+
+	sweep_schedule_init(&schedule, RING_SIZE, 0x4000, 0, 0);
+	sweep_schedule_next(&schedule, false, 0x4000);
+	sweep_schedule_missed(&schedule);
+	CHECK(!sweep_schedule_gapless(&schedule, false));
+
+	start = sweep_schedule_next(&schedule, false, 0x8000 + 0x100);
+	CHECK_EQUAL(start, 0xc000);
+	CHECK((int32_t) (start - (0x8000 + 0x100 + GUARD)) >= 0);
+	CHECK(sweep_schedule_gapless(&schedule, false));
+	CHECK_EQUAL(sweep_schedule_sent(&schedule, 0x4000), 0x4000);
+	CHECK_EQUAL(sweep_schedule_sent(&schedule, 0x8000), 0xc000);
+}
+
+/* Positions wrap at 2^32. */
+static void test_wrap(void)
+{
+	sweep_schedule_t schedule;
+
+	sweep_schedule_init(&schedule, RING_SIZE, 0x4000, 0, 0);
+	schedule.block_start = 0xffffc000;
+	CHECK_EQUAL(sweep_schedule_block_end(&schedule), 0);
+	CHECK_EQUAL(sweep_schedule_next(&schedule, false, 0), 0);
+
+	sweep_schedule_init(&schedule, RING_SIZE, 0x4000, 0x100, 0);
+	schedule.block_start = 0xffff8000;
+	CHECK_EQUAL(sweep_schedule_next(&schedule, true, 0xfffffff0), 0x4000);
+}
+
+/*
+ * Drive the schedule with random settings, retunes and transfer delays,
+ * checking that blocks never overlap or straddle the end of the ring, that
+ * gapped blocks start far enough ahead of the M0, and that space is only
+ * credited once every block before it has been sent.
+ */
+static void test_random_schedules(void)
+{
+	sweep_schedule_t schedule;
+	uint32_t pending[SWEEP_SCHEDULE_MAX_GAPS];
+	uint32_t block_size, settle, min_gap, now, prev_end, start, consumed;
+	unsigned int head, count, run, step;
+	bool retuned;
+
+	for (run = 0; run < 200; run++) {
+		block_size = 0x800 << (test_random() % 4);
+		settle = test_random() % 0x4000;
+		min_gap = (test_random() % 2) ? 0 : (test_random() % 0x8000);
+		now = (test_random() << 30) ^ (test_random() << 15) ^ test_random();
+		now &= ~(block_size - 1);
+		sweep_schedule_init(&schedule, RING_SIZE, block_size, settle, min_gap);
+		schedule.block_start = now;
+		schedule.consumed = now;
+		head = 0;
+		count = 0;
+
+		for (step = 0; step < 2000; step++) {
+			prev_end = sweep_schedule_block_end(&schedule);
+			CHECK_EQUAL(prev_end % block_size, 0);
+			CHECK(sweep_schedule_ring_offset(&schedule) + block_size <= RING_SIZE);
+
+			// The block may only be captured into space that has been
+			// credited to the M0.
+			CHECK((int32_t) (schedule.consumed + RING_SIZE - prev_end) >= 0);
+
+			pending[(head + count) % SWEEP_SCHEDULE_MAX_GAPS] = prev_end;
+			count++;
+
+			// Send some of the pending blocks, oldest first.
+			while ((count > 0) && ((count >= 2) || (test_random() % 2))) {
+				consumed = sweep_schedule_sent(&schedule, pending[head]);
+				CHECK((int32_t) (consumed - pending[head]) >= 0);
+				head = (head + 1) % SWEEP_SCHEDULE_MAX_GAPS;
+				count--;
+				if (count > 0) {
+					CHECK((int32_t) (pending[head] - block_size - consumed) >=
+					      0);
+				}
+			}
+
+			retuned = (test_random() % 4) == 0;
+			now = prev_end + (test_random() % 0x1000);
+			if (sweep_schedule_gapless(&schedule, retuned)) {
+				start = sweep_schedule_next(&schedule, false, prev_end);
+				CHECK_EQUAL(start, prev_end);
+				if ((test_random() % 8) == 0) {
+					sweep_schedule_missed(&schedule);
+				}
+				continue;
+			}
+			start = sweep_schedule_next(&schedule, retuned, now);
+			CHECK((int32_t) (start - (now + GUARD)) >= 0);
+			CHECK((int32_t) (start - (prev_end + min_gap)) >= 0);
+			if (retuned) {
+				CHECK((int32_t) (start - (now + settle)) >= 0);
+			}
+		}
+	}
+}
+
+int main(void)
+{
+	test_gapless();
+	test_min_gap();
+	test_settle();
+	test_missed();
+	test_wrap();
+	test_random_schedules();
+	return test_result("sweep_schedule");
+}
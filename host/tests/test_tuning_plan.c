@@ -0,0 +1,195 @@
+/*
+ * Copyright 2026 Great Scott Gadgets <info@greatscottgadgets.com>
+ *
+ * This file is part of HackRF.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "tuning_plan.h"
+#include "test.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#define ONE_MHZ     1000000ULL
+#define MIN_FREQ_HZ (1 * ONE_MHZ)
+#define MAX_FREQ_HZ (7250 * ONE_MHZ)
+
+/* Entries in the firmware tuning table. */
+#define TABLE_SIZE 128
+
+/*
+ * The MAX283x fractional divider has 20 bits of a 30MHz step, and drops
+ * the remainder, so it may tune up to one LSB below the requested IF.
+ */
+#define SYNTH_LSB_HZ ((30000000ULL + (1 << 20) - 1) >> 20)
+
+static uint64_t max_error_hz = 0;
+
+/* LO frequency the RFFC5071 produces with the planned fields. */
+static uint64_t mixer_hz(const rffc5071_synth_t* const mixer)
+{
+	const uint64_t n = ((uint64_t) mixer->n << 24) | ((uint64_t) mixer->nmsb << 8) |
+		mixer->nlsb;
+	const uint64_t fbkdiv = (uint64_t) mixer->presc << 1;
+
+	return (40 * n * fbkdiv * ONE_MHZ) / ((uint64_t) 1 << (mixer->lodiv + 24));
+}
+
+/* IF frequency the MAX283x produces with the planned fields. */
+static uint64_t synth_hz(const max283x_synth_t* const synth)
+{
+	return (synth->n * 30000000ULL) + ((synth->frac * 30000000ULL) >> 20);
+}
+
+/* Check that a planned step tunes to its RF frequency. */
+static void check_step(const tuning_step_t* const step)
+{
+	const uint64_t if_hz = synth_hz(&step->synth);
+	uint64_t rf_hz, error;
+
+	if (!(step->flags & TUNING_STEP_MIXER)) {
+		CHECK_EQUAL(step->filter, TUNING_FILTER_BYPASS);
+		rf_hz = if_hz;
+	} else if (step->flags & TUNING_STEP_MIXER_INVERT) {
+		CHECK_EQUAL(step->filter, TUNING_FILTER_LOW_PASS);
+		rf_hz = mixer_hz(&step->mixer) - if_hz;
+	} else {
+		CHECK_EQUAL(step->filter, TUNING_FILTER_HIGH_PASS);
+		rf_hz = mixer_hz(&step->mixer) + if_hz;
+	}
+
+	error = (rf_hz > step->freq) ? (rf_hz - step->freq) : (step->freq - rf_hz);
+	if (error > max_error_hz) {
+		max_error_hz = error;
+	}
+	if (error > SYNTH_LSB_HZ) {
+		fprintf(stderr,
+			"%llu Hz tunes to %llu Hz\n",
+			(unsigned long long) step->freq,
+			(unsigned long long) rf_hz);
+	}
+	CHECK(error <= SYNTH_LSB_HZ);
+
+	// Stay within the IF range, give or take the rounding of the LO.
+	if (step->flags & TUNING_STEP_MIXER) {
+		CHECK(if_hz + ONE_MHZ >= 2170 * ONE_MHZ);
+		CHECK(if_hz <= 2741 * ONE_MHZ);
+	}
+}
+
+static int mixer_changes(const tuning_step_t* const steps, const int count)
+{
+	int i, changes = 0;
+
+	for (i = 1; i < count; i++) {
+		if (memcmp(&steps[i].mixer, &steps[i - 1].mixer, sizeof(steps[i].mixer))) {
+			changes++;
+		}
+	}
+	return changes;
+}
+
+/*
+ * Plan a sweep from MIN_FREQ_HZ to MAX_FREQ_HZ, a table at a time, both
+ * step by step and as a sequence. Every step must tune to its frequency,
+ * and sharing LOs must never need more mixer changes than not sharing.
+ */
+static void test_sweep(const uint64_t step_hz)
+{
+	static tuning_step_t single[TABLE_SIZE];
+	static tuning_step_t sequence[TABLE_SIZE];
+	uint64_t freq = MIN_FREQ_HZ;
+	int i, count;
+
+	while (freq <= MAX_FREQ_HZ) {
+		for (count = 0; (count < TABLE_SIZE) && (freq <= MAX_FREQ_HZ); count++) {
+			CHECK(tuning_step_plan(freq, &single[count]));
+			check_step(&single[count]);
+			sequence[count].freq = freq;
+			freq += step_hz;
+		}
+		CHECK(tuning_sequence_plan(sequence, count));
+		for (i = 0; i < count; i++) {
+			CHECK_EQUAL(sequence[i].freq, single[i].freq);
+			CHECK_EQUAL(sequence[i].filter, single[i].filter);
+			check_step(&sequence[i]);
+		}
+		CHECK(mixer_changes(sequence, count) <= mixer_changes(single, count));
+	}
+}
+
+/* Closely spaced frequencies on one side of the mixer share an LO. */
+static void test_shared_lo(void)
+{
+	tuning_step_t steps[20];
+	int i;
+
+	for (i = 0; i < 20; i++) {
+		steps[i].freq = (100 * ONE_MHZ) + (i * 15 * ONE_MHZ);
+	}
+	CHECK(tuning_sequence_plan(steps, 20));
+	CHECK_EQUAL(mixer_changes(steps, 20), 0);
+
+	for (i = 0; i < 20; i++) {
+		steps[i].freq = (4000 * ONE_MHZ) + (i * 5 * ONE_MHZ);
+	}
+	CHECK(tuning_sequence_plan(steps, 20));
+	CHECK_EQUAL(mixer_changes(steps, 20), 0);
+}
+
+/* Random frequencies, in random order. */
+static void test_random_order(void)
+{
+	tuning_step_t steps[TABLE_SIZE];
+	uint64_t r;
+	int i, n;
+
+	for (n = 0; n < 100; n++) {
+		for (i = 0; i < TABLE_SIZE; i++) {
+			r = ((uint64_t) test_random() << 15) | test_random();
+			steps[i].freq = MIN_FREQ_HZ + ((r * (MAX_FREQ_HZ - MIN_FREQ_HZ)) >> 30);
+		}
+		CHECK(tuning_sequence_plan(steps, TABLE_SIZE));
+		for (i = 0; i < TABLE_SIZE; i++) {
+			check_step(&steps[i]);
+		}
+	}
+}
+
+static void test_out_of_range(void)
+{
+	tuning_step_t steps[2];
+
+	CHECK(!tuning_step_plan(MAX_FREQ_HZ + ONE_MHZ, &steps[0]));
+	steps[0].freq = MAX_FREQ_HZ;
+	steps[1].freq = MAX_FREQ_HZ + ONE_MHZ;
+	CHECK(!tuning_sequence_plan(steps, 2));
+}
+
+int main(void)
+{
+	test_sweep(ONE_MHZ);
+	test_sweep(20 * ONE_MHZ);
+	test_sweep(3333333);
+	test_sweep(123456789);
+	test_shared_lo();
+	test_random_order();
+	test_out_of_range();
+	printf("largest tuning error: %llu Hz\n", (unsigned long long) max_error_hz);
+	return test_result("tuning_plan");
+}